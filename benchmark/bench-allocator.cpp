@@ -0,0 +1,80 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/arena-allocator.hpp"
+#include "hexl/util/pool-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Second argument of each benchmark: the allocator under test
+enum BenchAllocator { kBenchMalloc = 0, kBenchPool = 1, kBenchArena = 2 };
+
+// Returns the allocator for the benchmark argument; kBenchArena uses arena
+inline std::shared_ptr<AllocatorBase> GetBenchAllocator(int64_t kind,
+                                                        ArenaAllocator* arena) {
+  switch (kind) {
+    case kBenchPool:
+      return GetPoolAllocator();
+    case kBenchArena:
+      return std::shared_ptr<AllocatorBase>(arena, [](AllocatorBase*) {});
+    default:
+      return nullptr;
+  }
+}
+
+//=================================================================
+
+// Allocates and frees a scratch vector, as the experimental kernels do for
+// their workspace. Only touches the first element, so the allocation dominates
+static void BM_AllocatorScratchVector(benchmark::State& state) {  //  NOLINT
+  size_t num_words = state.range(0);
+  ArenaAllocator arena;
+  AlignedAllocator<uint64_t, 64> alloc(
+      GetBenchAllocator(state.range(1), &arena));
+
+  for (auto _ : state) {
+    ScopedArenaReset arena_reset(arena);
+    AlignedVector64<uint64_t> workspace(alloc);
+    workspace.reserve(num_words);
+    workspace.push_back(1);
+    benchmark::DoNotOptimize(workspace.data());
+  }
+}
+
+BENCHMARK(BM_AllocatorScratchVector)
+    ->Unit(benchmark::kNanosecond)
+    ->ArgsProduct({{1024, 16384, 262144}, {0, 1, 2}});
+
+//=================================================================
+
+// Constructs an NTT, whose tables are allocated by the allocator under test
+static void BM_AllocatorNTTConstruct(benchmark::State& state) {  //  NOLINT
+  size_t ntt_size = state.range(0);
+  size_t modulus = GeneratePrimes(1, 45, true, ntt_size)[0];
+  uint64_t root_of_unity = MinimalPrimitiveRoot(2 * ntt_size, modulus);
+  ArenaAllocator arena;
+  std::shared_ptr<AllocatorBase> alloc =
+      GetBenchAllocator(state.range(1), &arena);
+
+  for (auto _ : state) {
+    ScopedArenaReset arena_reset(arena);
+    NTT ntt(ntt_size, modulus, root_of_unity, alloc);
+    benchmark::DoNotOptimize(ntt.GetRootOfUnityPowers().data());
+  }
+}
+
+BENCHMARK(BM_AllocatorNTTConstruct)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096, 16384}, {0, 1, 2}});
+
+}  // namespace hexl
+}  // namespace intel
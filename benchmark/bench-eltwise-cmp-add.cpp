@@ -10,6 +10,7 @@
 #include "hexl/eltwise/eltwise-cmp-add.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -44,6 +45,10 @@ BENCHMARK(BM_EltwiseCmpAddNative)
 #ifdef HEXL_HAS_AVX512DQ
 // state[0] is the degree
 static void BM_EltwiseCmpAddAVX512(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
 
   uint64_t bound = 50;
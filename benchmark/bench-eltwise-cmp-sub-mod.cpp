@@ -10,6 +10,7 @@
 #include "hexl/eltwise/eltwise-cmp-sub-mod.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -43,6 +44,10 @@ BENCHMARK(BM_EltwiseCmpSubModNative)
 #ifdef HEXL_HAS_AVX512DQ
 // state[0] is the degree
 static void BM_EltwiseCmpSubModAVX512_64(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   uint64_t modulus = 100;
   uint64_t bound = GenerateInsecureUniformRandomValue(0, modulus);
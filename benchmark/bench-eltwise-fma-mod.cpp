@@ -11,6 +11,7 @@
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -43,6 +44,10 @@ BENCHMARK(BM_EltwiseFMAModAddNative)
 
 #ifdef HEXL_HAS_AVX512DQ
 static void BM_EltwiseFMAModAVX512DQ(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 100;
   bool add = state.range(1);
@@ -69,6 +74,10 @@ BENCHMARK(BM_EltwiseFMAModAVX512DQ)
 
 #ifdef HEXL_HAS_AVX512IFMA
 static void BM_EltwiseFMAModAVX512IFMA(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 100;
   bool add = state.range(1);
@@ -12,6 +12,7 @@
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -69,6 +70,10 @@ BENCHMARK(BM_EltwiseMultModNative)
 // state[0] is the degree
 // state[1] is the input_mod_factor
 static void BM_EltwiseMultModAVX512Float(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t input_mod_factor = state.range(1);
   size_t modulus = 100;
@@ -106,6 +111,10 @@ BENCHMARK(BM_EltwiseMultModAVX512Float)
 // state[0] is the degree
 // state[1] is the input_mod_factor
 static void BM_EltwiseMultModAVX512DQInt(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t input_mod_factor = state.range(1);
   size_t modulus = 0xffffffffffc0001ULL;
@@ -137,11 +146,43 @@ BENCHMARK(BM_EltwiseMultModAVX512DQInt)
     ->ArgsProduct({{1024, 4096, 16384}, {1, 2, 4}});
 #endif
 
+#ifdef HEXL_HAS_AVX512VBMI2
+// state[0] is the degree
+// state[1] is the input_mod_factor
+static void BM_EltwiseMultModAVX512VBMI2Int(
+    benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq || !GetCpuFeatures().avx512vbmi2) {
+    state.SkipWithError("AVX512VBMI2 not supported");
+    return;
+  }
+  size_t input_size = state.range(0);
+  size_t input_mod_factor = state.range(1);
+  size_t modulus = 0xffffffffffc0001ULL;
+
+  auto input1 = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto input2 = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> output(input_size, 3);
+
+  for (auto _ : state) {
+    EltwiseMultModAVX512VBMI2Int(output.data(), input1.data(), input2.data(),
+                                 input_size, modulus, input_mod_factor);
+  }
+}
+
+BENCHMARK(BM_EltwiseMultModAVX512VBMI2Int)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096, 16384}, {1, 2, 4}});
+#endif
+
 #ifdef HEXL_HAS_AVX512IFMA
 // state[0] is the degree
 // state[1] is the input_mod_factor
 static void BM_EltwiseMultModAVX512IFMAInt(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t input_mod_factor = state.range(1);
   size_t modulus = 100;
@@ -183,6 +224,10 @@ BENCHMARK(BM_EltwiseMultModAVX512IFMAInt)
 // state[1] is the input_mod_factor
 static void BM_EltwiseMultModMontAVX512IFMAIntEConv(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
 
   size_t input_size = state.range(0);
   size_t input_mod_factor = state.range(1);
@@ -11,6 +11,7 @@
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -92,6 +93,10 @@ BENCHMARK(BM_EltwiseReduceModNative)
 #ifdef HEXL_HAS_AVX512DQ
 // state[0] is the degree
 static void BM_EltwiseReduceModAVX512(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 0xffffffffffc0001ULL;
 
@@ -120,6 +125,10 @@ BENCHMARK(BM_EltwiseReduceModAVX512)
 // state[0] is the degree
 static void BM_EltwiseReduceModAVX512BitShift64(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 0xffffffffffc0001ULL;
 
@@ -148,6 +157,10 @@ BENCHMARK(BM_EltwiseReduceModAVX512BitShift64)
 // state[0] is the degree
 static void BM_EltwiseReduceModAVX512BitShift52(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 0xffffffffffc0001ULL;
 
@@ -176,6 +189,10 @@ BENCHMARK(BM_EltwiseReduceModAVX512BitShift52)
 // state[0] is the degree
 static void BM_EltwiseReduceModAVX512BitShift52GT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 0xffffffffffc0001ULL;
 
@@ -199,6 +216,10 @@ BENCHMARK(BM_EltwiseReduceModAVX512BitShift52GT)
 
 static void BM_EltwiseReduceModAVX512BitShift52LT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 0xffffffffffc0001ULL;
 
@@ -226,6 +247,10 @@ BENCHMARK(BM_EltwiseReduceModAVX512BitShift52LT)
 #ifdef HEXL_HAS_AVX512IFMA
 static void BM_EltwiseReduceModMontAVX512BitShift52LT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   uint64_t modulus = 67280421310725ULL;
 
@@ -253,6 +278,10 @@ BENCHMARK(BM_EltwiseReduceModMontAVX512BitShift52LT)
 
 static void BM_EltwiseReduceModMontFormInAVX512BitShift52LT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   uint64_t modulus = 67280421310725ULL;
 
@@ -279,6 +308,10 @@ BENCHMARK(BM_EltwiseReduceModMontFormInAVX512BitShift52LT)
 
 static void BM_EltwiseReduceModMontFormInAVX512BitShift64LT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   uint64_t modulus = 67280421310725ULL;
 
@@ -305,6 +338,10 @@ BENCHMARK(BM_EltwiseReduceModMontFormInAVX512BitShift64LT)
 
 static void BM_EltwiseReduceModInOutMontFormAVX512BitShift52LT(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   uint64_t modulus = 67280421310725ULL;
 
@@ -11,6 +11,7 @@
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -44,6 +45,10 @@ BENCHMARK(BM_EltwiseVectorVectorSubModNative)
 // state[0] is the degree
 static void BM_EltwiseVectorVectorSubModAVX512(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 1152921504606877697;
 
@@ -93,6 +98,10 @@ BENCHMARK(BM_EltwiseVectorScalarSubModNative)
 // state[0] is the degree
 static void BM_EltwiseVectorScalarSubModAVX512(
     benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t input_size = state.range(0);
   size_t modulus = 1152921504606877697;
 
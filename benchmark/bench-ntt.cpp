@@ -9,9 +9,11 @@
 #include "hexl/ntt/ntt.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/dispatch.hpp"
 #include "ntt/fwd-ntt-avx512.hpp"
 #include "ntt/inv-ntt-avx512.hpp"
 #include "ntt/ntt-internal.hpp"
+#include "util/cpu-features.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -115,6 +117,10 @@ BENCHMARK(BM_FwdNTTNativeRadix4Copy)
 #ifdef HEXL_HAS_AVX512IFMA
 // state[0] is the degree
 static void BM_FwdNTT_AVX512IFMA(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   size_t modulus_bits = 49;
   size_t modulus = GeneratePrimes(1, modulus_bits, true, ntt_size)[0];
@@ -144,6 +150,10 @@ BENCHMARK(BM_FwdNTT_AVX512IFMA)
 
 // state[0] is the degree
 static void BM_FwdNTT_AVX512IFMALazy(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   size_t modulus_bits = 49;
   size_t modulus = GeneratePrimes(1, modulus_bits, true, ntt_size)[0];
@@ -179,6 +189,10 @@ BENCHMARK(BM_FwdNTT_AVX512IFMALazy)
 // state[0] is the degree
 // state[1] is the output modulus factor
 static void BM_FwdNTT_AVX512DQ_32(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   uint64_t output_mod_factor = state.range(1);
   size_t modulus_bits = 29;
@@ -210,6 +224,10 @@ BENCHMARK(BM_FwdNTT_AVX512DQ_32)
 // state[0] is the degree
 // state[1] is the output modulus factor
 static void BM_FwdNTT_AVX512DQ_64(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   uint64_t output_mod_factor = state.range(1);
   size_t modulus_bits = 55;
@@ -285,6 +303,36 @@ BENCHMARK(BM_FwdNTTCopy)
 
 //=================================================================
 
+// state[0] is the degree
+// state[1] is the number of bits in the modulus
+// state[2] is the Backend to which dispatch is restricted
+static void BM_FwdNTTBackend(benchmark::State& state) {  //  NOLINT
+  size_t ntt_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  Backend backend = static_cast<Backend>(state.range(2));
+  if (backend > GetSupportedBackend()) {
+    state.SkipWithError("Backend not supported");
+    return;
+  }
+  size_t modulus = GeneratePrimes(1, modulus_bits, true, ntt_size)[0];
+
+  auto input = GenerateInsecureUniformRandomValues(ntt_size, 0, modulus);
+  NTT ntt(ntt_size, modulus);
+
+  SetBackend(backend);
+  state.SetLabel(BackendName(GetKernelBackend(Kernel::kForwardNTT, modulus)));
+  for (auto _ : state) {
+    ntt.ComputeForward(input.data(), input.data(), 1, 1);
+  }
+  ResetBackend();
+}
+
+BENCHMARK(BM_FwdNTTBackend)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096, 16384}, {45, 61}, {0, 1, 2}});
+
+//=================================================================
+
 static void BM_InvNTTInPlace(benchmark::State& state) {  //  NOLINT
   size_t ntt_size = state.range(0);
   size_t modulus = GeneratePrimes(1, 45, true, ntt_size)[0];
@@ -434,6 +482,10 @@ BENCHMARK(BM_InvNTTNativeRadix4Copy)
 #ifdef HEXL_HAS_AVX512IFMA
 // state[0] is the degree
 static void BM_InvNTT_AVX512IFMA(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   size_t modulus = GeneratePrimes(1, 49, true, ntt_size)[0];
 
@@ -460,6 +512,10 @@ BENCHMARK(BM_InvNTT_AVX512IFMA)
 
 // state[0] is the degree
 static void BM_InvNTT_AVX512IFMALazy(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   size_t modulus = GeneratePrimes(1, 49, true, ntt_size)[0];
 
@@ -489,6 +545,10 @@ BENCHMARK(BM_InvNTT_AVX512IFMALazy)
 #ifdef HEXL_HAS_AVX512DQ
 // state[0] is the degree
 static void BM_InvNTT_AVX512DQ_32(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   uint64_t output_mod_factor = state.range(1);
   size_t modulus = GeneratePrimes(1, 29, true, ntt_size)[0];
@@ -517,6 +577,10 @@ BENCHMARK(BM_InvNTT_AVX512DQ_32)
     ->Args({16384, 2});
 
 static void BM_InvNTT_AVX512DQ_64(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
   size_t ntt_size = state.range(0);
   uint64_t output_mod_factor = state.range(1);
   size_t modulus = GeneratePrimes(1, 61, true, ntt_size)[0];
@@ -0,0 +1,88 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/experimental/misc/diagonal-mat-vec-mult.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+//=================================================================
+
+static void BM_DiagonalMatrixVectorMultiply(  //  NOLINT
+    benchmark::State& state) {
+  size_t poly_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  size_t baby_steps = state.range(2);
+  bool fused = state.range(3) == 1;
+  size_t giant_steps = 4;
+  size_t num_moduli = 3;
+  size_t limbs = poly_size * num_moduli;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  AlignedVector64<uint64_t> diagonals;
+  for (size_t d = 0; d < giant_steps * baby_steps; ++d) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      diagonals.insert(diagonals.end(), values.begin(), values.end());
+    }
+  }
+  AlignedVector64<uint64_t> ciphers;
+  for (size_t i = 0; i < 2 * baby_steps; ++i) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      ciphers.insert(ciphers.end(), values.begin(), values.end());
+    }
+  }
+  AlignedVector64<uint64_t> result(giant_steps * 2 * limbs);
+  AlignedVector64<uint64_t> temp(poly_size);
+
+  for (auto _ : state) {
+    if (fused) {
+      DiagonalMatrixVectorMultiply(result.data(), diagonals.data(),
+                                   ciphers.data(), poly_size, moduli.data(),
+                                   num_moduli, baby_steps, giant_steps);
+      continue;
+    }
+    // One multiplication and one addition per diagonal, limb and component
+    for (size_t j = 0; j < giant_steps; ++j) {
+      for (size_t i = 0; i < baby_steps; ++i) {
+        for (size_t k = 0; k < 2; ++k) {
+          for (size_t m = 0; m < num_moduli; ++m) {
+            uint64_t* out = &result[(2 * j + k) * limbs + m * poly_size];
+            const uint64_t* d =
+                &diagonals[(j * baby_steps + i) * limbs + m * poly_size];
+            const uint64_t* c = &ciphers[(2 * i + k) * limbs + m * poly_size];
+            if (i == 0) {
+              EltwiseMultMod(out, d, c, poly_size, moduli[m], 1);
+            } else {
+              EltwiseMultMod(temp.data(), d, c, poly_size, moduli[m], 1);
+              EltwiseAddMod(out, out, temp.data(), poly_size, moduli[m]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of bits in each modulus
+// state[2] is the number of baby steps
+// state[3] is whether to use DiagonalMatrixVectorMultiply rather than
+// separate element-wise multiplications and additions
+BENCHMARK(BM_DiagonalMatrixVectorMultiply)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {40, 60}, {8, 16}, {0, 1}});
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,108 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/misc/lr-mat-vec-mult.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+//=================================================================
+
+static void BM_LinRegMatrixVectorMultiply(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t num_weights = state.range(1);
+  size_t num_threads = state.range(2);
+  size_t num_moduli = 3;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, 50, true, poly_size);
+  AlignedVector64<uint64_t> operand1;
+  AlignedVector64<uint64_t> operand2;
+  for (size_t r = 0; r < num_weights; ++r) {
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        operand1.insert(operand1.end(), values1.begin(), values1.end());
+        operand2.insert(operand2.end(), values2.begin(), values2.end());
+      }
+    }
+  }
+  AlignedVector64<uint64_t> result(num_weights * 3 * poly_size * num_moduli);
+
+  std::unique_ptr<ThreadExecutor> executor;
+  if (num_threads > 0) {
+    executor.reset(new ThreadExecutor(num_threads));
+  }
+  AlignedVector64<uint64_t> workspace(
+      LinRegMatrixVectorMultiplyWorkspaceSize(poly_size, executor.get()));
+
+  for (auto _ : state) {
+    LinRegMatrixVectorMultiply(result.data(), operand1.data(),
+                               operand2.data(), poly_size, moduli.data(),
+                               num_moduli, num_weights, workspace.data(),
+                               executor.get());
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of weights
+// state[2] is the number of threads, or 0 to run on the calling thread
+BENCHMARK(BM_LinRegMatrixVectorMultiply)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {16, 63}, {0, 1, 2, 4}});
+
+//=================================================================
+
+static void BM_LinRegMatrixVectorMultiplyAccumulate(  //  NOLINT
+    benchmark::State& state) {
+  size_t poly_size = state.range(0);
+  size_t num_weights = state.range(1);
+  size_t num_moduli = 3;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, 50, true, poly_size);
+  AlignedVector64<uint64_t> operand1;
+  AlignedVector64<uint64_t> operand2;
+  for (size_t r = 0; r < num_weights; ++r) {
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        operand1.insert(operand1.end(), values1.begin(), values1.end());
+        operand2.insert(operand2.end(), values2.begin(), values2.end());
+      }
+    }
+  }
+  AlignedVector64<uint64_t> result(3 * poly_size * num_moduli);
+  AlignedVector64<uint64_t> workspace(
+      LinRegMatrixVectorMultiplyAccumulateWorkspaceSize(poly_size));
+
+  for (auto _ : state) {
+    LinRegMatrixVectorMultiplyAccumulate(
+        result.data(), operand1.data(), operand2.data(), poly_size,
+        moduli.data(), num_moduli, num_weights, workspace.data());
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of weights
+BENCHMARK(BM_LinRegMatrixVectorMultiplyAccumulate)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {16, 63}});
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,351 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/command-queue.hpp"
+#include "hexl/experimental/seal/dyadic-multiply.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/cache-info.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+//=================================================================
+
+static void BM_DyadicMultiply(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  bool karatsuba = state.range(2) == 1;
+  size_t num_moduli = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  AlignedVector64<uint64_t> operand1;
+  AlignedVector64<uint64_t> operand2;
+  for (size_t poly = 0; poly < 2; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values1 = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      auto values2 = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      operand1.insert(operand1.end(), values1.begin(), values1.end());
+      operand2.insert(operand2.end(), values2.begin(), values2.end());
+    }
+  }
+  AlignedVector64<uint64_t> result(3 * poly_size * num_moduli, 0);
+  AlignedVector64<uint64_t> workspace(DyadicMultiplyWorkspaceSize(poly_size));
+
+  for (auto _ : state) {
+    if (karatsuba) {
+      DyadicMultiplyKaratsuba(result.data(), operand1.data(), operand2.data(),
+                              poly_size, moduli.data(), num_moduli,
+                              workspace.data());
+    } else {
+      DyadicMultiply(result.data(), operand1.data(), operand2.data(),
+                     poly_size, moduli.data(), num_moduli, workspace.data());
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of bits in each modulus
+// state[2] is 1 to use Karatsuba multiplication for every modulus
+BENCHMARK(BM_DyadicMultiply)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096, 16384}, {40, 50, 60}, {0, 1}});
+
+//=================================================================
+
+static void BM_DyadicMultiplyBatch(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  size_t batch_size = state.range(2);
+  size_t num_threads = state.range(3);
+  size_t num_moduli = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  std::vector<AlignedVector64<uint64_t>> operand1s(batch_size);
+  std::vector<AlignedVector64<uint64_t>> operand2s(batch_size);
+  std::vector<AlignedVector64<uint64_t>> results(batch_size);
+  std::vector<const uint64_t*> operand1_ptrs;
+  std::vector<const uint64_t*> operand2_ptrs;
+  std::vector<uint64_t*> result_ptrs;
+  for (size_t b = 0; b < batch_size; ++b) {
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        operand1s[b].insert(operand1s[b].end(), values1.begin(),
+                            values1.end());
+        operand2s[b].insert(operand2s[b].end(), values2.begin(),
+                            values2.end());
+      }
+    }
+    results[b].resize(3 * poly_size * num_moduli);
+    operand1_ptrs.push_back(operand1s[b].data());
+    operand2_ptrs.push_back(operand2s[b].data());
+    result_ptrs.push_back(results[b].data());
+  }
+
+  std::unique_ptr<ThreadExecutor> executor;
+  if (num_threads > 0) {
+    executor.reset(new ThreadExecutor(num_threads));
+  }
+  AlignedVector64<uint64_t> workspace(
+      DyadicMultiplyBatchWorkspaceSize(poly_size, executor.get()));
+
+  for (auto _ : state) {
+    if (num_threads == 0) {
+      for (size_t b = 0; b < batch_size; ++b) {
+        DyadicMultiply(result_ptrs[b], operand1_ptrs[b], operand2_ptrs[b],
+                       poly_size, moduli.data(), num_moduli,
+                       workspace.data());
+      }
+    } else {
+      DyadicMultiplyBatch(result_ptrs.data(), operand1_ptrs.data(),
+                          operand2_ptrs.data(), batch_size, poly_size,
+                          moduli.data(), num_moduli, executor.get(),
+                          workspace.data());
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of bits in each modulus
+// state[2] is the number of ciphertext pairs
+// state[3] is the number of threads for DyadicMultiplyBatch, or 0 for one
+// DyadicMultiply per pair
+BENCHMARK(BM_DyadicMultiplyBatch)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096}, {40, 60}, {64, 1024}, {0, 1, 2, 4}});
+
+//=================================================================
+
+static void BM_DyadicMultiplyCommandQueue(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t batch_size = state.range(1);
+  size_t mode = state.range(2);
+  size_t num_threads = state.range(3);
+  size_t num_moduli = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, 50, true, poly_size);
+  std::vector<AlignedVector64<uint64_t>> operand1s(batch_size);
+  std::vector<AlignedVector64<uint64_t>> operand2s(batch_size);
+  std::vector<AlignedVector64<uint64_t>> results(batch_size);
+  std::vector<Command> commands;
+  for (size_t b = 0; b < batch_size; ++b) {
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+        operand1s[b].insert(operand1s[b].end(), values1.begin(),
+                            values1.end());
+        operand2s[b].insert(operand2s[b].end(), values2.begin(),
+                            values2.end());
+      }
+    }
+    results[b].resize(3 * poly_size * num_moduli);
+
+    DyadicMultiplyCommand command;
+    command.result = results[b].data();
+    command.operand1 = operand1s[b].data();
+    command.operand2 = operand2s[b].data();
+    command.n = poly_size;
+    command.moduli = moduli.data();
+    command.num_moduli = num_moduli;
+    commands.push_back(command);
+  }
+
+  CommandQueue queue(std::make_shared<CpuCommandQueueBackend>(num_threads));
+  AlignedVector64<uint64_t> workspace(DyadicMultiplyWorkspaceSize(poly_size));
+
+  for (auto _ : state) {
+    if (mode == 0) {
+      for (const auto& command : commands) {
+        const DyadicMultiplyCommand& args = command.dyadic_multiply;
+        DyadicMultiply(args.result, args.operand1, args.operand2, args.n,
+                       args.moduli, args.num_moduli, workspace.data());
+      }
+    } else if (mode == 1) {
+      for (const auto& command : commands) {
+        queue.Submit(command.dyadic_multiply);
+      }
+      queue.Wait();
+    } else {
+      queue.SubmitBatch(commands).get();
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of ciphertext pairs
+// state[2] is 0 for synchronous DyadicMultiply calls, 1 for one submission
+// per pair, 2 for one batched submission
+// state[3] is the number of workers of the queue backend
+// Commands run on the backend threads, so the benchmark reports wall time
+BENCHMARK(BM_DyadicMultiplyCommandQueue)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime()
+    ->ArgsProduct({{1024, 4096}, {64}, {0, 1, 2}, {1, 2}});
+
+//=================================================================
+
+static void BM_DyadicMultiplyTileSize(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t num_moduli = state.range(1);
+  uint64_t l1_data_cache_size = state.range(2) * 1024;
+
+  // Moduli of 62 bits use the tiled element-wise kernels
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, 62, true, poly_size);
+  AlignedVector64<uint64_t> operand1;
+  AlignedVector64<uint64_t> operand2;
+  for (size_t poly = 0; poly < 2; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values1 = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      auto values2 = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      operand1.insert(operand1.end(), values1.begin(), values1.end());
+      operand2.insert(operand2.end(), values2.begin(), values2.end());
+    }
+  }
+  AlignedVector64<uint64_t> result(3 * poly_size * num_moduli, 0);
+  AlignedVector64<uint64_t> workspace(DyadicMultiplyWorkspaceSize(poly_size));
+
+  SetCacheSizes(l1_data_cache_size, 0);
+  for (auto _ : state) {
+    DyadicMultiply(result.data(), operand1.data(), operand2.data(), poly_size,
+                   moduli.data(), num_moduli, workspace.data());
+  }
+  SetCacheSizes(0, 0);
+}
+
+// state[0] is the degree
+// state[1] is the number of moduli
+// state[2] is the level 1 data cache size in KiB from which the tile size is
+// chosen, or 0 for the detected size
+BENCHMARK(BM_DyadicMultiplyTileSize)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384, 65536}, {1, 4, 16}, {0, 8, 32, 128}});
+
+//=================================================================
+
+static void BM_DyadicTensorProduct(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  size_t operand1_size = state.range(2);
+  size_t operand2_size = state.range(3);
+  bool square = state.range(4) == 1;
+  size_t num_moduli = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  AlignedVector64<uint64_t> operand1;
+  AlignedVector64<uint64_t> operand2;
+  for (size_t poly = 0; poly < operand1_size; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      operand1.insert(operand1.end(), values.begin(), values.end());
+    }
+  }
+  for (size_t poly = 0; poly < operand2_size; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      operand2.insert(operand2.end(), values.begin(), values.end());
+    }
+  }
+  AlignedVector64<uint64_t> result(
+      (operand1_size + operand2_size - 1) * poly_size * num_moduli, 0);
+
+  for (auto _ : state) {
+    if (square) {
+      DyadicTensorSquare(result.data(), operand1.data(), operand1_size,
+                         poly_size, moduli.data(), num_moduli);
+    } else {
+      DyadicTensorProduct(result.data(), operand1.data(), operand1_size,
+                          operand2.data(), operand2_size, poly_size,
+                          moduli.data(), num_moduli);
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of bits in each modulus
+// state[2] is the number of polynomials in the first ciphertext
+// state[3] is the number of polynomials in the second ciphertext
+// state[4] is 1 to square the first ciphertext instead
+BENCHMARK(BM_DyadicTensorProduct)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {40, 50, 60}, {2}, {2}, {0, 1}})
+    ->ArgsProduct({{4096, 16384}, {40, 50, 60}, {3}, {2}, {0}})
+    ->ArgsProduct({{4096, 16384}, {40, 50, 60}, {3}, {3}, {0, 1}});
+
+//=================================================================
+
+static void BM_PlainMultiplyAccumulate(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t modulus_bits = state.range(1);
+  size_t mode = state.range(2);
+  size_t num_moduli = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  AlignedVector64<uint64_t> plain;
+  AlignedVector64<uint64_t> cipher;
+  for (uint64_t modulus : moduli) {
+    auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+    plain.insert(plain.end(), values.begin(), values.end());
+  }
+  for (size_t poly = 0; poly < 2; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      cipher.insert(cipher.end(), values.begin(), values.end());
+    }
+  }
+  AlignedVector64<uint64_t> result(cipher);
+  AlignedVector64<uint64_t> plain_shoup(plain.size());
+  PlainMultiplyShoupFactors(plain_shoup.data(), plain.data(), poly_size,
+                            moduli.data(), num_moduli);
+  AlignedVector64<uint64_t> temp(poly_size);
+
+  for (auto _ : state) {
+    if (mode == 0) {
+      for (size_t k = 0; k < 2; ++k) {
+        for (size_t i = 0; i < num_moduli; ++i) {
+          uint64_t* out = &result[(k * num_moduli + i) * poly_size];
+          EltwiseMultMod(temp.data(), &plain[i * poly_size],
+                         &cipher[(k * num_moduli + i) * poly_size], poly_size,
+                         moduli[i], 1);
+          EltwiseAddMod(out, out, temp.data(), poly_size, moduli[i]);
+        }
+      }
+    } else {
+      PlainMultiplyAccumulate(result.data(), plain.data(), cipher.data(),
+                              poly_size, moduli.data(), num_moduli,
+                              mode == 2 ? plain_shoup.data() : nullptr);
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of bits in each modulus
+// state[2] is 0 for EltwiseMultMod and EltwiseAddMod per limb, 1 for
+// PlainMultiplyAccumulate and 2 for PlainMultiplyAccumulate with Shoup factors
+BENCHMARK(BM_PlainMultiplyAccumulate)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {40, 50, 60}, {0, 1, 2}});
+
+}  // namespace hexl
+}  // namespace intel
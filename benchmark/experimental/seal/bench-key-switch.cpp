@@ -0,0 +1,723 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "experimental/seal/key-switch-avx512.hpp"
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-fma-mod.hpp"
+#include "hexl/eltwise/eltwise-reduce-mod.hpp"
+#include "hexl/eltwise/eltwise-sub-mod.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
+#include "hexl/experimental/seal/hybrid-key-switch.hpp"
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+#include "hexl/logging/logging.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "util/cpu-features.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+//=================================================================
+
+static void BM_KeySwitchMultiplyAccumulateNative(
+    benchmark::State& state) {  //  NOLINT
+  size_t input_size = state.range(0);
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto operand = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto key = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> acc_hi(input_size, 0);
+  AlignedVector64<uint64_t> acc_lo(input_size, 0);
+
+  for (auto _ : state) {
+    internal::KeySwitchMultiplyAccumulateNative(
+        acc_hi.data(), acc_lo.data(), operand.data(), key.data(), input_size);
+  }
+}
+
+BENCHMARK(BM_KeySwitchMultiplyAccumulateNative)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({1024})
+    ->Args({4096})
+    ->Args({16384});
+
+//=================================================================
+
+#ifdef HEXL_HAS_AVX512DQ
+static void BM_KeySwitchMultiplyAccumulateAVX512DQ(
+    benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
+  size_t input_size = state.range(0);
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto operand = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto key = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> acc_hi(input_size, 0);
+  AlignedVector64<uint64_t> acc_lo(input_size, 0);
+
+  for (auto _ : state) {
+    internal::KeySwitchMultiplyAccumulateAVX512<64>(
+        acc_hi.data(), acc_lo.data(), operand.data(), key.data(), input_size);
+  }
+}
+
+BENCHMARK(BM_KeySwitchMultiplyAccumulateAVX512DQ)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({1024})
+    ->Args({4096})
+    ->Args({16384});
+#endif
+
+//=================================================================
+
+#ifdef HEXL_HAS_AVX512IFMA
+static void BM_KeySwitchMultiplyAccumulateAVX512IFMA(
+    benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512ifma) {
+    state.SkipWithError("AVX512IFMA not supported");
+    return;
+  }
+  size_t input_size = state.range(0);
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto operand = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto key = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> acc_hi(input_size, 0);
+  AlignedVector64<uint64_t> acc_lo(input_size, 0);
+
+  for (auto _ : state) {
+    internal::KeySwitchMultiplyAccumulateAVX512<52>(
+        acc_hi.data(), acc_lo.data(), operand.data(), key.data(), input_size);
+  }
+}
+
+BENCHMARK(BM_KeySwitchMultiplyAccumulateAVX512IFMA)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({1024})
+    ->Args({4096})
+    ->Args({16384});
+#endif
+
+//=================================================================
+
+static void BM_KeySwitchReduceNative(benchmark::State& state) {  //  NOLINT
+  size_t input_size = state.range(0);
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto acc_hi = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto acc_lo = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> output(input_size, 0);
+
+  for (auto _ : state) {
+    internal::KeySwitchReduceNative(output.data(), acc_hi.data(),
+                                    acc_lo.data(), input_size, modulus);
+  }
+}
+
+BENCHMARK(BM_KeySwitchReduceNative)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({1024})
+    ->Args({4096})
+    ->Args({16384});
+
+//=================================================================
+
+#ifdef HEXL_HAS_AVX512DQ
+static void BM_KeySwitchReduceAVX512DQ(benchmark::State& state) {  //  NOLINT
+  if (!GetCpuFeatures().avx512dq) {
+    state.SkipWithError("AVX512DQ not supported");
+    return;
+  }
+  size_t input_size = state.range(0);
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto acc_hi = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto acc_lo = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> output(input_size, 0);
+
+  for (auto _ : state) {
+    internal::KeySwitchReduceAVX512<64>(output.data(), acc_hi.data(),
+                                        acc_lo.data(), input_size, modulus);
+  }
+}
+
+BENCHMARK(BM_KeySwitchReduceAVX512DQ)
+    ->Unit(benchmark::kMicrosecond)
+    ->Args({1024})
+    ->Args({4096})
+    ->Args({16384});
+#endif
+
+//=================================================================
+
+// state[0] is the degree
+// state[1] is 0 for the native, 1 for the AVX512DQ and 2 for the AVX512IFMA
+// implementation
+static void BM_KeySwitchModDownAccumulate(benchmark::State& state) {  //  NOLINT
+  size_t input_size = state.range(0);
+  size_t implementation = state.range(1);
+  if ((implementation == 1 && !GetCpuFeatures().avx512dq) ||
+      (implementation == 2 && !GetCpuFeatures().avx512ifma)) {
+    state.SkipWithError("Implementation not supported");
+    return;
+  }
+  uint64_t modulus = GeneratePrimes(1, 49, true, input_size)[0];
+
+  auto operand = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto special =
+      GenerateInsecureUniformRandomValues(input_size, 0, 4 * modulus);
+  auto output = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  uint64_t factor = GenerateInsecureUniformRandomValue(0, modulus);
+
+  for (auto _ : state) {
+    if (implementation == 0) {
+      internal::KeySwitchModDownAccumulateNative(output.data(), operand.data(),
+                                                 special.data(), input_size,
+                                                 modulus, factor);
+    }
+#ifdef HEXL_HAS_AVX512DQ
+    if (implementation == 1) {
+      internal::KeySwitchModDownAccumulateAVX512<64>(
+          output.data(), operand.data(), special.data(), input_size, modulus,
+          factor);
+    }
+#endif
+#ifdef HEXL_HAS_AVX512IFMA
+    if (implementation == 2) {
+      internal::KeySwitchModDownAccumulateAVX512<52>(
+          output.data(), operand.data(), special.data(), input_size, modulus,
+          factor);
+    }
+#endif
+  }
+}
+
+BENCHMARK(BM_KeySwitchModDownAccumulate)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{1024, 4096, 16384}, {0, 1, 2}});
+
+//=================================================================
+
+// state[0] is the degree
+// state[1] is whether to use the fused ModDown passes, rather than the
+// separate element-wise operations they replace
+static void BM_KeySwitchModDown(benchmark::State& state) {  //  NOLINT
+  size_t input_size = state.range(0);
+  bool fused = state.range(1);
+  std::vector<uint64_t> moduli = GeneratePrimes(2, 49, true, input_size);
+  uint64_t modulus = moduli[0];
+  uint64_t special_modulus = moduli[1];
+  uint64_t half = special_modulus >> 1;
+  NTT ntt(input_size, modulus);
+
+  auto special =
+      GenerateInsecureUniformRandomValues(input_size, 0, special_modulus);
+  auto operand = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  auto output = GenerateInsecureUniformRandomValues(input_size, 0, modulus);
+  AlignedVector64<uint64_t> t_ntt(input_size, 0);
+  AlignedVector64<uint64_t> t_diff(input_size, 0);
+  uint64_t factor = InverseMod(special_modulus % modulus, modulus);
+
+  for (auto _ : state) {
+    if (fused) {
+      internal::KeySwitchModDownPrepare(t_ntt.data(), special.data(),
+                                        input_size, special_modulus, modulus);
+      ntt.ComputeForward(t_ntt.data(), t_ntt.data(), 4, 4);
+      internal::KeySwitchModDownAccumulate(output.data(), operand.data(),
+                                           t_ntt.data(), input_size, modulus,
+                                           factor);
+    } else {
+      EltwiseAddMod(t_ntt.data(), special.data(), half, input_size,
+                    special_modulus);
+      EltwiseReduceMod(t_ntt.data(), t_ntt.data(), input_size, modulus,
+                       modulus, 1);
+      EltwiseSubMod(t_ntt.data(), t_ntt.data(), half % modulus, input_size,
+                    modulus);
+      ntt.ComputeForward(t_ntt.data(), t_ntt.data(), 1, 1);
+      EltwiseSubMod(t_diff.data(), operand.data(), t_ntt.data(), input_size,
+                    modulus);
+      EltwiseFMAMod(output.data(), t_diff.data(), factor, output.data(),
+                    input_size, modulus, 1);
+    }
+  }
+}
+
+BENCHMARK(BM_KeySwitchModDown)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {0, 1}});
+
+//=================================================================
+
+// state[0] is the degree
+// state[1] is the number of decomposition moduli
+// state[2] is the bit size of the moduli
+static void BM_KeySwitch(benchmark::State& state) {  //  NOLINT
+  size_t coeff_count = state.range(0);
+  size_t decomp_modulus_size = state.range(1);
+  size_t modulus_bits = state.range(2);
+  size_t num_threads = state.range(3);
+  bool precompute_ntt = state.range(4);
+  size_t key_modulus_size = decomp_modulus_size + 1;
+  size_t rns_modulus_size = decomp_modulus_size + 1;
+  size_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(key_modulus_size, modulus_bits, true, coeff_count);
+  uint64_t special_modulus = moduli.back();
+
+  std::vector<uint64_t> modswitch_factors(decomp_modulus_size);
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors[i] =
+        InverseMod(special_modulus % moduli[i], moduli[i]);
+  }
+
+  std::vector<AlignedVector64<uint64_t>> keys;
+  std::vector<const uint64_t*> key_ptrs;
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    AlignedVector64<uint64_t> key(
+        key_component_count * key_modulus_size * coeff_count, 0);
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto values =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[m]);
+        std::copy(values.begin(), values.end(),
+                  &key[(k * key_modulus_size + m) * coeff_count]);
+      }
+    }
+    keys.push_back(key);
+  }
+  for (const auto& key : keys) {
+    key_ptrs.push_back(key.data());
+  }
+
+  AlignedVector64<uint64_t> input(decomp_modulus_size * coeff_count, 0);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    auto values =
+        GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[j]);
+    std::copy(values.begin(), values.end(), &input[j * coeff_count]);
+  }
+  AlignedVector64<uint64_t> output(
+      key_component_count * decomp_modulus_size * coeff_count, 0);
+
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(coeff_count, moduli[m]);
+  }
+
+  ThreadExecutor executor(num_threads);
+  AlignedVector64<uint64_t> workspace(
+      KeySwitchWorkspaceSize(coeff_count, decomp_modulus_size, rns_modulus_size,
+                             key_component_count, &executor),
+      0);
+  for (auto _ : state) {
+    if (precompute_ntt) {
+      KeySwitch(output.data(), input.data(), coeff_count, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts,
+                &executor, workspace.data());
+    } else {
+      KeySwitch(output.data(), input.data(), coeff_count, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+                nullptr, &executor);
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of decomposition moduli
+// state[2] is the modulus bit size
+// state[3] is the number of threads
+// state[4] is whether to use pre-computed NTTs and workspace
+BENCHMARK(BM_KeySwitch)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->ArgsProduct({{4096, 16384}, {3, 7}, {49, 59}, {1, 4}, {0, 1}});
+
+//=================================================================
+
+static void BM_KeySwitchBatch(benchmark::State& state) {  //  NOLINT
+  size_t coeff_count = state.range(0);
+  size_t decomp_modulus_size = state.range(1);
+  size_t batch_size = state.range(2);
+  bool batched = state.range(3);
+  size_t key_modulus_size = decomp_modulus_size + 1;
+  size_t rns_modulus_size = decomp_modulus_size + 1;
+  size_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(key_modulus_size, 50, true, coeff_count);
+  uint64_t special_modulus = moduli.back();
+
+  std::vector<uint64_t> modswitch_factors(decomp_modulus_size);
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors[i] =
+        InverseMod(special_modulus % moduli[i], moduli[i]);
+  }
+
+  std::vector<AlignedVector64<uint64_t>> keys;
+  std::vector<const uint64_t*> key_ptrs;
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    AlignedVector64<uint64_t> key(
+        key_component_count * key_modulus_size * coeff_count, 0);
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto values =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[m]);
+        std::copy(values.begin(), values.end(),
+                  &key[(k * key_modulus_size + m) * coeff_count]);
+      }
+    }
+    keys.push_back(key);
+  }
+  for (const auto& key : keys) {
+    key_ptrs.push_back(key.data());
+  }
+
+  std::vector<AlignedVector64<uint64_t>> inputs;
+  std::vector<AlignedVector64<uint64_t>> outputs;
+  for (size_t b = 0; b < batch_size; ++b) {
+    AlignedVector64<uint64_t> input(decomp_modulus_size * coeff_count, 0);
+    for (size_t j = 0; j < decomp_modulus_size; ++j) {
+      auto values =
+          GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[j]);
+      std::copy(values.begin(), values.end(), &input[j * coeff_count]);
+    }
+    inputs.push_back(input);
+    outputs.emplace_back(
+        key_component_count * decomp_modulus_size * coeff_count, 0);
+  }
+  std::vector<const uint64_t*> input_ptrs;
+  std::vector<uint64_t*> output_ptrs;
+  for (size_t b = 0; b < batch_size; ++b) {
+    input_ptrs.push_back(inputs[b].data());
+    output_ptrs.push_back(outputs[b].data());
+  }
+
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(coeff_count, moduli[m]);
+  }
+
+  AlignedVector64<uint64_t> workspace(
+      KeySwitchBatchWorkspaceSize(coeff_count, decomp_modulus_size,
+                                  rns_modulus_size, key_component_count,
+                                  batch_size),
+      0);
+  for (auto _ : state) {
+    if (batched) {
+      KeySwitchBatch(output_ptrs.data(), input_ptrs.data(), batch_size,
+                     coeff_count, decomp_modulus_size, key_modulus_size,
+                     rns_modulus_size, key_component_count, moduli.data(),
+                     key_ptrs.data(), modswitch_factors.data(), ntts, nullptr,
+                     workspace.data());
+    } else {
+      for (size_t b = 0; b < batch_size; ++b) {
+        KeySwitch(output_ptrs[b], input_ptrs[b], coeff_count,
+                  decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                  key_component_count, moduli.data(), key_ptrs.data(),
+                  modswitch_factors.data(), ntts, nullptr, workspace.data());
+      }
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of decomposition moduli
+// state[2] is the number of ciphertexts
+// state[3] is whether to use KeySwitchBatch rather than one KeySwitch per
+// ciphertext
+BENCHMARK(BM_KeySwitchBatch)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({{16384, 32768}, {7, 15}, {8, 32}, {0, 1}});
+
+//=================================================================
+
+static void BM_KeySwitchKeyStorage(benchmark::State& state) {  //  NOLINT
+  size_t coeff_count = state.range(0);
+  size_t decomp_modulus_size = state.range(1);
+  size_t key_storage = state.range(2);
+  size_t key_modulus_size = decomp_modulus_size + 1;
+  size_t rns_modulus_size = decomp_modulus_size + 1;
+  size_t key_component_count = 2;
+  uint64_t seed[CompactKeySwitchKey::kSeedSize] = {1, 2, 3, 4};
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(key_modulus_size, 50, true, coeff_count);
+  uint64_t special_modulus = moduli.back();
+
+  std::vector<uint64_t> modswitch_factors(decomp_modulus_size);
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors[i] =
+        InverseMod(special_modulus % moduli[i], moduli[i]);
+  }
+
+  std::vector<AlignedVector64<uint64_t>> keys;
+  std::vector<const uint64_t*> key_ptrs;
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    AlignedVector64<uint64_t> key(
+        key_component_count * key_modulus_size * coeff_count, 0);
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto values =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[m]);
+        std::copy(values.begin(), values.end(),
+                  &key[(k * key_modulus_size + m) * coeff_count]);
+      }
+    }
+    keys.push_back(key);
+  }
+  for (const auto& key : keys) {
+    key_ptrs.push_back(key.data());
+  }
+  CompactKeySwitchKey compact_key(coeff_count, moduli, decomp_modulus_size,
+                                  key_component_count,
+                                  key_storage == 2 ? seed : nullptr);
+  compact_key.SetKeys(key_ptrs.data());
+  PreparedKeySwitchKey prepared_key(key_ptrs.data(), coeff_count,
+                                    decomp_modulus_size, key_modulus_size,
+                                    key_component_count, key_storage == 4);
+
+  AlignedVector64<uint64_t> input(decomp_modulus_size * coeff_count, 0);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    auto values =
+        GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[j]);
+    std::copy(values.begin(), values.end(), &input[j * coeff_count]);
+  }
+  AlignedVector64<uint64_t> output(
+      key_component_count * decomp_modulus_size * coeff_count, 0);
+
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(coeff_count, moduli[m]);
+  }
+  AlignedVector64<uint64_t> workspace(
+      KeySwitchWorkspaceSize(coeff_count, decomp_modulus_size,
+                             rns_modulus_size, key_component_count),
+      0);
+
+  for (auto _ : state) {
+    if (key_storage == 0) {
+      KeySwitch(output.data(), input.data(), coeff_count, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts,
+                nullptr, workspace.data());
+    } else if (key_storage <= 2) {
+      KeySwitch(output.data(), input.data(), coeff_count, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), compact_key, modswitch_factors.data(), ntts,
+                nullptr, workspace.data());
+    } else {
+      KeySwitch(output.data(), input.data(), coeff_count, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), prepared_key, modswitch_factors.data(), ntts,
+                nullptr, workspace.data());
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of decomposition moduli
+// state[2] is 0 for keys in the KeySwitch layout, 1 for bit-packed keys, 2
+// for bit-packed keys with a seeded uniform component, 3 for prepared keys and
+// 4 for prepared keys on huge pages
+BENCHMARK(BM_KeySwitchKeyStorage)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({{16384}, {7, 15}, {0, 1, 2, 3, 4}});
+
+//=================================================================
+
+static void BM_KeySwitchHoisted(benchmark::State& state) {  //  NOLINT
+  size_t coeff_count = state.range(0);
+  size_t decomp_modulus_size = state.range(1);
+  size_t num_rotations = state.range(2);
+  bool hoisted = state.range(3);
+  size_t key_modulus_size = decomp_modulus_size + 1;
+  size_t rns_modulus_size = decomp_modulus_size + 1;
+  size_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(key_modulus_size, 50, true, coeff_count);
+  uint64_t special_modulus = moduli.back();
+
+  std::vector<uint64_t> modswitch_factors(decomp_modulus_size);
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors[i] =
+        InverseMod(special_modulus % moduli[i], moduli[i]);
+  }
+
+  // The same key serves for every Galois element; only the access pattern
+  // matters here
+  std::vector<AlignedVector64<uint64_t>> keys;
+  std::vector<const uint64_t*> key_ptrs;
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    AlignedVector64<uint64_t> key(
+        key_component_count * key_modulus_size * coeff_count, 0);
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto values =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[m]);
+        std::copy(values.begin(), values.end(),
+                  &key[(k * key_modulus_size + m) * coeff_count]);
+      }
+    }
+    keys.push_back(key);
+  }
+  for (const auto& key : keys) {
+    key_ptrs.push_back(key.data());
+  }
+  std::vector<const uint64_t**> key_set_ptrs(num_rotations, key_ptrs.data());
+
+  std::vector<uint64_t> galois_elts(num_rotations);
+  for (size_t r = 0; r < num_rotations; ++r) {
+    galois_elts[r] = PowMod(5, r + 1, 2 * coeff_count);
+  }
+
+  AlignedVector64<uint64_t> input(decomp_modulus_size * coeff_count, 0);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    auto values =
+        GenerateInsecureUniformRandomValues(coeff_count, 0, moduli[j]);
+    std::copy(values.begin(), values.end(), &input[j * coeff_count]);
+  }
+  AlignedVector64<uint64_t> rotated_input(input.size(), 0);
+  std::vector<AlignedVector64<uint64_t>> outputs(
+      num_rotations, AlignedVector64<uint64_t>(
+                         key_component_count * decomp_modulus_size *
+                             coeff_count,
+                         0));
+  std::vector<uint64_t*> output_ptrs;
+  for (auto& output : outputs) {
+    output_ptrs.push_back(output.data());
+  }
+
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(coeff_count, moduli[m]);
+  }
+
+  AlignedVector64<uint64_t> decomposition(KeySwitchDecompositionSize(
+      coeff_count, decomp_modulus_size, rns_modulus_size));
+  AlignedVector64<uint64_t> workspace(
+      std::max(KeySwitchHoistedWorkspaceSize(coeff_count, rns_modulus_size,
+                                             key_component_count,
+                                             num_rotations),
+               KeySwitchWorkspaceSize(coeff_count, decomp_modulus_size,
+                                      rns_modulus_size, key_component_count)),
+      0);
+
+  for (auto _ : state) {
+    if (hoisted) {
+      KeySwitchDecompose(decomposition.data(), input.data(), coeff_count,
+                         decomp_modulus_size, key_modulus_size,
+                         rns_modulus_size, moduli.data(), ntts);
+      KeySwitchHoisted(output_ptrs.data(), decomposition.data(),
+                       galois_elts.data(), num_rotations, coeff_count,
+                       decomp_modulus_size, key_modulus_size,
+                       rns_modulus_size, key_component_count, moduli.data(),
+                       key_set_ptrs.data(), modswitch_factors.data(), ntts,
+                       nullptr, workspace.data());
+    } else {
+      for (size_t r = 0; r < num_rotations; ++r) {
+        for (size_t j = 0; j < decomp_modulus_size; ++j) {
+          GaloisPermuteNTT(&rotated_input[j * coeff_count],
+                           &input[j * coeff_count], coeff_count,
+                           galois_elts[r]);
+        }
+        KeySwitch(output_ptrs[r], rotated_input.data(), coeff_count,
+                  decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                  key_component_count, moduli.data(), key_ptrs.data(),
+                  modswitch_factors.data(), ntts, nullptr, workspace.data());
+      }
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of decomposition moduli
+// state[2] is the number of rotations of the same ciphertext
+// state[3] is 1 to decompose once and apply hoisted key switching, 0 to key
+// switch each rotated ciphertext separately
+BENCHMARK(BM_KeySwitchHoisted)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({{16384}, {7, 15}, {1, 8, 32}, {0, 1}});
+
+//=================================================================
+
+static void BM_HybridKeySwitch(benchmark::State& state) {  //  NOLINT
+  size_t coeff_count = state.range(0);
+  size_t num_moduli = state.range(1);
+  size_t dnum = state.range(2);
+  size_t num_special_moduli = state.range(3);
+  size_t key_component_count = 2;
+
+  std::vector<uint64_t> primes =
+      GeneratePrimes(num_moduli + num_special_moduli, 50, true, coeff_count);
+  std::vector<uint64_t> ciphertext_moduli(primes.begin(),
+                                          primes.begin() + num_moduli);
+  std::vector<uint64_t> special_moduli(primes.begin() + num_moduli,
+                                       primes.end());
+  HybridKeySwitch ks(coeff_count, ciphertext_moduli, special_moduli, dnum,
+                     KeySwitchScheme::CKKS);
+
+  std::vector<AlignedVector64<uint64_t>> keys;
+  std::vector<const uint64_t*> key_ptrs;
+  for (size_t j = 0; j < ks.NumDigits(num_moduli); ++j) {
+    AlignedVector64<uint64_t> key(
+        key_component_count * ks.KeyModulusSize() * coeff_count, 0);
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < ks.KeyModulusSize(); ++m) {
+        auto values =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, primes[m]);
+        std::copy(values.begin(), values.end(),
+                  &key[(k * ks.KeyModulusSize() + m) * coeff_count]);
+      }
+    }
+    keys.push_back(key);
+  }
+  for (const auto& key : keys) {
+    key_ptrs.push_back(key.data());
+  }
+
+  AlignedVector64<uint64_t> input(num_moduli * coeff_count, 0);
+  for (size_t i = 0; i < num_moduli; ++i) {
+    auto values =
+        GenerateInsecureUniformRandomValues(coeff_count, 0, primes[i]);
+    std::copy(values.begin(), values.end(), &input[i * coeff_count]);
+  }
+  AlignedVector64<uint64_t> output(
+      key_component_count * num_moduli * coeff_count, 0);
+  AlignedVector64<uint64_t> workspace(
+      ks.WorkspaceSize(num_moduli, key_component_count), 0);
+
+  for (auto _ : state) {
+    ks.KeySwitch(output.data(), input.data(), num_moduli, key_component_count,
+                 key_ptrs.data(), nullptr, workspace.data());
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of ciphertext moduli
+// state[2] is the number of digits
+// state[3] is the number of special moduli
+BENCHMARK(BM_HybridKeySwitch)
+    ->Unit(benchmark::kMillisecond)
+    ->Args({16384, 8, 8, 1})
+    ->Args({16384, 8, 4, 2})
+    ->Args({16384, 8, 2, 4})
+    ->Args({16384, 8, 1, 8});
+
+}  // namespace hexl
+}  // namespace intel
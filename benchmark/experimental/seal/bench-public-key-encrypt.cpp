@@ -0,0 +1,116 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/experimental/seal/public-key-encrypt.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+//=================================================================
+
+static void BM_PublicKeyEncrypt(benchmark::State& state) {  //  NOLINT
+  size_t poly_size = state.range(0);
+  size_t num_moduli = state.range(1);
+  size_t modulus_bits = state.range(2);
+  bool fused = state.range(3);
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(num_moduli, modulus_bits, true, poly_size);
+  std::vector<NTT> ntts;
+  for (uint64_t modulus : moduli) {
+    ntts.emplace_back(poly_size, modulus);
+  }
+
+  AlignedVector64<uint64_t> public_key;
+  AlignedVector64<uint64_t> plain;
+  for (size_t k = 0; k < 2; ++k) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(poly_size, 0, modulus);
+      public_key.insert(public_key.end(), values.begin(), values.end());
+      if (k == 0) {
+        plain.insert(plain.end(), values.begin(), values.end());
+      }
+    }
+  }
+  std::vector<std::vector<int64_t>> small(3, std::vector<int64_t>(poly_size));
+  for (auto& poly : small) {
+    auto values = GenerateInsecureUniformRandomValues(poly_size, 0, 3);
+    for (size_t j = 0; j < poly_size; ++j) {
+      poly[j] = static_cast<int64_t>(values[j]) - 1;
+    }
+  }
+
+  size_t rns_size = poly_size * num_moduli;
+  AlignedVector64<uint64_t> result(2 * rns_size);
+  AlignedVector64<uint64_t> workspace(PublicKeyEncryptWorkspaceSize(poly_size));
+  AlignedVector64<uint64_t> u_ntt(rns_size);
+  AlignedVector64<uint64_t> e_ntt(2 * rns_size);
+
+  for (auto _ : state) {
+    if (fused) {
+      PublicKeyEncrypt(result.data(), public_key.data(), small[0].data(),
+                       small[1].data(), small[2].data(), plain.data(),
+                       poly_size, moduli.data(), num_moduli, ntts, nullptr,
+                       workspace.data());
+      continue;
+    }
+    // Each step over all limbs, as with separate HEXL calls
+    for (size_t i = 0; i < num_moduli; ++i) {
+      uint64_t modulus = moduli[i];
+      uint64_t* u_i = u_ntt.data() + i * poly_size;
+      for (size_t j = 0; j < poly_size; ++j) {
+        int64_t x = small[0][j];
+        u_i[j] = static_cast<uint64_t>(x) + ((x < 0) ? modulus : 0);
+      }
+      ntts[i].ComputeForward(u_i, u_i, 1, 1);
+      for (size_t k = 0; k < 2; ++k) {
+        uint64_t* e_i = e_ntt.data() + k * rns_size + i * poly_size;
+        for (size_t j = 0; j < poly_size; ++j) {
+          int64_t x = small[k + 1][j];
+          e_i[j] = static_cast<uint64_t>(x) + ((x < 0) ? modulus : 0);
+        }
+        ntts[i].ComputeForward(e_i, e_i, 1, 1);
+      }
+    }
+    for (size_t k = 0; k < 2; ++k) {
+      for (size_t i = 0; i < num_moduli; ++i) {
+        size_t offset = k * rns_size + i * poly_size;
+        EltwiseMultMod(result.data() + offset, u_ntt.data() + i * poly_size,
+                       public_key.data() + offset, poly_size, moduli[i], 1);
+      }
+    }
+    for (size_t k = 0; k < 2; ++k) {
+      for (size_t i = 0; i < num_moduli; ++i) {
+        size_t offset = k * rns_size + i * poly_size;
+        EltwiseAddMod(result.data() + offset, result.data() + offset,
+                      e_ntt.data() + offset, poly_size, moduli[i]);
+      }
+    }
+    for (size_t i = 0; i < num_moduli; ++i) {
+      size_t offset = i * poly_size;
+      EltwiseAddMod(result.data() + offset, result.data() + offset,
+                    plain.data() + offset, poly_size, moduli[i]);
+    }
+  }
+}
+
+// state[0] is the degree
+// state[1] is the number of moduli
+// state[2] is the number of bits in each modulus
+// state[3] is 0 for separate passes over all limbs, 1 for PublicKeyEncrypt
+BENCHMARK(BM_PublicKeyEncrypt)
+    ->Unit(benchmark::kMicrosecond)
+    ->ArgsProduct({{4096, 16384}, {4, 8}, {40, 60}, {0, 1}});
+
+}  // namespace hexl
+}  // namespace intel
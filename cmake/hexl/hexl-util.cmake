@@ -26,6 +26,45 @@ function(hexl_check_compile_flag SOURCE_FILE OUTPUT_FLAG)
     endif()
 endfunction()
 
+# Checks if SOURCE_FILE can be compiled with ISA_FLAGS, without running it,
+# so the result does not depend on the processor of the build host.
+# If so, adds OUTPUT_FLAG to compile definitions
+function(hexl_check_isa_flag SOURCE_FILE ISA_FLAGS OUTPUT_FLAG)
+    try_compile(${OUTPUT_FLAG}_COMPILES ${CMAKE_BINARY_DIR}
+        "${SOURCE_FILE}"
+        COMPILE_DEFINITIONS ${ISA_FLAGS}
+        OUTPUT_VARIABLE TRY_COMPILE_OUTPUT
+    )
+    # Uncomment below to debug
+    # message("TRY_COMPILE_OUTPUT ${TRY_COMPILE_OUTPUT}")
+    if (${OUTPUT_FLAG}_COMPILES)
+        message(STATUS "Setting ${OUTPUT_FLAG}")
+        add_definitions(-D${OUTPUT_FLAG})
+        set(${OUTPUT_FLAG} 1 PARENT_SCOPE)
+    else()
+        message(STATUS "Compile flag not found: ${OUTPUT_FLAG}")
+    endif()
+endfunction()
+
+# Compiles the given sources with the AVX512 instruction set flags when
+# HEXL_PORTABLE is set. Otherwise, all sources are compiled for the native
+# processor, so no flags are needed
+function(hexl_add_avx512_flags)
+    if (HEXL_PORTABLE AND HEXL_AVX512_FLAGS)
+        set_source_files_properties(${ARGN} PROPERTIES
+            COMPILE_OPTIONS "${HEXL_AVX512_FLAGS}")
+    endif()
+endfunction()
+
+# Compiles the given sources with the AVX512 and AVX512-VBMI2 instruction set
+# flags when HEXL_PORTABLE is set
+function(hexl_add_avx512vbmi2_flags)
+    if (HEXL_PORTABLE AND HEXL_AVX512VBMI2_FLAGS)
+        set_source_files_properties(${ARGN} PROPERTIES
+            COMPILE_OPTIONS "${HEXL_AVX512VBMI2_FLAGS}")
+    endif()
+endfunction()
+
 # Checks the supported compiler versions
 function(hexl_check_compiler_version)
     if("${CMAKE_CXX_COMPILER_ID}" STREQUAL "GNU")
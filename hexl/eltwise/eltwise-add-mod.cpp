@@ -3,12 +3,12 @@
 
 #include "hexl/eltwise/eltwise-add-mod.hpp"
 
-#include "eltwise/eltwise-add-mod-avx512.hpp"
 #include "eltwise/eltwise-add-mod-internal.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -80,15 +80,11 @@ void EltwiseAddMod(uint64_t* result, const uint64_t* operand1,
   HEXL_CHECK_BOUNDS(operand2, n, modulus,
                     "pre-add value in operand2 exceeds bound " << modulus);
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseAddModAVX512(result, operand1, operand2, n, modulus);
-    return;
-  }
-#endif
-
-  HEXL_VLOG(3, "Calling EltwiseAddModNative");
-  EltwiseAddModNative(result, operand1, operand2, n, modulus);
+  KernelTimer timer(Kernel::kEltwiseAddMod, n, &modulus, 1, n,
+                    3 * n * sizeof(uint64_t));
+  const auto& variant = GetDispatchTable().eltwise_add_mod.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, operand2, n, modulus);
 }
 
 void EltwiseAddMod(uint64_t* result, const uint64_t* operand1,
@@ -101,15 +97,12 @@ void EltwiseAddMod(uint64_t* result, const uint64_t* operand1,
                     "pre-add value in operand1 exceeds bound " << modulus);
   HEXL_CHECK(operand2 < modulus, "Require operand2 < modulus");
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseAddModAVX512(result, operand1, operand2, n, modulus);
-    return;
-  }
-#endif
-
-  HEXL_VLOG(3, "Calling EltwiseAddModNative");
-  EltwiseAddModNative(result, operand1, operand2, n, modulus);
+  KernelTimer timer(Kernel::kEltwiseAddMod, n, &modulus, 1, n,
+                    2 * n * sizeof(uint64_t));
+  const auto& variant =
+      GetDispatchTable().eltwise_add_mod_scalar.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, operand2, n, modulus);
 }
 
 }  // namespace hexl
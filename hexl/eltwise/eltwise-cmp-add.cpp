@@ -3,12 +3,12 @@
 
 #include "hexl/eltwise/eltwise-cmp-add.hpp"
 
-#include "eltwise/eltwise-cmp-add-avx512.hpp"
 #include "eltwise/eltwise-cmp-add-internal.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -20,13 +20,11 @@ void EltwiseCmpAdd(uint64_t* result, const uint64_t* operand1, uint64_t n,
   HEXL_CHECK(n != 0, "Require n != 0");
   HEXL_CHECK(diff != 0, "Require diff != 0");
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseCmpAddAVX512(result, operand1, n, cmp, bound, diff);
-    return;
-  }
-#endif
-  EltwiseCmpAddNative(result, operand1, n, cmp, bound, diff);
+  KernelTimer timer(Kernel::kEltwiseCmpAdd, n, nullptr, 1, n,
+                    2 * n * sizeof(uint64_t));
+  const auto& variant = GetDispatchTable().eltwise_cmp_add.Select(0);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, n, cmp, bound, diff);
 }
 
 void EltwiseCmpAddNative(uint64_t* result, const uint64_t* operand1, uint64_t n,
@@ -81,6 +81,21 @@ void EltwiseCmpSubModAVX512(uint64_t* result, const uint64_t* operand1,
     ++v_result_ptr;
   }
 }
+
+// Instantiated in eltwise-cmp-sub-mod-avx512.cpp, so callers need not be
+// compiled for AVX512
+extern template void EltwiseCmpSubModAVX512<64>(uint64_t* result,
+                                                const uint64_t* operand1,
+                                                uint64_t n, uint64_t modulus,
+                                                CMPINT cmp, uint64_t bound,
+                                                uint64_t diff);
+#ifdef HEXL_HAS_AVX512IFMA
+extern template void EltwiseCmpSubModAVX512<52>(uint64_t* result,
+                                                const uint64_t* operand1,
+                                                uint64_t n, uint64_t modulus,
+                                                CMPINT cmp, uint64_t bound,
+                                                uint64_t diff);
+#endif
 #endif
 
 }  // namespace hexl
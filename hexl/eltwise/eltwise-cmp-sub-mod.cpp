@@ -9,7 +9,8 @@
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/check.hpp"
 #include "hexl/util/util.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 #include "util/util-internal.hpp"
 
 namespace intel {
@@ -24,20 +25,12 @@ void EltwiseCmpSubMod(uint64_t* result, const uint64_t* operand1, uint64_t n,
   HEXL_CHECK(modulus > 1, "Require modulus > 1");
   HEXL_CHECK(diff != 0, "Require diff != 0");
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    if (modulus < (1ULL << 52)) {
-      EltwiseCmpSubModAVX512<52>(result, operand1, n, modulus, cmp, bound,
-                                 diff);
-    } else {
-      EltwiseCmpSubModAVX512<64>(result, operand1, n, modulus, cmp, bound,
-                                 diff);
-    }
-    return;
-  }
-#endif
-  EltwiseCmpSubModNative(result, operand1, n, modulus, cmp, bound, diff);
-  return;
+  KernelTimer timer(Kernel::kEltwiseCmpSubMod, n, &modulus, 1, n,
+                    2 * n * sizeof(uint64_t));
+
+  const auto& variant = GetDispatchTable().eltwise_cmp_sub_mod.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, n, modulus, cmp, bound, diff);
 }
 
 void EltwiseCmpSubModNative(uint64_t* result, const uint64_t* operand1,
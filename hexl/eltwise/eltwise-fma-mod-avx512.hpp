@@ -16,6 +16,13 @@ template <int BitShift, int InputModFactor>
 void EltwiseFMAModAVX512(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
                          const uint64_t* arg3, uint64_t n, uint64_t modulus);
 
+/// @brief EltwiseFMAModAVX512 for an input_mod_factor of 1, 2, 4 or 8 given
+/// at runtime
+template <int BitShift>
+void EltwiseFMAModAVX512(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
+                         const uint64_t* arg3, uint64_t n, uint64_t modulus,
+                         uint64_t input_mod_factor);
+
 #endif
 
 }  // namespace hexl
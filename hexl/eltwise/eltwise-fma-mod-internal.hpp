@@ -38,5 +38,11 @@ void EltwiseFMAModNative(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
   }
 }
 
+/// @brief EltwiseFMAModNative for an input_mod_factor of 1, 2, 4 or 8 given
+/// at runtime
+void EltwiseFMAModNative(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
+                         const uint64_t* arg3, uint64_t n, uint64_t modulus,
+                         uint64_t input_mod_factor);
+
 }  // namespace hexl
 }  // namespace intel
@@ -9,7 +9,8 @@
 #include "eltwise/eltwise-fma-mod-internal.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -39,50 +40,19 @@ void EltwiseFMAMod(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
              "arg3 value in EltwiseFMAMod exceeds bound "
                  << (input_mod_factor * modulus));
 
-#ifdef HEXL_HAS_AVX512IFMA
-  if (has_avx512ifma && input_mod_factor * modulus < (1ULL << 52)) {
-    HEXL_VLOG(3, "Calling 52-bit EltwiseFMAModAVX512");
-
-    switch (input_mod_factor) {
-      case 1:
-        EltwiseFMAModAVX512<52, 1>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 2:
-        EltwiseFMAModAVX512<52, 2>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 4:
-        EltwiseFMAModAVX512<52, 4>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 8:
-        EltwiseFMAModAVX512<52, 8>(result, arg1, arg2, arg3, n, modulus);
-        break;
-    }
-    return;
-  }
-#endif
+  uint64_t num_operands = (arg3 == nullptr) ? 2 : 3;
+  KernelTimer timer(Kernel::kEltwiseFMAMod, n, &modulus, 1, n,
+                    num_operands * n * sizeof(uint64_t));
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    HEXL_VLOG(3, "Calling 64-bit EltwiseFMAModAVX512");
-
-    switch (input_mod_factor) {
-      case 1:
-        EltwiseFMAModAVX512<64, 1>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 2:
-        EltwiseFMAModAVX512<64, 2>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 4:
-        EltwiseFMAModAVX512<64, 4>(result, arg1, arg2, arg3, n, modulus);
-        break;
-      case 8:
-        EltwiseFMAModAVX512<64, 8>(result, arg1, arg2, arg3, n, modulus);
-        break;
-    }
-    return;
-  }
-#endif
+  const auto& variant =
+      GetDispatchTable().eltwise_fma_mod.Select(input_mod_factor * modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, arg1, arg2, arg3, n, modulus, input_mod_factor);
+}
 
+void EltwiseFMAModNative(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
+                         const uint64_t* arg3, uint64_t n, uint64_t modulus,
+                         uint64_t input_mod_factor) {
   HEXL_VLOG(3, "Calling EltwiseFMAModNative");
   switch (input_mod_factor) {
     case 1:
@@ -100,5 +70,40 @@ void EltwiseFMAMod(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
   }
 }
 
+#ifdef HEXL_HAS_AVX512DQ
+template <int BitShift>
+void EltwiseFMAModAVX512(uint64_t* result, const uint64_t* arg1, uint64_t arg2,
+                         const uint64_t* arg3, uint64_t n, uint64_t modulus,
+                         uint64_t input_mod_factor) {
+  HEXL_VLOG(3, "Calling " << BitShift << "-bit EltwiseFMAModAVX512");
+  switch (input_mod_factor) {
+    case 1:
+      EltwiseFMAModAVX512<BitShift, 1>(result, arg1, arg2, arg3, n, modulus);
+      break;
+    case 2:
+      EltwiseFMAModAVX512<BitShift, 2>(result, arg1, arg2, arg3, n, modulus);
+      break;
+    case 4:
+      EltwiseFMAModAVX512<BitShift, 4>(result, arg1, arg2, arg3, n, modulus);
+      break;
+    case 8:
+      EltwiseFMAModAVX512<BitShift, 8>(result, arg1, arg2, arg3, n, modulus);
+      break;
+  }
+}
+
+template void EltwiseFMAModAVX512<64>(uint64_t* result, const uint64_t* arg1,
+                                      uint64_t arg2, const uint64_t* arg3,
+                                      uint64_t n, uint64_t modulus,
+                                      uint64_t input_mod_factor);
+#endif
+
+#ifdef HEXL_HAS_AVX512IFMA
+template void EltwiseFMAModAVX512<52>(uint64_t* result, const uint64_t* arg1,
+                                      uint64_t arg2, const uint64_t* arg3,
+                                      uint64_t n, uint64_t modulus,
+                                      uint64_t input_mod_factor);
+#endif
+
 }  // namespace hexl
 }  // namespace intel
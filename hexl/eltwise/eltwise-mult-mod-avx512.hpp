@@ -48,8 +48,9 @@ void EltwiseMultModAVX512IFMAInt(uint64_t* result, const uint64_t* operand1,
 /// modulus for i=0, ..., \p n - 1
 /// @details Barrett's algorithm for vector-vector modular multiplication
 /// (Algorithm 1 from https://hal.archives-ouvertes.fr/hal-01215845/document)
-/// using AVX512DQ
-template <int InputModFactor>
+/// using AVX512DQ. If \p UseVBMI2, the products are shifted with AVX512-VBMI2
+/// instructions
+template <int InputModFactor, bool UseVBMI2 = false>
 void EltwiseMultModAVX512DQInt(uint64_t* result, const uint64_t* operand1,
                                const uint64_t* operand2, uint64_t n,
                                uint64_t modulus);
@@ -75,6 +76,26 @@ void EltwiseMultModAVX512Float(uint64_t* result, const uint64_t* operand1,
                                const uint64_t* operand2, uint64_t n,
                                uint64_t modulus);
 
+/// @brief EltwiseMultModAVX512Float for an input_mod_factor of 1, 2 or 4 given
+/// at runtime
+void EltwiseMultModAVX512Float(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t modulus, uint64_t input_mod_factor);
+
+/// @brief EltwiseMultModAVX512DQInt for an input_mod_factor of 1, 2 or 4 given
+/// at runtime
+void EltwiseMultModAVX512DQInt(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t modulus, uint64_t input_mod_factor);
+
+#ifdef HEXL_HAS_AVX512VBMI2
+/// @brief EltwiseMultModAVX512DQInt with AVX512-VBMI2 instructions, for an
+/// input_mod_factor of 1, 2 or 4 given at runtime
+void EltwiseMultModAVX512VBMI2Int(uint64_t* result, const uint64_t* operand1,
+                                  const uint64_t* operand2, uint64_t n,
+                                  uint64_t modulus, uint64_t input_mod_factor);
+#endif
+
 #endif  // HEXL_HAS_AVX512DQ
 
 }  // namespace hexl
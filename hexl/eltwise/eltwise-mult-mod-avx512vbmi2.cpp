@@ -0,0 +1,31 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdint.h>
+
+#include "eltwise/eltwise-mult-mod-avx512.hpp"
+#include "eltwise/eltwise-mult-mod-avx512dq-int.hpp"
+#include "hexl/util/defines.hpp"
+
+namespace intel {
+namespace hexl {
+
+#ifdef HEXL_HAS_AVX512VBMI2
+
+template void EltwiseMultModAVX512DQInt<1, true>(uint64_t* result,
+                                                 const uint64_t* operand1,
+                                                 const uint64_t* operand2,
+                                                 uint64_t n, uint64_t modulus);
+template void EltwiseMultModAVX512DQInt<2, true>(uint64_t* result,
+                                                 const uint64_t* operand1,
+                                                 const uint64_t* operand2,
+                                                 uint64_t n, uint64_t modulus);
+template void EltwiseMultModAVX512DQInt<4, true>(uint64_t* result,
+                                                 const uint64_t* operand1,
+                                                 const uint64_t* operand2,
+                                                 uint64_t n, uint64_t modulus);
+
+#endif
+
+}  // namespace hexl
+}  // namespace intel
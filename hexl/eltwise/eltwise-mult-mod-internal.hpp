@@ -100,5 +100,11 @@ void EltwiseMultModNative(uint64_t* result, const uint64_t* operand1,
   }
 }
 
+/// @brief EltwiseMultModNative for an input_mod_factor of 1, 2 or 4 given at
+/// runtime
+void EltwiseMultModNative(uint64_t* result, const uint64_t* operand1,
+                          const uint64_t* operand2, uint64_t n,
+                          uint64_t modulus, uint64_t input_mod_factor);
+
 }  // namespace hexl
 }  // namespace intel
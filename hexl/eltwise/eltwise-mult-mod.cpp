@@ -10,7 +10,8 @@
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -33,40 +34,20 @@ void EltwiseMultMod(uint64_t* result, const uint64_t* operand1,
   HEXL_CHECK_BOUNDS(operand2, n, input_mod_factor * modulus,
                     "operand2 exceeds bound " << (input_mod_factor * modulus))
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    if (modulus < (1ULL << 50)) {
-      // EltwiseMultModAVX512IFMA has similar performance to
-      // EltwiseMultModAVX512Float, but requires the AVX512IFMA instruction set,
-      // so we prefer to use EltwiseMultModAVX512Float.
-      switch (input_mod_factor) {
-        case 1:
-          EltwiseMultModAVX512Float<1>(result, operand1, operand2, n, modulus);
-          break;
-        case 2:
-          EltwiseMultModAVX512Float<2>(result, operand1, operand2, n, modulus);
-          break;
-        case 4:
-          EltwiseMultModAVX512Float<4>(result, operand1, operand2, n, modulus);
-          break;
-      }
-    } else {
-      switch (input_mod_factor) {
-        case 1:
-          EltwiseMultModAVX512DQInt<1>(result, operand1, operand2, n, modulus);
-          break;
-        case 2:
-          EltwiseMultModAVX512DQInt<2>(result, operand1, operand2, n, modulus);
-          break;
-        case 4:
-          EltwiseMultModAVX512DQInt<4>(result, operand1, operand2, n, modulus);
-          break;
-      }
-    }
-    return;
-  }
-#endif
+  KernelTimer timer(Kernel::kEltwiseMultMod, n, &modulus, 1, n,
+                    3 * n * sizeof(uint64_t));
+
+  // EltwiseMultModAVX512IFMAInt has similar performance to
+  // EltwiseMultModAVX512Float, but requires the AVX512IFMA instruction set, so
+  // no backend selects it
+  const auto& variant = GetDispatchTable().eltwise_mult_mod.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, operand2, n, modulus, input_mod_factor);
+}
 
+void EltwiseMultModNative(uint64_t* result, const uint64_t* operand1,
+                          const uint64_t* operand2, uint64_t n,
+                          uint64_t modulus, uint64_t input_mod_factor) {
   HEXL_VLOG(3, "Calling EltwiseMultModNative");
   switch (input_mod_factor) {
     case 1:
@@ -79,7 +60,62 @@ void EltwiseMultMod(uint64_t* result, const uint64_t* operand1,
       EltwiseMultModNative<4>(result, operand1, operand2, n, modulus);
       break;
   }
-  return;
 }
+
+#ifdef HEXL_HAS_AVX512DQ
+void EltwiseMultModAVX512Float(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t modulus, uint64_t input_mod_factor) {
+  switch (input_mod_factor) {
+    case 1:
+      EltwiseMultModAVX512Float<1>(result, operand1, operand2, n, modulus);
+      break;
+    case 2:
+      EltwiseMultModAVX512Float<2>(result, operand1, operand2, n, modulus);
+      break;
+    case 4:
+      EltwiseMultModAVX512Float<4>(result, operand1, operand2, n, modulus);
+      break;
+  }
+}
+
+void EltwiseMultModAVX512DQInt(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t modulus, uint64_t input_mod_factor) {
+  switch (input_mod_factor) {
+    case 1:
+      EltwiseMultModAVX512DQInt<1>(result, operand1, operand2, n, modulus);
+      break;
+    case 2:
+      EltwiseMultModAVX512DQInt<2>(result, operand1, operand2, n, modulus);
+      break;
+    case 4:
+      EltwiseMultModAVX512DQInt<4>(result, operand1, operand2, n, modulus);
+      break;
+  }
+}
+#endif
+
+#ifdef HEXL_HAS_AVX512VBMI2
+void EltwiseMultModAVX512VBMI2Int(uint64_t* result, const uint64_t* operand1,
+                                  const uint64_t* operand2, uint64_t n,
+                                  uint64_t modulus, uint64_t input_mod_factor) {
+  switch (input_mod_factor) {
+    case 1:
+      EltwiseMultModAVX512DQInt<1, true>(result, operand1, operand2, n,
+                                         modulus);
+      break;
+    case 2:
+      EltwiseMultModAVX512DQInt<2, true>(result, operand1, operand2, n,
+                                         modulus);
+      break;
+    case 4:
+      EltwiseMultModAVX512DQInt<4, true>(result, operand1, operand2, n,
+                                         modulus);
+      break;
+  }
+}
+#endif
+
 }  // namespace hexl
 }  // namespace intel
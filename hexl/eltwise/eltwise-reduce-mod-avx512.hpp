@@ -375,6 +375,21 @@ void EltwiseMontgomeryFormOutAVX512(uint64_t* result, const uint64_t* a,
   }
 }
 
+// Instantiated in eltwise-reduce-mod-avx512.cpp, so callers need not be
+// compiled for AVX512
+extern template void EltwiseReduceModAVX512<64>(uint64_t* result,
+                                                const uint64_t* operand,
+                                                uint64_t n, uint64_t modulus,
+                                                uint64_t input_mod_factor,
+                                                uint64_t output_mod_factor);
+#ifdef HEXL_HAS_AVX512IFMA
+extern template void EltwiseReduceModAVX512<52>(uint64_t* result,
+                                                const uint64_t* operand,
+                                                uint64_t n, uint64_t modulus,
+                                                uint64_t input_mod_factor,
+                                                uint64_t output_mod_factor);
+#endif
+
 #endif
 
 }  // namespace hexl
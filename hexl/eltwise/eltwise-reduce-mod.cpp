@@ -8,7 +8,8 @@
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -91,6 +92,9 @@ void EltwiseReduceMod(uint64_t* result, const uint64_t* operand, uint64_t n,
   HEXL_CHECK(output_mod_factor == 1 || output_mod_factor == 2,
              "output_mod_factor must be 1 or 2 " << output_mod_factor);
 
+  KernelTimer timer(Kernel::kEltwiseReduceMod, n, &modulus, 1, n,
+                    2 * n * sizeof(uint64_t));
+
   if (input_mod_factor == output_mod_factor && (operand != result)) {
     for (size_t i = 0; i < n; ++i) {
       result[i] = operand[i];
@@ -98,25 +102,10 @@ void EltwiseReduceMod(uint64_t* result, const uint64_t* operand, uint64_t n,
     return;
   }
 
-#ifdef HEXL_HAS_AVX512IFMA
-  if (has_avx512ifma && modulus < (1ULL << 52)) {
-    EltwiseReduceModAVX512<52>(result, operand, n, modulus, input_mod_factor,
-                               output_mod_factor);
-    return;
-  }
-#endif
-
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseReduceModAVX512<64>(result, operand, n, modulus, input_mod_factor,
-                               output_mod_factor);
-    return;
-  }
-#endif
-
-  HEXL_VLOG(3, "Calling EltwiseReduceModNative");
-  EltwiseReduceModNative(result, operand, n, modulus, input_mod_factor,
-                         output_mod_factor);
+  const auto& variant = GetDispatchTable().eltwise_reduce_mod.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand, n, modulus, input_mod_factor,
+                   output_mod_factor);
 }
 }  // namespace hexl
 }  // namespace intel
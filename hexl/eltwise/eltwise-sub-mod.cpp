@@ -1,13 +1,13 @@
 // Copyright (C) 2020-2021 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 
-#include "eltwise/eltwise-sub-mod-avx512.hpp"
 #include "eltwise/eltwise-sub-mod-internal.hpp"
 #include "hexl/eltwise/eltwise-add-mod.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -76,15 +76,11 @@ void EltwiseSubMod(uint64_t* result, const uint64_t* operand1,
   HEXL_CHECK_BOUNDS(operand2, n, modulus,
                     "pre-sub value in operand2 exceeds bound " << modulus);
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseSubModAVX512(result, operand1, operand2, n, modulus);
-    return;
-  }
-#endif
-
-  HEXL_VLOG(3, "Calling EltwiseSubModNative");
-  EltwiseSubModNative(result, operand1, operand2, n, modulus);
+  KernelTimer timer(Kernel::kEltwiseSubMod, n, &modulus, 1, n,
+                    3 * n * sizeof(uint64_t));
+  const auto& variant = GetDispatchTable().eltwise_sub_mod.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, operand2, n, modulus);
 }
 
 void EltwiseSubMod(uint64_t* result, const uint64_t* operand1,
@@ -97,15 +93,12 @@ void EltwiseSubMod(uint64_t* result, const uint64_t* operand1,
                     "pre-sub value in operand1 exceeds bound " << modulus);
   HEXL_CHECK(operand2 < modulus, "Require operand2 < modulus");
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq) {
-    EltwiseSubModAVX512(result, operand1, operand2, n, modulus);
-    return;
-  }
-#endif
-
-  HEXL_VLOG(3, "Calling EltwiseSubModNative");
-  EltwiseSubModNative(result, operand1, operand2, n, modulus);
+  KernelTimer timer(Kernel::kEltwiseSubMod, n, &modulus, 1, n,
+                    2 * n * sizeof(uint64_t));
+  const auto& variant =
+      GetDispatchTable().eltwise_sub_mod_scalar.Select(modulus);
+  timer.SetBackend(variant.backend);
+  variant.function(result, operand1, operand2, n, modulus);
 }
 
 }  // namespace hexl
@@ -0,0 +1,67 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/misc/diagonal-mat-vec-mult.hpp"
+
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/check.hpp"
+#include "hexl/util/pool-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+// diagonals:       giant_steps x baby_steps x n x num_moduli
+// rotated_ciphers: baby_steps x 2 x n x num_moduli
+//
+// result:          giant_steps x 2 x n x num_moduli
+// [giant_steps x {sum_i d[j][i] .* c[i][0], sum_i d[j][i] .* c[i][1]}].
+uint64_t DiagonalMatrixVectorMultiplyWorkspaceSize(uint64_t n,
+                                                   const Executor* executor) {
+  return NumWorkers(executor) * internal::DyadicMultiplyWorkspaceSize(n);
+}
+
+void DiagonalMatrixVectorMultiply(uint64_t* result, const uint64_t* diagonals,
+                                  const uint64_t* rotated_ciphers, uint64_t n,
+                                  const uint64_t* moduli, uint64_t num_moduli,
+                                  uint64_t baby_steps, uint64_t giant_steps,
+                                  Executor* executor, uint64_t* workspace) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(diagonals != nullptr, "Require diagonals != nullptr");
+  HEXL_CHECK(rotated_ciphers != nullptr, "Require rotated_ciphers != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+  HEXL_CHECK(baby_steps != 0, "Require baby_steps != 0");
+  HEXL_CHECK(giant_steps != 0, "Require giant_steps != 0");
+
+  // pointer increment to switch to a next polynomial
+  size_t poly_size = n * num_moduli;
+
+  // ciphertext increment to switch to the next ciphertext
+  size_t cipher_size = 2 * poly_size;
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(
+        DiagonalMatrixVectorMultiplyWorkspaceSize(n, executor));
+    workspace = owned_workspace.data();
+  }
+  size_t temp_size = internal::DyadicMultiplyWorkspaceSize(n);
+
+  // Each task computes one limb of one inner sum, reading the baby-step
+  // rotations and the diagonals of its giant step once
+  size_t num_tasks = giant_steps * num_moduli;
+  ParallelFor(executor, num_tasks, [&](size_t task, size_t worker) {
+    size_t j = task / num_moduli;
+    size_t i = task % num_moduli;
+    size_t i_times_n = i * n;
+    internal::DiagonalMultiplyAccumulate(
+        result + j * cipher_size + i_times_n,
+        diagonals + j * baby_steps * poly_size + i_times_n,
+        rotated_ciphers + i_times_n, baby_steps, poly_size, cipher_size, n,
+        poly_size, moduli[i], workspace + worker * temp_size);
+  });
+}
+
+}  // namespace hexl
+}  // namespace intel
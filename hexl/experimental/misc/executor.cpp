@@ -0,0 +1,160 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/misc/executor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace intel {
+namespace hexl {
+
+namespace {
+
+// Set while the thread runs a chunk of ThreadPoolExecutor tasks. ParallelFor
+// calls from such a task run inline, since the workers are busy and waiting
+// for them, or for the pool's call lock, would deadlock
+thread_local bool in_pool_task = false;
+
+}  // namespace
+
+ThreadExecutor::ThreadExecutor(size_t num_threads)
+    : m_num_threads(num_threads) {
+  if (m_num_threads == 0) {
+    m_num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+}
+
+ThreadExecutor::~ThreadExecutor() noexcept {}
+
+void ThreadExecutor::ParallelFor(
+    size_t num_tasks,
+    const std::function<void(size_t task, size_t worker)>& task) {
+  size_t num_workers = std::min(m_num_threads, num_tasks);
+  if (num_workers <= 1 || in_pool_task) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+
+  std::call_once(m_pool_started, [this] {
+    m_pool.reset(new ThreadPoolExecutor(m_num_threads));
+  });
+  m_pool->ParallelFor(num_tasks, task);
+}
+
+ThreadPoolExecutor::ThreadPoolExecutor(size_t num_threads)
+    : m_num_threads(num_threads) {
+  if (m_num_threads == 0) {
+    m_num_threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  m_errors.resize(m_num_threads);
+  m_threads.reserve(m_num_threads - 1);
+  for (size_t worker = 1; worker < m_num_threads; ++worker) {
+    m_threads.emplace_back(&ThreadPoolExecutor::WorkerLoop, this, worker);
+  }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void ThreadPoolExecutor::RunChunk(size_t worker) {
+  size_t begin = worker * m_num_tasks / m_num_workers;
+  size_t end = (worker + 1) * m_num_tasks / m_num_workers;
+  bool was_in_pool_task = in_pool_task;
+  in_pool_task = true;
+  try {
+    for (size_t i = begin; i < end; ++i) {
+      (*m_task)(i, worker);
+    }
+  } catch (...) {
+    m_errors[worker] = std::current_exception();
+  }
+  in_pool_task = was_in_pool_task;
+}
+
+void ThreadPoolExecutor::WorkerLoop(size_t worker) {
+  uint64_t generation = 0;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+    if (m_stop) {
+      return;
+    }
+    generation = m_generation;
+    // Workers beyond the number of chunks sit out this call
+    if (worker >= m_num_workers) {
+      continue;
+    }
+    lock.unlock();
+    RunChunk(worker);
+    lock.lock();
+    if (--m_pending == 0) {
+      m_done.notify_one();
+    }
+  }
+}
+
+void ThreadPoolExecutor::ParallelFor(
+    size_t num_tasks,
+    const std::function<void(size_t task, size_t worker)>& task) {
+  size_t num_workers = std::min(m_num_threads, num_tasks);
+  if (num_workers <= 1 || in_pool_task) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> call_lock(m_call_mutex);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_num_tasks = num_tasks;
+    m_num_workers = num_workers;
+    m_pending = num_workers - 1;
+    std::fill(m_errors.begin(), m_errors.end(), nullptr);
+    ++m_generation;
+  }
+  m_start.notify_all();
+
+  RunChunk(0);
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_pending == 0; });
+    m_task = nullptr;
+  }
+
+  for (const auto& error : m_errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+void ParallelFor(Executor* executor, size_t num_tasks,
+                 const std::function<void(size_t task, size_t worker)>& task) {
+  if (executor == nullptr) {
+    for (size_t i = 0; i < num_tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+  executor->ParallelFor(num_tasks, task);
+}
+
+}  // namespace hexl
+}  // namespace intel
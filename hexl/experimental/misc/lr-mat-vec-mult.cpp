@@ -7,10 +7,11 @@
 
 #include "hexl/eltwise/eltwise-add-mod.hpp"
 #include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "hexl/util/pool-allocator.hpp"
 
 namespace intel {
 namespace hexl {
@@ -20,18 +21,32 @@ namespace hexl {
 //
 // results:  num_weights x 3 x n x num_moduli
 // [num_weights x {x[0].*y[0], x[0].*y[1]+x[1].*y[0], x[1].*y[1]} x num_moduli].
-// TODO(@fdiasmor): Ideally, the size of results can be optimized to [3 x n x
-// num_moduli].
+// LinRegMatrixVectorMultiplyAccumulate below only produces the sum, with
+// results of size [3 x n x num_moduli].
 void LinRegMatrixVectorMultiply(uint64_t* result, const uint64_t* operand1,
                                 const uint64_t* operand2, uint64_t n,
                                 const uint64_t* moduli, uint64_t num_moduli,
                                 uint64_t num_weights) {
+  LinRegMatrixVectorMultiply(result, operand1, operand2, n, moduli, num_moduli,
+                             num_weights, nullptr);
+}
+
+uint64_t LinRegMatrixVectorMultiplyWorkspaceSize(uint64_t n,
+                                                 const Executor* executor) {
+  return NumWorkers(executor) * n;
+}
+
+void LinRegMatrixVectorMultiply(uint64_t* result, const uint64_t* operand1,
+                                const uint64_t* operand2, uint64_t n,
+                                const uint64_t* moduli, uint64_t num_moduli,
+                                uint64_t num_weights, uint64_t* workspace,
+                                Executor* executor) {
   HEXL_CHECK(result != nullptr, "Require result != nullptr");
   HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
   HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
   HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
   HEXL_CHECK(n != 0, "Require n != 0");
-  HEXL_CHECK(num_weights != 0, "Require n != 0");
+  HEXL_CHECK(num_weights != 0, "Require num_weights != 0");
 
   // pointer increment to switch to a next polynomial
   size_t poly_size = n * num_moduli;
@@ -42,107 +57,96 @@ void LinRegMatrixVectorMultiply(uint64_t* result, const uint64_t* operand1,
   // ciphertext output increment to switch to the next output
   size_t output_size = 3 * poly_size;
 
-  AlignedVector64<uint64_t> temp(n, 0);
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(
+        LinRegMatrixVectorMultiplyWorkspaceSize(n, executor));
+    workspace = owned_workspace.data();
+  }
+
+  // Each task computes one limb of the product of one row, with the worker's
+  // own temporary polynomial
+  size_t num_product_tasks = num_weights * num_moduli;
+  ParallelFor(executor, num_product_tasks, [&](size_t task, size_t worker) {
+    size_t r = task / num_moduli;
+    size_t i = task % num_moduli;
+    uint64_t* temp = workspace + worker * n;
 
-  for (size_t r = 0; r < num_weights; r++) {
     size_t next_output = r * output_size;
     size_t next_poly_pair = r * cipher_size;
     uint64_t* cipher2 = result + next_output;
     const uint64_t* cipher0 = operand1 + next_poly_pair;
     const uint64_t* cipher1 = operand2 + next_poly_pair;
 
-    for (size_t i = 0; i < num_moduli; i++) {
-      size_t i_times_n = i * n;
-      size_t poly0_offset = i_times_n;
-      size_t poly1_offset = poly0_offset + poly_size;
-      size_t poly2_offset = poly0_offset + 2 * poly_size;
-
-      // Output ciphertext has 3 polynomials, where x, y are the input
-      // ciphertexts: (x[0] * y[0], x[0] * y[1] + x[1] * y[0], x[1] * y[1])
-
-      // Compute third output polynomial
-      // Output written directly to result rather than temporary buffer
-      // result[2] = x[1] * y[1]
-      intel::hexl::EltwiseMultMod(cipher2 + poly2_offset,
-                                  cipher0 + poly1_offset,
-                                  cipher1 + poly1_offset, n, moduli[i], 1);
-
-      // Compute second output polynomial
-      // result[1] = x[1] * y[0]
-      intel::hexl::EltwiseMultMod(cipher2 + poly1_offset,
-                                  cipher0 + poly1_offset,
-                                  cipher1 + poly0_offset, n, moduli[i], 1);
-
-      // result[1] = x[0] * y[1]
-      intel::hexl::EltwiseMultMod(temp.data(), cipher0 + poly0_offset,
-                                  cipher1 + poly1_offset, n, moduli[i], 1);
-      // result[1] += temp_poly
-      intel::hexl::EltwiseAddMod(cipher2 + poly1_offset, cipher2 + poly1_offset,
-                                 temp.data(), n, moduli[i]);
-
-      // Compute first output polynomial
-      // result[0] = x[0] * y[0]
-      intel::hexl::EltwiseMultMod(cipher2 + poly0_offset,
-                                  cipher0 + poly0_offset,
-                                  cipher1 + poly0_offset, n, moduli[i], 1);
-    }
+    size_t i_times_n = i * n;
+    size_t poly0_offset = i_times_n;
+    size_t poly1_offset = poly0_offset + poly_size;
+    size_t poly2_offset = poly0_offset + 2 * poly_size;
+
+    // Output ciphertext has 3 polynomials, where x, y are the input
+    // ciphertexts: (x[0] * y[0], x[0] * y[1] + x[1] * y[0], x[1] * y[1])
+
+    // Compute third output polynomial
+    // Output written directly to result rather than temporary buffer
+    // result[2] = x[1] * y[1]
+    intel::hexl::EltwiseMultMod(cipher2 + poly2_offset, cipher0 + poly1_offset,
+                                cipher1 + poly1_offset, n, moduli[i], 1);
+
+    // Compute second output polynomial
+    // result[1] = x[1] * y[0]
+    intel::hexl::EltwiseMultMod(cipher2 + poly1_offset, cipher0 + poly1_offset,
+                                cipher1 + poly0_offset, n, moduli[i], 1);
+
+    // result[1] = x[0] * y[1]
+    intel::hexl::EltwiseMultMod(temp, cipher0 + poly0_offset,
+                                cipher1 + poly1_offset, n, moduli[i], 1);
+    // result[1] += temp_poly
+    intel::hexl::EltwiseAddMod(cipher2 + poly1_offset, cipher2 + poly1_offset,
+                               temp, n, moduli[i]);
+
+    // Compute first output polynomial
+    // result[0] = x[0] * y[0]
+    intel::hexl::EltwiseMultMod(cipher2 + poly0_offset, cipher0 + poly0_offset,
+                                cipher1 + poly0_offset, n, moduli[i], 1);
+  });
+
+  // Each output ciphertext is 3 * num_moduli contiguous limbs of n elements
+  size_t num_limbs = 3 * num_moduli;
+
+  // Accumulate with the adder-tree algorithm in O(logn). Each level runs one
+  // task per limb of each pair of ciphertexts; a ciphertext without a right
+  // neighbor is carried to the next level unchanged
+  for (size_t dist = 1; dist < num_weights; dist += dist) {
+    size_t step = dist * 2;
+    size_t neighbor_cipher_incr = dist * output_size;
+    size_t num_pairs = (num_weights - dist + step - 1) / step;
+    size_t num_tasks = num_pairs * num_limbs;
+
+    ParallelFor(executor, num_tasks, [&](size_t task, size_t) {
+      size_t s = (task / num_limbs) * step;
+      size_t limb = task % num_limbs;
+      uint64_t* left_cipher = result + s * output_size + limb * n;
+      uint64_t* right_cipher = left_cipher + neighbor_cipher_incr;
+      intel::hexl::EltwiseAddMod(left_cipher, right_cipher, left_cipher, n,
+                                 moduli[limb % num_moduli]);
+    });
   }
+}
 
-  const bool USE_ADDER_TREE = true;
-  if (USE_ADDER_TREE) {
-    // Accumulate with the adder-tree algorithm in O(logn)
-    for (size_t dist = 1; dist < num_weights; dist += dist) {
-      size_t step = dist * 2;
-      size_t neighbor_cipher_incr = dist * output_size;
-      // This loop can leverage parallelism using #pragma unroll
-      for (size_t s = 0; s < num_weights; s += step) {
-        size_t next_cipher_pair_incr = s * output_size;
-        uint64_t* left_cipher = result + next_cipher_pair_incr;
-        uint64_t* right_cipher = left_cipher + neighbor_cipher_incr;
-
-        // This loop can leverage parallelism using #pragma unroll
-        for (size_t i = 0; i < num_moduli; i++) {
-          size_t i_times_n = i * n;
-          size_t poly0_offset = i_times_n;
-          size_t poly1_offset = poly0_offset + poly_size;
-          size_t poly2_offset = poly0_offset + 2 * poly_size;
-
-          // All EltwiseAddMod below can run in parallel
-          intel::hexl::EltwiseAddMod(left_cipher + poly0_offset,
-                                     right_cipher + poly0_offset,
-                                     left_cipher + poly0_offset, n, moduli[i]);
-          intel::hexl::EltwiseAddMod(left_cipher + poly1_offset,
-                                     right_cipher + poly1_offset,
-                                     left_cipher + poly1_offset, n, moduli[i]);
-          intel::hexl::EltwiseAddMod(left_cipher + poly2_offset,
-                                     right_cipher + poly2_offset,
-                                     left_cipher + poly2_offset, n, moduli[i]);
-        }
-      }
-    }
-  } else {
-    // Accumulate all rows in sequence
-    uint64_t* acc = result;
-    for (size_t r = 1; r < num_weights; r++) {
-      size_t next_cipher = r * output_size;
-      acc += next_cipher;
-      for (size_t i = 0; i < num_moduli; i++) {
-        size_t i_times_n = i * n;
-        size_t poly0_offset = i_times_n;
-        size_t poly1_offset = poly0_offset + poly_size;
-        size_t poly2_offset = poly0_offset + 2 * poly_size;
-
-        // All EltwiseAddMod below can run in parallel
-
-        intel::hexl::EltwiseAddMod(result + poly0_offset, result + poly0_offset,
-                                   acc + poly0_offset, n, moduli[i]);
-        intel::hexl::EltwiseAddMod(result + poly1_offset, result + poly1_offset,
-                                   acc + poly1_offset, n, moduli[i]);
-        intel::hexl::EltwiseAddMod(result + poly2_offset, result + poly2_offset,
-                                   acc + poly2_offset, n, moduli[i]);
-      }
-    }
-  }
+uint64_t LinRegMatrixVectorMultiplyAccumulateWorkspaceSize(uint64_t n) {
+  return internal::DyadicMultiplyWorkspaceSize(n);
+}
+
+void LinRegMatrixVectorMultiplyAccumulate(uint64_t* result,
+                                          const uint64_t* operand1,
+                                          const uint64_t* operand2, uint64_t n,
+                                          const uint64_t* moduli,
+                                          uint64_t num_moduli,
+                                          uint64_t num_weights,
+                                          uint64_t* workspace) {
+  HEXL_CHECK(num_weights != 0, "Require num_weights != 0");
+  internal::DyadicMultiplyAccumulate(result, operand1, operand2, num_weights, n,
+                                     moduli, num_moduli, workspace);
 }
 
 }  // namespace hexl
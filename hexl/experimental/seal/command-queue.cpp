@@ -0,0 +1,231 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/seal/command-queue.hpp"
+
+#include <utility>
+
+#include "hexl/experimental/seal/dyadic-multiply.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/logging/logging.hpp"
+#include "hexl/util/check.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Whether two DyadicMultiply commands can be computed by one
+// DyadicMultiplyBatch
+inline bool SameBatch(const DyadicMultiplyCommand& x,
+                      const DyadicMultiplyCommand& y) {
+  return x.n == y.n && x.moduli == y.moduli && x.num_moduli == y.num_moduli;
+}
+
+// Whether two KeySwitch commands can be computed by one KeySwitchBatch
+inline bool SameBatch(const KeySwitchCommand& x, const KeySwitchCommand& y) {
+  return x.ntts != nullptr && x.ntts == y.ntts && x.n == y.n &&
+         x.decomp_modulus_size == y.decomp_modulus_size &&
+         x.key_modulus_size == y.key_modulus_size &&
+         x.rns_modulus_size == y.rns_modulus_size &&
+         x.key_component_count == y.key_component_count &&
+         x.moduli == y.moduli && x.k_switch_keys == y.k_switch_keys &&
+         x.modswitch_factors == y.modswitch_factors;
+}
+
+inline bool SameBatch(const Command& x, const Command& y) {
+  if (x.type != y.type) {
+    return false;
+  }
+  if (x.type == CommandType::kDyadicMultiply) {
+    return SameBatch(x.dyadic_multiply, y.dyadic_multiply);
+  }
+  return SameBatch(x.key_switch, y.key_switch);
+}
+
+CpuCommandQueueBackend::CpuCommandQueueBackend(size_t num_threads)
+    : m_executor(num_threads) {
+  m_dispatcher = std::thread(&CpuCommandQueueBackend::DispatchLoop, this);
+}
+
+CpuCommandQueueBackend::~CpuCommandQueueBackend() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_ready.notify_one();
+  m_dispatcher.join();
+}
+
+void CpuCommandQueueBackend::Submit(std::vector<Command> commands,
+                                    CommandCallback on_complete) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_submissions.push_back(
+        Submission{std::move(commands), std::move(on_complete)});
+  }
+  m_ready.notify_one();
+}
+
+void CpuCommandQueueBackend::DispatchLoop() {
+  while (true) {
+    Submission submission;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_ready.wait(lock, [&] { return m_stop || !m_submissions.empty(); });
+      // Completes the remaining submissions before stopping
+      if (m_submissions.empty()) {
+        return;
+      }
+      submission = std::move(m_submissions.front());
+      m_submissions.pop_front();
+    }
+
+    std::exception_ptr error;
+    try {
+      Run(submission.commands);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (submission.on_complete) {
+      submission.on_complete(error);
+    }
+  }
+}
+
+void CpuCommandQueueBackend::Run(const std::vector<Command>& commands) {
+  std::vector<uint64_t*> results;
+  std::vector<const uint64_t*> operand1s;
+  std::vector<const uint64_t*> operand2s;
+
+  size_t begin = 0;
+  while (begin < commands.size()) {
+    size_t end = begin + 1;
+    while (end < commands.size() && SameBatch(commands[begin], commands[end])) {
+      ++end;
+    }
+    uint64_t batch_size = end - begin;
+
+    if (commands[begin].type == CommandType::kDyadicMultiply) {
+      const DyadicMultiplyCommand& first = commands[begin].dyadic_multiply;
+      results.clear();
+      operand1s.clear();
+      operand2s.clear();
+      for (size_t i = begin; i < end; ++i) {
+        results.push_back(commands[i].dyadic_multiply.result);
+        operand1s.push_back(commands[i].dyadic_multiply.operand1);
+        operand2s.push_back(commands[i].dyadic_multiply.operand2);
+      }
+      uint64_t workspace_size =
+          DyadicMultiplyBatchWorkspaceSize(first.n, &m_executor);
+      if (m_workspace.size() < workspace_size) {
+        m_workspace.resize(workspace_size);
+      }
+      HEXL_VLOG(3, "Running " << batch_size << " DyadicMultiply commands");
+      DyadicMultiplyBatch(results.data(), operand1s.data(), operand2s.data(),
+                          batch_size, first.n, first.moduli, first.num_moduli,
+                          &m_executor, m_workspace.data());
+    } else if (commands[begin].key_switch.ntts == nullptr) {
+      const KeySwitchCommand& ks = commands[begin].key_switch;
+      HEXL_VLOG(3, "Running 1 KeySwitch command");
+      KeySwitch(ks.result, ks.t_target_iter_ptr, ks.n, ks.decomp_modulus_size,
+                ks.key_modulus_size, ks.rns_modulus_size,
+                ks.key_component_count, ks.moduli, ks.k_switch_keys,
+                ks.modswitch_factors, ks.root_of_unity_powers_ptr,
+                &m_executor);
+    } else {
+      const KeySwitchCommand& first = commands[begin].key_switch;
+      results.clear();
+      operand1s.clear();
+      for (size_t i = begin; i < end; ++i) {
+        results.push_back(commands[i].key_switch.result);
+        operand1s.push_back(commands[i].key_switch.t_target_iter_ptr);
+      }
+      uint64_t workspace_size = KeySwitchBatchWorkspaceSize(
+          first.n, first.decomp_modulus_size, first.rns_modulus_size,
+          first.key_component_count, batch_size, &m_executor);
+      if (m_workspace.size() < workspace_size) {
+        m_workspace.resize(workspace_size);
+      }
+      HEXL_VLOG(3, "Running " << batch_size << " KeySwitch commands");
+      KeySwitchBatch(results.data(), operand1s.data(), batch_size, first.n,
+                     first.decomp_modulus_size, first.key_modulus_size,
+                     first.rns_modulus_size, first.key_component_count,
+                     first.moduli, first.k_switch_keys,
+                     first.modswitch_factors, *first.ntts, &m_executor,
+                     m_workspace.data());
+    }
+    begin = end;
+  }
+}
+
+CommandQueue::CommandQueue()
+    : m_backend(std::make_shared<CpuCommandQueueBackend>()) {}
+
+CommandQueue::CommandQueue(std::shared_ptr<CommandQueueBackend> backend)
+    : m_backend(std::move(backend)) {
+  HEXL_CHECK(m_backend != nullptr, "Require backend != nullptr");
+}
+
+CommandQueue::~CommandQueue() noexcept { Wait(); }
+
+std::future<void> CommandQueue::Submit(const DyadicMultiplyCommand& command,
+                                       CommandCallback callback) {
+  return SubmitBatch({Command(command)}, std::move(callback));
+}
+
+std::future<void> CommandQueue::Submit(const KeySwitchCommand& command,
+                                       CommandCallback callback) {
+  return SubmitBatch({Command(command)}, std::move(callback));
+}
+
+std::future<void> CommandQueue::SubmitBatch(std::vector<Command> commands,
+                                            CommandCallback callback) {
+  auto promise = std::make_shared<std::promise<void>>();
+  std::future<void> future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_num_pending;
+  }
+
+  // The callback runs before the future becomes ready, so it has returned
+  // once the future is ready
+  auto on_complete = [this, promise, callback = std::move(callback)](
+                         std::exception_ptr error) {
+    if (callback) {
+      try {
+        callback(error);
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      promise->set_exception(error);
+    } else {
+      promise->set_value();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_num_pending == 0) {
+      m_idle.notify_all();
+    }
+  };
+  try {
+    m_backend->Submit(std::move(commands), std::move(on_complete));
+  } catch (...) {
+    // The commands were not enqueued, so Wait must not wait for them
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_num_pending == 0) {
+      m_idle.notify_all();
+    }
+    throw;
+  }
+  return future;
+}
+
+void CommandQueue::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [&] { return m_num_pending == 0; });
+}
+
+}  // namespace hexl
+}  // namespace intel
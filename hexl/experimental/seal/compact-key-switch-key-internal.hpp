@@ -0,0 +1,50 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+/// @brief Computes one 64-byte block of the ChaCha20 keystream
+/// @param[out] result Stores the 16 words of the block
+/// @param[in] key 256-bit key, as 4 words
+/// @param[in] counter 64-bit block counter
+/// @param[in] nonce 64-bit nonce
+/// @details Uses the original ChaCha20 layout, with a 64-bit counter in state
+/// words 12 and 13 and a 64-bit nonce in state words 14 and 15
+void ChaCha20Block(uint32_t* result, const uint64_t* key, uint64_t counter,
+                   uint64_t nonce);
+
+/// @brief Samples uniform residues modulo \p modulus from the ChaCha20
+/// keystream, by rejection sampling
+/// @param[out] result Stores the \p n residues
+/// @param[in] seed 256-bit ChaCha20 key, as 4 words
+/// @param[in] nonce Identifies the stream
+/// @param[in] n Number of residues to sample
+/// @param[in] modulus Modulus of the residues
+void ExpandUniform(uint64_t* result, const uint64_t* seed, uint64_t nonce,
+                   uint64_t n, uint64_t modulus);
+
+/// @brief Packs \p n values of \p bit_width bits each into a bit stream
+/// @param[out] result Stores the ceil(n * bit_width / 64) words of the stream
+/// @param[in] values Values to pack, each less than 2^bit_width
+/// @param[in] n Number of values
+/// @param[in] bit_width Number of bits per value, in [1, 64]
+void PackBits(uint64_t* result, const uint64_t* values, uint64_t n,
+              uint64_t bit_width);
+
+/// @brief Unpacks \p n values of \p bit_width bits each from a bit stream
+/// @param[out] result Stores the \p n values
+/// @param[in] packed Bit stream written by PackBits
+/// @param[in] n Number of values
+/// @param[in] bit_width Number of bits per value, in [1, 64]
+void UnpackBits(uint64_t* result, const uint64_t* packed, uint64_t n,
+                uint64_t bit_width);
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,373 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "experimental/seal/compact-key-switch-key-internal.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/check.hpp"
+
+namespace intel {
+namespace hexl {
+
+namespace internal {
+
+inline uint32_t RotateLeft32(uint32_t x, int shift) {
+  return (x << shift) | (x >> (32 - shift));
+}
+
+inline void ChaCha20QuarterRound(uint32_t* x, size_t a, size_t b, size_t c,
+                                 size_t d) {
+  x[a] += x[b];
+  x[d] = RotateLeft32(x[d] ^ x[a], 16);
+  x[c] += x[d];
+  x[b] = RotateLeft32(x[b] ^ x[c], 12);
+  x[a] += x[b];
+  x[d] = RotateLeft32(x[d] ^ x[a], 8);
+  x[c] += x[d];
+  x[b] = RotateLeft32(x[b] ^ x[c], 7);
+}
+
+void ChaCha20Block(uint32_t* result, const uint64_t* key, uint64_t counter,
+                   uint64_t nonce) {
+  // "expand 32-byte k"
+  uint32_t state[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+  for (size_t i = 0; i < 4; ++i) {
+    state[4 + 2 * i] = static_cast<uint32_t>(key[i]);
+    state[5 + 2 * i] = static_cast<uint32_t>(key[i] >> 32);
+  }
+  state[12] = static_cast<uint32_t>(counter);
+  state[13] = static_cast<uint32_t>(counter >> 32);
+  state[14] = static_cast<uint32_t>(nonce);
+  state[15] = static_cast<uint32_t>(nonce >> 32);
+
+  std::copy(state, state + 16, result);
+  for (size_t round = 0; round < 10; ++round) {
+    ChaCha20QuarterRound(result, 0, 4, 8, 12);
+    ChaCha20QuarterRound(result, 1, 5, 9, 13);
+    ChaCha20QuarterRound(result, 2, 6, 10, 14);
+    ChaCha20QuarterRound(result, 3, 7, 11, 15);
+    ChaCha20QuarterRound(result, 0, 5, 10, 15);
+    ChaCha20QuarterRound(result, 1, 6, 11, 12);
+    ChaCha20QuarterRound(result, 2, 7, 8, 13);
+    ChaCha20QuarterRound(result, 3, 4, 9, 14);
+  }
+  for (size_t i = 0; i < 16; ++i) {
+    result[i] += state[i];
+  }
+}
+
+void ExpandUniform(uint64_t* result, const uint64_t* seed, uint64_t nonce,
+                   uint64_t n, uint64_t modulus) {
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  uint64_t bit_width = Log2(modulus - 1) + 1;
+  uint64_t mask =
+      (bit_width == 64) ? ~uint64_t(0) : (uint64_t(1) << bit_width) - 1;
+
+  uint32_t block[16];
+  uint64_t counter = 0;
+  size_t l = 0;
+  while (l < n) {
+    ChaCha20Block(block, seed, counter++, nonce);
+    for (size_t i = 0; i < 8 && l < n; ++i) {
+      uint64_t value = (uint64_t(block[2 * i + 1]) << 32) | block[2 * i];
+      value &= mask;
+      // Rejection sampling keeps the residues uniform
+      if (value < modulus) {
+        result[l++] = value;
+      }
+    }
+  }
+}
+
+void PackBits(uint64_t* result, const uint64_t* values, uint64_t n,
+              uint64_t bit_width) {
+  HEXL_CHECK(bit_width >= 1 && bit_width <= 64, "Invalid bit_width");
+  uint64_t num_words = (n * bit_width + 63) / 64;
+  std::fill(result, result + num_words, 0);
+  for (size_t l = 0; l < n; ++l) {
+    HEXL_CHECK(bit_width == 64 || values[l] < (uint64_t(1) << bit_width),
+               "Value " << values[l] << " exceeds " << bit_width << " bits");
+    uint64_t position = l * bit_width;
+    uint64_t word = position / 64;
+    uint64_t shift = position % 64;
+    result[word] |= values[l] << shift;
+    if (shift + bit_width > 64) {
+      result[word + 1] |= values[l] >> (64 - shift);
+    }
+  }
+}
+
+void UnpackBits(uint64_t* result, const uint64_t* packed, uint64_t n,
+                uint64_t bit_width) {
+  HEXL_CHECK(bit_width >= 1 && bit_width <= 64, "Invalid bit_width");
+  uint64_t mask =
+      (bit_width == 64) ? ~uint64_t(0) : (uint64_t(1) << bit_width) - 1;
+  for (size_t l = 0; l < n; ++l) {
+    uint64_t position = l * bit_width;
+    uint64_t word = position / 64;
+    uint64_t shift = position % 64;
+    uint64_t value = packed[word] >> shift;
+    if (shift + bit_width > 64) {
+      value |= packed[word + 1] << (64 - shift);
+    }
+    result[l] = value & mask;
+  }
+}
+
+}  // namespace internal
+
+// File header: magic, n, number of moduli, number of digits, key component
+// count, seeded flag, seed, then the moduli, padded to a 64-byte boundary
+inline uint64_t CompactKeySwitchKeyMagic() {
+  return 0x314B534B4C584548;  // "HEXLKSK1"
+}
+
+inline uint64_t CompactKeySwitchKeyHeaderWords(uint64_t num_moduli) {
+  uint64_t words = 6 + CompactKeySwitchKey::kSeedSize + num_moduli;
+  return (words + 7) / 8 * 8;
+}
+
+// Sets result to a * b. Returns false if the product overflows 64 bits
+inline bool CheckedMultiply(uint64_t a, uint64_t b, uint64_t* result) {
+  if (b != 0 && a > ~uint64_t(0) / b) {
+    return false;
+  }
+  *result = a * b;
+  return true;
+}
+
+CompactKeySwitchKey::CompactKeySwitchKey(uint64_t n,
+                                         const std::vector<uint64_t>& moduli,
+                                         uint64_t num_digits,
+                                         uint64_t key_component_count,
+                                         const uint64_t* seed)
+    : m_n(n),
+      m_moduli(moduli),
+      m_num_digits(num_digits),
+      m_key_component_count(key_component_count),
+      m_seeded(seed != nullptr) {
+  HEXL_CHECK(n > 0, "Require n > 0");
+  HEXL_CHECK(!moduli.empty(), "Require at least one modulus");
+  HEXL_CHECK(key_component_count > 0, "Require key_component_count > 0");
+  if (m_seeded) {
+    std::copy(seed, seed + kSeedSize, m_seed);
+  }
+  if (!InitializeLayout()) {
+    throw std::invalid_argument("Key switching key size overflows");
+  }
+  m_storage.resize(m_data_words, 0);
+}
+
+bool CompactKeySwitchKey::InitializeLayout() {
+  m_bit_widths.resize(m_moduli.size());
+  m_limb_words.resize(m_moduli.size());
+  m_modulus_offsets.resize(m_moduli.size());
+
+  // Each limb starts on a 64-byte boundary
+  uint64_t offset = 0;
+  for (size_t m = 0; m < m_moduli.size(); ++m) {
+    HEXL_CHECK(m_moduli[m] > 1, "Require moduli > 1");
+    m_bit_widths[m] = Log2(m_moduli[m] - 1) + 1;
+    // n may come from a mapped file, so the words per limb are computed
+    // without forming n * bit_width
+    uint64_t limb_words = m_n / 64 * m_bit_widths[m] +
+                          ((m_n % 64) * m_bit_widths[m] + 63) / 64;
+    if (limb_words > ~uint64_t(0) - 7) {
+      return false;
+    }
+    m_limb_words[m] = (limb_words + 7) / 8 * 8;
+    m_modulus_offsets[m] = offset;
+
+    uint64_t modulus_words = 0;
+    if (!CheckedMultiply(m_num_digits, StoredComponentCount(),
+                         &modulus_words) ||
+        !CheckedMultiply(modulus_words, m_limb_words[m], &modulus_words) ||
+        modulus_words > ~uint64_t(0) - offset) {
+      return false;
+    }
+    offset += modulus_words;
+  }
+  m_data_words = offset;
+  return true;
+}
+
+void CompactKeySwitchKey::SetLimb(uint64_t digit, uint64_t component,
+                                  uint64_t modulus_index,
+                                  const uint64_t* values) {
+  HEXL_CHECK(!IsMapped(), "Cannot modify a memory-mapped key");
+  HEXL_CHECK(digit < m_num_digits, "Invalid digit " << digit);
+  HEXL_CHECK(component < StoredComponentCount(),
+             "Component " << component << " is not stored");
+  HEXL_CHECK(modulus_index < m_moduli.size(),
+             "Invalid modulus index " << modulus_index);
+  HEXL_CHECK_BOUNDS(values, m_n, m_moduli[modulus_index],
+                    "values exceed bound " << m_moduli[modulus_index]);
+
+  internal::PackBits(&m_storage[LimbOffset(digit, component, modulus_index)],
+                     values, m_n, m_bit_widths[modulus_index]);
+}
+
+void CompactKeySwitchKey::SetKeys(const uint64_t** k_switch_keys) {
+  uint64_t key_modulus_size = m_moduli.size();
+  for (size_t j = 0; j < m_num_digits; ++j) {
+    for (size_t k = 0; k < StoredComponentCount(); ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        SetLimb(j, k, m, &k_switch_keys[j][(k * key_modulus_size + m) * m_n]);
+      }
+    }
+  }
+}
+
+void CompactKeySwitchKey::GetLimb(uint64_t* result, uint64_t digit,
+                                  uint64_t component,
+                                  uint64_t modulus_index) const {
+  HEXL_CHECK(digit < m_num_digits, "Invalid digit " << digit);
+  HEXL_CHECK(component < m_key_component_count,
+             "Invalid component " << component);
+  HEXL_CHECK(modulus_index < m_moduli.size(),
+             "Invalid modulus index " << modulus_index);
+
+  if (component >= StoredComponentCount()) {
+    // Each (digit, modulus) limb is an independent stream
+    uint64_t nonce = (digit << 32) | modulus_index;
+    internal::ExpandUniform(result, m_seed, nonce, m_n,
+                            m_moduli[modulus_index]);
+    return;
+  }
+  internal::UnpackBits(result,
+                       &Data()[LimbOffset(digit, component, modulus_index)],
+                       m_n, m_bit_widths[modulus_index]);
+}
+
+void CompactKeySwitchKey::Save(const std::string& path) const {
+  std::vector<uint64_t> header(CompactKeySwitchKeyHeaderWords(m_moduli.size()),
+                               0);
+  header[0] = CompactKeySwitchKeyMagic();
+  header[1] = m_n;
+  header[2] = m_moduli.size();
+  header[3] = m_num_digits;
+  header[4] = m_key_component_count;
+  header[5] = m_seeded ? 1 : 0;
+  std::copy(m_seed, m_seed + kSeedSize, &header[6]);
+  std::copy(m_moduli.begin(), m_moduli.end(), &header[6 + kSeedSize]);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(header.data()),
+             static_cast<std::streamsize>(header.size() * sizeof(uint64_t)));
+  file.write(reinterpret_cast<const char*>(Data()),
+             static_cast<std::streamsize>(StorageSize()));
+  if (!file) {
+    throw std::runtime_error("Failed to write key switching key to " + path);
+  }
+}
+
+CompactKeySwitchKey CompactKeySwitchKey::Map(const std::string& path) {
+  const void* base = nullptr;
+  uint64_t file_size = 0;
+  std::shared_ptr<const void> mapping;
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error("Failed to open key switching key " + path);
+  }
+  LARGE_INTEGER size;
+  HANDLE file_mapping = nullptr;
+  if (GetFileSizeEx(file, &size)) {
+    file_size = static_cast<uint64_t>(size.QuadPart);
+    file_mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+  CloseHandle(file);
+  if (file_mapping == nullptr) {
+    throw std::runtime_error("Failed to map key switching key " + path);
+  }
+  base = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (base == nullptr) {
+    CloseHandle(file_mapping);
+    throw std::runtime_error("Failed to map key switching key " + path);
+  }
+  mapping = std::shared_ptr<const void>(base, [file_mapping](const void* p) {
+    UnmapViewOfFile(p);
+    CloseHandle(file_mapping);
+  });
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open key switching key " + path);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    file_size = static_cast<uint64_t>(file_stat.st_size);
+    base = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == nullptr || base == MAP_FAILED) {
+    throw std::runtime_error("Failed to map key switching key " + path);
+  }
+  mapping = std::shared_ptr<const void>(base, [file_size](const void* p) {
+    munmap(const_cast<void*>(p), file_size);
+  });
+#endif
+
+  // The header is untrusted, so each field is checked before it is used in
+  // a size computation. The number of moduli is bounded by the file size
+  // before the header size is computed from it
+  const uint64_t* words = static_cast<const uint64_t*>(base);
+  uint64_t file_words = file_size / sizeof(uint64_t);
+  if (file_words < 6 + kSeedSize || words[0] != CompactKeySwitchKeyMagic()) {
+    throw std::runtime_error("Invalid key switching key file " + path);
+  }
+  uint64_t num_moduli = words[2];
+  if (num_moduli == 0 || num_moduli > file_words - (6 + kSeedSize) ||
+      file_words < CompactKeySwitchKeyHeaderWords(num_moduli)) {
+    throw std::runtime_error("Invalid key switching key file " + path);
+  }
+  if (words[1] == 0 || words[4] == 0 || words[5] > 1) {
+    throw std::runtime_error("Invalid key switching key file " + path);
+  }
+  const uint64_t* moduli = &words[6 + kSeedSize];
+  if (std::any_of(moduli, moduli + num_moduli,
+                  [](uint64_t modulus) { return modulus <= 1; })) {
+    throw std::runtime_error("Invalid moduli in key switching key file " +
+                             path);
+  }
+
+  CompactKeySwitchKey key;
+  key.m_n = words[1];
+  key.m_num_digits = words[3];
+  key.m_key_component_count = words[4];
+  key.m_seeded = (words[5] != 0);
+  std::copy(&words[6], &words[6 + kSeedSize], key.m_seed);
+  key.m_moduli.assign(moduli, moduli + num_moduli);
+  if (!key.InitializeLayout()) {
+    throw std::runtime_error("Invalid key switching key file " + path);
+  }
+
+  uint64_t header_words = CompactKeySwitchKeyHeaderWords(num_moduli);
+  if (file_words - header_words < key.m_data_words) {
+    throw std::runtime_error("Truncated key switching key file " + path);
+  }
+  key.m_mapping = mapping;
+  key.m_mapped_data = words + header_words;
+  return key;
+}
+
+}  // namespace hexl
+}  // namespace intel
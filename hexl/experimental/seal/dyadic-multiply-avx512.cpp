@@ -0,0 +1,787 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "experimental/seal/dyadic-multiply-avx512.hpp"
+
+#include <immintrin.h>
+
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/check.hpp"
+#include "util/avx512-util.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+#ifdef HEXL_HAS_AVX512IFMA
+template void DyadicMultiplyFusedAVX512<52>(uint64_t* result,
+                                            const uint64_t* operand1,
+                                            const uint64_t* operand2,
+                                            uint64_t n, uint64_t poly_size,
+                                            uint64_t modulus);
+template void DyadicMultiplyKaratsubaAVX512<52>(uint64_t* result,
+                                                const uint64_t* operand1,
+                                                const uint64_t* operand2,
+                                                uint64_t n, uint64_t poly_size,
+                                                uint64_t modulus);
+template void DyadicMultiplyFusedAVX512<52>(
+    uint64_t* const* results, const uint64_t* const* operand1s,
+    const uint64_t* const* operand2s, uint64_t batch_size, uint64_t offset,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicMultiplyKaratsubaAVX512<52>(
+    uint64_t* const* results, const uint64_t* const* operand1s,
+    const uint64_t* const* operand2s, uint64_t batch_size, uint64_t offset,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicMultiplyAccumulateAVX512<52>(
+    uint64_t* result, const uint64_t* operand1, const uint64_t* operand2,
+    uint64_t num_pairs, uint64_t pair_stride, uint64_t n, uint64_t poly_size,
+    uint64_t modulus);
+template void PlainMultiplyAccumulateShoupAVX512<52>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* plain_shoup,
+    const uint64_t* cipher, uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void PlainMultiplyAccumulateAVX512<52>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DiagonalMultiplyAccumulateAVX512<52>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+    uint64_t num_terms, uint64_t plain_stride, uint64_t cipher_stride,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicTensorProductAVX512<52>(
+    uint64_t* result, const uint64_t* operand1, uint64_t operand1_size,
+    const uint64_t* operand2, uint64_t operand2_size, uint64_t n,
+    uint64_t poly_size, uint64_t modulus);
+template void DyadicTensorSquareAVX512<52>(uint64_t* result,
+                                           const uint64_t* operand,
+                                           uint64_t operand_size, uint64_t n,
+                                           uint64_t poly_size,
+                                           uint64_t modulus);
+#endif
+
+#ifdef HEXL_HAS_AVX512DQ
+template void DyadicMultiplyFusedAVX512<64>(uint64_t* result,
+                                            const uint64_t* operand1,
+                                            const uint64_t* operand2,
+                                            uint64_t n, uint64_t poly_size,
+                                            uint64_t modulus);
+template void DyadicMultiplyKaratsubaAVX512<64>(uint64_t* result,
+                                                const uint64_t* operand1,
+                                                const uint64_t* operand2,
+                                                uint64_t n, uint64_t poly_size,
+                                                uint64_t modulus);
+template void DyadicMultiplyFusedAVX512<64>(
+    uint64_t* const* results, const uint64_t* const* operand1s,
+    const uint64_t* const* operand2s, uint64_t batch_size, uint64_t offset,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicMultiplyKaratsubaAVX512<64>(
+    uint64_t* const* results, const uint64_t* const* operand1s,
+    const uint64_t* const* operand2s, uint64_t batch_size, uint64_t offset,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicMultiplyAccumulateAVX512<64>(
+    uint64_t* result, const uint64_t* operand1, const uint64_t* operand2,
+    uint64_t num_pairs, uint64_t pair_stride, uint64_t n, uint64_t poly_size,
+    uint64_t modulus);
+template void PlainMultiplyAccumulateShoupAVX512<64>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* plain_shoup,
+    const uint64_t* cipher, uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void PlainMultiplyAccumulateAVX512<64>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DiagonalMultiplyAccumulateAVX512<64>(
+    uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+    uint64_t num_terms, uint64_t plain_stride, uint64_t cipher_stride,
+    uint64_t n, uint64_t poly_size, uint64_t modulus);
+template void DyadicTensorProductAVX512<64>(
+    uint64_t* result, const uint64_t* operand1, uint64_t operand1_size,
+    const uint64_t* operand2, uint64_t operand2_size, uint64_t n,
+    uint64_t poly_size, uint64_t modulus);
+template void DyadicTensorSquareAVX512<64>(uint64_t* result,
+                                           const uint64_t* operand,
+                                           uint64_t operand_size, uint64_t n,
+                                           uint64_t poly_size,
+                                           uint64_t modulus);
+#endif
+
+#ifdef HEXL_HAS_AVX512DQ
+
+// Double-word products are represented as hi * 2^BitShift + lo, with lo less
+// than 2^BitShift
+
+// Sets (*hi, *lo) to x * y
+template <int BitShift>
+inline void DyadicMultiplyProductAVX512(__m512i* hi, __m512i* lo, __m512i x,
+                                        __m512i y) {
+  *hi = _mm512_hexl_mulhi_epi<BitShift>(x, y);
+  *lo = _mm512_hexl_mullo_epi<BitShift>(x, y);
+}
+
+// Adds (y_hi, y_lo) to (*hi, *lo)
+template <int BitShift>
+inline void DyadicMultiplyAddAVX512(__m512i* hi, __m512i* lo, __m512i y_hi,
+                                    __m512i y_lo) {
+  *lo = _mm512_add_epi64(*lo, y_lo);
+  *hi = _mm512_add_epi64(*hi, y_hi);
+  if (BitShift == 64) {
+    // Carry of the low word detected by overflow
+    __mmask8 carry = _mm512_cmp_epu64_mask(*lo, y_lo, _MM_CMPINT_LT);
+    *hi = _mm512_mask_add_epi64(*hi, carry, *hi, _mm512_set1_epi64(1));
+  } else {
+    *hi = _mm512_add_epi64(*hi, _mm512_srli_epi64(*lo, 52));
+    *lo = ClearTopBits64<52>(*lo);
+  }
+}
+
+// Subtracts (y_hi, y_lo) from (*hi, *lo). The difference must be non-negative
+template <int BitShift>
+inline void DyadicMultiplySubAVX512(__m512i* hi, __m512i* lo, __m512i y_hi,
+                                    __m512i y_lo) {
+  if (BitShift == 64) {
+    __mmask8 borrow = _mm512_cmp_epu64_mask(*lo, y_lo, _MM_CMPINT_LT);
+    *lo = _mm512_sub_epi64(*lo, y_lo);
+    *hi = _mm512_sub_epi64(*hi, y_hi);
+    *hi = _mm512_mask_sub_epi64(*hi, borrow, *hi, _mm512_set1_epi64(1));
+  } else {
+    // The signed low word is in (-2^52, 2^52)
+    *lo = _mm512_sub_epi64(*lo, y_lo);
+    *hi = _mm512_sub_epi64(*hi, y_hi);
+    *hi = _mm512_add_epi64(*hi, _mm512_srai_epi64(*lo, 52));
+    *lo = ClearTopBits64<52>(*lo);
+  }
+}
+
+// Reduces (hi, lo) < 2^(L + BitShift - 2) modulo q, where L = Log2(q) + 1,
+// using Algorithm 2 from
+// https://homes.esat.kuleuven.be/~fvercaut/papers/bar_mont.pdf with beta = -2
+template <int BitShift>
+inline __m512i DyadicMultiplyReduceAVX512(__m512i hi, __m512i lo,
+                                          __m512i v_modulus,
+                                          __m512i v_neg_modulus,
+                                          __m512i v_twice_modulus,
+                                          __m512i v_barrett,
+                                          unsigned int shift) {
+#ifdef HEXL_HAS_AVX512IFMA
+  if (BitShift == 52) {
+    // c1 < 2^52, so no bits of the shifted words overlap
+    __m512i c1 = _mm512_or_epi64(_mm512_srli_epi64(lo, shift),
+                                 _mm512_slli_epi64(hi, 52 - shift));
+    __m512i q_hat = _mm512_hexl_mulhi_epi<52>(c1, v_barrett);
+    // In [0, 3q)
+    __m512i z = _mm512_hexl_mullo_add_lo_epi<52>(lo, q_hat, v_neg_modulus);
+    return _mm512_hexl_small_mod_epu64<4>(z, v_modulus, &v_twice_modulus);
+  }
+#endif
+  HEXL_UNUSED(v_neg_modulus);
+  __m512i c1 = _mm512_hexl_shrdi_epi64(lo, hi, shift);
+  // Approximate high bits, as in EltwiseMultModAVX512DQInt
+  __m512i q_hat = _mm512_hexl_mulhi_approx_epi<64>(c1, v_barrett);
+  // In [0, 4q)
+  __m512i z = _mm512_sub_epi64(lo, _mm512_hexl_mullo_epi<64>(q_hat, v_modulus));
+  return _mm512_hexl_small_mod_epu64<4>(z, v_modulus, &v_twice_modulus);
+}
+
+// Computes one limb for each of batch_size ciphertext pairs, at the given
+// offset from each pointer, with the constants set up once
+template <int BitShift, bool Karatsuba>
+inline void DyadicMultiplyAVX512Impl(uint64_t* const* results,
+                                     const uint64_t* const* operand1s,
+                                     const uint64_t* const* operand2s,
+                                     uint64_t batch_size, uint64_t offset,
+                                     uint64_t n, uint64_t poly_size,
+                                     uint64_t modulus) {
+  HEXL_CHECK(results != nullptr, "Require results != nullptr");
+  HEXL_CHECK(operand1s != nullptr, "Require operand1s != nullptr");
+  HEXL_CHECK(operand2s != nullptr, "Require operand2s != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 3)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  // The middle output is at most 2 * (q - 1)^2 < 2^(L + BitShift - 2)
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t barrett_factor =
+      MultiplyFactor(uint64_t(1) << shift, BitShift, modulus).BarrettFactor();
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  unsigned int v_shift = static_cast<unsigned int>(shift);
+
+  for (size_t b = 0; b < batch_size; ++b) {
+    const uint64_t* operand1 = operand1s[b] + offset;
+    const uint64_t* operand2 = operand2s[b] + offset;
+    uint64_t* result = results[b] + offset;
+    HEXL_CHECK_BOUNDS(operand1, n, modulus,
+                      "operand1 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand1 + poly_size, n, modulus,
+                      "operand1 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand2, n, modulus,
+                      "operand2 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand2 + poly_size, n, modulus,
+                      "operand2 exceeds bound " << modulus);
+
+    const __m512i* vp_x0 = reinterpret_cast<const __m512i*>(operand1);
+    const __m512i* vp_x1 =
+        reinterpret_cast<const __m512i*>(operand1 + poly_size);
+    const __m512i* vp_y0 = reinterpret_cast<const __m512i*>(operand2);
+    const __m512i* vp_y1 =
+        reinterpret_cast<const __m512i*>(operand2 + poly_size);
+    __m512i* vp_r0 = reinterpret_cast<__m512i*>(result);
+    __m512i* vp_r1 = reinterpret_cast<__m512i*>(result + poly_size);
+    __m512i* vp_r2 = reinterpret_cast<__m512i*>(result + 2 * poly_size);
+
+    // All inputs of a vector are loaded before any output is stored, so the
+    // result may alias either operand
+    HEXL_LOOP_UNROLL_4
+    for (size_t i = n / 8; i > 0; --i) {
+      __m512i v_x0 = _mm512_loadu_si512(vp_x0);
+      __m512i v_x1 = _mm512_loadu_si512(vp_x1);
+      __m512i v_y0 = _mm512_loadu_si512(vp_y0);
+      __m512i v_y1 = _mm512_loadu_si512(vp_y1);
+
+      __m512i v_p0_hi, v_p0_lo, v_p1_hi, v_p1_lo, v_p2_hi, v_p2_lo;
+      DyadicMultiplyProductAVX512<BitShift>(&v_p0_hi, &v_p0_lo, v_x0, v_y0);
+      DyadicMultiplyProductAVX512<BitShift>(&v_p2_hi, &v_p2_lo, v_x1, v_y1);
+      if (Karatsuba) {
+        // (x0 + x1) * (y0 + y1) - x0 * y0 - x1 * y1, exactly
+        __m512i v_x_sum = _mm512_add_epi64(v_x0, v_x1);
+        __m512i v_y_sum = _mm512_add_epi64(v_y0, v_y1);
+        DyadicMultiplyProductAVX512<BitShift>(&v_p1_hi, &v_p1_lo, v_x_sum,
+                                              v_y_sum);
+        DyadicMultiplySubAVX512<BitShift>(&v_p1_hi, &v_p1_lo, v_p0_hi,
+                                          v_p0_lo);
+        DyadicMultiplySubAVX512<BitShift>(&v_p1_hi, &v_p1_lo, v_p2_hi,
+                                          v_p2_lo);
+      } else {
+        __m512i v_t_hi, v_t_lo;
+        DyadicMultiplyProductAVX512<BitShift>(&v_p1_hi, &v_p1_lo, v_x0, v_y1);
+        DyadicMultiplyProductAVX512<BitShift>(&v_t_hi, &v_t_lo, v_x1, v_y0);
+        DyadicMultiplyAddAVX512<BitShift>(&v_p1_hi, &v_p1_lo, v_t_hi, v_t_lo);
+      }
+
+      __m512i v_r0 = DyadicMultiplyReduceAVX512<BitShift>(
+          v_p0_hi, v_p0_lo, v_modulus, v_neg_modulus, v_twice_modulus,
+          v_barrett, v_shift);
+      __m512i v_r1 = DyadicMultiplyReduceAVX512<BitShift>(
+          v_p1_hi, v_p1_lo, v_modulus, v_neg_modulus, v_twice_modulus,
+          v_barrett, v_shift);
+      __m512i v_r2 = DyadicMultiplyReduceAVX512<BitShift>(
+          v_p2_hi, v_p2_lo, v_modulus, v_neg_modulus, v_twice_modulus,
+          v_barrett, v_shift);
+      _mm512_storeu_si512(vp_r0, v_r0);
+      _mm512_storeu_si512(vp_r1, v_r1);
+      _mm512_storeu_si512(vp_r2, v_r2);
+
+      ++vp_x0;
+      ++vp_x1;
+      ++vp_y0;
+      ++vp_y1;
+      ++vp_r0;
+      ++vp_r1;
+      ++vp_r2;
+    }
+  }
+}
+
+template <int BitShift>
+void DyadicMultiplyFusedAVX512(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus) {
+  DyadicMultiplyAVX512Impl<BitShift, false>(&result, &operand1, &operand2, 1,
+                                            0, n, poly_size, modulus);
+}
+
+template <int BitShift>
+void DyadicMultiplyKaratsubaAVX512(uint64_t* result, const uint64_t* operand1,
+                                   const uint64_t* operand2, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  DyadicMultiplyAVX512Impl<BitShift, true>(&result, &operand1, &operand2, 1,
+                                           0, n, poly_size, modulus);
+}
+
+template <int BitShift>
+void DyadicMultiplyFusedAVX512(uint64_t* const* results,
+                               const uint64_t* const* operand1s,
+                               const uint64_t* const* operand2s,
+                               uint64_t batch_size, uint64_t offset,
+                               uint64_t n, uint64_t poly_size,
+                               uint64_t modulus) {
+  DyadicMultiplyAVX512Impl<BitShift, false>(results, operand1s, operand2s,
+                                            batch_size, offset, n, poly_size,
+                                            modulus);
+}
+
+template <int BitShift>
+void DyadicMultiplyKaratsubaAVX512(uint64_t* const* results,
+                                   const uint64_t* const* operand1s,
+                                   const uint64_t* const* operand2s,
+                                   uint64_t batch_size, uint64_t offset,
+                                   uint64_t n, uint64_t poly_size,
+                                   uint64_t modulus) {
+  DyadicMultiplyAVX512Impl<BitShift, true>(results, operand1s, operand2s,
+                                           batch_size, offset, n, poly_size,
+                                           modulus);
+}
+
+// Adds (y_hi, y_lo) to (*hi, *lo). For BitShift == 52, the low word is not
+// normalized, so at most 2^11 products may be summed before
+// DyadicTensorNormalizeAVX512
+template <int BitShift>
+inline void DyadicTensorAddAVX512(__m512i* hi, __m512i* lo, __m512i y_hi,
+                                  __m512i y_lo) {
+  if (BitShift == 64) {
+    DyadicMultiplyAddAVX512<64>(hi, lo, y_hi, y_lo);
+  } else {
+    *lo = _mm512_add_epi64(*lo, y_lo);
+    *hi = _mm512_add_epi64(*hi, y_hi);
+  }
+}
+
+// Carries the low word of a sum from DyadicTensorAddAVX512 into the high word
+template <int BitShift>
+inline void DyadicTensorNormalizeAVX512(__m512i* hi, __m512i* lo) {
+  if (BitShift == 52) {
+    *hi = _mm512_add_epi64(*hi, _mm512_srli_epi64(*lo, 52));
+    *lo = ClearTopBits64<52>(*lo);
+  }
+}
+
+template <int BitShift>
+void DyadicMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* operand1,
+                                    const uint64_t* operand2,
+                                    uint64_t num_pairs, uint64_t pair_stride,
+                                    uint64_t n, uint64_t poly_size,
+                                    uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(num_pairs > 0, "Require num_pairs > 0");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 3)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t barrett_factor =
+      MultiplyFactor(uint64_t(1) << shift, BitShift, modulus).BarrettFactor();
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, BitShift);
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  unsigned int v_shift = static_cast<unsigned int>(shift);
+
+  auto reduce = [&](__m512i v_hi, __m512i v_lo) {
+    DyadicTensorNormalizeAVX512<BitShift>(&v_hi, &v_lo);
+    return DyadicMultiplyReduceAVX512<BitShift>(v_hi, v_lo, v_modulus,
+                                                v_neg_modulus, v_twice_modulus,
+                                                v_barrett, v_shift);
+  };
+
+  // Unreduced sums of the three outputs over one tile, each as high and low
+  // words, kept in L1 cache while every pair is streamed through
+  const size_t tile_size = 128;
+  alignas(64) uint64_t sums[6 * tile_size];
+  __m512i* vp_sums = reinterpret_cast<__m512i*>(sums);
+  const size_t tile_vectors = tile_size / 8;
+
+  for (size_t tile = 0; tile < n; tile += tile_size) {
+    size_t num_vectors = (std::min(tile + tile_size, static_cast<size_t>(n)) -
+                          tile) / 8;
+    // Number of products in the middle sum, which grows fastest
+    uint64_t num_terms = 0;
+
+    for (size_t r = 0; r < num_pairs; ++r) {
+      const uint64_t* x = operand1 + r * pair_stride + tile;
+      const uint64_t* y = operand2 + r * pair_stride + tile;
+      bool fold = (num_terms + 2 > max_terms);
+
+      for (size_t j = 0; j < num_vectors; ++j) {
+        __m512i v_x0 = _mm512_loadu_si512(x + 8 * j);
+        __m512i v_x1 = _mm512_loadu_si512(x + poly_size + 8 * j);
+        __m512i v_y0 = _mm512_loadu_si512(y + 8 * j);
+        __m512i v_y1 = _mm512_loadu_si512(y + poly_size + 8 * j);
+
+        __m512i v_p_hi[3], v_p_lo[3];
+        __m512i v_t_hi, v_t_lo;
+        DyadicMultiplyProductAVX512<BitShift>(&v_p_hi[0], &v_p_lo[0], v_x0,
+                                              v_y0);
+        DyadicMultiplyProductAVX512<BitShift>(&v_p_hi[1], &v_p_lo[1], v_x0,
+                                              v_y1);
+        DyadicMultiplyProductAVX512<BitShift>(&v_t_hi, &v_t_lo, v_x1, v_y0);
+        DyadicTensorAddAVX512<BitShift>(&v_p_hi[1], &v_p_lo[1], v_t_hi,
+                                        v_t_lo);
+        DyadicMultiplyProductAVX512<BitShift>(&v_p_hi[2], &v_p_lo[2], v_x1,
+                                              v_y1);
+
+        for (size_t k = 0; k < 3; ++k) {
+          __m512i* vp_hi = vp_sums + (2 * k) * tile_vectors + j;
+          __m512i* vp_lo = vp_sums + (2 * k + 1) * tile_vectors + j;
+          if (r != 0) {
+            __m512i v_sum_hi = _mm512_load_si512(vp_hi);
+            __m512i v_sum_lo = _mm512_load_si512(vp_lo);
+            if (fold) {
+              v_sum_lo = reduce(v_sum_hi, v_sum_lo);
+              v_sum_hi = _mm512_setzero_si512();
+            }
+            DyadicTensorAddAVX512<BitShift>(&v_p_hi[k], &v_p_lo[k], v_sum_hi,
+                                            v_sum_lo);
+          }
+          _mm512_store_si512(vp_hi, v_p_hi[k]);
+          _mm512_store_si512(vp_lo, v_p_lo[k]);
+        }
+      }
+      num_terms = (r == 0 || fold) ? 2 : num_terms + 2;
+    }
+
+    for (size_t k = 0; k < 3; ++k) {
+      for (size_t j = 0; j < num_vectors; ++j) {
+        __m512i* vp_hi = vp_sums + (2 * k) * tile_vectors + j;
+        __m512i* vp_lo = vp_sums + (2 * k + 1) * tile_vectors + j;
+        __m512i v_sum_hi = _mm512_load_si512(vp_hi);
+        __m512i v_sum_lo = _mm512_load_si512(vp_lo);
+        _mm512_storeu_si512(result + k * poly_size + tile + 8 * j,
+                            reduce(v_sum_hi, v_sum_lo));
+      }
+    }
+  }
+}
+
+template <int BitShift>
+void PlainMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 3)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  // The sum is at most (q - 1)^2 + (q - 1) < 2^(L + BitShift - 2)
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t barrett_factor =
+      MultiplyFactor(uint64_t(1) << shift, BitShift, modulus).BarrettFactor();
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  unsigned int v_shift = static_cast<unsigned int>(shift);
+  __m512i v_zero = _mm512_setzero_si512();
+
+  const __m512i* vp_plain = reinterpret_cast<const __m512i*>(plain);
+  HEXL_LOOP_UNROLL_4
+  for (size_t j = 0; j < n / 8; ++j) {
+    __m512i v_p = _mm512_loadu_si512(vp_plain + j);
+    for (size_t k = 0; k < 2; ++k) {
+      const __m512i* vp_cipher =
+          reinterpret_cast<const __m512i*>(cipher + k * poly_size) + j;
+      __m512i* vp_result =
+          reinterpret_cast<__m512i*>(result + k * poly_size) + j;
+      __m512i v_hi, v_lo;
+      DyadicMultiplyProductAVX512<BitShift>(&v_hi, &v_lo, v_p,
+                                            _mm512_loadu_si512(vp_cipher));
+      DyadicMultiplyAddAVX512<BitShift>(&v_hi, &v_lo, v_zero,
+                                        _mm512_loadu_si512(vp_result));
+      _mm512_storeu_si512(
+          vp_result,
+          DyadicMultiplyReduceAVX512<BitShift>(v_hi, v_lo, v_modulus,
+                                               v_neg_modulus, v_twice_modulus,
+                                               v_barrett, v_shift));
+    }
+  }
+}
+
+template <int BitShift>
+void PlainMultiplyAccumulateShoupAVX512(uint64_t* result, const uint64_t* plain,
+                                        const uint64_t* plain_shoup,
+                                        const uint64_t* cipher, uint64_t n,
+                                        uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(plain_shoup != nullptr, "Require plain_shoup != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 2)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+
+  const __m512i* vp_plain = reinterpret_cast<const __m512i*>(plain);
+  const __m512i* vp_plain_shoup = reinterpret_cast<const __m512i*>(plain_shoup);
+  HEXL_LOOP_UNROLL_4
+  for (size_t j = 0; j < n / 8; ++j) {
+    __m512i v_p = _mm512_loadu_si512(vp_plain + j);
+    // floor(p * 2^52 / q) is the 64-bit factor floor(p * 2^64 / q) shifted
+    __m512i v_p_shoup = _mm512_loadu_si512(vp_plain_shoup + j);
+    if (BitShift == 52) {
+      v_p_shoup = _mm512_srli_epi64(v_p_shoup, 12);
+    }
+    for (size_t k = 0; k < 2; ++k) {
+      const __m512i* vp_cipher =
+          reinterpret_cast<const __m512i*>(cipher + k * poly_size) + j;
+      __m512i* vp_result =
+          reinterpret_cast<__m512i*>(result + k * poly_size) + j;
+      __m512i v_c = _mm512_loadu_si512(vp_cipher);
+      __m512i v_z;
+#ifdef HEXL_HAS_AVX512IFMA
+      if (BitShift == 52) {
+        // In [0, 2q), computed modulo 2^52
+        __m512i v_q_hat = _mm512_hexl_mulhi_epi<52>(v_c, v_p_shoup);
+        v_z = _mm512_hexl_mullo_add_lo_epi<52>(
+            _mm512_hexl_mullo_epi<52>(v_c, v_p), v_q_hat, v_neg_modulus);
+      }
+#endif
+      if (BitShift == 64) {
+        HEXL_UNUSED(v_neg_modulus);
+        // The approximate quotient is at most one too small, so the product
+        // is in [0, 3q)
+        __m512i v_q_hat = _mm512_hexl_mulhi_approx_epi<64>(v_c, v_p_shoup);
+        v_z = _mm512_sub_epi64(_mm512_hexl_mullo_epi<64>(v_c, v_p),
+                               _mm512_hexl_mullo_epi<64>(v_q_hat, v_modulus));
+      }
+      // In [0, 4q)
+      v_z = _mm512_add_epi64(v_z, _mm512_loadu_si512(vp_result));
+      _mm512_storeu_si512(vp_result, _mm512_hexl_small_mod_epu64<4>(
+                                         v_z, v_modulus, &v_twice_modulus));
+    }
+  }
+}
+
+template <int BitShift>
+void DiagonalMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* plain,
+                                      const uint64_t* cipher,
+                                      uint64_t num_terms,
+                                      uint64_t plain_stride,
+                                      uint64_t cipher_stride, uint64_t n,
+                                      uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(num_terms > 0, "Require num_terms > 0");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 3)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t barrett_factor =
+      MultiplyFactor(uint64_t(1) << shift, BitShift, modulus).BarrettFactor();
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, BitShift);
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  unsigned int v_shift = static_cast<unsigned int>(shift);
+
+  auto reduce = [&](__m512i v_hi, __m512i v_lo) {
+    DyadicTensorNormalizeAVX512<BitShift>(&v_hi, &v_lo);
+    return DyadicMultiplyReduceAVX512<BitShift>(v_hi, v_lo, v_modulus,
+                                                v_neg_modulus, v_twice_modulus,
+                                                v_barrett, v_shift);
+  };
+
+  // Unreduced sums of the two outputs over one tile, each as high and low
+  // words, kept in L1 cache while every term is streamed through
+  const size_t tile_size = 128;
+  alignas(64) uint64_t sums[4 * tile_size];
+  __m512i* vp_sums = reinterpret_cast<__m512i*>(sums);
+  const size_t tile_vectors = tile_size / 8;
+
+  for (size_t tile = 0; tile < n; tile += tile_size) {
+    size_t num_vectors = (std::min(tile + tile_size, static_cast<size_t>(n)) -
+                          tile) / 8;
+    // Number of products in each sum
+    uint64_t num_products = 0;
+
+    for (size_t i = 0; i < num_terms; ++i) {
+      const uint64_t* p = plain + i * plain_stride + tile;
+      const uint64_t* c = cipher + i * cipher_stride + tile;
+      bool fold = (num_products + 1 > max_terms);
+
+      for (size_t j = 0; j < num_vectors; ++j) {
+        __m512i v_p = _mm512_loadu_si512(p + 8 * j);
+        for (size_t k = 0; k < 2; ++k) {
+          __m512i v_c = _mm512_loadu_si512(c + k * poly_size + 8 * j);
+          __m512i v_hi, v_lo;
+          DyadicMultiplyProductAVX512<BitShift>(&v_hi, &v_lo, v_p, v_c);
+
+          __m512i* vp_hi = vp_sums + (2 * k) * tile_vectors + j;
+          __m512i* vp_lo = vp_sums + (2 * k + 1) * tile_vectors + j;
+          if (i != 0) {
+            __m512i v_sum_hi = _mm512_load_si512(vp_hi);
+            __m512i v_sum_lo = _mm512_load_si512(vp_lo);
+            if (fold) {
+              v_sum_lo = reduce(v_sum_hi, v_sum_lo);
+              v_sum_hi = _mm512_setzero_si512();
+            }
+            DyadicTensorAddAVX512<BitShift>(&v_hi, &v_lo, v_sum_hi, v_sum_lo);
+          }
+          _mm512_store_si512(vp_hi, v_hi);
+          _mm512_store_si512(vp_lo, v_lo);
+        }
+      }
+      num_products = (i == 0 || fold) ? 1 : num_products + 1;
+    }
+
+    for (size_t k = 0; k < 2; ++k) {
+      for (size_t j = 0; j < num_vectors; ++j) {
+        __m512i* vp_hi = vp_sums + (2 * k) * tile_vectors + j;
+        __m512i* vp_lo = vp_sums + (2 * k + 1) * tile_vectors + j;
+        __m512i v_sum_hi = _mm512_load_si512(vp_hi);
+        __m512i v_sum_lo = _mm512_load_si512(vp_lo);
+        _mm512_storeu_si512(result + k * poly_size + tile + 8 * j,
+                            reduce(v_sum_hi, v_sum_lo));
+      }
+    }
+  }
+}
+
+// If Square, operand2 is operand1, and each product x[i] * x[j] with i != j is
+// computed once, as x[i] * (2 * x[j])
+template <int BitShift, bool Square>
+inline void DyadicTensorAVX512Impl(uint64_t* result, const uint64_t* operand1,
+                                   uint64_t operand1_size,
+                                   const uint64_t* operand2,
+                                   uint64_t operand2_size, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(operand1_size > 0, "Require operand1_size > 0");
+  HEXL_CHECK(operand2_size > 0, "Require operand2_size > 0");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << (BitShift - 3)),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t barrett_factor =
+      MultiplyFactor(uint64_t(1) << shift, BitShift, modulus).BarrettFactor();
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, BitShift);
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  unsigned int v_shift = static_cast<unsigned int>(shift);
+
+  auto reduce = [&](__m512i v_hi, __m512i v_lo) {
+    DyadicTensorNormalizeAVX512<BitShift>(&v_hi, &v_lo);
+    return DyadicMultiplyReduceAVX512<BitShift>(v_hi, v_lo, v_modulus,
+                                                v_neg_modulus, v_twice_modulus,
+                                                v_barrett, v_shift);
+  };
+
+  // Outputs are computed one at a time over short tiles, so the number of
+  // products in the inner loop is the same for each vector. Within each tile,
+  // output k overwrites only inputs with index k, which are not read by the
+  // remaining outputs
+  size_t result_size = operand1_size + operand2_size - 1;
+  const size_t tile_size = 256;
+  for (size_t tile = 0; tile < n; tile += tile_size) {
+    size_t tile_end = std::min(tile + tile_size, static_cast<size_t>(n));
+    for (size_t k = result_size; k-- > 0;) {
+      size_t i_begin = (k < operand2_size) ? 0 : k - operand2_size + 1;
+      size_t i_end = std::min(k + 1, static_cast<size_t>(operand1_size));
+      for (size_t l = tile; l < tile_end; l += 8) {
+        __m512i v_sum_hi = _mm512_setzero_si512();
+        __m512i v_sum_lo = _mm512_setzero_si512();
+        uint64_t num_terms = 0;
+
+        // Adds x * y, counted as term_count terms, to the sum
+        auto accumulate = [&](__m512i v_x, __m512i v_y, uint64_t term_count) {
+          if (num_terms == 0) {
+            DyadicMultiplyProductAVX512<BitShift>(&v_sum_hi, &v_sum_lo, v_x,
+                                                  v_y);
+            num_terms = term_count;
+            return;
+          }
+          if (num_terms + term_count > max_terms) {
+            v_sum_lo = reduce(v_sum_hi, v_sum_lo);
+            v_sum_hi = _mm512_setzero_si512();
+            num_terms = 0;
+          }
+          __m512i v_prod_hi, v_prod_lo;
+          DyadicMultiplyProductAVX512<BitShift>(&v_prod_hi, &v_prod_lo, v_x,
+                                                v_y);
+          DyadicTensorAddAVX512<BitShift>(&v_sum_hi, &v_sum_lo, v_prod_hi,
+                                          v_prod_lo);
+          num_terms += term_count;
+        };
+
+        if (Square) {
+          for (size_t i = i_begin; 2 * i < k; ++i) {
+            __m512i v_x = _mm512_loadu_si512(operand1 + i * poly_size + l);
+            __m512i v_y =
+                _mm512_loadu_si512(operand1 + (k - i) * poly_size + l);
+            accumulate(v_x, _mm512_add_epi64(v_y, v_y), 2);
+          }
+          if (k % 2 == 0) {
+            __m512i v_x =
+                _mm512_loadu_si512(operand1 + (k / 2) * poly_size + l);
+            accumulate(v_x, v_x, 1);
+          }
+        } else {
+          for (size_t i = i_begin; i < i_end; ++i) {
+            __m512i v_x = _mm512_loadu_si512(operand1 + i * poly_size + l);
+            __m512i v_y =
+                _mm512_loadu_si512(operand2 + (k - i) * poly_size + l);
+            accumulate(v_x, v_y, 1);
+          }
+        }
+        _mm512_storeu_si512(result + k * poly_size + l,
+                            reduce(v_sum_hi, v_sum_lo));
+      }
+    }
+  }
+}
+
+template <int BitShift>
+void DyadicTensorProductAVX512(uint64_t* result, const uint64_t* operand1,
+                               uint64_t operand1_size, const uint64_t* operand2,
+                               uint64_t operand2_size, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus) {
+  DyadicTensorAVX512Impl<BitShift, false>(result, operand1, operand1_size,
+                                          operand2, operand2_size, n,
+                                          poly_size, modulus);
+}
+
+template <int BitShift>
+void DyadicTensorSquareAVX512(uint64_t* result, const uint64_t* operand,
+                              uint64_t operand_size, uint64_t n,
+                              uint64_t poly_size, uint64_t modulus) {
+  DyadicTensorAVX512Impl<BitShift, true>(result, operand, operand_size,
+                                         operand, operand_size, n, poly_size,
+                                         modulus);
+}
+
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
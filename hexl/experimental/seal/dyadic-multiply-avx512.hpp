@@ -0,0 +1,130 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+/// @brief Returns the number of products less than modulus^2 which, together
+/// with one value less than \p modulus, sum to less than 2^(L + bit_shift - 2),
+/// where L = Log2(modulus) + 1, and at most 2^10. This is at least 2 for
+/// modulus less than 2^(bit_shift - 3)
+inline uint64_t DyadicTensorMaxTerms(uint64_t modulus, uint64_t bit_shift) {
+  return uint64_t(1) << std::min(bit_shift - 3 - Log2(modulus), uint64_t(10));
+}
+
+#ifdef HEXL_HAS_AVX512DQ
+
+/// @brief Computes dyadic multiplication of one RNS limb in a single pass
+/// @details Parameters are as in DyadicMultiplyFusedNative. \p n must be a
+/// multiple of 8. For BitShift == 52, \p modulus must be less than 2^49
+template <int BitShift>
+void DyadicMultiplyFusedAVX512(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb in a single pass
+/// using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiplyFusedAVX512
+template <int BitShift>
+void DyadicMultiplyKaratsubaAVX512(uint64_t* result, const uint64_t* operand1,
+                                   const uint64_t* operand2, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb of each of a batch of
+/// ciphertext pairs in a single pass
+/// @details Parameters are as in DyadicMultiplyFusedNative for a batch, with
+/// the constants for \p modulus set up once
+template <int BitShift>
+void DyadicMultiplyFusedAVX512(uint64_t* const* results,
+                               const uint64_t* const* operand1s,
+                               const uint64_t* const* operand2s,
+                               uint64_t batch_size, uint64_t offset,
+                               uint64_t n, uint64_t poly_size,
+                               uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb of each of a batch of
+/// ciphertext pairs in a single pass using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiplyFusedAVX512 for a batch
+template <int BitShift>
+void DyadicMultiplyKaratsubaAVX512(uint64_t* const* results,
+                                   const uint64_t* const* operand1s,
+                                   const uint64_t* const* operand2s,
+                                   uint64_t batch_size, uint64_t offset,
+                                   uint64_t n, uint64_t poly_size,
+                                   uint64_t modulus);
+
+/// @brief Computes the sum of the dyadic products of one RNS limb of a
+/// sequence of ciphertext pairs in a single pass
+/// @details Parameters are as in DyadicMultiplyAccumulateNative. \p n must be
+/// a multiple of 8. For BitShift == 52, \p modulus must be less than 2^49
+template <int BitShift>
+void DyadicMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* operand1,
+                                    const uint64_t* operand2,
+                                    uint64_t num_pairs, uint64_t pair_stride,
+                                    uint64_t n, uint64_t poly_size,
+                                    uint64_t modulus);
+
+/// @brief Adds the product of one RNS limb of a plaintext and a ciphertext to
+/// a ciphertext in a single pass
+/// @details Parameters are as in PlainMultiplyAccumulateNative, without
+/// Shoup factors. \p n must be a multiple of 8. For BitShift == 52, \p
+/// modulus must be less than 2^49
+template <int BitShift>
+void PlainMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus);
+
+/// @brief Adds the product of one RNS limb of a plaintext and a ciphertext to
+/// a ciphertext in a single pass, using Shoup factors of the plaintext
+/// @details Parameters are as in PlainMultiplyAccumulateNative. \p n must be
+/// a multiple of 8. For BitShift == 52, \p modulus must be less than 2^50
+template <int BitShift>
+void PlainMultiplyAccumulateShoupAVX512(uint64_t* result, const uint64_t* plain,
+                                        const uint64_t* plain_shoup,
+                                        const uint64_t* cipher, uint64_t n,
+                                        uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the sum of the products of one RNS limb of a sequence of
+/// plaintexts and ciphertexts in a single pass
+/// @details Parameters are as in DiagonalMultiplyAccumulateNative. \p n must
+/// be a multiple of 8. For BitShift == 52, \p modulus must be less than 2^49
+template <int BitShift>
+void DiagonalMultiplyAccumulateAVX512(uint64_t* result, const uint64_t* plain,
+                                      const uint64_t* cipher,
+                                      uint64_t num_terms,
+                                      uint64_t plain_stride,
+                                      uint64_t cipher_stride, uint64_t n,
+                                      uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the dyadic tensor product of one RNS limb in a single pass
+/// @details Parameters are as in DyadicTensorProductNative. \p n must be a
+/// multiple of 8. For BitShift == 52, \p modulus must be less than 2^49
+template <int BitShift>
+void DyadicTensorProductAVX512(uint64_t* result, const uint64_t* operand1,
+                               uint64_t operand1_size, const uint64_t* operand2,
+                               uint64_t operand2_size, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the dyadic tensor square of one RNS limb in a single pass
+/// @details Parameters are as in DyadicTensorProductAVX512, with \p operand
+/// as both arguments
+template <int BitShift>
+void DyadicTensorSquareAVX512(uint64_t* result, const uint64_t* operand,
+                              uint64_t operand_size, uint64_t n,
+                              uint64_t poly_size, uint64_t modulus);
+
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
@@ -3,76 +3,961 @@
 
 #include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
 
+#include <algorithm>
+
+#include "experimental/seal/dyadic-multiply-avx512.hpp"
 #include "hexl/eltwise/eltwise-add-mod.hpp"
 #include "hexl/eltwise/eltwise-mult-mod.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/cache-info.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "hexl/util/pool-allocator.hpp"
+#include "hexl/util/types.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
 namespace internal {
 
+// Bounds the workspace independently of the cache sizes, which may change
+// between DyadicMultiplyWorkspaceSize and DyadicMultiply
+inline uint64_t DyadicMultiplyMaxTileSize(uint64_t n) {
+  return std::min(n, uint64_t(4096));
+}
+
+// The four operand tiles, the three result tiles and the temporary tile fit
+// in the L1 data cache
+inline uint64_t DyadicMultiplyTileSize(uint64_t n) {
+  return std::min(CacheTileSize(n, GetL1DataCacheSize(), 8),
+                  DyadicMultiplyMaxTileSize(n));
+}
+
+// The AVX512 kernels process 8 coefficients at a time
+inline const DispatchTable& DyadicMultiplyTable(uint64_t n) {
+  return (n % 8 == 0) ? GetDispatchTable() : GetNativeDispatchTable();
+}
+
+uint64_t DyadicMultiplyWorkspaceSize(uint64_t n) {
+  return DyadicMultiplyMaxTileSize(n);
+}
+
+// Reduces x < 2^(L + 62) modulo q, where L = Log2(q) + 1, using Algorithm 2
+// from https://homes.esat.kuleuven.be/~fvercaut/papers/bar_mont.pdf with
+// beta = -2
+inline uint64_t DyadicMultiplyReduce(uint128_t x, uint64_t modulus,
+                                     uint64_t twice_modulus,
+                                     uint64_t barrett_factor, uint64_t shift) {
+  uint64_t c1 = static_cast<uint64_t>(x >> shift);
+  uint64_t q_hat = MultiplyUInt64Hi<64>(c1, barrett_factor);
+  // In [0, 3q)
+  uint64_t z = static_cast<uint64_t>(x) - q_hat * modulus;
+  return ReduceMod<4>(z, modulus, &twice_modulus);
+}
+
+inline uint64_t DyadicMultiplyBarrettFactor(uint64_t modulus) {
+  return MultiplyFactor(uint64_t(1) << (Log2(modulus) + 1 + 62 - 64), 64,
+                        modulus)
+      .BarrettFactor();
+}
+
+// Computes one limb for each of batch_size ciphertext pairs, at the given
+// offset from each pointer, with the constants set up once
+template <bool Karatsuba>
+inline void DyadicMultiplyNativeImpl(uint64_t* const* results,
+                                     const uint64_t* const* operand1s,
+                                     const uint64_t* const* operand2s,
+                                     uint64_t batch_size, uint64_t offset,
+                                     uint64_t n, uint64_t poly_size,
+                                     uint64_t modulus) {
+  HEXL_CHECK(results != nullptr, "Require results != nullptr");
+  HEXL_CHECK(operand1s != nullptr, "Require operand1s != nullptr");
+  HEXL_CHECK(operand2s != nullptr, "Require operand2s != nullptr");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+
+  for (size_t b = 0; b < batch_size; ++b) {
+    const uint64_t* operand1 = operand1s[b] + offset;
+    const uint64_t* operand2 = operand2s[b] + offset;
+    uint64_t* result = results[b] + offset;
+    HEXL_CHECK_BOUNDS(operand1, n, modulus,
+                      "operand1 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand1 + poly_size, n, modulus,
+                      "operand1 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand2, n, modulus,
+                      "operand2 exceeds bound " << modulus);
+    HEXL_CHECK_BOUNDS(operand2 + poly_size, n, modulus,
+                      "operand2 exceeds bound " << modulus);
+
+    // All inputs of a coefficient are read before any output is written
+    for (size_t l = 0; l < n; ++l) {
+      uint64_t x0 = operand1[l];
+      uint64_t x1 = operand1[l + poly_size];
+      uint64_t y0 = operand2[l];
+      uint64_t y1 = operand2[l + poly_size];
+
+      uint128_t prod0 = MultiplyUInt64(x0, y0);
+      uint128_t prod2 = MultiplyUInt64(x1, y1);
+      uint128_t prod1;
+      if (Karatsuba) {
+        // Exact, so the middle product is at most 2 * (q - 1)^2
+        prod1 = MultiplyUInt64(x0 + x1, y0 + y1) - prod0 - prod2;
+      } else {
+        prod1 = MultiplyUInt64(x0, y1) + MultiplyUInt64(x1, y0);
+      }
+
+      result[l] = DyadicMultiplyReduce(prod0, modulus, twice_modulus,
+                                       barrett_factor, shift);
+      result[l + poly_size] = DyadicMultiplyReduce(
+          prod1, modulus, twice_modulus, barrett_factor, shift);
+      result[l + 2 * poly_size] = DyadicMultiplyReduce(
+          prod2, modulus, twice_modulus, barrett_factor, shift);
+    }
+  }
+}
+
+void DyadicMultiplyFusedNative(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus) {
+  DyadicMultiplyNativeImpl<false>(&result, &operand1, &operand2, 1, 0, n,
+                                  poly_size, modulus);
+}
+
+void DyadicMultiplyKaratsubaNative(uint64_t* result, const uint64_t* operand1,
+                                   const uint64_t* operand2, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  DyadicMultiplyNativeImpl<true>(&result, &operand1, &operand2, 1, 0, n,
+                                 poly_size, modulus);
+}
+
+void DyadicMultiplyFusedNative(uint64_t* const* results,
+                               const uint64_t* const* operand1s,
+                               const uint64_t* const* operand2s,
+                               uint64_t batch_size, uint64_t offset,
+                               uint64_t n, uint64_t poly_size,
+                               uint64_t modulus) {
+  DyadicMultiplyNativeImpl<false>(results, operand1s, operand2s, batch_size,
+                                  offset, n, poly_size, modulus);
+}
+
+void DyadicMultiplyKaratsubaNative(uint64_t* const* results,
+                                   const uint64_t* const* operand1s,
+                                   const uint64_t* const* operand2s,
+                                   uint64_t batch_size, uint64_t offset,
+                                   uint64_t n, uint64_t poly_size,
+                                   uint64_t modulus) {
+  DyadicMultiplyNativeImpl<true>(results, operand1s, operand2s, batch_size,
+                                 offset, n, poly_size, modulus);
+}
+
+void DyadicMultiplyAccumulateNative(uint64_t* result, const uint64_t* operand1,
+                                    const uint64_t* operand2,
+                                    uint64_t num_pairs, uint64_t pair_stride,
+                                    uint64_t n, uint64_t poly_size,
+                                    uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(num_pairs > 0, "Require num_pairs > 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, 64);
+
+  for (size_t l = 0; l < n; ++l) {
+    uint128_t sum0 = 0;
+    uint128_t sum1 = 0;
+    uint128_t sum2 = 0;
+    // Number of products in the middle sum, which grows fastest
+    uint64_t num_terms = 0;
+    for (size_t r = 0; r < num_pairs; ++r) {
+      if (num_terms + 2 > max_terms) {
+        sum0 = DyadicMultiplyReduce(sum0, modulus, twice_modulus,
+                                    barrett_factor, shift);
+        sum1 = DyadicMultiplyReduce(sum1, modulus, twice_modulus,
+                                    barrett_factor, shift);
+        sum2 = DyadicMultiplyReduce(sum2, modulus, twice_modulus,
+                                    barrett_factor, shift);
+        num_terms = 0;
+      }
+      const uint64_t* x = operand1 + r * pair_stride + l;
+      const uint64_t* y = operand2 + r * pair_stride + l;
+      sum0 += MultiplyUInt64(x[0], y[0]);
+      sum1 += MultiplyUInt64(x[0], y[poly_size]) +
+              MultiplyUInt64(x[poly_size], y[0]);
+      sum2 += MultiplyUInt64(x[poly_size], y[poly_size]);
+      num_terms += 2;
+    }
+    result[l] = DyadicMultiplyReduce(sum0, modulus, twice_modulus,
+                                     barrett_factor, shift);
+    result[l + poly_size] = DyadicMultiplyReduce(sum1, modulus, twice_modulus,
+                                                 barrett_factor, shift);
+    result[l + 2 * poly_size] = DyadicMultiplyReduce(
+        sum2, modulus, twice_modulus, barrett_factor, shift);
+  }
+}
+
+void PlainMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* plain_shoup,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+
+  uint64_t twice_modulus = 2 * modulus;
+  if (plain_shoup != nullptr) {
+    HEXL_CHECK(modulus < (1ULL << 62), "Require modulus < 2^62");
+    for (size_t k = 0; k < 2; ++k) {
+      const uint64_t* c = cipher + k * poly_size;
+      uint64_t* r = result + k * poly_size;
+      for (size_t l = 0; l < n; ++l) {
+        // In [0, 3q)
+        uint64_t sum = MultiplyModLazy<64>(c[l], plain[l], plain_shoup[l],
+                                           modulus) +
+                       r[l];
+        sum = (sum >= twice_modulus) ? sum - twice_modulus : sum;
+        r[l] = (sum >= modulus) ? sum - modulus : sum;
+      }
+    }
+    return;
+  }
+
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+  for (size_t k = 0; k < 2; ++k) {
+    const uint64_t* c = cipher + k * poly_size;
+    uint64_t* r = result + k * poly_size;
+    for (size_t l = 0; l < n; ++l) {
+      r[l] = DyadicMultiplyReduce(MultiplyUInt64(plain[l], c[l]) + r[l],
+                                  modulus, twice_modulus, barrett_factor,
+                                  shift);
+    }
+  }
+}
+
+void PlainMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus) {
+  PlainMultiplyAccumulateNative(result, plain, nullptr, cipher, n, poly_size,
+                                modulus);
+}
+
+void DiagonalMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                      const uint64_t* cipher,
+                                      uint64_t num_terms,
+                                      uint64_t plain_stride,
+                                      uint64_t cipher_stride, uint64_t n,
+                                      uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(num_terms > 0, "Require num_terms > 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, 64);
+
+  for (size_t l = 0; l < n; ++l) {
+    uint128_t sum0 = 0;
+    uint128_t sum1 = 0;
+    uint64_t num_products = 0;
+    for (size_t i = 0; i < num_terms; ++i) {
+      if (num_products + 1 > max_terms) {
+        sum0 = DyadicMultiplyReduce(sum0, modulus, twice_modulus,
+                                    barrett_factor, shift);
+        sum1 = DyadicMultiplyReduce(sum1, modulus, twice_modulus,
+                                    barrett_factor, shift);
+        num_products = 0;
+      }
+      uint64_t p = plain[i * plain_stride + l];
+      const uint64_t* c = cipher + i * cipher_stride + l;
+      sum0 += MultiplyUInt64(p, c[0]);
+      sum1 += MultiplyUInt64(p, c[poly_size]);
+      ++num_products;
+    }
+    result[l] = DyadicMultiplyReduce(sum0, modulus, twice_modulus,
+                                     barrett_factor, shift);
+    result[l + poly_size] = DyadicMultiplyReduce(sum1, modulus, twice_modulus,
+                                                 barrett_factor, shift);
+  }
+}
+
+void DyadicTensorProductNative(uint64_t* result, const uint64_t* operand1,
+                               uint64_t operand1_size, const uint64_t* operand2,
+                               uint64_t operand2_size, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(operand1_size > 0, "Require operand1_size > 0");
+  HEXL_CHECK(operand2_size > 0, "Require operand2_size > 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, 64);
+  size_t result_size = operand1_size + operand2_size - 1;
+
+  for (size_t l = 0; l < n; ++l) {
+    // Output k overwrites only inputs with index k, which are not read by the
+    // remaining outputs
+    for (size_t k = result_size; k-- > 0;) {
+      size_t i_begin = (k < operand2_size) ? 0 : k - operand2_size + 1;
+      size_t i_end = std::min(k + 1, static_cast<size_t>(operand1_size));
+      uint128_t sum = 0;
+      uint64_t num_terms = 0;
+      for (size_t i = i_begin; i < i_end; ++i) {
+        if (num_terms == max_terms) {
+          sum = DyadicMultiplyReduce(sum, modulus, twice_modulus,
+                                     barrett_factor, shift);
+          num_terms = 0;
+        }
+        sum += MultiplyUInt64(operand1[i * poly_size + l],
+                              operand2[(k - i) * poly_size + l]);
+        ++num_terms;
+      }
+      result[k * poly_size + l] = DyadicMultiplyReduce(
+          sum, modulus, twice_modulus, barrett_factor, shift);
+    }
+  }
+}
+
+void DyadicTensorSquareNative(uint64_t* result, const uint64_t* operand,
+                              uint64_t operand_size, uint64_t n,
+                              uint64_t poly_size, uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(operand_size > 0, "Require operand_size > 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t barrett_factor = DyadicMultiplyBarrettFactor(modulus);
+  uint64_t shift = Log2(modulus) - 1;
+  uint64_t max_terms = DyadicTensorMaxTerms(modulus, 64);
+  size_t result_size = 2 * operand_size - 1;
+
+  for (size_t l = 0; l < n; ++l) {
+    for (size_t k = result_size; k-- > 0;) {
+      size_t i_begin = (k < operand_size) ? 0 : k - operand_size + 1;
+      uint128_t sum = 0;
+      uint64_t num_terms = 0;
+      // x[i] * x[k - i] and x[k - i] * x[i] as one product x[i] * 2x[k - i],
+      // which counts as two terms
+      for (size_t i = i_begin; 2 * i < k; ++i) {
+        if (num_terms + 2 > max_terms) {
+          sum = DyadicMultiplyReduce(sum, modulus, twice_modulus,
+                                     barrett_factor, shift);
+          num_terms = 0;
+        }
+        sum += MultiplyUInt64(operand[i * poly_size + l],
+                              2 * operand[(k - i) * poly_size + l]);
+        num_terms += 2;
+      }
+      if (k % 2 == 0) {
+        if (num_terms == max_terms) {
+          sum = DyadicMultiplyReduce(sum, modulus, twice_modulus,
+                                     barrett_factor, shift);
+        }
+        uint64_t x = operand[(k / 2) * poly_size + l];
+        sum += MultiplyUInt64(x, x);
+      }
+      result[k * poly_size + l] = DyadicMultiplyReduce(
+          sum, modulus, twice_modulus, barrett_factor, shift);
+    }
+  }
+}
+
+// Computes one RNS limb of the dyadic product with separate element-wise
+// multiplications
+inline void DyadicMultiplyTiled(uint64_t* result, const uint64_t* operand1,
+                                const uint64_t* operand2, uint64_t n,
+                                uint64_t poly_size, uint64_t modulus,
+                                uint64_t* temp) {
+  size_t tile_size = DyadicMultiplyTileSize(n);
+
+  // Split by tiles for better caching
+  for (size_t poly0_offset = 0; poly0_offset < n; poly0_offset += tile_size) {
+    size_t length = std::min(tile_size, static_cast<size_t>(n) - poly0_offset);
+    size_t poly1_offset = poly0_offset + poly_size;
+    size_t poly2_offset = poly0_offset + 2 * poly_size;
+
+    // Compute third output polynomial
+    // Output written directly to result rather than temporary buffer
+    // result[2] = x[1] * y[1]
+    intel::hexl::EltwiseMultMod(&result[poly2_offset], operand1 + poly1_offset,
+                                operand2 + poly1_offset, length, modulus, 1);
+
+    // Compute second output polynomial
+    // result[1] = x[1] * y[0]
+    intel::hexl::EltwiseMultMod(temp, operand1 + poly1_offset,
+                                operand2 + poly0_offset, length, modulus, 1);
+    // result[1] = x[0] * y[1]
+    intel::hexl::EltwiseMultMod(&result[poly1_offset], operand1 + poly0_offset,
+                                operand2 + poly1_offset, length, modulus, 1);
+    // result[1] += temp_poly
+    intel::hexl::EltwiseAddMod(&result[poly1_offset], temp,
+                               &result[poly1_offset], length, modulus);
+
+    // Compute first output polynomial
+    // result[0] = x[0] * y[0]
+    intel::hexl::EltwiseMultMod(&result[poly0_offset], operand1 + poly0_offset,
+                                operand2 + poly0_offset, length, modulus, 1);
+  }
+}
+
+// Computes one RNS limb, at the given offset, of each of a batch of ciphertext
+// pairs in a single pass. Returns false, without computing the limbs, where
+// separate element-wise multiplications are faster
+inline bool DyadicMultiplySinglePass(uint64_t* const* results,
+                                     const uint64_t* const* operand1s,
+                                     const uint64_t* const* operand2s,
+                                     uint64_t batch_size, uint64_t offset,
+                                     uint64_t n, uint64_t poly_size,
+                                     uint64_t modulus, bool karatsuba) {
+  if (modulus >= (1ULL << 61)) {
+    return false;
+  }
+  // Where AVX512DQ is the fastest backend, Karatsuba multiplication is used
+  // even if not requested: each 64-bit product takes several multiplications,
+  // so saving one product outweighs the extra additions
+  const DispatchTable& table = DyadicMultiplyTable(n);
+  const KernelVariant<DyadicMultiplyBatchFunction>& variant =
+      karatsuba ? table.dyadic_multiply_karatsuba.Select(modulus)
+                : table.dyadic_multiply.Select(modulus);
+  if (variant.function == nullptr) {
+    // EltwiseMultMod uses faster floating-point multiplication for these
+    return false;
+  }
+  variant.function(results, operand1s, operand2s, batch_size, offset, n,
+                   poly_size, modulus);
+  return true;
+}
+
+// Returns the slowest backend which DyadicMultiplySinglePass or
+// DyadicMultiplyTiled selects for any of the moduli
+inline Backend DyadicMultiplyBackend(uint64_t n, const uint64_t* moduli,
+                                     uint64_t num_moduli) {
+  uint64_t min_modulus = *std::min_element(moduli, moduli + num_moduli);
+  uint64_t max_modulus = *std::max_element(moduli, moduli + num_moduli);
+  if (n % 8 != 0 && min_modulus < (1ULL << 61)) {
+    return Backend::kNative;
+  }
+  return GetKernelBackend(Kernel::kDyadicMultiply, max_modulus);
+}
+
+// Output ciphertext has 3 polynomials, where x, y are the input ciphertexts:
+// (x[0] * y[0], x[0] * y[1] + x[1] * y[0], x[1] * y[1])
+inline void DyadicMultiplyImpl(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               const uint64_t* moduli, uint64_t num_moduli,
+                               uint64_t* workspace, bool karatsuba) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+
+  // pointer increment to switch to a next polynomial
+  size_t poly_size = n * num_moduli;
+
+  // Reads two ciphertexts of 2 polynomials and writes 3 polynomials
+  KernelTimer timer(Kernel::kDyadicMultiply, n, moduli, num_moduli,
+                    4 * poly_size, 7 * poly_size * sizeof(uint64_t));
+  if (timer.IsEnabled()) {
+    timer.SetBackend(DyadicMultiplyBackend(n, moduli, num_moduli));
+  }
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+
+  // Modulus by modulus
+  for (size_t i = 0; i < num_moduli; i++) {
+    size_t i_times_n = i * n;
+    if (DyadicMultiplySinglePass(&result, &operand1, &operand2, 1, i_times_n,
+                                 n, poly_size, moduli[i], karatsuba)) {
+      continue;
+    }
+
+    if (workspace == nullptr) {
+      owned_workspace.resize(DyadicMultiplyWorkspaceSize(n));
+      workspace = owned_workspace.data();
+    }
+    DyadicMultiplyTiled(result + i_times_n, operand1 + i_times_n,
+                        operand2 + i_times_n, n, poly_size, moduli[i],
+                        workspace);
+  }
+}
+
 void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
                     const uint64_t* operand2, uint64_t n,
-                    const uint64_t* moduli, uint64_t num_moduli) {
+                    const uint64_t* moduli, uint64_t num_moduli,
+                    uint64_t* workspace) {
+  DyadicMultiplyImpl(result, operand1, operand2, n, moduli, num_moduli,
+                     workspace, false);
+}
+
+void DyadicMultiplyKaratsuba(uint64_t* result, const uint64_t* operand1,
+                             const uint64_t* operand2, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             uint64_t* workspace) {
+  DyadicMultiplyImpl(result, operand1, operand2, n, moduli, num_moduli,
+                     workspace, true);
+}
+
+// Computes one RNS limb of the sum of the dyadic products of a sequence of
+// ciphertext pairs with separate element-wise multiplications. Each tile of
+// the result is accumulated in place while every pair is streamed through
+inline void DyadicMultiplyAccumulateTiled(uint64_t* result,
+                                          const uint64_t* operand1,
+                                          const uint64_t* operand2,
+                                          uint64_t num_pairs,
+                                          uint64_t pair_stride, uint64_t n,
+                                          uint64_t poly_size, uint64_t modulus,
+                                          uint64_t* temp) {
+  size_t tile_size = DyadicMultiplyTileSize(n);
+
+  for (size_t offset = 0; offset < n; offset += tile_size) {
+    size_t length = std::min(tile_size, static_cast<size_t>(n) - offset);
+    uint64_t* out0 = result + offset;
+    uint64_t* out1 = out0 + poly_size;
+    uint64_t* out2 = out0 + 2 * poly_size;
+    for (size_t r = 0; r < num_pairs; ++r) {
+      const uint64_t* x0 = operand1 + r * pair_stride + offset;
+      const uint64_t* x1 = x0 + poly_size;
+      const uint64_t* y0 = operand2 + r * pair_stride + offset;
+      const uint64_t* y1 = y0 + poly_size;
+      if (r == 0) {
+        EltwiseMultMod(out0, x0, y0, length, modulus, 1);
+        EltwiseMultMod(out1, x0, y1, length, modulus, 1);
+        EltwiseMultMod(temp, x1, y0, length, modulus, 1);
+        EltwiseAddMod(out1, out1, temp, length, modulus);
+        EltwiseMultMod(out2, x1, y1, length, modulus, 1);
+        continue;
+      }
+      EltwiseMultMod(temp, x0, y0, length, modulus, 1);
+      EltwiseAddMod(out0, out0, temp, length, modulus);
+      EltwiseMultMod(temp, x0, y1, length, modulus, 1);
+      EltwiseAddMod(out1, out1, temp, length, modulus);
+      EltwiseMultMod(temp, x1, y0, length, modulus, 1);
+      EltwiseAddMod(out1, out1, temp, length, modulus);
+      EltwiseMultMod(temp, x1, y1, length, modulus, 1);
+      EltwiseAddMod(out2, out2, temp, length, modulus);
+    }
+  }
+}
+
+// Computes one RNS limb of the sum of the dyadic products of a sequence of
+// ciphertext pairs in a single pass. Returns false, without computing the
+// limb, where separate element-wise multiplications are faster
+inline bool DyadicMultiplyAccumulateSinglePass(
+    uint64_t* result, const uint64_t* operand1, const uint64_t* operand2,
+    uint64_t num_pairs, uint64_t pair_stride, uint64_t n, uint64_t poly_size,
+    uint64_t modulus) {
+  if (modulus >= (1ULL << 61)) {
+    return false;
+  }
+  DyadicMultiplyTable(n).dyadic_multiply_accumulate.Select(modulus).function(
+      result, operand1, operand2, num_pairs, pair_stride, n, poly_size,
+      modulus);
+  return true;
+}
+
+void DyadicMultiplyAccumulate(uint64_t* result, const uint64_t* operand1,
+                              const uint64_t* operand2, uint64_t num_pairs,
+                              uint64_t n, const uint64_t* moduli,
+                              uint64_t num_moduli, uint64_t* workspace) {
   HEXL_CHECK(result != nullptr, "Require result != nullptr");
   HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
   HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
   HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
   HEXL_CHECK(n != 0, "Require n != 0");
+  HEXL_CHECK(num_pairs != 0, "Require num_pairs != 0");
 
-  // pointer increment to switch to a next polynomial
   size_t poly_size = n * num_moduli;
+  size_t pair_stride = 2 * poly_size;
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
 
-  // Output ciphertext has 3 polynomials, where x, y are the input
-  // ciphertexts: (x[0] * y[0], x[0] * y[1] + x[1] * y[0], x[1] * y[1])
+  for (size_t i = 0; i < num_moduli; i++) {
+    size_t i_times_n = i * n;
+    if (DyadicMultiplyAccumulateSinglePass(
+            result + i_times_n, operand1 + i_times_n, operand2 + i_times_n,
+            num_pairs, pair_stride, n, poly_size, moduli[i])) {
+      continue;
+    }
 
-  // TODO(fboemer): Determine based on cpu cache size
-  size_t tile_size = std::min(n, uint64_t(512));
-  size_t num_tiles = n / tile_size;
+    if (workspace == nullptr) {
+      owned_workspace.resize(DyadicMultiplyWorkspaceSize(n));
+      workspace = owned_workspace.data();
+    }
+    DyadicMultiplyAccumulateTiled(result + i_times_n, operand1 + i_times_n,
+                                  operand2 + i_times_n, num_pairs, pair_stride,
+                                  n, poly_size, moduli[i], workspace);
+  }
+}
 
-  AlignedVector64<uint64_t> temp(tile_size, 0);
+// Adds the product of one RNS limb of a plaintext and a ciphertext to the
+// result with separate element-wise multiplications
+inline void PlainMultiplyAccumulateTiled(uint64_t* result,
+                                         const uint64_t* plain,
+                                         const uint64_t* cipher, uint64_t n,
+                                         uint64_t poly_size, uint64_t modulus,
+                                         uint64_t* temp) {
+  size_t tile_size = DyadicMultiplyTileSize(n);
+  for (size_t offset = 0; offset < n; offset += tile_size) {
+    size_t length = std::min(tile_size, static_cast<size_t>(n) - offset);
+    for (size_t k = 0; k < 2; ++k) {
+      uint64_t* out = result + k * poly_size + offset;
+      EltwiseMultMod(temp, plain + offset, cipher + k * poly_size + offset,
+                     length, modulus, 1);
+      EltwiseAddMod(out, out, temp, length, modulus);
+    }
+  }
+}
+
+void PlainMultiplyAccumulateLimb(uint64_t* result, const uint64_t* plain,
+                                 const uint64_t* plain_shoup,
+                                 const uint64_t* cipher, uint64_t n,
+                                 uint64_t poly_size, uint64_t modulus,
+                                 uint64_t* temp) {
+  const DispatchTable& table = DyadicMultiplyTable(n);
+  if (plain_shoup != nullptr) {
+    table.plain_multiply_accumulate_shoup.Select(modulus).function(
+        result, plain, plain_shoup, cipher, n, poly_size, modulus);
+    return;
+  }
+
+  // As for DyadicMultiply, the element-wise floating-point multiplication
+  // is faster than a single AVX512DQ pass for moduli less than 2^50
+  if (modulus < (1ULL << 61)) {
+    const auto& variant = table.plain_multiply_accumulate.Select(modulus);
+    if (variant.function != nullptr) {
+      variant.function(result, plain, cipher, n, poly_size, modulus);
+      return;
+    }
+  }
+
+  HEXL_CHECK(temp != nullptr, "Require temp != nullptr");
+  PlainMultiplyAccumulateTiled(result, plain, cipher, n, poly_size, modulus,
+                               temp);
+}
+
+void PlainMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                             const uint64_t* cipher, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             const uint64_t* plain_shoup, uint64_t* workspace) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(cipher != nullptr, "Require cipher != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+
+  size_t poly_size = n * num_moduli;
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(DyadicMultiplyWorkspaceSize(n));
+    workspace = owned_workspace.data();
+  }
 
-  // Modulus by modulus
   for (size_t i = 0; i < num_moduli; i++) {
-    // Split by tiles for better caching
     size_t i_times_n = i * n;
-    for (size_t tile = 0; tile < num_tiles; ++tile) {
-      size_t poly0_offset = i_times_n + tile_size * tile;
-      size_t poly1_offset = poly0_offset + poly_size;
-      size_t poly2_offset = poly0_offset + 2 * poly_size;
-
-      // Compute third output polynomial
-      // Output written directly to result rather than temporary buffer
-      // result[2] = x[1] * y[1]
-      intel::hexl::EltwiseMultMod(
-          &result[poly2_offset], operand1 + poly1_offset,
-          operand2 + poly1_offset, tile_size, moduli[i], 1);
-
-      // Compute second output polynomial
-      // result[1] = x[1] * y[0]
-      intel::hexl::EltwiseMultMod(temp.data(), operand1 + poly1_offset,
-                                  operand2 + poly0_offset, tile_size, moduli[i],
-                                  1);
-      // result[1] = x[0] * y[1]
-      intel::hexl::EltwiseMultMod(
-          &result[poly1_offset], operand1 + poly0_offset,
-          operand2 + poly1_offset, tile_size, moduli[i], 1);
-      // result[1] += temp_poly
-      intel::hexl::EltwiseAddMod(&result[poly1_offset], temp.data(),
-                                 &result[poly1_offset], tile_size, moduli[i]);
-
-      // Compute first output polynomial
-      // result[0] = x[0] * y[0]
-      intel::hexl::EltwiseMultMod(
-          &result[poly0_offset], operand1 + poly0_offset,
-          operand2 + poly0_offset, tile_size, moduli[i], 1);
+    const uint64_t* plain_shoup_i =
+        (plain_shoup == nullptr) ? nullptr : plain_shoup + i_times_n;
+    PlainMultiplyAccumulateLimb(result + i_times_n, plain + i_times_n,
+                                plain_shoup_i, cipher + i_times_n, n,
+                                poly_size, moduli[i], workspace);
+  }
+}
+
+void PlainMultiplyShoupFactors(uint64_t* plain_shoup, const uint64_t* plain,
+                               uint64_t n, const uint64_t* moduli,
+                               uint64_t num_moduli) {
+  HEXL_CHECK(plain_shoup != nullptr, "Require plain_shoup != nullptr");
+  HEXL_CHECK(plain != nullptr, "Require plain != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  for (size_t i = 0; i < num_moduli; i++) {
+    for (size_t l = i * n; l < (i + 1) * n; ++l) {
+      plain_shoup[l] = MultiplyFactor(plain[l], 64, moduli[i]).BarrettFactor();
     }
   }
 }
 
+void DiagonalMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                                const uint64_t* cipher, uint64_t num_terms,
+                                uint64_t plain_stride, uint64_t cipher_stride,
+                                uint64_t n, uint64_t poly_size,
+                                uint64_t modulus, uint64_t* temp) {
+  if (modulus < (1ULL << 61)) {
+    DyadicMultiplyTable(n)
+        .diagonal_multiply_accumulate.Select(modulus)
+        .function(result, plain, cipher, num_terms, plain_stride,
+                  cipher_stride, n, poly_size, modulus);
+    return;
+  }
+
+  // Each tile of the result is accumulated in place with separate
+  // element-wise multiplications
+  HEXL_CHECK(temp != nullptr, "Require temp != nullptr");
+  size_t tile_size = DyadicMultiplyTileSize(n);
+  for (size_t offset = 0; offset < n; offset += tile_size) {
+    size_t length = std::min(tile_size, static_cast<size_t>(n) - offset);
+    for (size_t k = 0; k < 2; ++k) {
+      uint64_t* out = result + k * poly_size + offset;
+      for (size_t i = 0; i < num_terms; ++i) {
+        const uint64_t* p = plain + i * plain_stride + offset;
+        const uint64_t* c = cipher + i * cipher_stride + k * poly_size + offset;
+        if (i == 0) {
+          EltwiseMultMod(out, p, c, length, modulus, 1);
+          continue;
+        }
+        EltwiseMultMod(temp, p, c, length, modulus, 1);
+        EltwiseAddMod(out, out, temp, length, modulus);
+      }
+    }
+  }
+}
+
+uint64_t DyadicMultiplyBatchWorkspaceSize(uint64_t n,
+                                          const Executor* executor) {
+  return NumWorkers(executor) * DyadicMultiplyWorkspaceSize(n);
+}
+
+void DyadicMultiplyBatch(uint64_t** results, const uint64_t** operand1s,
+                         const uint64_t** operand2s, uint64_t batch_size,
+                         uint64_t n, const uint64_t* moduli,
+                         uint64_t num_moduli, Executor* executor,
+                         uint64_t* workspace) {
+  HEXL_CHECK(results != nullptr, "Require results != nullptr");
+  HEXL_CHECK(operand1s != nullptr, "Require operand1s != nullptr");
+  HEXL_CHECK(operand2s != nullptr, "Require operand2s != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+  if (batch_size == 0) {
+    return;
+  }
+
+  size_t poly_size = n * num_moduli;
+  KernelTimer timer(Kernel::kDyadicMultiply, n, moduli, num_moduli,
+                    4 * batch_size * poly_size,
+                    7 * batch_size * poly_size * sizeof(uint64_t));
+  if (timer.IsEnabled()) {
+    timer.SetBackend(DyadicMultiplyBackend(n, moduli, num_moduli));
+  }
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(DyadicMultiplyBatchWorkspaceSize(n, executor));
+    workspace = owned_workspace.data();
+  }
+  uint64_t worker_workspace_size = DyadicMultiplyWorkspaceSize(n);
+
+  // Each task computes one limb of a contiguous chunk of the batch, so the
+  // dispatch and the constants of each modulus are set up once per chunk.
+  // Chunks are only split to give each worker several tasks
+  size_t num_workers = NumWorkers(executor);
+  size_t num_chunks = 1;
+  if (num_workers > 1) {
+    size_t min_tasks = 4 * num_workers;
+    num_chunks = std::min(static_cast<size_t>(batch_size),
+                          (min_tasks + num_moduli - 1) / num_moduli);
+  }
+  size_t chunk_size = (batch_size + num_chunks - 1) / num_chunks;
+  num_chunks = (batch_size + chunk_size - 1) / chunk_size;
+
+  size_t num_tasks = num_moduli * num_chunks;
+  ParallelFor(executor, num_tasks, [&](size_t task, size_t worker) {
+    size_t i = task / num_chunks;
+    size_t begin = (task % num_chunks) * chunk_size;
+    size_t end = std::min(begin + chunk_size, static_cast<size_t>(batch_size));
+    size_t i_times_n = i * n;
+    if (DyadicMultiplySinglePass(results + begin, operand1s + begin,
+                                 operand2s + begin, end - begin, i_times_n, n,
+                                 poly_size, moduli[i], false)) {
+      return;
+    }
+    uint64_t* temp = workspace + worker * worker_workspace_size;
+    for (size_t b = begin; b < end; ++b) {
+      DyadicMultiplyTiled(results[b] + i_times_n, operand1s[b] + i_times_n,
+                          operand2s[b] + i_times_n, n, poly_size, moduli[i],
+                          temp);
+    }
+  });
+}
+
+// Computes one RNS limb of the tensor product with separate element-wise
+// multiplications. If square, operand2 is operand1 and each product
+// x[i] * x[j] with i != j is computed once. Uses two tiles of temp
+inline void DyadicTensorTiled(uint64_t* result, const uint64_t* operand1,
+                              uint64_t operand1_size, const uint64_t* operand2,
+                              uint64_t operand2_size, uint64_t n,
+                              uint64_t poly_size, uint64_t modulus, bool square,
+                              uint64_t* temp) {
+  size_t tile_size = DyadicMultiplyTileSize(n);
+  size_t result_size = operand1_size + operand2_size - 1;
+  uint64_t* temp_sum = temp;
+  uint64_t* temp_prod = temp + tile_size;
+
+  for (size_t offset = 0; offset < n; offset += tile_size) {
+    size_t length = std::min(tile_size, static_cast<size_t>(n) - offset);
+    for (size_t k = result_size; k-- > 0;) {
+      size_t i_begin = (k < operand2_size) ? 0 : k - operand2_size + 1;
+      size_t i_end = std::min(k + 1, static_cast<size_t>(operand1_size));
+      uint64_t* out = result + k * poly_size + offset;
+
+      // Sums the products of all but the last pair into temp_sum
+      size_t i_last = square ? (k + 1) / 2 : i_end;
+      for (size_t i = i_begin; i + 1 < i_last; ++i) {
+        uint64_t* prod = (i == i_begin) ? temp_sum : temp_prod;
+        EltwiseMultMod(prod, operand1 + i * poly_size + offset,
+                       operand2 + (k - i) * poly_size + offset, length,
+                       modulus, 1);
+        if (i != i_begin) {
+          EltwiseAddMod(temp_sum, temp_sum, temp_prod, length, modulus);
+        }
+      }
+      bool has_sum = (i_last > i_begin + 1);
+
+      if (!square) {
+        size_t i = i_end - 1;
+        EltwiseMultMod(out, operand1 + i * poly_size + offset,
+                       operand2 + (k - i) * poly_size + offset, length,
+                       modulus, 1);
+        if (has_sum) {
+          EltwiseAddMod(out, out, temp_sum, length, modulus);
+        }
+        continue;
+      }
+
+      // Adds the last product x[i] * x[k - i] with i < k - i, then doubles
+      if (i_last > i_begin) {
+        size_t i = i_last - 1;
+        uint64_t* prod = has_sum ? temp_prod : temp_sum;
+        EltwiseMultMod(prod, operand1 + i * poly_size + offset,
+                       operand1 + (k - i) * poly_size + offset, length,
+                       modulus, 1);
+        if (has_sum) {
+          EltwiseAddMod(temp_sum, temp_sum, temp_prod, length, modulus);
+        }
+        has_sum = true;
+      }
+      if (k % 2 == 1) {
+        EltwiseAddMod(out, temp_sum, temp_sum, length, modulus);
+        continue;
+      }
+      if (has_sum) {
+        EltwiseAddMod(temp_sum, temp_sum, temp_sum, length, modulus);
+      }
+      const uint64_t* x = operand1 + (k / 2) * poly_size + offset;
+      EltwiseMultMod(out, x, x, length, modulus, 1);
+      if (has_sum) {
+        EltwiseAddMod(out, out, temp_sum, length, modulus);
+      }
+    }
+  }
+}
+
+// Computes one RNS limb of the tensor product in a single pass. Returns false,
+// without computing the limb, where separate element-wise multiplications are
+// faster
+inline bool DyadicTensorSinglePass(uint64_t* result, const uint64_t* operand1,
+                                   uint64_t operand1_size,
+                                   const uint64_t* operand2,
+                                   uint64_t operand2_size, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus,
+                                   bool square) {
+  if (modulus >= (1ULL << 61)) {
+    return false;
+  }
+  const DispatchTable& table = DyadicMultiplyTable(n);
+  if (square) {
+    const auto& variant = table.dyadic_tensor_square.Select(modulus);
+    if (variant.function == nullptr) {
+      // EltwiseMultMod uses faster floating-point multiplication for these
+      return false;
+    }
+    variant.function(result, operand1, operand1_size, n, poly_size, modulus);
+    return true;
+  }
+  const auto& variant = table.dyadic_tensor_product.Select(modulus);
+  if (variant.function == nullptr) {
+    return false;
+  }
+  variant.function(result, operand1, operand1_size, operand2, operand2_size, n,
+                   poly_size, modulus);
+  return true;
+}
+
+inline void DyadicTensorImpl(uint64_t* result, const uint64_t* operand1,
+                             uint64_t operand1_size, const uint64_t* operand2,
+                             uint64_t operand2_size, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             bool square) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand1 != nullptr, "Require operand1 != nullptr");
+  HEXL_CHECK(operand2 != nullptr, "Require operand2 != nullptr");
+  HEXL_CHECK(operand1_size > 0, "Require operand1_size > 0");
+  HEXL_CHECK(operand2_size > 0, "Require operand2_size > 0");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+
+  // The kernels for two 2-polynomial ciphertexts are faster, also for squares
+  if (operand1_size == 2 && operand2_size == 2) {
+    DyadicMultiplyImpl(result, operand1, operand2, n, moduli, num_moduli,
+                       nullptr, false);
+    return;
+  }
+
+  size_t poly_size = n * num_moduli;
+  AlignedVector64<uint64_t> temp = MakePooledVector<uint64_t>();
+
+  for (size_t i = 0; i < num_moduli; i++) {
+    size_t i_times_n = i * n;
+    if (DyadicTensorSinglePass(result + i_times_n, operand1 + i_times_n,
+                               operand1_size, operand2 + i_times_n,
+                               operand2_size, n, poly_size, moduli[i],
+                               square)) {
+      continue;
+    }
+
+    if (temp.empty()) {
+      temp.resize(2 * DyadicMultiplyMaxTileSize(n));
+    }
+    DyadicTensorTiled(result + i_times_n, operand1 + i_times_n, operand1_size,
+                      operand2 + i_times_n, operand2_size, n, poly_size,
+                      moduli[i], square, temp.data());
+  }
+}
+
+void DyadicTensorProduct(uint64_t* result, const uint64_t* operand1,
+                         uint64_t operand1_size, const uint64_t* operand2,
+                         uint64_t operand2_size, uint64_t n,
+                         const uint64_t* moduli, uint64_t num_moduli) {
+  DyadicTensorImpl(result, operand1, operand1_size, operand2, operand2_size, n,
+                   moduli, num_moduli, false);
+}
+
+void DyadicTensorSquare(uint64_t* result, const uint64_t* operand,
+                        uint64_t operand_size, uint64_t n,
+                        const uint64_t* moduli, uint64_t num_moduli) {
+  DyadicTensorImpl(result, operand, operand_size, operand, operand_size, n,
+                   moduli, num_moduli, true);
+}
+
 }  // namespace internal
 }  // namespace hexl
 }  // namespace intel
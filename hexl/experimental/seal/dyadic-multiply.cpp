@@ -1,8 +1,6 @@
 // Copyright (C) 2020-2021 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 
-#ifndef HEXL_FPGA_COMPATIBLE_DYADIC_MULTIPLY
-
 #include "hexl/experimental/seal/dyadic-multiply.hpp"
 
 #include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
@@ -10,13 +8,81 @@
 namespace intel {
 namespace hexl {
 
+#ifndef HEXL_FPGA_COMPATIBLE_DYADIC_MULTIPLY
 void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
                     const uint64_t* operand2, uint64_t n,
                     const uint64_t* moduli, uint64_t num_moduli) {
   intel::hexl::internal::DyadicMultiply(result, operand1, operand2, n, moduli,
                                         num_moduli);
 }
+#endif
+
+// Not provided by HEXL-FPGA, so are available in all configurations
+void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
+                    const uint64_t* operand2, uint64_t n,
+                    const uint64_t* moduli, uint64_t num_moduli,
+                    uint64_t* workspace) {
+  intel::hexl::internal::DyadicMultiply(result, operand1, operand2, n, moduli,
+                                        num_moduli, workspace);
+}
+
+void DyadicMultiplyKaratsuba(uint64_t* result, const uint64_t* operand1,
+                             const uint64_t* operand2, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             uint64_t* workspace) {
+  intel::hexl::internal::DyadicMultiplyKaratsuba(
+      result, operand1, operand2, n, moduli, num_moduli, workspace);
+}
+
+void DyadicMultiplyBatch(uint64_t** results, const uint64_t** operand1s,
+                         const uint64_t** operand2s, uint64_t batch_size,
+                         uint64_t n, const uint64_t* moduli,
+                         uint64_t num_moduli, Executor* executor,
+                         uint64_t* workspace) {
+  intel::hexl::internal::DyadicMultiplyBatch(results, operand1s, operand2s,
+                                             batch_size, n, moduli, num_moduli,
+                                             executor, workspace);
+}
+
+uint64_t DyadicMultiplyBatchWorkspaceSize(uint64_t n,
+                                          const Executor* executor) {
+  return intel::hexl::internal::DyadicMultiplyBatchWorkspaceSize(n, executor);
+}
+
+void DyadicTensorProduct(uint64_t* result, const uint64_t* operand1,
+                         uint64_t operand1_size, const uint64_t* operand2,
+                         uint64_t operand2_size, uint64_t n,
+                         const uint64_t* moduli, uint64_t num_moduli) {
+  intel::hexl::internal::DyadicTensorProduct(result, operand1, operand1_size,
+                                             operand2, operand2_size, n,
+                                             moduli, num_moduli);
+}
+
+void DyadicTensorSquare(uint64_t* result, const uint64_t* operand,
+                        uint64_t operand_size, uint64_t n,
+                        const uint64_t* moduli, uint64_t num_moduli) {
+  intel::hexl::internal::DyadicTensorSquare(result, operand, operand_size, n,
+                                            moduli, num_moduli);
+}
+
+void PlainMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                             const uint64_t* cipher, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             const uint64_t* plain_shoup, uint64_t* workspace) {
+  intel::hexl::internal::PlainMultiplyAccumulate(
+      result, plain, cipher, n, moduli, num_moduli, plain_shoup, workspace);
+}
+
+void PlainMultiplyShoupFactors(uint64_t* plain_shoup, const uint64_t* plain,
+                               uint64_t n, const uint64_t* moduli,
+                               uint64_t num_moduli) {
+  intel::hexl::internal::PlainMultiplyShoupFactors(plain_shoup, plain, n,
+                                                   moduli, num_moduli);
+}
+
+uint64_t DyadicMultiplyWorkspaceSize(uint64_t n) {
+  return intel::hexl::internal::DyadicMultiplyWorkspaceSize(n);
+}
 
 }  // namespace hexl
 }  // namespace intel
-#endif
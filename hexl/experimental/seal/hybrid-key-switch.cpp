@@ -0,0 +1,318 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/seal/hybrid-key-switch.hpp"
+
+#include <algorithm>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-fma-mod.hpp"
+#include "hexl/eltwise/eltwise-reduce-mod.hpp"
+#include "hexl/eltwise/eltwise-sub-mod.hpp"
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/check.hpp"
+#include "hexl/util/pool-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Returns the product of moduli[begin, end), excluding moduli[skip], modulo
+// modulus
+inline uint64_t ProductMod(const uint64_t* moduli, size_t begin, size_t end,
+                           size_t skip, uint64_t modulus) {
+  uint64_t product = 1 % modulus;
+  for (size_t i = begin; i < end; ++i) {
+    if (i != skip) {
+      product = MultiplyMod(product, moduli[i] % modulus, modulus);
+    }
+  }
+  return product;
+}
+
+// Computes result = sum_k (operand_k * factors[k * factor_stride]) mod
+// modulus, where operand_k = &operands[k * n] is in [0, operand_moduli[k])
+inline void FastBaseConvert(uint64_t* result, uint64_t* temp,
+                            const uint64_t* operands,
+                            const uint64_t* operand_moduli,
+                            const uint64_t* factors, size_t num_operands,
+                            size_t factor_stride, uint64_t n,
+                            uint64_t modulus) {
+  for (size_t k = 0; k < num_operands; ++k) {
+    const uint64_t* operand = &operands[k * n];
+    if (operand_moduli[k] > modulus) {
+      EltwiseReduceMod(temp, operand, n, modulus, modulus, 1);
+      operand = temp;
+    }
+    EltwiseFMAMod(result, operand, factors[k * factor_stride],
+                  (k == 0) ? nullptr : result, n, modulus, 1);
+  }
+}
+
+HybridKeySwitch::HybridKeySwitch(uint64_t n,
+                                 const std::vector<uint64_t>& ciphertext_moduli,
+                                 const std::vector<uint64_t>& special_moduli,
+                                 uint64_t dnum, KeySwitchScheme scheme,
+                                 uint64_t plain_modulus)
+    : m_n(n),
+      m_num_ciphertext_moduli(ciphertext_moduli.size()),
+      m_num_special_moduli(special_moduli.size()),
+      m_scheme(scheme),
+      m_plain_modulus(plain_modulus) {
+  HEXL_CHECK(m_num_ciphertext_moduli > 0, "Require ciphertext moduli");
+  HEXL_CHECK(m_num_special_moduli > 0, "Require special moduli");
+  HEXL_CHECK(dnum >= 1 && dnum <= m_num_ciphertext_moduli,
+             "Require dnum in [1, " << m_num_ciphertext_moduli << "]");
+  HEXL_CHECK(scheme != KeySwitchScheme::BGV || plain_modulus > 1,
+             "BGV requires plain_modulus > 1");
+
+  uint64_t L = m_num_ciphertext_moduli;
+  uint64_t K = m_num_special_moduli;
+  m_digit_size = (L + dnum - 1) / dnum;
+
+  m_moduli = ciphertext_moduli;
+  m_moduli.insert(m_moduli.end(), special_moduli.begin(),
+                  special_moduli.end());
+  const uint64_t* q = m_moduli.data();
+  const uint64_t* p = &m_moduli[L];
+
+  m_ntts.reserve(L + K);
+  for (uint64_t modulus : m_moduli) {
+    HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+    m_ntts.emplace_back(n, modulus);
+  }
+
+  // ModUp tables for each level
+  m_digit_inv.resize(L);
+  m_digit_conv.resize(L);
+  for (uint64_t num_moduli = 1; num_moduli <= L; ++num_moduli) {
+    uint64_t ext_size = num_moduli + K;
+    auto& digit_inv = m_digit_inv[num_moduli - 1];
+    auto& digit_conv = m_digit_conv[num_moduli - 1];
+    digit_inv.resize(num_moduli);
+    digit_conv.resize(num_moduli * ext_size);
+
+    for (uint64_t i = 0; i < num_moduli; ++i) {
+      uint64_t begin = (i / m_digit_size) * m_digit_size;
+      uint64_t end = std::min(begin + m_digit_size, num_moduli);
+      digit_inv[i] = InverseMod(ProductMod(q, begin, end, i, q[i]), q[i]);
+      for (uint64_t m = 0; m < ext_size; ++m) {
+        uint64_t modulus = m_moduli[ExtendedIndex(m, num_moduli)];
+        digit_conv[i * ext_size + m] = ProductMod(q, begin, end, i, modulus);
+      }
+    }
+  }
+
+  // ModDown tables
+  m_special_inv.resize(K);
+  m_special_conv.resize(K * L);
+  for (uint64_t k = 0; k < K; ++k) {
+    m_special_inv[k] = InverseMod(ProductMod(p, 0, K, k, p[k]), p[k]);
+    if (scheme == KeySwitchScheme::BGV) {
+      uint64_t plain_inv = InverseMod(plain_modulus % p[k], p[k]);
+      m_special_inv[k] = MultiplyMod(m_special_inv[k], plain_inv, p[k]);
+    }
+    for (uint64_t i = 0; i < L; ++i) {
+      m_special_conv[k * L + i] = ProductMod(p, 0, K, k, q[i]);
+    }
+  }
+
+  m_special_modulus_inv.resize(L);
+  m_plain_modulus_mod.resize(L);
+  for (uint64_t i = 0; i < L; ++i) {
+    m_special_modulus_inv[i] = InverseMod(ProductMod(p, 0, K, K, q[i]), q[i]);
+    m_plain_modulus_mod[i] = plain_modulus % q[i];
+  }
+
+  // P is odd, so floor(P / 2) = (P - 1) / 2
+  m_half_special_modulus.resize(L + K);
+  for (uint64_t m = 0; m < L + K; ++m) {
+    uint64_t modulus = m_moduli[m];
+    uint64_t special_mod = ProductMod(p, 0, K, K, modulus);
+    uint64_t inv_two = InverseMod(2, modulus);
+    m_half_special_modulus[m] =
+        MultiplyMod(SubUIntMod(special_mod, 1, modulus), inv_two, modulus);
+  }
+}
+
+// Per-worker scratch: two polynomials for base conversion, followed by the
+// lazy accumulators (128-bit coefficients) stored as planar high and low words
+inline uint64_t HybridKeySwitchWorkerScratchSize(uint64_t n,
+                                                 uint64_t key_component_count) {
+  return n * (2 + 2 * key_component_count);
+}
+
+uint64_t HybridKeySwitch::WorkspaceSize(uint64_t num_moduli,
+                                        uint64_t key_component_count,
+                                        const Executor* executor) const {
+  uint64_t ext_size = num_moduli + m_num_special_moduli;
+  return m_n * num_moduli + m_n * key_component_count * ext_size +
+         NumWorkers(executor) *
+             HybridKeySwitchWorkerScratchSize(m_n, key_component_count);
+}
+
+void HybridKeySwitch::KeySwitch(uint64_t* result, const uint64_t* input,
+                                uint64_t num_moduli,
+                                uint64_t key_component_count,
+                                const uint64_t** k_switch_keys,
+                                Executor* executor,
+                                uint64_t* workspace) const {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(input != nullptr, "Require input != nullptr");
+  HEXL_CHECK(k_switch_keys != nullptr, "Require k_switch_keys != nullptr");
+  HEXL_CHECK(num_moduli >= 1 && num_moduli <= m_num_ciphertext_moduli,
+             "Require num_moduli in [1, " << m_num_ciphertext_moduli << "]");
+
+  uint64_t n = m_n;
+  uint64_t L = m_num_ciphertext_moduli;
+  uint64_t K = m_num_special_moduli;
+  uint64_t ext_size = num_moduli + K;
+  uint64_t key_modulus_size = KeyModulusSize();
+  uint64_t num_digits = NumDigits(num_moduli);
+  bool ntt_form = (m_scheme != KeySwitchScheme::BFV);
+
+  const auto& digit_inv = m_digit_inv[num_moduli - 1];
+  const auto& digit_conv = m_digit_conv[num_moduli - 1];
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(
+        WorkspaceSize(num_moduli, key_component_count, executor));
+    workspace = owned_workspace.data();
+  }
+
+  // Workspace layout: the scaled digits in coefficient form, the products for
+  // each key component in the extended basis, then per-worker scratch
+  uint64_t* t_scaled = workspace;
+  uint64_t* t_poly_prod = t_scaled + n * num_moduli;
+  uint64_t* scratch = t_poly_prod + n * key_component_count * ext_size;
+  uint64_t scratch_size =
+      HybridKeySwitchWorkerScratchSize(n, key_component_count);
+
+  // ModUp, first step: t_scaled[i] = [d_i * (Q_j / q_i)^{-1}]_{q_i} in
+  // coefficient form
+  ParallelFor(executor, num_moduli, [&](size_t i, size_t) {
+    uint64_t* t_scaled_i = &t_scaled[i * n];
+    const uint64_t* input_i = &input[i * n];
+    if (ntt_form) {
+      m_ntts[i].ComputeInverse(t_scaled_i, input_i, 1, 1);
+      input_i = t_scaled_i;
+    }
+    EltwiseFMAMod(t_scaled_i, input_i, digit_inv[i], nullptr, n, m_moduli[i],
+                  1);
+  });
+
+  // ModUp, second step, and inner product: each modulus of the extended basis
+  // is independent
+  ParallelFor(executor, ext_size, [&](size_t m, size_t worker) {
+    uint64_t key_index = ExtendedIndex(m, num_moduli);
+    uint64_t modulus = m_moduli[key_index];
+
+    uint64_t* t_ntt = &scratch[worker * scratch_size];
+    uint64_t* t_temp = t_ntt + n;
+    uint64_t lazy_size = key_component_count * n;
+    uint64_t* t_poly_lazy_hi = t_temp + n;
+    uint64_t* t_poly_lazy_lo = t_poly_lazy_hi + lazy_size;
+    std::fill(t_poly_lazy_hi, t_poly_lazy_hi + lazy_size, 0);
+    std::fill(t_poly_lazy_lo, t_poly_lazy_lo + lazy_size, 0);
+
+    int bit_shift =
+        internal::KeySwitchAccumulatorBitShift(n, modulus, num_digits);
+
+    for (uint64_t j = 0; j < num_digits; ++j) {
+      uint64_t begin = j * m_digit_size;
+      uint64_t end = std::min(begin + m_digit_size, num_moduli);
+
+      const uint64_t* t_operand;
+      if (m >= begin && m < end) {
+        // Digit j is exact modulo its own moduli
+        if (ntt_form) {
+          t_operand = &input[m * n];
+        } else {
+          m_ntts[key_index].ComputeForward(t_ntt, &input[m * n], 1, 4);
+          t_operand = t_ntt;
+        }
+      } else {
+        FastBaseConvert(t_ntt, t_temp, &t_scaled[begin * n], &m_moduli[begin],
+                        &digit_conv[begin * ext_size + m], end - begin,
+                        ext_size, n, modulus);
+        // NTT conversion lazy outputs in [0, 4q)
+        m_ntts[key_index].ComputeForward(t_ntt, t_ntt, 1, 4);
+        t_operand = t_ntt;
+      }
+
+      // Multiply with keys and accumulate products in a lazy fashion
+      for (uint64_t k = 0; k < key_component_count; ++k) {
+        const uint64_t* key_ptr =
+            &k_switch_keys[j][(k * key_modulus_size + key_index) * n];
+        internal::KeySwitchMultiplyAccumulate(&t_poly_lazy_hi[k * n],
+                                              &t_poly_lazy_lo[k * n],
+                                              t_operand, key_ptr, n, bit_shift);
+      }
+    }
+
+    for (uint64_t k = 0; k < key_component_count; ++k) {
+      internal::KeySwitchReduce(&t_poly_prod[(k * ext_size + m) * n],
+                                &t_poly_lazy_hi[k * n], &t_poly_lazy_lo[k * n],
+                                n, modulus, bit_shift);
+    }
+  });
+
+  // ModDown, first step: scale each special limb in coefficient form. For
+  // CKKS and BFV, adds floor(P / 2) so the division by P rounds. For BGV,
+  // multiplies by t^{-1} so the subtracted term is a multiple of t.
+  ParallelFor(executor, key_component_count * K, [&](size_t task, size_t) {
+    uint64_t k = task / K;
+    uint64_t s = task % K;
+    uint64_t key_index = L + s;
+    uint64_t modulus = m_moduli[key_index];
+    uint64_t* t_last = &t_poly_prod[(k * ext_size + num_moduli + s) * n];
+
+    m_ntts[key_index].ComputeInverse(t_last, t_last, 1, 1);
+    if (m_scheme != KeySwitchScheme::BGV) {
+      EltwiseAddMod(t_last, t_last, m_half_special_modulus[key_index], n,
+                    modulus);
+    }
+    EltwiseFMAMod(t_last, t_last, m_special_inv[s], nullptr, n, modulus, 1);
+  });
+
+  // ModDown, second step: each (key component, ciphertext modulus) pair is
+  // independent
+  uint64_t num_mod_down_tasks = key_component_count * num_moduli;
+  ParallelFor(executor, num_mod_down_tasks, [&](size_t task, size_t worker) {
+    uint64_t k = task / num_moduli;
+    uint64_t i = task % num_moduli;
+    uint64_t modulus = m_moduli[i];
+
+    uint64_t* t_conv = &scratch[worker * scratch_size];
+    uint64_t* t_temp = t_conv + n;
+
+    // The special limbs of component k are contiguous
+    const uint64_t* t_last = &t_poly_prod[(k * ext_size + num_moduli) * n];
+    FastBaseConvert(t_conv, t_temp, t_last, &m_moduli[L], &m_special_conv[i],
+                    K, L, n, modulus);
+
+    if (m_scheme == KeySwitchScheme::BGV) {
+      EltwiseFMAMod(t_conv, t_conv, m_plain_modulus_mod[i], nullptr, n,
+                    modulus, 1);
+    } else {
+      EltwiseSubMod(t_conv, t_conv, m_half_special_modulus[i], n, modulus);
+    }
+
+    uint64_t* t_ith_poly = &t_poly_prod[(k * ext_size + i) * n];
+    if (ntt_form) {
+      m_ntts[i].ComputeForward(t_conv, t_conv, 1, 1);
+    } else {
+      m_ntts[i].ComputeInverse(t_ith_poly, t_ith_poly, 1, 1);
+    }
+
+    // P^{-1} * ((ct mod q_i) - (ct mod P)) mod q_i
+    uint64_t* result_ptr = &result[(k * num_moduli + i) * n];
+    internal::KeySwitchModDownAccumulate(result_ptr, t_ith_poly, t_conv, n,
+                                         modulus, m_special_modulus_inv[i]);
+  });
+}
+
+}  // namespace hexl
+}  // namespace intel
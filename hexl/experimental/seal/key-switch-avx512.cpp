@@ -0,0 +1,293 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "experimental/seal/key-switch-avx512.hpp"
+
+#include <immintrin.h>
+
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/check.hpp"
+#include "util/avx512-util.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+#ifdef HEXL_HAS_AVX512IFMA
+template void KeySwitchMultiplyAccumulateAVX512<52>(uint64_t* acc_hi,
+                                                    uint64_t* acc_lo,
+                                                    const uint64_t* operand,
+                                                    const uint64_t* key,
+                                                    uint64_t n);
+template void KeySwitchReduceAVX512<52>(uint64_t* result,
+                                        const uint64_t* acc_hi,
+                                        const uint64_t* acc_lo, uint64_t n,
+                                        uint64_t modulus);
+template void KeySwitchModDownAccumulateAVX512<52>(
+    uint64_t* result, const uint64_t* operand, const uint64_t* special,
+    uint64_t n, uint64_t modulus, uint64_t modswitch_factor);
+#endif
+
+#ifdef HEXL_HAS_AVX512DQ
+template void KeySwitchMultiplyAccumulateAVX512<64>(uint64_t* acc_hi,
+                                                    uint64_t* acc_lo,
+                                                    const uint64_t* operand,
+                                                    const uint64_t* key,
+                                                    uint64_t n);
+template void KeySwitchReduceAVX512<64>(uint64_t* result,
+                                        const uint64_t* acc_hi,
+                                        const uint64_t* acc_lo, uint64_t n,
+                                        uint64_t modulus);
+template void KeySwitchModDownAccumulateAVX512<64>(
+    uint64_t* result, const uint64_t* operand, const uint64_t* special,
+    uint64_t n, uint64_t modulus, uint64_t modswitch_factor);
+#endif
+
+#ifdef HEXL_HAS_AVX512DQ
+
+template <int BitShift>
+void KeySwitchMultiplyAccumulateAVX512(uint64_t* acc_hi, uint64_t* acc_lo,
+                                       const uint64_t* operand,
+                                       const uint64_t* key, uint64_t n) {
+  HEXL_CHECK(acc_hi != nullptr, "Require acc_hi != nullptr");
+  HEXL_CHECK(acc_lo != nullptr, "Require acc_lo != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(key != nullptr, "Require key != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 52 || BitShift == 64,
+             "Invalid bitshift " << BitShift << "; need 52 or 64");
+
+  __m512i* vp_acc_hi = reinterpret_cast<__m512i*>(acc_hi);
+  __m512i* vp_acc_lo = reinterpret_cast<__m512i*>(acc_lo);
+  const __m512i* vp_operand = reinterpret_cast<const __m512i*>(operand);
+  const __m512i* vp_key = reinterpret_cast<const __m512i*>(key);
+
+#ifdef HEXL_HAS_AVX512IFMA
+  if (BitShift == 52) {
+    HEXL_CHECK_BOUNDS(operand, n, MaximumValue(52) + 1,
+                      "operand exceeds bound " << MaximumValue(52));
+    HEXL_CHECK_BOUNDS(key, n, MaximumValue(52) + 1,
+                      "key exceeds bound " << MaximumValue(52));
+    // Each 52-bit half of the 104-bit product is added into its own 64-bit
+    // word, so no carry propagation is needed until the final reduction
+    HEXL_LOOP_UNROLL_4
+    for (size_t i = n / 8; i > 0; --i) {
+      __m512i v_operand = _mm512_loadu_si512(vp_operand);
+      __m512i v_key = _mm512_loadu_si512(vp_key);
+      __m512i v_acc_hi = _mm512_loadu_si512(vp_acc_hi);
+      __m512i v_acc_lo = _mm512_loadu_si512(vp_acc_lo);
+
+      v_acc_lo = _mm512_madd52lo_epu64(v_acc_lo, v_operand, v_key);
+      v_acc_hi = _mm512_madd52hi_epu64(v_acc_hi, v_operand, v_key);
+
+      _mm512_storeu_si512(vp_acc_hi, v_acc_hi);
+      _mm512_storeu_si512(vp_acc_lo, v_acc_lo);
+
+      ++vp_operand;
+      ++vp_key;
+      ++vp_acc_hi;
+      ++vp_acc_lo;
+    }
+    return;
+  }
+#endif
+
+  HEXL_CHECK(BitShift == 64, "Invalid bitshift " << BitShift << "; need 64");
+  __m512i v_one = _mm512_set1_epi64(1);
+  HEXL_LOOP_UNROLL_4
+  for (size_t i = n / 8; i > 0; --i) {
+    __m512i v_operand = _mm512_loadu_si512(vp_operand);
+    __m512i v_key = _mm512_loadu_si512(vp_key);
+    __m512i v_acc_hi = _mm512_loadu_si512(vp_acc_hi);
+    __m512i v_acc_lo = _mm512_loadu_si512(vp_acc_lo);
+
+    __m512i v_prod_hi = _mm512_hexl_mulhi_epi<64>(v_operand, v_key);
+    __m512i v_prod_lo = _mm512_hexl_mullo_epi<64>(v_operand, v_key);
+
+    // 128-bit addition, with the carry of the low word detected by overflow
+    v_acc_lo = _mm512_add_epi64(v_acc_lo, v_prod_lo);
+    __mmask8 carry = _mm512_cmp_epu64_mask(v_acc_lo, v_prod_lo, _MM_CMPINT_LT);
+    v_acc_hi = _mm512_add_epi64(v_acc_hi, v_prod_hi);
+    v_acc_hi = _mm512_mask_add_epi64(v_acc_hi, carry, v_acc_hi, v_one);
+
+    _mm512_storeu_si512(vp_acc_hi, v_acc_hi);
+    _mm512_storeu_si512(vp_acc_lo, v_acc_lo);
+
+    ++vp_operand;
+    ++vp_key;
+    ++vp_acc_hi;
+    ++vp_acc_lo;
+  }
+}
+
+template <int BitShift>
+void KeySwitchReduceAVX512(uint64_t* result, const uint64_t* acc_hi,
+                           const uint64_t* acc_lo, uint64_t n,
+                           uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(acc_hi != nullptr, "Require acc_hi != nullptr");
+  HEXL_CHECK(acc_lo != nullptr, "Require acc_lo != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+  HEXL_CHECK(modulus < (1ULL << 62), "Require modulus < (1ULL << 62)");
+
+  // (acc_hi * 2^BitShift + acc_lo) mod q
+  //   = ((acc_hi mod q) * (2^BitShift mod q) + (acc_lo mod q)) mod q
+  uint64_t radix_mod = (BitShift == 64) ? BarrettReduce128(1, 0, modulus)
+                                        : (1ULL << BitShift) % modulus;
+  uint64_t radix_precon =
+      MultiplyFactor(radix_mod, 64, modulus).BarrettFactor();
+  uint64_t barrett_factor = MultiplyFactor(1, 64, modulus).BarrettFactor();
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  __m512i v_radix = _mm512_set1_epi64(static_cast<int64_t>(radix_mod));
+  __m512i v_radix_precon =
+      _mm512_set1_epi64(static_cast<int64_t>(radix_precon));
+
+  const __m512i* vp_acc_hi = reinterpret_cast<const __m512i*>(acc_hi);
+  const __m512i* vp_acc_lo = reinterpret_cast<const __m512i*>(acc_lo);
+  __m512i* vp_result = reinterpret_cast<__m512i*>(result);
+
+  HEXL_LOOP_UNROLL_4
+  for (size_t i = n / 8; i > 0; --i) {
+    __m512i v_hi = _mm512_loadu_si512(vp_acc_hi);
+    __m512i v_lo = _mm512_loadu_si512(vp_acc_lo);
+
+    v_hi = _mm512_hexl_barrett_reduce64<64, 1>(v_hi, v_modulus, v_barrett,
+                                               v_barrett, 0, v_neg_modulus);
+    v_lo = _mm512_hexl_barrett_reduce64<64, 1>(v_lo, v_modulus, v_barrett,
+                                               v_barrett, 0, v_neg_modulus);
+
+    // Shoup multiplication by the precomputed radix, result in [0, 2q)
+    __m512i v_q_hat = _mm512_hexl_mulhi_epi<64>(v_hi, v_radix_precon);
+    __m512i v_prod = _mm512_hexl_mullo_epi<64>(v_hi, v_radix);
+    v_prod = _mm512_hexl_mullo_add_lo_epi<64>(v_prod, v_q_hat, v_neg_modulus);
+    v_prod = _mm512_hexl_small_mod_epu64(v_prod, v_modulus);
+
+    __m512i v_result = _mm512_hexl_small_add_mod_epi64(v_prod, v_lo, v_modulus);
+    _mm512_storeu_si512(vp_result, v_result);
+
+    ++vp_acc_hi;
+    ++vp_acc_lo;
+    ++vp_result;
+  }
+}
+
+void KeySwitchModDownPrepareAVX512(uint64_t* result, const uint64_t* special,
+                                   uint64_t n, uint64_t special_modulus,
+                                   uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(special != nullptr, "Require special != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK_BOUNDS(special, n, special_modulus,
+                    "special exceeds bound " << special_modulus);
+
+  uint64_t half = special_modulus >> 1;
+  uint64_t barrett_factor = MultiplyFactor(1, 64, modulus).BarrettFactor();
+  uint64_t fix = modulus - BarrettReduce64(half, modulus, barrett_factor);
+
+  __m512i v_special_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(special_modulus));
+  __m512i v_half = _mm512_set1_epi64(static_cast<int64_t>(half));
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_barrett = _mm512_set1_epi64(static_cast<int64_t>(barrett_factor));
+  __m512i v_fix = _mm512_set1_epi64(static_cast<int64_t>(fix));
+
+  const __m512i* vp_special = reinterpret_cast<const __m512i*>(special);
+  __m512i* vp_result = reinterpret_cast<__m512i*>(result);
+
+  bool reduce = special_modulus > modulus;
+  HEXL_LOOP_UNROLL_4
+  for (size_t i = n / 8; i > 0; --i) {
+    __m512i v_x = _mm512_loadu_si512(vp_special);
+
+    // (x + floor(qk / 2)) mod qk
+    v_x = _mm512_add_epi64(v_x, v_half);
+    v_x = _mm512_hexl_small_mod_epu64(v_x, v_special_modulus);
+
+    // (x mod qi) + fix, in [0, 2 * qi)
+    if (reduce) {
+      v_x = _mm512_hexl_barrett_reduce64<64, 1>(v_x, v_modulus, v_barrett,
+                                                v_barrett, 0, v_neg_modulus);
+    }
+    v_x = _mm512_add_epi64(v_x, v_fix);
+    _mm512_storeu_si512(vp_result, v_x);
+
+    ++vp_special;
+    ++vp_result;
+  }
+}
+
+template <int BitShift>
+void KeySwitchModDownAccumulateAVX512(uint64_t* result, const uint64_t* operand,
+                                      const uint64_t* special, uint64_t n,
+                                      uint64_t modulus,
+                                      uint64_t modswitch_factor) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(special != nullptr, "Require special != nullptr");
+  HEXL_CHECK(n % 8 == 0, "Require n % 8 == 0");
+  HEXL_CHECK(BitShift == 64 || modulus < (1ULL << 50),
+             "Modulus " << modulus << " too large for BitShift " << BitShift);
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+  HEXL_CHECK_BOUNDS(operand, n, modulus, "operand exceeds bound " << modulus);
+  HEXL_CHECK_BOUNDS(special, n, 4 * modulus,
+                    "special exceeds bound " << (4 * modulus));
+  HEXL_CHECK(modswitch_factor < modulus,
+             "modswitch_factor exceeds bound " << modulus);
+
+  uint64_t factor_precon =
+      MultiplyFactor(modswitch_factor, BitShift, modulus).BarrettFactor();
+
+  __m512i v_modulus = _mm512_set1_epi64(static_cast<int64_t>(modulus));
+  __m512i v_neg_modulus = _mm512_set1_epi64(-static_cast<int64_t>(modulus));
+  __m512i v_twice_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(2 * modulus));
+  __m512i v_four_times_modulus =
+      _mm512_set1_epi64(static_cast<int64_t>(4 * modulus));
+  __m512i v_factor = _mm512_set1_epi64(static_cast<int64_t>(modswitch_factor));
+  __m512i v_factor_precon =
+      _mm512_set1_epi64(static_cast<int64_t>(factor_precon));
+
+  const __m512i* vp_operand = reinterpret_cast<const __m512i*>(operand);
+  const __m512i* vp_special = reinterpret_cast<const __m512i*>(special);
+  __m512i* vp_result = reinterpret_cast<__m512i*>(result);
+
+  HEXL_LOOP_UNROLL_4
+  for (size_t i = n / 8; i > 0; --i) {
+    __m512i v_operand = _mm512_loadu_si512(vp_operand);
+    __m512i v_special = _mm512_loadu_si512(vp_special);
+    __m512i v_result = _mm512_loadu_si512(vp_result);
+
+    // (operand - special) mod qi, via operand + 4 * qi - special in [0, 8 * qi)
+    __m512i v_diff = _mm512_add_epi64(v_operand, v_four_times_modulus);
+    v_diff = _mm512_sub_epi64(v_diff, v_special);
+    v_diff = _mm512_hexl_small_mod_epu64<8>(
+        v_diff, v_modulus, &v_twice_modulus, &v_four_times_modulus);
+
+    // Shoup multiplication by the modulus switch factor, in [0, 2 * qi)
+    __m512i v_q_hat = _mm512_hexl_mulhi_epi<BitShift>(v_diff, v_factor_precon);
+    __m512i v_prod = _mm512_hexl_mullo_epi<BitShift>(v_diff, v_factor);
+    v_prod =
+        _mm512_hexl_mullo_add_lo_epi<BitShift>(v_prod, v_q_hat, v_neg_modulus);
+
+    // Accumulate, reducing from [0, 3 * qi)
+    v_result = _mm512_add_epi64(v_result, v_prod);
+    v_result = _mm512_hexl_small_mod_epu64<4>(v_result, v_modulus,
+                                              &v_twice_modulus);
+    _mm512_storeu_si512(vp_result, v_result);
+
+    ++vp_operand;
+    ++vp_special;
+    ++vp_result;
+  }
+}
+
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,65 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+#ifdef HEXL_HAS_AVX512DQ
+
+/// @brief Multiplies two vectors element-wise and adds the products to a lazy
+/// accumulator without modular reduction
+/// @param[in,out] acc_hi High words of the accumulator. Element i of the
+/// accumulator represents acc_hi[i] * 2^BitShift + acc_lo[i]
+/// @param[in,out] acc_lo Low words of the accumulator
+/// @param[in] operand Vector of elements to multiply
+/// @param[in] key Vector of elements to multiply
+/// @param[in] n Number of elements in each vector. Must be a multiple of 8
+/// @details For BitShift == 52, each element of \p operand and \p key must be
+/// less than 2^52. For BitShift == 64, the accumulated sum must not exceed
+/// 2^128.
+template <int BitShift>
+void KeySwitchMultiplyAccumulateAVX512(uint64_t* acc_hi, uint64_t* acc_lo,
+                                       const uint64_t* operand,
+                                       const uint64_t* key, uint64_t n);
+
+/// @brief Reduces a lazy accumulator modulo \p modulus
+/// @param[out] result Stores the result, in [0, modulus)
+/// @param[in] acc_hi High words of the accumulator. Element i of the
+/// accumulator represents acc_hi[i] * 2^BitShift + acc_lo[i]
+/// @param[in] acc_lo Low words of the accumulator
+/// @param[in] n Number of elements in each vector. Must be a multiple of 8
+/// @param[in] modulus Modulus with which to perform modular reduction
+template <int BitShift>
+void KeySwitchReduceAVX512(uint64_t* result, const uint64_t* acc_hi,
+                           const uint64_t* acc_lo, uint64_t n,
+                           uint64_t modulus);
+
+/// @brief First fused ModDown pass
+/// @details Parameters are as in KeySwitchModDownPrepareNative. \p n must be
+/// a multiple of 8
+void KeySwitchModDownPrepareAVX512(uint64_t* result, const uint64_t* special,
+                                   uint64_t n, uint64_t special_modulus,
+                                   uint64_t modulus);
+
+/// @brief Second fused ModDown pass
+/// @details Parameters are as in KeySwitchModDownAccumulateNative. \p n must
+/// be a multiple of 8. For BitShift == 52, \p modulus must be less than
+/// 2^50
+template <int BitShift>
+void KeySwitchModDownAccumulateAVX512(uint64_t* result, const uint64_t* operand,
+                                      const uint64_t* special, uint64_t n,
+                                      uint64_t modulus,
+                                      uint64_t modswitch_factor);
+
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
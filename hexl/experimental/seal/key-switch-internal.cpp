@@ -3,76 +3,502 @@
 
 #include "hexl/experimental/seal/key-switch-internal.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <exception>
 #include <iostream>
+#include <vector>
 
-#include "hexl/eltwise/eltwise-add-mod.hpp"
-#include "hexl/eltwise/eltwise-fma-mod.hpp"
 #include "hexl/eltwise/eltwise-mult-mod.hpp"
 #include "hexl/eltwise/eltwise-reduce-mod.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/ntt/ntt.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/cache-info.hpp"
 #include "hexl/util/check.hpp"
-#include "util/cpu-features.hpp"
+#include "hexl/util/pool-allocator.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
 namespace internal {
 
+void KeySwitchMultiplyAccumulateNative(uint64_t* acc_hi, uint64_t* acc_lo,
+                                       const uint64_t* operand,
+                                       const uint64_t* key, uint64_t n) {
+  HEXL_CHECK(acc_hi != nullptr, "Require acc_hi != nullptr");
+  HEXL_CHECK(acc_lo != nullptr, "Require acc_lo != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(key != nullptr, "Require key != nullptr");
+
+  // No reduction used; assume intermediate results don't overflow
+  for (size_t l = 0; l < n; ++l) {
+    uint128_t prod = MultiplyUInt64(operand[l], key[l]);
+    uint128_t x = (uint128_t(acc_hi[l]) << 64) + acc_lo[l];
+    uint128_t sum = prod + x;
+    acc_hi[l] = static_cast<uint64_t>(sum >> 64);
+    acc_lo[l] = static_cast<uint64_t>(sum);
+  }
+}
+
+void KeySwitchReduceNative(uint64_t* result, const uint64_t* acc_hi,
+                           const uint64_t* acc_lo, uint64_t n,
+                           uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(acc_hi != nullptr, "Require acc_hi != nullptr");
+  HEXL_CHECK(acc_lo != nullptr, "Require acc_lo != nullptr");
+  HEXL_CHECK(modulus > 1, "Require modulus > 1");
+
+  for (size_t l = 0; l < n; ++l) {
+    result[l] = BarrettReduce128(acc_hi[l], acc_lo[l], modulus);
+  }
+}
+
+// The AVX512 kernels process 8 coefficients at a time
+inline const DispatchTable& KeySwitchTable(uint64_t n) {
+  return (n % 8 == 0) ? GetDispatchTable() : GetNativeDispatchTable();
+}
+
+// Returns the backend of the inner products of the largest key modulus
+inline Backend KeySwitchBackend(uint64_t n, const uint64_t* moduli,
+                                uint64_t key_modulus_size) {
+  uint64_t max_modulus = *std::max_element(moduli, moduli + key_modulus_size);
+  return KeySwitchTable(n).key_switch_accumulate.Select(max_modulus).backend;
+}
+
+// Returns the inner product kernels of the table for n with the given radix
+inline const KeySwitchAccumulator& GetKeySwitchAccumulator(uint64_t n,
+                                                           int bit_shift) {
+  const auto& variants = KeySwitchTable(n).key_switch_accumulate.variants;
+  for (const auto& variant : variants) {
+    if (variant.function.bit_shift == bit_shift) {
+      return variant.function;
+    }
+  }
+  HEXL_CHECK(false, "Invalid bit_shift " << bit_shift);
+  return variants[0].function;
+}
+
+int KeySwitchAccumulatorBitShift(uint64_t n, uint64_t modulus,
+                                 uint64_t num_products) {
+  int bit_shift = KeySwitchTable(n)
+                      .key_switch_accumulate.Select(modulus)
+                      .function.bit_shift;
+  // The 52-bit accumulators overflow beyond 2^12 products
+  if (bit_shift == 52 && num_products >= (1ULL << 12)) {
+    return 64;
+  }
+  return bit_shift;
+}
+
+void KeySwitchMultiplyAccumulate(uint64_t* acc_hi, uint64_t* acc_lo,
+                                 const uint64_t* operand, const uint64_t* key,
+                                 uint64_t n, int bit_shift) {
+  GetKeySwitchAccumulator(n, bit_shift)
+      .multiply_accumulate(acc_hi, acc_lo, operand, key, n);
+}
+
+void KeySwitchReduce(uint64_t* result, const uint64_t* acc_hi,
+                     const uint64_t* acc_lo, uint64_t n, uint64_t modulus,
+                     int bit_shift) {
+  GetKeySwitchAccumulator(n, bit_shift)
+      .reduce(result, acc_hi, acc_lo, n, modulus);
+}
+
+void KeySwitchModDownPrepareNative(uint64_t* result, const uint64_t* special,
+                                   uint64_t n, uint64_t special_modulus,
+                                   uint64_t modulus) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(special != nullptr, "Require special != nullptr");
+  HEXL_CHECK_BOUNDS(special, n, special_modulus,
+                    "special exceeds bound " << special_modulus);
+
+  uint64_t half = special_modulus >> 1;
+  uint64_t barrett_factor = MultiplyFactor(1, 64, modulus).BarrettFactor();
+  uint64_t fix = modulus - BarrettReduce64(half, modulus, barrett_factor);
+
+  for (size_t l = 0; l < n; ++l) {
+    uint64_t x = special[l] + half;
+    x = (x >= special_modulus) ? x - special_modulus : x;
+    result[l] = BarrettReduce64(x, modulus, barrett_factor) + fix;
+  }
+}
+
+void KeySwitchModDownPrepare(uint64_t* result, const uint64_t* special,
+                             uint64_t n, uint64_t special_modulus,
+                             uint64_t modulus) {
+  KeySwitchTable(n)
+      .key_switch_mod_down_prepare.Select(modulus)
+      .function(result, special, n, special_modulus, modulus);
+}
+
+void KeySwitchModDownAccumulateNative(uint64_t* result, const uint64_t* operand,
+                                      const uint64_t* special, uint64_t n,
+                                      uint64_t modulus,
+                                      uint64_t modswitch_factor) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(special != nullptr, "Require special != nullptr");
+  HEXL_CHECK(modulus < (1ULL << 61), "Require modulus < 2^61");
+  HEXL_CHECK_BOUNDS(operand, n, modulus, "operand exceeds bound " << modulus);
+  HEXL_CHECK_BOUNDS(special, n, 4 * modulus,
+                    "special exceeds bound " << (4 * modulus));
+
+  uint64_t twice_modulus = 2 * modulus;
+  uint64_t four_times_modulus = 4 * modulus;
+  uint64_t factor_precon =
+      MultiplyFactor(modswitch_factor, 64, modulus).BarrettFactor();
+
+  for (size_t l = 0; l < n; ++l) {
+    uint64_t diff = operand[l] + four_times_modulus - special[l];
+    diff = ReduceMod<8>(diff, modulus, &twice_modulus, &four_times_modulus);
+    uint64_t prod =
+        MultiplyModLazy<64>(diff, modswitch_factor, factor_precon, modulus);
+    uint64_t sum = result[l] + prod;
+    result[l] = ReduceMod<4>(sum, modulus, &twice_modulus);
+  }
+}
+
+void KeySwitchModDownAccumulate(uint64_t* result, const uint64_t* operand,
+                                const uint64_t* special, uint64_t n,
+                                uint64_t modulus, uint64_t modswitch_factor) {
+  KeySwitchTable(n)
+      .key_switch_mod_down_accumulate.Select(modulus)
+      .function(result, operand, special, n, modulus, modswitch_factor);
+}
+
+// Largest number of ciphertexts whose inner products share one pass over the
+// key switching keys. Bounds the per-worker scratch for large batches
+constexpr uint64_t kKeySwitchMaxGroupSize = 8;
+
+inline uint64_t KeySwitchBatchMaxGroupSize(uint64_t batch_size) {
+  return std::min(batch_size, kKeySwitchMaxGroupSize);
+}
+
+// Number of ciphertexts whose inner products share one pass over the key
+// switching keys, such that the key tiles and the operand and accumulator
+// tiles of the group stay in L2 cache
+inline uint64_t KeySwitchBatchGroupSize(uint64_t batch_size, uint64_t tile_size,
+                                        uint64_t key_component_count) {
+  uint64_t tile_bytes = tile_size * sizeof(uint64_t);
+  uint64_t num_tiles = GetL2CacheSize() / tile_bytes;
+  uint64_t group_size = 1;
+  if (num_tiles > key_component_count) {
+    group_size = (num_tiles - key_component_count) /
+                 (1 + 2 * key_component_count);
+  }
+  return std::max(uint64_t(1),
+                  std::min(group_size, KeySwitchBatchMaxGroupSize(batch_size)));
+}
+
+// A key tile of each component and the operand and accumulator tiles of one
+// ciphertext fit in half of the L1 data cache, leaving room for the operand
+// tiles of the rest of the group
+uint64_t KeySwitchBatchTileSize(uint64_t n, uint64_t key_component_count) {
+  return CacheTileSize(n, GetL1DataCacheSize() / 2,
+                       3 * key_component_count + 1);
+}
+
+// Per-worker scratch: for each ciphertext of a group, one polynomial for
+// RNS-NTT conversions and the lazy accumulators (128-bit coefficients) stored
+// as planar high and low words, followed by one limb per key component for
+// keys which are not stored in the KeySwitch layout, and one word per key
+// component holding the pointer to its limb, padded to whole cache lines so
+// the scratch of each worker stays 64-byte aligned
+inline uint64_t KeySwitchWorkerScratchSize(uint64_t n,
+                                           uint64_t key_component_count,
+                                           uint64_t group_size) {
+  return n * (group_size * (1 + 2 * key_component_count) +
+              key_component_count) +
+         (key_component_count + 7) / 8 * 8;
+}
+
+uint64_t KeySwitchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                uint64_t rns_modulus_size,
+                                uint64_t key_component_count,
+                                const Executor* executor) {
+  return KeySwitchBatchWorkspaceSize(n, decomp_modulus_size, rns_modulus_size,
+                                     key_component_count, 1, executor);
+}
+
+uint64_t KeySwitchBatchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                     uint64_t rns_modulus_size,
+                                     uint64_t key_component_count,
+                                     uint64_t batch_size,
+                                     const Executor* executor) {
+  return batch_size * n * decomp_modulus_size +
+         batch_size * n * key_component_count * rns_modulus_size +
+         NumWorkers(executor) *
+             KeySwitchWorkerScratchSize(n, key_component_count,
+                                        KeySwitchBatchMaxGroupSize(batch_size));
+}
+
+namespace {
+
+// NTTs built by the KeySwitch overload taking root of unity powers, for one
+// parameter set. root_of_unity is 0 for the minimal root of unity
+struct KeySwitchNTTCacheEntry {
+  uint64_t n;
+  std::vector<uint64_t> moduli;
+  std::vector<uint64_t> roots_of_unity;
+  std::vector<NTT> ntts;
+};
+
+// Parameter sets whose NTTs are kept on each thread
+constexpr size_t kKeySwitchNTTCacheSize = 4;
+
+// Returns the NTTs for the moduli, built on the first call with these
+// parameters on the calling thread. Keeps the most recently used entries
+const std::vector<NTT>& GetKeySwitchNTTs(
+    uint64_t n, uint64_t key_modulus_size, const uint64_t* moduli,
+    const uint64_t* root_of_unity_powers_ptr) {
+  thread_local std::vector<KeySwitchNTTCacheEntry> cache;
+
+  // The minimal root of unity is stored at bit-reversed index 1
+  auto root_of_unity = [&](size_t m) -> uint64_t {
+    if (root_of_unity_powers_ptr == nullptr) {
+      return 0;
+    }
+    const uint64_t* powers = &root_of_unity_powers_ptr[m * n];
+    HEXL_CHECK(powers[0] == 1,
+               "Invalid root of unity powers for modulus " << moduli[m]);
+    return powers[n >> 1];
+  };
+
+  for (auto it = cache.begin(); it != cache.end(); ++it) {
+    bool match = it->n == n && it->moduli.size() == key_modulus_size;
+    for (size_t m = 0; match && m < key_modulus_size; ++m) {
+      match = it->moduli[m] == moduli[m] &&
+              it->roots_of_unity[m] == root_of_unity(m);
+    }
+    if (match) {
+      std::rotate(cache.begin(), it, it + 1);
+      return cache.front().ntts;
+    }
+  }
+
+  KeySwitchNTTCacheEntry entry;
+  entry.n = n;
+  entry.moduli.assign(moduli, moduli + key_modulus_size);
+  entry.ntts.reserve(key_modulus_size);
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    uint64_t root = root_of_unity(m);
+    entry.roots_of_unity.push_back(root);
+    if (root != 0) {
+      entry.ntts.emplace_back(n, moduli[m], root);
+    } else {
+      entry.ntts.emplace_back(n, moduli[m]);
+    }
+  }
+  if (cache.size() == kKeySwitchNTTCacheSize) {
+    cache.pop_back();
+  }
+  cache.insert(cache.begin(), std::move(entry));
+  return cache.front().ntts;
+}
+
+}  // namespace
+
 void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
                uint64_t decomp_modulus_size, uint64_t key_modulus_size,
                uint64_t rns_modulus_size, uint64_t key_component_count,
                const uint64_t* moduli, const uint64_t** k_switch_keys,
                const uint64_t* modswitch_factors,
-               const uint64_t* root_of_unity_powers_ptr) {
-  if (root_of_unity_powers_ptr != nullptr) {
-    throw std::invalid_argument(
-        "Parameter root_of_unity_powers_ptr is not supported yet.");
+               const uint64_t* root_of_unity_powers_ptr, Executor* executor) {
+  const std::vector<NTT>& ntts = GetKeySwitchNTTs(
+      n, key_modulus_size, moduli, root_of_unity_powers_ptr);
+  KeySwitch(result, t_target_iter_ptr, n, decomp_modulus_size,
+            key_modulus_size, rns_modulus_size, key_component_count, moduli,
+            k_switch_keys, modswitch_factors, ntts, executor);
+}
+
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  KeySwitchBatch(&result, &t_target_iter_ptr, 1, n, decomp_modulus_size,
+                 key_modulus_size, rns_modulus_size, key_component_count,
+                 moduli, k_switch_keys, modswitch_factors, ntts, executor,
+                 workspace);
+}
+
+// Switches the products of each ciphertext down from the rns moduli to the
+// decomposition moduli and adds them to results. t_poly_prod_base holds the
+// products of each ciphertext and key component, in NTT form with entries in
+// [0, moduli[key index]). Each worker uses at least n words of scratch
+inline void KeySwitchModDownBatch(
+    uint64_t** results, uint64_t* t_poly_prod_base, uint64_t batch_size,
+    uint64_t n, uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+    uint64_t rns_modulus_size, uint64_t key_component_count,
+    const uint64_t* moduli, const uint64_t* modswitch_factors,
+    const std::vector<NTT>& ntts, Executor* executor, uint64_t* scratch,
+    uint64_t scratch_size) {
+  uint64_t coeff_count = n;
+  size_t prod_size = key_component_count * coeff_count * rns_modulus_size;
+  uint64_t qk = moduli[key_modulus_size - 1];
+
+  // Switch the special limb to normal form, fully reduced
+  size_t num_special_tasks = batch_size * key_component_count;
+  ParallelFor(executor, num_special_tasks, [&](size_t task, size_t) {
+    size_t b = task / key_component_count;
+    size_t k = task % key_component_count;
+    uint64_t* t_poly_prod_it =
+        &t_poly_prod_base[b * prod_size + k * coeff_count * rns_modulus_size];
+    uint64_t* t_last = &t_poly_prod_it[decomp_modulus_size * coeff_count];
+
+    ntts[key_modulus_size - 1].ComputeInverse(t_last, t_last, 2, 1);
+  });
+
+  // Each (ciphertext, key component, modulus) triple is independent
+  size_t num_mod_down_tasks =
+      batch_size * key_component_count * decomp_modulus_size;
+  ParallelFor(executor, num_mod_down_tasks, [&](size_t task, size_t worker) {
+    size_t b = task / (key_component_count * decomp_modulus_size);
+    size_t key_component = (task / decomp_modulus_size) % key_component_count;
+    size_t i = task % decomp_modulus_size;
+
+    uint64_t* t_ntt_ptr = &scratch[worker * scratch_size];
+    uint64_t* t_poly_prod_it =
+        &t_poly_prod_base[b * prod_size +
+                          key_component * coeff_count * rns_modulus_size];
+    uint64_t* t_last = &t_poly_prod_it[decomp_modulus_size * coeff_count];
+
+    // ((ct + qk/2) mod qk) mod qi - qk/2 mod qi, lazily in [0, 2*qi)
+    KeySwitchModDownPrepare(t_ntt_ptr, t_last, coeff_count, qk, moduli[i]);
+
+    // NTT conversion lazy outputs in [0, 4*qi)
+    ntts[i].ComputeForward(t_ntt_ptr, t_ntt_ptr, 4, 4);
+
+    // ct + qk^(-1) * ((ct mod qi) - (ct mod qk)) mod qi
+    uint64_t data_ptr_offset =
+        coeff_count * (decomp_modulus_size * key_component + i);
+    uint64_t* data_ptr = &results[b][data_ptr_offset];
+    KeySwitchModDownAccumulate(data_ptr, &t_poly_prod_it[i * coeff_count],
+                               t_ntt_ptr, coeff_count, moduli[i],
+                               modswitch_factors[i]);
+  });
+}
+
+// Computes batched key switching, reading the key limbs through key_limb.
+// key_limb(j, k, key_index, buffer) returns the first tile of component k of
+// key j modulo moduli[key_index], either in place or unpacked into buffer.
+// Consecutive tiles of a limb are key_tile_stride words apart
+template <typename KeyLimb>
+void KeySwitchBatchImpl(uint64_t** results,
+                        const uint64_t** t_target_iter_ptrs,
+                        uint64_t batch_size, uint64_t n,
+                        uint64_t decomp_modulus_size,
+                        uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                        uint64_t key_component_count, const uint64_t* moduli,
+                        const KeyLimb& key_limb, uint64_t tile_size,
+                        uint64_t key_tile_stride,
+                        const uint64_t* modswitch_factors,
+                        const std::vector<NTT>& ntts, Executor* executor,
+                        uint64_t* workspace) {
+  HEXL_CHECK(batch_size > 0, "Require batch_size > 0");
+  HEXL_CHECK(n % tile_size == 0, "Require tile_size to divide n");
+  HEXL_CHECK(ntts.size() >= key_modulus_size,
+             "Require one NTT per key modulus");
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    HEXL_CHECK(ntts[m].GetDegree() == n, "NTT " << m << " has wrong degree");
+    HEXL_CHECK(ntts[m].GetModulus() == moduli[m],
+               "NTT " << m << " has wrong modulus");
   }
 
   uint64_t coeff_count = n;
 
-  // Create a copy of target_iter
-  std::vector<uint64_t> t_target(coeff_count * decomp_modulus_size, 0);
-  for (size_t i = 0; i < coeff_count * decomp_modulus_size; ++i) {
-    t_target[i] = t_target_iter_ptr[i];
+  // Reads each target_iter and adds key_component_count polynomials to each
+  // result
+  uint64_t num_elements = batch_size * coeff_count * decomp_modulus_size;
+  KernelTimer timer(
+      Kernel::kKeySwitch, n, moduli, decomp_modulus_size, num_elements,
+      (1 + 2 * key_component_count) * num_elements * sizeof(uint64_t));
+  if (timer.IsEnabled()) {
+    timer.SetBackend(KeySwitchBackend(n, moduli, key_modulus_size));
+  }
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(KeySwitchBatchWorkspaceSize(
+        n, decomp_modulus_size, rns_modulus_size, key_component_count,
+        batch_size, executor));
+    workspace = owned_workspace.data();
   }
 
-  uint64_t* t_target_ptr = &t_target[0];
+  // Workspace layout: the normal-form copies of each target_iter, the
+  // products for each ciphertext and key component, then per-worker scratch
+  size_t target_size = coeff_count * decomp_modulus_size;
+  size_t prod_size = key_component_count * coeff_count * rns_modulus_size;
+  uint64_t* t_target_base = workspace;
+  uint64_t* t_poly_prod_base = t_target_base + batch_size * target_size;
+  uint64_t* scratch = t_poly_prod_base + batch_size * prod_size;
 
-  // Simplified implementation, where we assume no modular reduction is required
-  // for intermediate additions
-  std::vector<uint64_t> t_ntt(coeff_count, 0);
-  uint64_t* t_ntt_ptr = &t_ntt[0];
+  size_t group_size =
+      KeySwitchBatchGroupSize(batch_size, tile_size, key_component_count);
+  size_t num_groups = (batch_size + group_size - 1) / group_size;
+  size_t scratch_size =
+      KeySwitchWorkerScratchSize(n, key_component_count, group_size);
 
   // In CKKS t_target is in NTT form; switch
   // back to normal form
-  for (size_t j = 0; j < decomp_modulus_size; ++j) {
-    NTT(n, moduli[j])
-        .ComputeInverse(&t_target_ptr[j * coeff_count],
-                        &t_target_ptr[j * coeff_count], 2, 1);
-  }
+  size_t num_inverse_tasks = batch_size * decomp_modulus_size;
+  ParallelFor(executor, num_inverse_tasks, [&](size_t task, size_t) {
+    size_t b = task / decomp_modulus_size;
+    size_t j = task % decomp_modulus_size;
+    ntts[j].ComputeInverse(&t_target_base[b * target_size + j * coeff_count],
+                           &t_target_iter_ptrs[b][j * coeff_count], 2, 1);
+  });
+
+  // Each (output modulus, group of ciphertexts) pair is independent. Within
+  // a group, each key tile is loaded once and applied to every ciphertext
+  size_t num_product_tasks = rns_modulus_size * num_groups;
+  ParallelFor(executor, num_product_tasks, [&](size_t task, size_t worker) {
+    size_t i = task / num_groups;
+    size_t group_begin = (task % num_groups) * group_size;
+    size_t group_end = std::min(group_begin + group_size, size_t(batch_size));
+    size_t key_index = (i == decomp_modulus_size ? key_modulus_size - 1 : i);
 
-  std::vector<uint64_t> t_poly_prod(
-      key_component_count * coeff_count * rns_modulus_size, 0);
+    // Scratch layout: an NTT polynomial for each ciphertext of the group,
+    // the high and low accumulator words of each ciphertext, the key buffer,
+    // then the key limb pointers
+    size_t lazy_size = key_component_count * coeff_count;
+    uint64_t* t_ntt_base = &scratch[worker * scratch_size];
+    uint64_t* t_lazy_base = t_ntt_base + group_size * coeff_count;
+    uint64_t* t_key_base = t_lazy_base + 2 * group_size * lazy_size;
+    static_assert(sizeof(const uint64_t*) <= sizeof(uint64_t),
+                  "A key limb pointer must fit in one scratch word");
+    const uint64_t** key_ptrs = reinterpret_cast<const uint64_t**>(
+        t_key_base + key_component_count * coeff_count);
 
-  for (size_t i = 0; i < rns_modulus_size; ++i) {
-    size_t key_index = (i == decomp_modulus_size ? key_modulus_size - 1 : i);
+    int bit_shift = KeySwitchAccumulatorBitShift(
+        coeff_count, moduli[key_index], decomp_modulus_size);
 
-    // Allocate memory for a lazy accumulator (128-bit coefficients)
-    std::vector<uint64_t> t_poly_lazy(key_component_count * coeff_count * 2, 0);
-    uint64_t* t_poly_lazy_ptr = &t_poly_lazy[0];
-    uint64_t* accumulator_ptr = &t_poly_lazy[0];
+    std::fill(t_lazy_base, t_lazy_base + 2 * group_size * lazy_size, 0);
 
+    std::array<const uint64_t*, kKeySwitchMaxGroupSize> t_operands;
     for (size_t j = 0; j < decomp_modulus_size; ++j) {
-      const uint64_t* t_operand;
-      // assume scheme == scheme_type::ckks
-      if (i == j) {
-        t_operand = &t_target_iter_ptr[j * coeff_count];
-      } else {
+      for (size_t k = 0; k < key_component_count; ++k) {
+        key_ptrs[k] =
+            key_limb(j, k, key_index, &t_key_base[k * coeff_count]);
+      }
+
+      for (size_t b = group_begin; b < group_end; ++b) {
+        uint64_t* t_ntt_ptr = &t_ntt_base[(b - group_begin) * coeff_count];
+        const uint64_t* t_target_ptr = &t_target_base[b * target_size];
+
+        // assume scheme == scheme_type::ckks
+        if (i == j) {
+          t_operands[b - group_begin] =
+              &t_target_iter_ptrs[b][j * coeff_count];
+          continue;
+        }
         // Perform RNS-NTT conversion
         // No need to perform RNS conversion (modular reduction)
         if (moduli[j] <= moduli[key_index]) {
@@ -87,120 +513,379 @@ void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
         }
 
         // NTT conversion lazy outputs in [0, 4q)
-        NTT(n, moduli[key_index]).ComputeForward(t_ntt_ptr, t_ntt_ptr, 4, 4);
-
-        t_operand = t_ntt_ptr;
+        ntts[key_index].ComputeForward(t_ntt_ptr, t_ntt_ptr, 4, 4);
+        t_operands[b - group_begin] = t_ntt_ptr;
       }
 
-      // Multiply with keys and modular accumulate products in a lazy fashion
-      for (size_t k = 0; k < key_component_count; ++k) {
-        // No reduction used; assume intermediate results don't overflow
-        for (size_t l = 0; l < coeff_count; ++l) {
-          uint64_t t_poly_idx = 2 * (k * coeff_count + l);
-
-          uint64_t mult_op2_idx =
-              coeff_count * key_index + k * key_modulus_size * coeff_count + l;
-
-          uint128_t prod =
-              MultiplyUInt64(t_operand[l], k_switch_keys[j][mult_op2_idx]);
-
-          // TODO(fboemer): add uint128
-          uint128_t low = t_poly_lazy_ptr[t_poly_idx];
-          uint128_t hi = t_poly_lazy_ptr[t_poly_idx + 1];
-          uint128_t x = (hi << 64) + low;
-          uint128_t sum = prod + x;
-          uint64_t sum_hi = static_cast<uint64_t>(sum >> 64);
-          uint64_t sum_lo = static_cast<uint64_t>(sum);
-          t_poly_lazy_ptr[t_poly_idx] = sum_lo;
-          t_poly_lazy_ptr[t_poly_idx + 1] = sum_hi;
+      // Multiply with keys and modular accumulate products in a lazy
+      // fashion, one key tile at a time for all ciphertexts of the group
+      for (size_t tile = 0; tile < coeff_count; tile += tile_size) {
+        size_t key_offset = (tile / tile_size) * key_tile_stride;
+        for (size_t k = 0; k < key_component_count; ++k) {
+          const uint64_t* key_ptr = &key_ptrs[k][key_offset];
+          for (size_t b = 0; b < group_end - group_begin; ++b) {
+            uint64_t* t_poly_lazy_hi = &t_lazy_base[2 * b * lazy_size];
+            uint64_t* t_poly_lazy_lo = t_poly_lazy_hi + lazy_size;
+            size_t offset = k * coeff_count + tile;
+            KeySwitchMultiplyAccumulate(
+                &t_poly_lazy_hi[offset], &t_poly_lazy_lo[offset],
+                &t_operands[b][tile], key_ptr, tile_size, bit_shift);
+          }
         }
       }
     }
 
-    // PolyIter pointing to the destination t_poly_prod, shifted to the
-    // appropriate modulus
-    uint64_t* t_poly_prod_iter_ptr = &t_poly_prod[i * coeff_count];
+    for (size_t b = group_begin; b < group_end; ++b) {
+      uint64_t* t_poly_lazy_hi =
+          &t_lazy_base[2 * (b - group_begin) * lazy_size];
+      uint64_t* t_poly_lazy_lo = t_poly_lazy_hi + lazy_size;
 
-    // Final modular reduction
-    for (size_t k = 0; k < key_component_count; ++k) {
-      for (size_t l = 0; l < coeff_count; ++l) {
-        uint64_t accumulator_idx = 2 * coeff_count * k + 2 * l;
-        uint64_t poly_iter_idx = coeff_count * rns_modulus_size * k + l;
+      // PolyIter pointing to the destination t_poly_prod, shifted to the
+      // appropriate modulus
+      uint64_t* t_poly_prod_iter_ptr =
+          &t_poly_prod_base[b * prod_size + i * coeff_count];
 
-        t_poly_prod_iter_ptr[poly_iter_idx] = BarrettReduce128(
-            accumulator_ptr[accumulator_idx + 1],
-            accumulator_ptr[accumulator_idx], moduli[key_index]);
+      // Final modular reduction
+      for (size_t k = 0; k < key_component_count; ++k) {
+        KeySwitchReduce(
+            &t_poly_prod_iter_ptr[k * coeff_count * rns_modulus_size],
+            &t_poly_lazy_hi[k * coeff_count], &t_poly_lazy_lo[k * coeff_count],
+            coeff_count, moduli[key_index], bit_shift);
       }
     }
+  });
+
+  KeySwitchModDownBatch(results, t_poly_prod_base, batch_size, n,
+                        decomp_modulus_size, key_modulus_size,
+                        rns_modulus_size, key_component_count, moduli,
+                        modswitch_factors, ntts, executor, scratch,
+                        scratch_size);
+}
+
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli, const uint64_t** k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  auto key_limb = [&](size_t j, size_t k, size_t key_index, uint64_t*) {
+    return &k_switch_keys[j][(k * key_modulus_size + key_index) * n];
+  };
+  uint64_t tile_size = KeySwitchBatchTileSize(n, key_component_count);
+  KeySwitchBatchImpl(results, t_target_iter_ptrs, batch_size, n,
+                     decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                     key_component_count, moduli, key_limb, tile_size,
+                     tile_size, modswitch_factors, ntts, executor, workspace);
+}
+
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const CompactKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  KeySwitchBatch(&result, &t_target_iter_ptr, 1, n, decomp_modulus_size,
+                 key_modulus_size, rns_modulus_size, key_component_count,
+                 moduli, k_switch_keys, modswitch_factors, ntts, executor,
+                 workspace);
+}
+
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const CompactKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  HEXL_CHECK(k_switch_keys.GetDegree() == n, "Key has wrong degree");
+  HEXL_CHECK(k_switch_keys.GetModuli().size() == key_modulus_size,
+             "Key has wrong number of moduli");
+  HEXL_CHECK(k_switch_keys.NumDigits() >= decomp_modulus_size,
+             "Key has too few digits");
+  HEXL_CHECK(k_switch_keys.KeyComponentCount() == key_component_count,
+             "Key has wrong number of components");
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    HEXL_CHECK(k_switch_keys.GetModuli()[m] == moduli[m],
+               "Key modulus " << m << " differs from moduli");
   }
 
-  uint64_t* data_array = result;
-  for (size_t key_component = 0; key_component < key_component_count;
-       ++key_component) {
-    uint64_t* t_poly_prod_it =
-        &t_poly_prod[key_component * coeff_count * rns_modulus_size];
-    uint64_t* t_last = &t_poly_prod_it[decomp_modulus_size * coeff_count];
+  auto key_limb = [&](size_t j, size_t k, size_t key_index, uint64_t* buffer) {
+    k_switch_keys.GetLimb(buffer, j, k, key_index);
+    return static_cast<const uint64_t*>(buffer);
+  };
+  uint64_t tile_size = KeySwitchBatchTileSize(n, key_component_count);
+  KeySwitchBatchImpl(results, t_target_iter_ptrs, batch_size, n,
+                     decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                     key_component_count, moduli, key_limb, tile_size,
+                     tile_size, modswitch_factors, ntts, executor, workspace);
+}
 
-    NTT(n, moduli[key_modulus_size - 1]).ComputeInverse(t_last, t_last, 2, 2);
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const PreparedKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  KeySwitchBatch(&result, &t_target_iter_ptr, 1, n, decomp_modulus_size,
+                 key_modulus_size, rns_modulus_size, key_component_count,
+                 moduli, k_switch_keys, modswitch_factors, ntts, executor,
+                 workspace);
+}
 
-    uint64_t qk = moduli[key_modulus_size - 1];
-    uint64_t qk_half = qk >> 1;
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const PreparedKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  HEXL_CHECK(k_switch_keys.GetDegree() == n, "Key has wrong degree");
+  HEXL_CHECK(k_switch_keys.KeyModulusSize() == key_modulus_size,
+             "Key has wrong number of moduli");
+  HEXL_CHECK(k_switch_keys.NumDigits() >= decomp_modulus_size,
+             "Key has too few digits");
+  HEXL_CHECK(k_switch_keys.KeyComponentCount() == key_component_count,
+             "Key has wrong number of components");
+
+  // The tiles of all components of a limb are interleaved
+  uint64_t tile_size = k_switch_keys.TileSize();
+  auto key_limb = [&](size_t j, size_t k, size_t key_index, uint64_t*) {
+    return k_switch_keys.GetLimbs(j, key_index) + k * tile_size;
+  };
+  KeySwitchBatchImpl(results, t_target_iter_ptrs, batch_size, n,
+                     decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                     key_component_count, moduli, key_limb, tile_size,
+                     key_component_count * tile_size, modswitch_factors, ntts,
+                     executor, workspace);
+}
 
-    for (size_t i = 0; i < coeff_count; ++i) {
-      uint64_t barrett_factor =
-          MultiplyFactor(1, 64, moduli[key_modulus_size - 1]).BarrettFactor();
-      t_last[i] = BarrettReduce64(t_last[i] + qk_half,
-                                  moduli[key_modulus_size - 1], barrett_factor);
-    }
+// Returns the index of the coefficient which the automorphism X ->
+// X^galois_elt moves to index i of a polynomial in NTT form
+inline uint64_t GaloisPermutationIndex(uint64_t i, uint64_t log_n,
+                                       uint64_t galois_elt) {
+  // The NTT evaluates at psi^(2 * ReverseBits(i) + 1); the automorphism maps
+  // that evaluation point to psi^(galois_elt * (2 * ReverseBits(i) + 1))
+  uint64_t n = uint64_t(1) << log_n;
+  uint64_t reversed = ReverseBits(i + n, log_n + 1);
+  uint64_t index = ((galois_elt * reversed) >> 1) & (n - 1);
+  return ReverseBits(index, log_n);
+}
+
+void GaloisPermutationNTT(uint64_t* permutation, uint64_t n,
+                          uint64_t galois_elt) {
+  HEXL_CHECK(permutation != nullptr, "Require permutation != nullptr");
+  HEXL_CHECK(IsPowerOfTwo(n), "Require n to be a power of two");
+  HEXL_CHECK(galois_elt % 2 == 1 && galois_elt < 2 * n,
+             "Invalid galois_elt " << galois_elt);
+
+  uint64_t log_n = Log2(n);
+  for (size_t i = 0; i < n; ++i) {
+    permutation[i] = GaloisPermutationIndex(i, log_n, galois_elt);
+  }
+}
+
+void GaloisPermuteNTT(uint64_t* result, const uint64_t* operand, uint64_t n,
+                      uint64_t galois_elt) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(operand != nullptr, "Require operand != nullptr");
+  HEXL_CHECK(result != operand, "Require result != operand");
+  HEXL_CHECK(IsPowerOfTwo(n), "Require n to be a power of two");
+  HEXL_CHECK(galois_elt % 2 == 1 && galois_elt < 2 * n,
+             "Invalid galois_elt " << galois_elt);
+
+  uint64_t log_n = Log2(n);
+  for (size_t i = 0; i < n; ++i) {
+    result[i] = operand[GaloisPermutationIndex(i, log_n, galois_elt)];
+  }
+}
+
+uint64_t KeySwitchDecompositionSize(uint64_t n, uint64_t decomp_modulus_size,
+                                    uint64_t rns_modulus_size) {
+  return n * decomp_modulus_size * rns_modulus_size;
+}
+
+void KeySwitchDecompose(uint64_t* decomposition,
+                        const uint64_t* t_target_iter_ptr, uint64_t n,
+                        uint64_t decomp_modulus_size,
+                        uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                        const uint64_t* moduli, const std::vector<NTT>& ntts,
+                        Executor* executor) {
+  HEXL_CHECK(decomposition != nullptr, "Require decomposition != nullptr");
+  HEXL_CHECK(t_target_iter_ptr != nullptr,
+             "Require t_target_iter_ptr != nullptr");
+  HEXL_CHECK(ntts.size() >= key_modulus_size,
+             "Require one NTT per key modulus");
 
-    for (size_t i = 0; i < decomp_modulus_size; ++i) {
-      // (ct mod 4qk) mod qi
-      uint64_t qi = moduli[i];
-
-      // TODO(fboemer): Use input_mod_factor != 0 when qk / qi < 4
-      // TODO(fboemer): Use output_mod_factor == 4?
-      uint64_t input_mod_factor = (qk > qi) ? moduli[i] : 2;
-      if (qk > qi) {
-        intel::hexl::EltwiseReduceMod(t_ntt_ptr, t_last, coeff_count, moduli[i],
-                                      input_mod_factor, 1);
-      } else {
-        for (size_t coeff_idx = 0; coeff_idx < coeff_count; ++coeff_idx) {
-          t_ntt_ptr[coeff_idx] = t_last[coeff_idx];
+  uint64_t coeff_count = n;
+
+  // In CKKS t_target is in NTT form; switch back to normal form
+  AlignedVector64<uint64_t> t_target = MakePooledVector<uint64_t>();
+  t_target.resize(decomp_modulus_size * coeff_count);
+  ParallelFor(executor, decomp_modulus_size, [&](size_t j, size_t) {
+    ntts[j].ComputeInverse(&t_target[j * coeff_count],
+                           &t_target_iter_ptr[j * coeff_count], 2, 1);
+  });
+
+  // Each (output modulus, digit) pair is independent
+  ParallelFor(
+      executor, rns_modulus_size * decomp_modulus_size,
+      [&](size_t task, size_t) {
+        size_t i = task / decomp_modulus_size;
+        size_t j = task % decomp_modulus_size;
+        size_t key_index =
+            (i == decomp_modulus_size ? key_modulus_size - 1 : i);
+        uint64_t* digit = &decomposition[task * coeff_count];
+
+        if (i == j) {
+          std::copy(&t_target_iter_ptr[j * coeff_count],
+                    &t_target_iter_ptr[(j + 1) * coeff_count], digit);
+          return;
         }
-      }
+        // No need to perform RNS conversion (modular reduction)
+        if (moduli[j] <= moduli[key_index]) {
+          std::copy(&t_target[j * coeff_count],
+                    &t_target[(j + 1) * coeff_count], digit);
+        } else {
+          intel::hexl::EltwiseReduceMod(digit, &t_target[j * coeff_count],
+                                        coeff_count, moduli[key_index],
+                                        moduli[key_index], 1);
+        }
+        // NTT conversion lazy outputs in [0, 4q)
+        ntts[key_index].ComputeForward(digit, digit, 4, 4);
+      });
+}
 
-      // Lazy subtraction, results in [0, 2*qi), since fix is in [0, qi].
-      uint64_t barrett_factor =
-          MultiplyFactor(1, 64, moduli[i]).BarrettFactor();
-      uint64_t fix = qi - BarrettReduce64(qk_half, moduli[i], barrett_factor);
-      for (size_t l = 0; l < coeff_count; ++l) {
-        t_ntt_ptr[l] += fix;
-      }
+// Per-worker scratch: one permuted digit and the lazy accumulators of each
+// key component, stored as planar high and low words
+inline uint64_t KeySwitchHoistedWorkerScratchSize(
+    uint64_t n, uint64_t key_component_count) {
+  return n * (1 + 2 * key_component_count);
+}
 
-      uint64_t qi_lazy = qi << 1;  // some multiples of qi
+uint64_t KeySwitchHoistedWorkspaceSize(uint64_t n, uint64_t rns_modulus_size,
+                                       uint64_t key_component_count,
+                                       uint64_t num_keys,
+                                       const Executor* executor) {
+  return num_keys * n * key_component_count * rns_modulus_size +
+         num_keys * n +
+         NumWorkers(executor) *
+             KeySwitchHoistedWorkerScratchSize(n, key_component_count);
+}
 
-      NTT(n, moduli[i]).ComputeForward(t_ntt_ptr, t_ntt_ptr, 4, 4);
-      // Since SEAL uses at most 60bit moduli, 8*qi < 2^63.
-      qi_lazy = qi << 2;
+void KeySwitchHoisted(uint64_t** results, const uint64_t* decomposition,
+                      const uint64_t* galois_elts, uint64_t num_keys,
+                      uint64_t n, uint64_t decomp_modulus_size,
+                      uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                      uint64_t key_component_count, const uint64_t* moduli,
+                      const uint64_t*** k_switch_keys,
+                      const uint64_t* modswitch_factors,
+                      const std::vector<NTT>& ntts, Executor* executor,
+                      uint64_t* workspace) {
+  HEXL_CHECK(results != nullptr, "Require results != nullptr");
+  HEXL_CHECK(decomposition != nullptr, "Require decomposition != nullptr");
+  HEXL_CHECK(galois_elts != nullptr, "Require galois_elts != nullptr");
+  HEXL_CHECK(k_switch_keys != nullptr, "Require k_switch_keys != nullptr");
+  HEXL_CHECK(ntts.size() >= key_modulus_size,
+             "Require one NTT per key modulus");
+  if (num_keys == 0) {
+    return;
+  }
 
-      // ((ct mod qi) - (ct mod qk)) mod qi
-      uint64_t* t_ith_poly = &t_poly_prod_it[i * coeff_count];
-      for (size_t k = 0; k < coeff_count; ++k) {
-        t_ith_poly[k] = t_ith_poly[k] + qi_lazy - t_ntt[k];
-      }
+  uint64_t coeff_count = n;
 
-      // qk^(-1) * ((ct mod qi) - (ct mod qk)) mod qi
-      intel::hexl::EltwiseFMAMod(t_ith_poly, t_ith_poly, modswitch_factors[i],
-                                 nullptr, coeff_count, moduli[i], 8);
-      uint64_t data_ptr_offset =
-          coeff_count * (decomp_modulus_size * key_component + i);
+  // Reads the decomposition once and adds key_component_count polynomials to
+  // each result
+  uint64_t num_elements = coeff_count * decomp_modulus_size;
+  KernelTimer timer(Kernel::kKeySwitch, n, moduli, decomp_modulus_size,
+                    num_keys * num_elements,
+                    (1 + 2 * key_component_count * num_keys) * num_elements *
+                        sizeof(uint64_t));
+  if (timer.IsEnabled()) {
+    timer.SetBackend(KeySwitchBackend(n, moduli, key_modulus_size));
+  }
 
-      uint64_t* data_ptr = &data_array[data_ptr_offset];
-      intel::hexl::EltwiseAddMod(data_ptr, data_ptr, t_ith_poly, coeff_count,
-                                 moduli[i]);
-    }
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(KeySwitchHoistedWorkspaceSize(
+        n, rns_modulus_size, key_component_count, num_keys, executor));
+    workspace = owned_workspace.data();
   }
-  return;
+
+  // Workspace layout: the products for each key and key component, the
+  // permutation of each key, then per-worker scratch
+  size_t prod_size = key_component_count * coeff_count * rns_modulus_size;
+  uint64_t* t_poly_prod_base = workspace;
+  uint64_t* permutations = t_poly_prod_base + num_keys * prod_size;
+  uint64_t* scratch = permutations + num_keys * coeff_count;
+  size_t scratch_size =
+      KeySwitchHoistedWorkerScratchSize(n, key_component_count);
+
+  ParallelFor(executor, num_keys, [&](size_t r, size_t) {
+    GaloisPermutationNTT(&permutations[r * coeff_count], n, galois_elts[r]);
+  });
+
+  // The automorphism permutes the NTT slots of each digit, so the digits of
+  // the rotated ciphertext are gathered from the shared decomposition. Each
+  // (key, output modulus) pair is independent
+  ParallelFor(
+      executor, num_keys * rns_modulus_size, [&](size_t task, size_t worker) {
+        size_t r = task / rns_modulus_size;
+        size_t i = task % rns_modulus_size;
+        size_t key_index =
+            (i == decomp_modulus_size ? key_modulus_size - 1 : i);
+        const uint64_t* permutation = &permutations[r * coeff_count];
+
+        size_t lazy_size = key_component_count * coeff_count;
+        uint64_t* t_ntt_ptr = &scratch[worker * scratch_size];
+        uint64_t* t_poly_lazy_hi = t_ntt_ptr + coeff_count;
+        uint64_t* t_poly_lazy_lo = t_poly_lazy_hi + lazy_size;
+        std::fill(t_poly_lazy_hi, t_poly_lazy_hi + 2 * lazy_size, 0);
+
+        int bit_shift = KeySwitchAccumulatorBitShift(
+            coeff_count, moduli[key_index], decomp_modulus_size);
+
+        for (size_t j = 0; j < decomp_modulus_size; ++j) {
+          const uint64_t* digit =
+              &decomposition[(i * decomp_modulus_size + j) * coeff_count];
+          for (size_t l = 0; l < coeff_count; ++l) {
+            t_ntt_ptr[l] = digit[permutation[l]];
+          }
+          for (size_t k = 0; k < key_component_count; ++k) {
+            const uint64_t* key_ptr =
+                &k_switch_keys[r][j][(k * key_modulus_size + key_index) *
+                                     coeff_count];
+            KeySwitchMultiplyAccumulate(&t_poly_lazy_hi[k * coeff_count],
+                                        &t_poly_lazy_lo[k * coeff_count],
+                                        t_ntt_ptr, key_ptr, coeff_count,
+                                        bit_shift);
+          }
+        }
+
+        // Final modular reduction
+        uint64_t* t_poly_prod_iter_ptr =
+            &t_poly_prod_base[r * prod_size + i * coeff_count];
+        for (size_t k = 0; k < key_component_count; ++k) {
+          KeySwitchReduce(
+              &t_poly_prod_iter_ptr[k * coeff_count * rns_modulus_size],
+              &t_poly_lazy_hi[k * coeff_count],
+              &t_poly_lazy_lo[k * coeff_count], coeff_count,
+              moduli[key_index], bit_shift);
+        }
+      });
+
+  KeySwitchModDownBatch(results, t_poly_prod_base, num_keys, n,
+                        decomp_modulus_size, key_modulus_size,
+                        rns_modulus_size, key_component_count, moduli,
+                        modswitch_factors, ntts, executor, scratch,
+                        scratch_size);
 }
 
 }  // namespace internal
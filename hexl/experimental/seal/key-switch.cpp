@@ -1,8 +1,6 @@
 // Copyright (C) 2020-2021 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 
-#ifndef HEXL_FPGA_COMPATIBLE_KEYSWITCH
-
 #include "hexl/experimental/seal/key-switch.hpp"
 
 #include "hexl/experimental/seal/key-switch-internal.hpp"
@@ -10,6 +8,7 @@
 namespace intel {
 namespace hexl {
 
+#ifndef HEXL_FPGA_COMPATIBLE_KEYSWITCH
 void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
                uint64_t decomp_modulus_size, uint64_t key_modulus_size,
                uint64_t rns_modulus_size, uint64_t key_component_count,
@@ -21,7 +20,165 @@ void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
       rns_modulus_size, key_component_count, moduli, k_switch_keys,
       modswitch_factors, root_of_unity_powers_ptr);
 }
+#endif
+
+// Not provided by HEXL-FPGA, so are available in all configurations
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors,
+               const uint64_t* root_of_unity_powers_ptr, Executor* executor) {
+  intel::hexl::internal::KeySwitch(
+      result, t_target_iter_ptr, n, decomp_modulus_size, key_modulus_size,
+      rns_modulus_size, key_component_count, moduli, k_switch_keys,
+      modswitch_factors, root_of_unity_powers_ptr, executor);
+}
+
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitch(
+      result, t_target_iter_ptr, n, decomp_modulus_size, key_modulus_size,
+      rns_modulus_size, key_component_count, moduli, k_switch_keys,
+      modswitch_factors, ntts, executor, workspace);
+}
+
+uint64_t KeySwitchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                uint64_t rns_modulus_size,
+                                uint64_t key_component_count,
+                                const Executor* executor) {
+  return intel::hexl::internal::KeySwitchWorkspaceSize(
+      n, decomp_modulus_size, rns_modulus_size, key_component_count, executor);
+}
+
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli, const uint64_t** k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitchBatch(
+      results, t_target_iter_ptrs, batch_size, n, decomp_modulus_size,
+      key_modulus_size, rns_modulus_size, key_component_count, moduli,
+      k_switch_keys, modswitch_factors, ntts, executor, workspace);
+}
+
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const CompactKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitch(
+      result, t_target_iter_ptr, n, decomp_modulus_size, key_modulus_size,
+      rns_modulus_size, key_component_count, moduli, k_switch_keys,
+      modswitch_factors, ntts, executor, workspace);
+}
+
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const CompactKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitchBatch(
+      results, t_target_iter_ptrs, batch_size, n, decomp_modulus_size,
+      key_modulus_size, rns_modulus_size, key_component_count, moduli,
+      k_switch_keys, modswitch_factors, ntts, executor, workspace);
+}
+
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const PreparedKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitch(
+      result, t_target_iter_ptr, n, decomp_modulus_size, key_modulus_size,
+      rns_modulus_size, key_component_count, moduli, k_switch_keys,
+      modswitch_factors, ntts, executor, workspace);
+}
+
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const PreparedKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor, uint64_t* workspace) {
+  intel::hexl::internal::KeySwitchBatch(
+      results, t_target_iter_ptrs, batch_size, n, decomp_modulus_size,
+      key_modulus_size, rns_modulus_size, key_component_count, moduli,
+      k_switch_keys, modswitch_factors, ntts, executor, workspace);
+}
+
+uint64_t KeySwitchBatchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                     uint64_t rns_modulus_size,
+                                     uint64_t key_component_count,
+                                     uint64_t batch_size,
+                                     const Executor* executor) {
+  return intel::hexl::internal::KeySwitchBatchWorkspaceSize(
+      n, decomp_modulus_size, rns_modulus_size, key_component_count,
+      batch_size, executor);
+}
+
+void GaloisPermuteNTT(uint64_t* result, const uint64_t* operand, uint64_t n,
+                      uint64_t galois_elt) {
+  intel::hexl::internal::GaloisPermuteNTT(result, operand, n, galois_elt);
+}
+
+uint64_t KeySwitchDecompositionSize(uint64_t n, uint64_t decomp_modulus_size,
+                                    uint64_t rns_modulus_size) {
+  return intel::hexl::internal::KeySwitchDecompositionSize(
+      n, decomp_modulus_size, rns_modulus_size);
+}
+
+void KeySwitchDecompose(uint64_t* decomposition,
+                        const uint64_t* t_target_iter_ptr, uint64_t n,
+                        uint64_t decomp_modulus_size,
+                        uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                        const uint64_t* moduli, const std::vector<NTT>& ntts,
+                        Executor* executor) {
+  intel::hexl::internal::KeySwitchDecompose(
+      decomposition, t_target_iter_ptr, n, decomp_modulus_size,
+      key_modulus_size, rns_modulus_size, moduli, ntts, executor);
+}
+
+void KeySwitchHoisted(uint64_t** results, const uint64_t* decomposition,
+                      const uint64_t* galois_elts, uint64_t num_keys,
+                      uint64_t n, uint64_t decomp_modulus_size,
+                      uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                      uint64_t key_component_count, const uint64_t* moduli,
+                      const uint64_t*** k_switch_keys,
+                      const uint64_t* modswitch_factors,
+                      const std::vector<NTT>& ntts, Executor* executor,
+                      uint64_t* workspace) {
+  intel::hexl::internal::KeySwitchHoisted(
+      results, decomposition, galois_elts, num_keys, n, decomp_modulus_size,
+      key_modulus_size, rns_modulus_size, key_component_count, moduli,
+      k_switch_keys, modswitch_factors, ntts, executor, workspace);
+}
+
+uint64_t KeySwitchHoistedWorkspaceSize(uint64_t n, uint64_t rns_modulus_size,
+                                       uint64_t key_component_count,
+                                       uint64_t num_keys,
+                                       const Executor* executor) {
+  return intel::hexl::internal::KeySwitchHoistedWorkspaceSize(
+      n, rns_modulus_size, key_component_count, num_keys, executor);
+}
 
 }  // namespace hexl
 }  // namespace intel
-#endif
@@ -0,0 +1,85 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/check.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Returns an anonymous mapping of at least num_words words, advised to be
+// backed by transparent huge pages, or nullptr if unavailable
+inline std::shared_ptr<uint64_t> AllocateHugePages(uint64_t num_words) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  const uint64_t huge_page_size = 1ULL << 21;
+  uint64_t bytes = num_words * sizeof(uint64_t);
+  bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+  void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    return nullptr;
+  }
+  // Without transparent huge pages, the mapping still works on regular pages
+  madvise(base, bytes, MADV_HUGEPAGE);
+  return std::shared_ptr<uint64_t>(static_cast<uint64_t*>(base),
+                                   [bytes](uint64_t* p) { munmap(p, bytes); });
+#else
+  HEXL_UNUSED(num_words);
+  return nullptr;
+#endif
+}
+
+PreparedKeySwitchKey::PreparedKeySwitchKey(const uint64_t** k_switch_keys,
+                                           uint64_t n, uint64_t num_digits,
+                                           uint64_t key_modulus_size,
+                                           uint64_t key_component_count,
+                                           bool use_huge_pages)
+    : m_n(n),
+      m_num_digits(num_digits),
+      m_key_modulus_size(key_modulus_size),
+      m_key_component_count(key_component_count),
+      m_tile_size(
+          internal::KeySwitchBatchTileSize(n, key_component_count)) {
+  HEXL_CHECK(k_switch_keys != nullptr, "Require k_switch_keys != nullptr");
+  HEXL_CHECK(IsPowerOfTwo(n), "Require n to be a power of two");
+  HEXL_CHECK(num_digits > 0, "Require num_digits > 0");
+  HEXL_CHECK(key_modulus_size > 0, "Require key_modulus_size > 0");
+  HEXL_CHECK(key_component_count > 0, "Require key_component_count > 0");
+
+  uint64_t num_words = StorageSize() / sizeof(uint64_t);
+  if (use_huge_pages) {
+    m_huge_pages = AllocateHugePages(num_words);
+  }
+  if (!UsesHugePages()) {
+    m_storage.resize(num_words);
+  }
+
+  // Destination is written sequentially; each tile reads one run of
+  // m_tile_size contiguous source coefficients
+  uint64_t* dest = Data();
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    for (size_t j = 0; j < num_digits; ++j) {
+      for (size_t tile = 0; tile < n; tile += m_tile_size) {
+        for (size_t k = 0; k < key_component_count; ++k) {
+          const uint64_t* src =
+              &k_switch_keys[j][(k * key_modulus_size + m) * n + tile];
+          std::copy(src, src + m_tile_size, dest);
+          dest += m_tile_size;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,85 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/experimental/seal/public-key-encrypt.hpp"
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/check.hpp"
+#include "hexl/util/pool-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Maps n signed coefficients, each of absolute value less than modulus, to
+// [0, modulus)
+inline void ExpandSmallPolynomial(uint64_t* result, const int64_t* operand,
+                                  uint64_t n, uint64_t modulus) {
+  for (size_t j = 0; j < n; ++j) {
+    int64_t x = operand[j];
+    result[j] = static_cast<uint64_t>(x) + ((x < 0) ? modulus : 0);
+  }
+}
+
+// Each worker uses one limb for the transformed u, followed by the scratch
+// memory of PlainMultiplyAccumulateLimb
+uint64_t PublicKeyEncryptWorkspaceSize(uint64_t n, const Executor* executor) {
+  return NumWorkers(executor) *
+         (n + internal::DyadicMultiplyWorkspaceSize(n));
+}
+
+void PublicKeyEncrypt(uint64_t* result, const uint64_t* public_key,
+                      const int64_t* u, const int64_t* e0, const int64_t* e1,
+                      const uint64_t* plain, uint64_t n,
+                      const uint64_t* moduli, uint64_t num_moduli,
+                      const std::vector<NTT>& ntts, Executor* executor,
+                      uint64_t* workspace) {
+  HEXL_CHECK(result != nullptr, "Require result != nullptr");
+  HEXL_CHECK(public_key != nullptr, "Require public_key != nullptr");
+  HEXL_CHECK(u != nullptr, "Require u != nullptr");
+  HEXL_CHECK(e0 != nullptr, "Require e0 != nullptr");
+  HEXL_CHECK(e1 != nullptr, "Require e1 != nullptr");
+  HEXL_CHECK(moduli != nullptr, "Require moduli != nullptr");
+  HEXL_CHECK(n != 0, "Require n != 0");
+  HEXL_CHECK(ntts.size() >= num_moduli, "Require ntts.size() >= num_moduli");
+
+  size_t poly_size = n * num_moduli;
+
+  AlignedVector64<uint64_t> owned_workspace = MakePooledVector<uint64_t>();
+  if (workspace == nullptr) {
+    owned_workspace.resize(PublicKeyEncryptWorkspaceSize(n, executor));
+    workspace = owned_workspace.data();
+  }
+  size_t worker_size = n + internal::DyadicMultiplyWorkspaceSize(n);
+
+  ParallelFor(executor, num_moduli, [&](size_t i, size_t worker) {
+    size_t i_times_n = i * n;
+    uint64_t modulus = moduli[i];
+    const NTT& ntt = ntts[i];
+    HEXL_CHECK(ntt.GetModulus() == modulus && ntt.GetDegree() == n,
+               "NTT " << i << " does not match modulus " << modulus);
+
+    uint64_t* u_ntt = workspace + worker * worker_size;
+    uint64_t* result0 = result + i_times_n;
+    uint64_t* result1 = result0 + poly_size;
+
+    ExpandSmallPolynomial(u_ntt, u, n, modulus);
+    ntt.ComputeForward(u_ntt, u_ntt, 1, 1);
+    ExpandSmallPolynomial(result0, e0, n, modulus);
+    ntt.ComputeForward(result0, result0, 1, 1);
+    ExpandSmallPolynomial(result1, e1, n, modulus);
+    ntt.ComputeForward(result1, result1, 1, 1);
+    if (plain != nullptr) {
+      EltwiseAddMod(result0, result0, plain + i_times_n, n, modulus);
+    }
+
+    // result += u * pk for both polynomials, in one pass
+    internal::PlainMultiplyAccumulateLimb(result0, u_ntt, nullptr,
+                                          public_key + i_times_n, n,
+                                          poly_size, modulus, u_ntt + n);
+  });
+}
+
+}  // namespace hexl
+}  // namespace intel
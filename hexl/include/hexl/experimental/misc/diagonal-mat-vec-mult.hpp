@@ -0,0 +1,60 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+
+#include "hexl/experimental/misc/executor.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Computes the inner sums of the baby-step giant-step diagonal method
+/// for the product of a plaintext matrix and an encrypted vector
+/// @details With b = baby_steps and g = giant_steps, the product of a matrix
+/// with diagonals diag[0], ..., diag[b * g - 1] and the vector encrypted in ct
+/// is the sum over j in [0, g) of rot[j * b](inner[j]), where
+/// inner[j] = sum over i in [0, b) of rot[-j * b](diag[j * b + i]) * rot[i](ct)
+/// and rot[k] rotates the slots by k. This computes the g inner sums with one
+/// pass over the diagonals; the caller rotates inner[j] for j > 0 and adds
+/// the results to inner[0]. The baby-step rotations of ct may share one key
+/// switching decomposition, as with KeySwitchDecompose and KeySwitchHoisted.
+/// All data is in NTT form.
+/// @param[out] result Stores the g inner sums, one ciphertext after another.
+/// Has (giant_steps * 2 * n * num_moduli) elements. Must not overlap the
+/// operands
+/// @param[in] diagonals Plaintext diagonals rot[-j * b](diag[j * b + i]), in
+/// the order of j * b + i. Has (giant_steps * baby_steps * n * num_moduli)
+/// elements
+/// @param[in] rotated_ciphers Baby-step rotations rot[i](ct), one ciphertext
+/// after another. Has (baby_steps * 2 * n * num_moduli) elements
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] baby_steps Number of baby-step rotations b
+/// @param[in] giant_steps Number of giant steps g
+/// @param[in] executor Executor on which to run tasks, one per giant step and
+/// modulus. If nullptr, runs on the calling thread
+/// @param[in] workspace Scratch memory with at least
+/// DiagonalMatrixVectorMultiplyWorkspaceSize(n) elements for the same \p
+/// executor. Need not be initialized. If nullptr, scratch memory is allocated
+/// internally
+void DiagonalMatrixVectorMultiply(uint64_t* result, const uint64_t* diagonals,
+                                  const uint64_t* rotated_ciphers, uint64_t n,
+                                  const uint64_t* moduli, uint64_t num_moduli,
+                                  uint64_t baby_steps, uint64_t giant_steps,
+                                  Executor* executor = nullptr,
+                                  uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// DiagonalMatrixVectorMultiply
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] executor Executor on which DiagonalMatrixVectorMultiply runs.
+/// The workspace grows with the number of workers
+uint64_t DiagonalMatrixVectorMultiplyWorkspaceSize(
+    uint64_t n, const Executor* executor = nullptr);
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,139 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace intel {
+namespace hexl {
+
+/// @brief Base class for running independent tasks concurrently
+/// @details Implementations may run tasks in any order and on any worker;
+/// kernels using an Executor only write task-disjoint outputs, so results are
+/// independent of the scheduling.
+struct Executor {
+  virtual ~Executor() noexcept {}
+
+  /// @brief Returns the maximum number of workers running tasks concurrently
+  virtual size_t NumWorkers() const = 0;
+
+  /// @brief Runs \p task(i, worker) for each i in [0, \p num_tasks), returning
+  /// once all tasks have completed
+  /// @param[in] num_tasks Number of tasks to run
+  /// @param[in] task Callable taking the task index and the index of the
+  /// worker running it, in [0, NumWorkers()). Tasks run by the same worker
+  /// never overlap, so the worker index may be used to select scratch memory.
+  virtual void ParallelFor(
+      size_t num_tasks,
+      const std::function<void(size_t task, size_t worker)>& task) = 0;
+};
+
+class ThreadPoolExecutor;
+
+/// @brief Executor which splits tasks into contiguous chunks, each run by its
+/// own worker thread
+/// @details The worker threads are started by the first ParallelFor call with
+/// more than one chunk, and are reused by later calls until the executor is
+/// destroyed, so construct the executor once and pass it to each KeySwitch
+/// call. ParallelFor may be called from several threads; the calls run one at
+/// a time. ParallelFor calls from within a task run inline, as for
+/// ThreadPoolExecutor
+class ThreadExecutor : public Executor {
+ public:
+  /// @brief Initializes an executor with \p num_threads workers
+  /// @param[in] num_threads Number of workers, including the calling thread.
+  /// If 0, uses std::thread::hardware_concurrency()
+  explicit ThreadExecutor(size_t num_threads = 0);
+
+  ~ThreadExecutor() noexcept override;
+
+  ThreadExecutor(const ThreadExecutor&) = delete;
+  ThreadExecutor& operator=(const ThreadExecutor&) = delete;
+
+  size_t NumWorkers() const override { return m_num_threads; }
+
+  void ParallelFor(
+      size_t num_tasks,
+      const std::function<void(size_t task, size_t worker)>& task) override;
+
+ private:
+  size_t m_num_threads;
+  std::once_flag m_pool_started;
+  std::unique_ptr<ThreadPoolExecutor> m_pool;
+};
+
+/// @brief Executor with persistent worker threads
+/// @details Splits tasks into contiguous chunks as ThreadExecutor does, but
+/// the threads are started in the constructor, rather than by the first
+/// ParallelFor call. ParallelFor may be called from several threads; the calls
+/// run one at a time. ParallelFor calls made from within a task, on this or
+/// any other ThreadPoolExecutor, run all their tasks inline on the calling
+/// worker with worker index 0
+class ThreadPoolExecutor : public Executor {
+ public:
+  /// @brief Starts a pool with \p num_threads workers
+  /// @param[in] num_threads Number of workers, including the thread calling
+  /// ParallelFor, so (num_threads - 1) threads are started. If 0, uses
+  /// std::thread::hardware_concurrency()
+  explicit ThreadPoolExecutor(size_t num_threads = 0);
+
+  /// @brief Stops and joins the worker threads
+  ~ThreadPoolExecutor() noexcept override;
+
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+  size_t NumWorkers() const override { return m_num_threads; }
+
+  void ParallelFor(
+      size_t num_tasks,
+      const std::function<void(size_t task, size_t worker)>& task) override;
+
+ private:
+  void RunChunk(size_t worker);
+  void WorkerLoop(size_t worker);
+
+  size_t m_num_threads;
+  std::vector<std::thread> m_threads;
+
+  // Serializes ParallelFor calls
+  std::mutex m_call_mutex;
+
+  // Guards the state of the current ParallelFor call below
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_done;
+  bool m_stop = false;
+  uint64_t m_generation = 0;
+  size_t m_pending = 0;
+
+  const std::function<void(size_t task, size_t worker)>* m_task = nullptr;
+  size_t m_num_tasks = 0;
+  size_t m_num_workers = 0;
+  std::vector<std::exception_ptr> m_errors;
+};
+
+/// @brief Runs \p task(i, worker) for each i in [0, \p num_tasks) on \p
+/// executor. If \p executor is nullptr, runs the tasks in order on the
+/// calling thread with worker index 0.
+void ParallelFor(Executor* executor, size_t num_tasks,
+                 const std::function<void(size_t task, size_t worker)>& task);
+
+/// @brief Returns the number of workers of \p executor, or 1 if \p executor
+/// is nullptr
+inline size_t NumWorkers(const Executor* executor) {
+  return (executor == nullptr) ? 1 : executor->NumWorkers();
+}
+
+}  // namespace hexl
+}  // namespace intel
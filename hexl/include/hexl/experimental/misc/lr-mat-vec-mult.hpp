@@ -5,6 +5,8 @@
 
 #include <cstdint>
 
+#include "hexl/experimental/misc/executor.hpp"
+
 namespace intel {
 namespace hexl {
 
@@ -27,5 +29,62 @@ void LinRegMatrixVectorMultiply(uint64_t* result, const uint64_t* operand1,
                                 const uint64_t* moduli, uint64_t num_moduli,
                                 uint64_t num_weights);
 
+/// @brief Computes transposed linear regression using caller-provided scratch
+/// memory, optionally on several threads
+/// @details Parameters are as in LinRegMatrixVectorMultiply above. The row
+/// products are split into one task per row and modulus, and each level of
+/// the adder tree into one task per output limb, so the output is the same
+/// for any executor.
+/// @param[in] workspace Scratch memory with at least
+/// LinRegMatrixVectorMultiplyWorkspaceSize(n) elements for the same \p
+/// executor, preferably 64-byte aligned. Need not be initialized. If nullptr,
+/// scratch memory is allocated internally
+/// @param[in] executor Executor on which to run tasks. If nullptr, runs on the
+/// calling thread
+void LinRegMatrixVectorMultiply(uint64_t* result, const uint64_t* operand1,
+                                const uint64_t* operand2, uint64_t n,
+                                const uint64_t* moduli, uint64_t num_moduli,
+                                uint64_t num_weights, uint64_t* workspace,
+                                Executor* executor = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// LinRegMatrixVectorMultiply
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] executor Executor on which LinRegMatrixVectorMultiply runs. The
+/// workspace grows with the number of workers
+uint64_t LinRegMatrixVectorMultiplyWorkspaceSize(
+    uint64_t n, const Executor* executor = nullptr);
+
+/// @brief Computes transposed linear regression, accumulating the products of
+/// each row on the fly
+/// @param[out] result Ciphertext data. Will be over-written with result. Has
+/// (3 * n * num_moduli) elements. Must not overlap the operands
+/// @param[in] operand1 As in LinRegMatrixVectorMultiply
+/// @param[in] operand2 As in LinRegMatrixVectorMultiply
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] num_weights Feature size of the linear/logistic regression model
+/// @param[in] workspace Scratch memory with at least
+/// LinRegMatrixVectorMultiplyAccumulateWorkspaceSize(n) elements. If nullptr,
+/// scratch memory is allocated internally when needed
+/// @details Computes the same sum as the first output ciphertext of
+/// LinRegMatrixVectorMultiply, but without storing the product of each row.
+/// The output is one ciphertext rather than num_weights ciphertexts, and the
+/// operands are read in a single pass.
+void LinRegMatrixVectorMultiplyAccumulate(uint64_t* result,
+                                          const uint64_t* operand1,
+                                          const uint64_t* operand2, uint64_t n,
+                                          const uint64_t* moduli,
+                                          uint64_t num_moduli,
+                                          uint64_t num_weights,
+                                          uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// LinRegMatrixVectorMultiplyAccumulate
+/// @param[in] n Number of coefficients in each polynomial
+uint64_t LinRegMatrixVectorMultiplyAccumulateWorkspaceSize(uint64_t n);
+
 }  // namespace hexl
 }  // namespace intel
@@ -0,0 +1,203 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/util/aligned-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Arguments of an asynchronous DyadicMultiply
+/// @details Fields are as the parameters of DyadicMultiply. The memory
+/// pointed to must remain valid until the command completes
+struct DyadicMultiplyCommand {
+  uint64_t* result = nullptr;
+  const uint64_t* operand1 = nullptr;
+  const uint64_t* operand2 = nullptr;
+  uint64_t n = 0;
+  const uint64_t* moduli = nullptr;
+  uint64_t num_moduli = 0;
+};
+
+/// @brief Arguments of an asynchronous KeySwitch
+/// @details Fields are as the parameters of KeySwitch. The memory pointed to
+/// must remain valid until the command completes
+struct KeySwitchCommand {
+  uint64_t* result = nullptr;
+  const uint64_t* t_target_iter_ptr = nullptr;
+  uint64_t n = 0;
+  uint64_t decomp_modulus_size = 0;
+  uint64_t key_modulus_size = 0;
+  uint64_t rns_modulus_size = 0;
+  uint64_t key_component_count = 0;
+  const uint64_t* moduli = nullptr;
+  const uint64_t** k_switch_keys = nullptr;
+  const uint64_t* modswitch_factors = nullptr;
+  /// Root of unity powers, as in KeySwitch. Used when ntts is nullptr
+  const uint64_t* root_of_unity_powers_ptr = nullptr;
+  /// NTT objects for each of the key_modulus_size moduli, or nullptr. Backends
+  /// may use them instead of constructing the NTTs for each command
+  std::vector<NTT>* ntts = nullptr;
+};
+
+/// @brief Kind of operation of a Command
+enum class CommandType { kDyadicMultiply, kKeySwitch };
+
+/// @brief One operation submitted to a CommandQueue
+/// @details Only the arguments matching \p type are used
+struct Command {
+  Command() = default;
+
+  /// @brief Initializes a DyadicMultiply command
+  Command(const DyadicMultiplyCommand& command)  // NOLINT(runtime/explicit)
+      : type(CommandType::kDyadicMultiply), dyadic_multiply(command) {}
+
+  /// @brief Initializes a KeySwitch command
+  Command(const KeySwitchCommand& command)  // NOLINT(runtime/explicit)
+      : type(CommandType::kKeySwitch), key_switch(command) {}
+
+  CommandType type = CommandType::kDyadicMultiply;
+  DyadicMultiplyCommand dyadic_multiply;
+  KeySwitchCommand key_switch;
+};
+
+/// @brief Callback run once a submission completes
+/// @details Takes nullptr on success, or the exception thrown by the first
+/// failing command. Runs on a thread of the backend, so it should return
+/// quickly and must not wait for other submissions
+using CommandCallback = std::function<void(std::exception_ptr error)>;
+
+/// @brief Base class for backends running the commands of a CommandQueue
+/// @details A backend may run on the CPU, as CpuCommandQueueBackend does, or
+/// offload the commands to an accelerator. Submissions complete in the order
+/// they are submitted.
+struct CommandQueueBackend {
+  virtual ~CommandQueueBackend() noexcept {}
+
+  /// @brief Enqueues \p commands and returns, possibly before they run
+  /// @param[in] commands Independent commands: no command reads or writes
+  /// memory written by another command of the same submission, so they may
+  /// run in any order or concurrently. Commands of earlier submissions have
+  /// completed before any command of this submission starts
+  /// @param[in] on_complete Called exactly once, after all \p commands have
+  /// completed or one of them has failed. Commands after a failing command
+  /// may be skipped. Not called if Submit throws
+  virtual void Submit(std::vector<Command> commands,
+                      CommandCallback on_complete) = 0;
+};
+
+/// @brief Runs commands on a ThreadPoolExecutor, from a dispatch thread
+/// @details The dispatch thread takes one submission at a time and runs it on
+/// the pool, using it as worker 0. Runs of consecutive DyadicMultiply commands
+/// with the same n and moduli are computed by one DyadicMultiplyBatch, and
+/// runs of consecutive KeySwitch commands with the same keys, moduli and NTTs
+/// by one KeySwitchBatch. Scratch memory is kept across submissions.
+class CpuCommandQueueBackend : public CommandQueueBackend {
+ public:
+  /// @brief Starts the dispatch thread and a pool with \p num_threads workers
+  /// @param[in] num_threads Number of workers, including the dispatch thread.
+  /// If 0, uses std::thread::hardware_concurrency()
+  explicit CpuCommandQueueBackend(size_t num_threads = 0);
+
+  /// @brief Completes all submitted commands, then stops the threads
+  ~CpuCommandQueueBackend() noexcept override;
+
+  CpuCommandQueueBackend(const CpuCommandQueueBackend&) = delete;
+  CpuCommandQueueBackend& operator=(const CpuCommandQueueBackend&) = delete;
+
+  void Submit(std::vector<Command> commands,
+              CommandCallback on_complete) override;
+
+ private:
+  struct Submission {
+    std::vector<Command> commands;
+    CommandCallback on_complete;
+  };
+
+  void DispatchLoop();
+  void Run(const std::vector<Command>& commands);
+
+  ThreadPoolExecutor m_executor;
+  AlignedVector64<uint64_t> m_workspace;
+
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  std::deque<Submission> m_submissions;
+  bool m_stop = false;
+  std::thread m_dispatcher;
+};
+
+/// @brief Asynchronous interface to DyadicMultiply and KeySwitch
+/// @details Each Submit call returns once the commands are enqueued. The
+/// returned future becomes ready, and the callback runs, when they complete.
+/// Submissions complete in order, so a command may use the result of any
+/// command of an earlier submission. Submit may be called from several
+/// threads.
+class CommandQueue {
+ public:
+  /// @brief Initializes a queue running on a CpuCommandQueueBackend with
+  /// std::thread::hardware_concurrency() workers
+  CommandQueue();
+
+  /// @brief Initializes a queue running on \p backend
+  /// @param[in] backend Backend on which to run commands. May be shared by
+  /// several queues
+  explicit CommandQueue(std::shared_ptr<CommandQueueBackend> backend);
+
+  /// @brief Waits for all submitted commands to complete
+  ~CommandQueue() noexcept;
+
+  CommandQueue(const CommandQueue&) = delete;
+  CommandQueue& operator=(const CommandQueue&) = delete;
+
+  /// @brief Submits one DyadicMultiply
+  /// @param[in] command Arguments of the DyadicMultiply
+  /// @param[in] callback Called on completion, or nullptr
+  /// @return Future which is ready once the command completes, and rethrows
+  /// any exception thrown by the command
+  std::future<void> Submit(const DyadicMultiplyCommand& command,
+                           CommandCallback callback = nullptr);
+
+  /// @brief Submits one KeySwitch
+  /// @details Parameters are as in Submit for DyadicMultiply
+  std::future<void> Submit(const KeySwitchCommand& command,
+                           CommandCallback callback = nullptr);
+
+  /// @brief Submits a batch of independent commands, completing together
+  /// @details Batching lets the backend share work across the commands, such
+  /// as the reads of common keys. Other parameters are as in Submit for
+  /// DyadicMultiply. Rethrows any exception thrown by the Submit of the
+  /// backend, in which case the commands are not submitted
+  /// @param[in] commands Commands which neither read nor write memory written
+  /// by another command of the batch
+  std::future<void> SubmitBatch(std::vector<Command> commands,
+                                CommandCallback callback = nullptr);
+
+  /// @brief Blocks until all commands submitted to this queue complete
+  void Wait();
+
+ private:
+  std::shared_ptr<CommandQueueBackend> m_backend;
+
+  std::mutex m_mutex;
+  std::condition_variable m_idle;
+  size_t m_num_pending = 0;
+};
+
+}  // namespace hexl
+}  // namespace intel
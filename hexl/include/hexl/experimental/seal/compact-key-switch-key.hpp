@@ -0,0 +1,145 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hexl/util/aligned-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Key switching keys stored compactly, for use with KeySwitch
+/// @details Stores num_digits keys of key_component_count components each,
+/// with one limb of n residues per key modulus, as KeySwitch expects. Each
+/// limb modulo q is bit-packed to ceil(log2(q)) bits per residue. If the key is
+/// seeded, the last component (the uniform "a" component) is not stored, but
+/// expanded from a 256-bit seed when needed. Limbs are stored modulus-major,
+/// then digit, then component, which is the order in which the KeySwitch
+/// inner product reads them. The packed limbs may be written to a file and
+/// memory-mapped read-only.
+class CompactKeySwitchKey {
+ public:
+  /// @brief Number of 64-bit words in a seed
+  static constexpr uint64_t kSeedSize = 4;
+
+  /// @brief Initializes an empty CompactKeySwitchKey object
+  CompactKeySwitchKey() = default;
+
+  /// @brief Initializes a CompactKeySwitchKey object with all limbs zero
+  /// @param[in] n Number of coefficients in each polynomial
+  /// @param[in] moduli The key moduli, i.e. the ciphertext moduli at the top
+  /// level followed by the special modulus
+  /// @param[in] num_digits Number of keys, one per decomposition modulus
+  /// @param[in] key_component_count Number of components in each key
+  /// @param[in] seed Array of kSeedSize words from which the last component is
+  /// expanded. If nullptr, all components are stored
+  CompactKeySwitchKey(uint64_t n, const std::vector<uint64_t>& moduli,
+                      uint64_t num_digits, uint64_t key_component_count,
+                      const uint64_t* seed = nullptr);
+
+  /// @brief Stores a limb of the key
+  /// @param[in] digit Index of the key, in [0, NumDigits())
+  /// @param[in] component Index of the key component. Must not be the seeded
+  /// component
+  /// @param[in] modulus_index Index of the modulus in GetModuli()
+  /// @param[in] values The n residues of the limb, in NTT form, each less than
+  /// the modulus
+  void SetLimb(uint64_t digit, uint64_t component, uint64_t modulus_index,
+               const uint64_t* values);
+
+  /// @brief Stores all limbs from keys in the layout taken by KeySwitch
+  /// @param[in] k_switch_keys Array of NumDigits() keys, each with
+  /// (KeyComponentCount() * GetModuli().size() * n) elements. For a seeded
+  /// key, the last component is ignored
+  void SetKeys(const uint64_t** k_switch_keys);
+
+  /// @brief Retrieves a limb of the key, unpacking or expanding it
+  /// @param[out] result Stores the n residues of the limb
+  /// @param[in] digit Index of the key, in [0, NumDigits())
+  /// @param[in] component Index of the key component
+  /// @param[in] modulus_index Index of the modulus in GetModuli()
+  void GetLimb(uint64_t* result, uint64_t digit, uint64_t component,
+               uint64_t modulus_index) const;
+
+  /// @brief Writes the key to a file, in native byte order
+  /// @param[in] path Path of the file to write
+  void Save(const std::string& path) const;
+
+  /// @brief Returns a key backed by a read-only memory mapping of a file
+  /// written by Save. The file must not be modified while mapped
+  /// @details Throws std::runtime_error if the file cannot be mapped, or if
+  /// its header is invalid or describes more data than the file holds
+  /// @param[in] path Path of the file to map
+  static CompactKeySwitchKey Map(const std::string& path);
+
+  /// @brief Returns the degree N
+  uint64_t GetDegree() const { return m_n; }
+
+  /// @brief Returns the key moduli
+  const std::vector<uint64_t>& GetModuli() const { return m_moduli; }
+
+  /// @brief Returns the number of keys
+  uint64_t NumDigits() const { return m_num_digits; }
+
+  /// @brief Returns the number of components in each key
+  uint64_t KeyComponentCount() const { return m_key_component_count; }
+
+  /// @brief Returns whether the last component is expanded from a seed
+  bool IsSeeded() const { return m_seeded; }
+
+  /// @brief Returns whether the key is backed by a memory-mapped file
+  bool IsMapped() const { return m_mapping != nullptr; }
+
+  /// @brief Returns the number of bytes used to store the limbs
+  uint64_t StorageSize() const { return m_data_words * sizeof(uint64_t); }
+
+ private:
+  // Computes the packed layout from the parameters. Returns false if the
+  // layout size overflows 64 bits
+  bool InitializeLayout();
+
+  // Number of components stored explicitly
+  uint64_t StoredComponentCount() const {
+    return m_seeded ? m_key_component_count - 1 : m_key_component_count;
+  }
+
+  // Offset, in words, of a stored limb
+  uint64_t LimbOffset(uint64_t digit, uint64_t component,
+                      uint64_t modulus_index) const {
+    return m_modulus_offsets[modulus_index] +
+           (digit * StoredComponentCount() + component) *
+               m_limb_words[modulus_index];
+  }
+
+  const uint64_t* Data() const {
+    return IsMapped() ? m_mapped_data : m_storage.data();
+  }
+
+  uint64_t m_n{0};
+  std::vector<uint64_t> m_moduli;
+  uint64_t m_num_digits{0};
+  uint64_t m_key_component_count{0};
+  bool m_seeded{false};
+  uint64_t m_seed[kSeedSize]{0, 0, 0, 0};
+
+  // Bits per residue, words per limb and offset of the first limb, per modulus
+  std::vector<uint64_t> m_bit_widths;
+  std::vector<uint64_t> m_limb_words;
+  std::vector<uint64_t> m_modulus_offsets;
+  uint64_t m_data_words{0};
+
+  // Packed limbs, either owned or in a read-only file mapping kept alive by
+  // m_mapping
+  AlignedVector64<uint64_t> m_storage;
+  std::shared_ptr<const void> m_mapping;
+  const uint64_t* m_mapped_data{nullptr};
+};
+
+}  // namespace hexl
+}  // namespace intel
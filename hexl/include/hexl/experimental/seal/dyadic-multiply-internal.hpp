@@ -5,6 +5,8 @@
 
 #include <cstdint>
 
+#include "hexl/experimental/misc/executor.hpp"
+
 namespace intel {
 namespace hexl {
 namespace internal {
@@ -20,9 +22,325 @@ namespace internal {
 /// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
 /// coefficient moduli
 /// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements. If nullptr, scratch memory is
+/// allocated internally
 void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
                     const uint64_t* operand2, uint64_t n,
-                    const uint64_t* moduli, uint64_t num_moduli);
+                    const uint64_t* moduli, uint64_t num_moduli,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Computes dyadic multiplication using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiply. Computes the middle
+/// polynomial as (x[0] + x[1]) * (y[0] + y[1]) - x[0] * y[0] - x[1] * y[1],
+/// using three products per coefficient rather than four, for each modulus
+/// less than 2^61. DyadicMultiply uses Karatsuba multiplication only where it
+/// is faster; the results are the same
+void DyadicMultiplyKaratsuba(uint64_t* result, const uint64_t* operand1,
+                             const uint64_t* operand2, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             uint64_t* workspace = nullptr);
+
+/// @brief Computes the sum of the dyadic products of a sequence of ciphertext
+/// pairs, reading each operand once
+/// @param[out] result Ciphertext data. Will be over-written with result. Has
+/// (3 * n * num_moduli) elements. Must not overlap the operands
+/// @param[in] operand1 First ciphertext of each pair, one after another. Has
+/// (num_pairs * 2 * n * num_moduli) elements
+/// @param[in] operand2 Second ciphertext of each pair, one after another. Has
+/// (num_pairs * 2 * n * num_moduli) elements
+/// @param[in] num_pairs Number of ciphertext pairs
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements. If nullptr, scratch memory is
+/// allocated internally
+/// @details Products are summed lazily per tile, with as few reductions as
+/// the modulus allows
+void DyadicMultiplyAccumulate(uint64_t* result, const uint64_t* operand1,
+                              const uint64_t* operand2, uint64_t num_pairs,
+                              uint64_t n, const uint64_t* moduli,
+                              uint64_t num_moduli,
+                              uint64_t* workspace = nullptr);
+
+/// @brief Adds the product of a plaintext and a ciphertext to a ciphertext
+/// @param[in,out] result Ciphertext data to accumulate into. Has
+/// (2 * n * num_moduli) elements. May alias \p cipher
+/// @param[in] plain Plaintext argument. Has (n * num_moduli) elements
+/// @param[in] cipher Ciphertext argument. Has (2 * n * num_moduli) elements
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] plain_shoup Shoup factors of \p plain, as computed by
+/// PlainMultiplyShoupFactors, or nullptr
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements. If nullptr, scratch memory is
+/// allocated internally
+void PlainMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                             const uint64_t* cipher, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             const uint64_t* plain_shoup = nullptr,
+                             uint64_t* workspace = nullptr);
+
+/// @brief Adds the product of one RNS limb of a plaintext and a ciphertext to
+/// a ciphertext
+/// @details Parameters are as in PlainMultiplyAccumulateNative, for any
+/// modulus
+/// @param[in] temp Scratch memory with at least DyadicMultiplyWorkspaceSize(n)
+/// elements, used for the moduli computed with element-wise multiplications
+void PlainMultiplyAccumulateLimb(uint64_t* result, const uint64_t* plain,
+                                 const uint64_t* plain_shoup,
+                                 const uint64_t* cipher, uint64_t n,
+                                 uint64_t poly_size, uint64_t modulus,
+                                 uint64_t* temp);
+
+/// @brief Computes the Shoup factors floor(plain * 2^64 / q) of a plaintext
+/// @param[out] plain_shoup Stores (n * num_moduli) factors
+/// @param[in] plain Plaintext. Has (n * num_moduli) elements
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+void PlainMultiplyShoupFactors(uint64_t* plain_shoup, const uint64_t* plain,
+                               uint64_t n, const uint64_t* moduli,
+                               uint64_t num_moduli);
+
+/// @brief Computes one RNS limb of the sum of the products of a sequence of
+/// plaintexts and ciphertexts, reading each operand once
+/// @details Parameters are as in DiagonalMultiplyAccumulateNative, for any
+/// modulus
+/// @param[in] temp Scratch memory with at least DyadicMultiplyWorkspaceSize(n)
+/// elements, used for moduli of at least 2^61
+void DiagonalMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                                const uint64_t* cipher, uint64_t num_terms,
+                                uint64_t plain_stride, uint64_t cipher_stride,
+                                uint64_t n, uint64_t poly_size,
+                                uint64_t modulus, uint64_t* temp);
+
+/// @brief Computes dyadic multiplication for a batch of ciphertext pairs
+/// @param[out] results Array of \p batch_size ciphertext data pointers, each
+/// as the result of DyadicMultiply
+/// @param[in] operand1s Array of \p batch_size first ciphertext arguments
+/// @param[in] operand2s Array of \p batch_size second ciphertext arguments
+/// @param[in] batch_size Number of ciphertext pairs
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] executor Runs the limbs of chunks of the batch concurrently. If
+/// nullptr, runs on the calling thread
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyBatchWorkspaceSize() elements for the same \p executor. If
+/// nullptr, scratch memory is allocated internally
+void DyadicMultiplyBatch(uint64_t** results, const uint64_t** operand1s,
+                         const uint64_t** operand2s, uint64_t batch_size,
+                         uint64_t n, const uint64_t* moduli,
+                         uint64_t num_moduli, Executor* executor = nullptr,
+                         uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// DyadicMultiplyBatch
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] executor Executor passed to DyadicMultiplyBatch
+uint64_t DyadicMultiplyBatchWorkspaceSize(uint64_t n,
+                                          const Executor* executor = nullptr);
+
+/// @brief Computes the dyadic tensor product of two ciphertexts of any size
+/// @param[out] result Ciphertext data. Will be over-written with result. Has
+/// ((operand1_size + operand2_size - 1) * n * num_moduli) elements. May alias
+/// \p operand1 or \p operand2
+/// @param[in] operand1 First ciphertext argument. Has
+/// (operand1_size * n * num_moduli) elements
+/// @param[in] operand1_size Number of polynomials in \p operand1
+/// @param[in] operand2 Second ciphertext argument. Has
+/// (operand2_size * n * num_moduli) elements
+/// @param[in] operand2_size Number of polynomials in \p operand2
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @details Output polynomial k is the sum of x[i] * y[j] over i + j = k
+void DyadicTensorProduct(uint64_t* result, const uint64_t* operand1,
+                         uint64_t operand1_size, const uint64_t* operand2,
+                         uint64_t operand2_size, uint64_t n,
+                         const uint64_t* moduli, uint64_t num_moduli);
+
+/// @brief Computes the dyadic tensor product of a ciphertext with itself
+/// @param[out] result Ciphertext data. Will be over-written with result. Has
+/// ((2 * operand_size - 1) * n * num_moduli) elements. May alias \p operand
+/// @param[in] operand Ciphertext argument. Has (operand_size * n * num_moduli)
+/// elements
+/// @param[in] operand_size Number of polynomials in \p operand
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @details Computes each product x[i] * x[j] with i != j once, so uses
+/// operand_size * (operand_size + 1) / 2 products per coefficient rather
+/// than operand_size^2
+void DyadicTensorSquare(uint64_t* result, const uint64_t* operand,
+                        uint64_t operand_size, uint64_t n,
+                        const uint64_t* moduli, uint64_t num_moduli);
+
+/// @brief Computes dyadic multiplication of one RNS limb in a single pass
+/// @param[out] result Stores the three output limbs, each (n) elements,
+/// starting at \p result, \p result + \p poly_size and \p result + 2 *
+/// \p poly_size. May alias \p operand1 or \p operand2
+/// @param[in] operand1 First ciphertext limbs, starting at \p operand1 and
+/// \p operand1 + \p poly_size. Each element must be less than \p modulus
+/// @param[in] operand2 Second ciphertext limbs, starting at \p operand2 and
+/// \p operand2 + \p poly_size. Each element must be less than \p modulus
+/// @param[in] n Number of coefficients in each limb
+/// @param[in] poly_size Distance between the limbs of consecutive polynomials
+/// @param[in] modulus Modulus with which to perform modular reduction. Must be
+/// less than 2^61
+/// @details Each coefficient of the middle limb is reduced once from the sum
+/// of both products
+void DyadicMultiplyFusedNative(uint64_t* result, const uint64_t* operand1,
+                               const uint64_t* operand2, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb in a single pass
+/// using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiplyFusedNative
+void DyadicMultiplyKaratsubaNative(uint64_t* result, const uint64_t* operand1,
+                                   const uint64_t* operand2, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb of each of a batch of
+/// ciphertext pairs in a single pass
+/// @param[out] results Array of \p batch_size pointers. The output limbs of
+/// pair b start at results[b] + offset, laid out as in
+/// DyadicMultiplyFusedNative
+/// @param[in] operand1s Array of \p batch_size pointers. The first operand
+/// limbs of pair b start at operand1s[b] + offset
+/// @param[in] operand2s Array of \p batch_size pointers. The second operand
+/// limbs of pair b start at operand2s[b] + offset
+/// @param[in] batch_size Number of ciphertext pairs
+/// @param[in] offset Offset of the limb from each pointer
+/// @details Other parameters are as in DyadicMultiplyFusedNative. The
+/// constants for \p modulus are set up once for the batch
+void DyadicMultiplyFusedNative(uint64_t* const* results,
+                               const uint64_t* const* operand1s,
+                               const uint64_t* const* operand2s,
+                               uint64_t batch_size, uint64_t offset,
+                               uint64_t n, uint64_t poly_size,
+                               uint64_t modulus);
+
+/// @brief Computes dyadic multiplication of one RNS limb of each of a batch of
+/// ciphertext pairs in a single pass using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiplyFusedNative for a batch
+void DyadicMultiplyKaratsubaNative(uint64_t* const* results,
+                                   const uint64_t* const* operand1s,
+                                   const uint64_t* const* operand2s,
+                                   uint64_t batch_size, uint64_t offset,
+                                   uint64_t n, uint64_t poly_size,
+                                   uint64_t modulus);
+
+/// @brief Computes the sum of the dyadic products of one RNS limb of a
+/// sequence of ciphertext pairs in a single pass
+/// @param[out] result Stores the three output limbs, each (n) elements,
+/// \p poly_size apart. Must not overlap the operands
+/// @param[in] operand1 First ciphertext limbs of the first pair, \p
+/// poly_size apart. The limbs of pair r start at operand1 + r * pair_stride.
+/// Each element must be less than \p modulus
+/// @param[in] operand2 Second ciphertext limbs, laid out as \p operand1
+/// @param[in] num_pairs Number of ciphertext pairs
+/// @param[in] pair_stride Distance between the limbs of consecutive pairs
+/// @param[in] n Number of coefficients in each limb
+/// @param[in] poly_size Distance between the limbs of consecutive polynomials
+/// @param[in] modulus Modulus with which to perform modular reduction. Must be
+/// less than 2^61
+void DyadicMultiplyAccumulateNative(uint64_t* result, const uint64_t* operand1,
+                                    const uint64_t* operand2,
+                                    uint64_t num_pairs, uint64_t pair_stride,
+                                    uint64_t n, uint64_t poly_size,
+                                    uint64_t modulus);
+
+/// @brief Adds the product of one RNS limb of a plaintext and a ciphertext to
+/// a ciphertext in a single pass
+/// @param[in,out] result Stores the two limbs to accumulate into, each (n)
+/// elements, \p poly_size apart. May alias \p cipher
+/// @param[in] plain Plaintext limb of (n) elements, each less than \p modulus
+/// @param[in] plain_shoup Shoup factors of \p plain, or nullptr
+/// @param[in] cipher Ciphertext limbs, \p poly_size apart. Each element must
+/// be less than \p modulus
+/// @param[in] n Number of coefficients in each limb
+/// @param[in] poly_size Distance between the limbs of consecutive polynomials
+/// @param[in] modulus Modulus with which to perform modular reduction. Must be
+/// less than 2^62 with Shoup factors, and less than 2^61 otherwise
+void PlainMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* plain_shoup,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes PlainMultiplyAccumulateNative without Shoup factors
+/// @details Parameters are as in PlainMultiplyAccumulateNative
+void PlainMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                   const uint64_t* cipher, uint64_t n,
+                                   uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the sum of the products of one RNS limb of a sequence of
+/// plaintexts and ciphertexts in a single pass
+/// @param[out] result Stores the two output limbs, each (n) elements, \p
+/// poly_size apart. Must not overlap the operands
+/// @param[in] plain Plaintext limb of the first term. The limb of term i
+/// starts at plain + i * plain_stride. Each element must be less than \p
+/// modulus
+/// @param[in] cipher Ciphertext limbs of the first term, \p poly_size apart.
+/// The limbs of term i start at cipher + i * cipher_stride. Each element must
+/// be less than \p modulus
+/// @param[in] num_terms Number of plaintext and ciphertext pairs
+/// @param[in] plain_stride Distance between the limbs of consecutive
+/// plaintexts
+/// @param[in] cipher_stride Distance between the limbs of consecutive
+/// ciphertexts
+/// @param[in] n Number of coefficients in each limb
+/// @param[in] poly_size Distance between the limbs of consecutive polynomials
+/// @param[in] modulus Modulus with which to perform modular reduction. Must be
+/// less than 2^61
+void DiagonalMultiplyAccumulateNative(uint64_t* result, const uint64_t* plain,
+                                      const uint64_t* cipher,
+                                      uint64_t num_terms,
+                                      uint64_t plain_stride,
+                                      uint64_t cipher_stride, uint64_t n,
+                                      uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the dyadic tensor product of one RNS limb in a single pass
+/// @param[out] result Stores the (operand1_size + operand2_size - 1) output
+/// limbs, each (n) elements, \p poly_size apart. May alias \p operand1 or
+/// \p operand2
+/// @param[in] operand1 First ciphertext limbs, \p poly_size apart. Each
+/// element must be less than \p modulus
+/// @param[in] operand1_size Number of limbs in \p operand1
+/// @param[in] operand2 Second ciphertext limbs, \p poly_size apart. Each
+/// element must be less than \p modulus
+/// @param[in] operand2_size Number of limbs in \p operand2
+/// @param[in] n Number of coefficients in each limb
+/// @param[in] poly_size Distance between the limbs of consecutive polynomials
+/// @param[in] modulus Modulus with which to perform modular reduction. Must be
+/// less than 2^61
+/// @details Products are summed lazily, with as few reductions as the
+/// modulus allows
+void DyadicTensorProductNative(uint64_t* result, const uint64_t* operand1,
+                               uint64_t operand1_size, const uint64_t* operand2,
+                               uint64_t operand2_size, uint64_t n,
+                               uint64_t poly_size, uint64_t modulus);
+
+/// @brief Computes the dyadic tensor square of one RNS limb in a single pass
+/// @details Parameters are as in DyadicTensorProductNative, with \p operand
+/// as both arguments
+void DyadicTensorSquareNative(uint64_t* result, const uint64_t* operand,
+                              uint64_t operand_size, uint64_t n,
+                              uint64_t poly_size, uint64_t modulus);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// DyadicMultiply
+/// @param[in] n Number of coefficients in each polynomial
+uint64_t DyadicMultiplyWorkspaceSize(uint64_t n);
 
 }  // namespace internal
 }  // namespace hexl
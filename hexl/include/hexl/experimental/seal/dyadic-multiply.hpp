@@ -5,6 +5,8 @@
 
 #include <cstdint>
 
+#include "hexl/experimental/misc/executor.hpp"
+
 namespace intel {
 namespace hexl {
 
@@ -23,5 +25,141 @@ void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
                     const uint64_t* operand2, uint64_t n,
                     const uint64_t* moduli, uint64_t num_moduli);
 
+/// @brief Computes dyadic multiplication using caller-provided scratch memory
+/// @details Parameters are as in DyadicMultiply above
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements, preferably 64-byte aligned. Need
+/// not be initialized
+void DyadicMultiply(uint64_t* result, const uint64_t* operand1,
+                    const uint64_t* operand2, uint64_t n,
+                    const uint64_t* moduli, uint64_t num_moduli,
+                    uint64_t* workspace);
+
+/// @brief Computes dyadic multiplication using Karatsuba multiplication
+/// @details Parameters are as in DyadicMultiply above. Computes the middle
+/// polynomial as (x[0] + x[1]) * (y[0] + y[1]) - x[0] * y[0] - x[1] * y[1],
+/// using three products per coefficient rather than four, for each modulus
+/// less than 2^61. DyadicMultiply uses Karatsuba multiplication only where it
+/// is faster; the results are the same
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements, or nullptr to allocate scratch
+/// memory internally
+void DyadicMultiplyKaratsuba(uint64_t* result, const uint64_t* operand1,
+                             const uint64_t* operand2, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             uint64_t* workspace = nullptr);
+
+/// @brief Computes dyadic multiplication for a batch of ciphertext pairs
+/// @details Each result is identical to DyadicMultiply on the same pair. The
+/// dispatch and the constants of each modulus are set up once per chunk of the
+/// batch rather than once per pair, and the chunks are run on \p executor.
+/// Other parameters are as in DyadicMultiply
+/// @param[in,out] results Array of \p batch_size ciphertext data pointers,
+/// each with (3 * n * num_moduli) elements. results[b] may alias
+/// operand1s[b] or operand2s[b]
+/// @param[in] operand1s Array of \p batch_size first ciphertext arguments,
+/// each with (2 * n * num_moduli) elements
+/// @param[in] operand2s Array of \p batch_size second ciphertext arguments,
+/// each with (2 * n * num_moduli) elements
+/// @param[in] batch_size Number of ciphertext pairs
+/// @param[in] executor Runs chunks of the batch concurrently. If nullptr, runs
+/// on the calling thread
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyBatchWorkspaceSize() elements for the same \p executor. Need
+/// not be initialized. If nullptr, scratch memory is allocated internally
+void DyadicMultiplyBatch(uint64_t** results, const uint64_t** operand1s,
+                         const uint64_t** operand2s, uint64_t batch_size,
+                         uint64_t n, const uint64_t* moduli,
+                         uint64_t num_moduli, Executor* executor = nullptr,
+                         uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// DyadicMultiplyBatch
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] executor Executor passed to DyadicMultiplyBatch
+uint64_t DyadicMultiplyBatchWorkspaceSize(uint64_t n,
+                                          const Executor* executor = nullptr);
+
+/// @brief Computes the dyadic tensor product of two ciphertexts of any size
+/// @param[in,out] result Ciphertext data. Will be over-written with result.
+/// Has ((operand1_size + operand2_size - 1) * n * num_moduli) elements. May
+/// alias \p operand1 or \p operand2
+/// @param[in] operand1 First ciphertext argument. Has
+/// (operand1_size * n * num_moduli) elements
+/// @param[in] operand1_size Number of polynomials in \p operand1
+/// @param[in] operand2 Second ciphertext argument. Has
+/// (operand2_size * n * num_moduli) elements
+/// @param[in] operand2_size Number of polynomials in \p operand2
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @details Output polynomial k is the sum of x[i] * y[j] over i + j = k. For
+/// two 2-polynomial ciphertexts, the result is that of DyadicMultiply
+void DyadicTensorProduct(uint64_t* result, const uint64_t* operand1,
+                         uint64_t operand1_size, const uint64_t* operand2,
+                         uint64_t operand2_size, uint64_t n,
+                         const uint64_t* moduli, uint64_t num_moduli);
+
+/// @brief Computes the dyadic tensor product of a ciphertext with itself
+/// @param[in,out] result Ciphertext data. Will be over-written with result.
+/// Has ((2 * operand_size - 1) * n * num_moduli) elements. May alias
+/// \p operand
+/// @param[in] operand Ciphertext argument. Has (operand_size * n * num_moduli)
+/// elements
+/// @param[in] operand_size Number of polynomials in \p operand
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @details Same result as DyadicTensorProduct(result, operand, operand_size,
+/// operand, operand_size, ...), but computes each product x[i] * x[j] with
+/// i != j only once
+void DyadicTensorSquare(uint64_t* result, const uint64_t* operand,
+                        uint64_t operand_size, uint64_t n,
+                        const uint64_t* moduli, uint64_t num_moduli);
+
+/// @brief Adds the product of a plaintext and a ciphertext to a ciphertext
+/// @param[in,out] result Ciphertext data to accumulate into. Has
+/// (2 * n * num_moduli) elements. May alias \p cipher
+/// @param[in] plain Plaintext argument in NTT form. Has (n * num_moduli)
+/// elements
+/// @param[in] cipher Ciphertext argument. Has (2 * n * num_moduli) elements
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] plain_shoup Shoup factors of \p plain, as computed by
+/// PlainMultiplyShoupFactors, or nullptr. With the factors, each product is
+/// reduced with one high and two low multiplications
+/// @param[in] workspace Scratch memory with at least
+/// DyadicMultiplyWorkspaceSize(n) elements. If nullptr, scratch memory is
+/// allocated internally
+/// @details Computes result[k] += plain * cipher[k] for both polynomials in
+/// one pass over each limb, replacing a multiplication and an addition per
+/// polynomial and limb
+void PlainMultiplyAccumulate(uint64_t* result, const uint64_t* plain,
+                             const uint64_t* cipher, uint64_t n,
+                             const uint64_t* moduli, uint64_t num_moduli,
+                             const uint64_t* plain_shoup = nullptr,
+                             uint64_t* workspace = nullptr);
+
+/// @brief Computes the Shoup factors floor(plain * 2^64 / q) of a plaintext,
+/// for a plaintext multiplied into many ciphertexts
+/// @param[out] plain_shoup Stores (n * num_moduli) factors
+/// @param[in] plain Plaintext. Has (n * num_moduli) elements
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+void PlainMultiplyShoupFactors(uint64_t* plain_shoup, const uint64_t* plain,
+                               uint64_t n, const uint64_t* moduli,
+                               uint64_t num_moduli);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// DyadicMultiply
+/// @param[in] n Number of coefficients in each polynomial
+uint64_t DyadicMultiplyWorkspaceSize(uint64_t n);
+
 }  // namespace hexl
 }  // namespace intel
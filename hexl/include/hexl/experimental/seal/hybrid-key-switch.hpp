@@ -0,0 +1,154 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/ntt/ntt.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Homomorphic encryption scheme of the ciphertexts to key switch
+/// @details CKKS and BGV ciphertexts are in NTT form, BFV ciphertexts are in
+/// coefficient form. BGV additionally keeps the key switching noise a multiple
+/// of the plaintext modulus.
+enum class KeySwitchScheme { CKKS, BFV, BGV };
+
+/// @brief Performs hybrid key switching with a configurable number of
+/// decomposition digits and special primes
+/// @details The ciphertext moduli q_0, ..., q_{L-1} are split into dnum
+/// digits of DigitSize() consecutive moduli each. Key switching a polynomial
+/// d at level l (i.e. with moduli q_0, ..., q_{l-1}) computes
+///   1. ModUp: each digit of d is extended to the basis {q_0, ..., q_{l-1},
+///   p_0, ..., p_{K-1}} using fast base conversion,
+///   2. the inner product of the extended digits with the key switching key,
+///   3. ModDown: the product is divided by P = p_0 * ... * p_{K-1} and
+///   rounded, returning to the basis {q_0, ..., q_{l-1}}.
+/// With dnum == L and a single special prime, this is the key switching
+/// performed by KeySwitch.
+class HybridKeySwitch {
+ public:
+  /// @brief Initializes an empty HybridKeySwitch object
+  HybridKeySwitch() = default;
+
+  /// @brief Initializes a HybridKeySwitch object
+  /// @param[in] n Number of coefficients in each polynomial. Must be a power
+  /// of two
+  /// @param[in] ciphertext_moduli The L ciphertext moduli at the top level.
+  /// Each must be an NTT-friendly prime less than 2^61
+  /// @param[in] special_moduli The K special moduli. Each must be an
+  /// NTT-friendly prime less than 2^61, distinct from the ciphertext moduli
+  /// @param[in] dnum Number of decomposition digits at the top level. Must be
+  /// in [1, L]
+  /// @param[in] scheme Scheme of the ciphertexts to key switch
+  /// @param[in] plain_modulus Plaintext modulus. Only used for BGV, where it
+  /// must be co-prime to the special moduli
+  HybridKeySwitch(uint64_t n, const std::vector<uint64_t>& ciphertext_moduli,
+                  const std::vector<uint64_t>& special_moduli, uint64_t dnum,
+                  KeySwitchScheme scheme, uint64_t plain_modulus = 0);
+
+  /// @brief Computes key switching, adding the result to \p result
+  /// @param[in,out] result Ciphertext data to which the key switched
+  /// polynomials are added. Has (key_component_count * num_moduli * n)
+  /// elements
+  /// @param[in] input Polynomial to key switch. Has (num_moduli * n) elements,
+  /// in NTT form for CKKS and BGV and in coefficient form for BFV
+  /// @param[in] num_moduli Number of ciphertext moduli at the current level.
+  /// Must be in [1, L]
+  /// @param[in] key_component_count Number of components in the key switching
+  /// key, e.g. key_component_count == 2
+  /// @param[in] k_switch_keys Array of NumDigits(L) evaluation keys, one per
+  /// top-level digit. Each has (key_component_count * KeyModulusSize() * n)
+  /// elements in NTT form; component k modulo the m'th modulus of
+  /// GetModuli() starts at element (k * KeyModulusSize() + m) * n
+  /// @param[in] executor Executor on which to run independent tasks. If
+  /// nullptr, runs on the calling thread
+  /// @param[in] workspace Scratch memory with at least WorkspaceSize()
+  /// elements for the same \p num_moduli, \p key_component_count and \p
+  /// executor. Need not be initialized. If nullptr, scratch memory is
+  /// allocated internally
+  void KeySwitch(uint64_t* result, const uint64_t* input, uint64_t num_moduli,
+                 uint64_t key_component_count, const uint64_t** k_switch_keys,
+                 Executor* executor = nullptr,
+                 uint64_t* workspace = nullptr) const;
+
+  /// @brief Returns the number of 64-bit words of scratch memory used by
+  /// KeySwitch
+  uint64_t WorkspaceSize(uint64_t num_moduli, uint64_t key_component_count,
+                         const Executor* executor = nullptr) const;
+
+  /// @brief Returns the degree N
+  uint64_t GetDegree() const { return m_n; }
+
+  /// @brief Returns the ciphertext moduli followed by the special moduli
+  const std::vector<uint64_t>& GetModuli() const { return m_moduli; }
+
+  /// @brief Returns the number of top-level ciphertext moduli L
+  uint64_t NumCiphertextModuli() const { return m_num_ciphertext_moduli; }
+
+  /// @brief Returns the number of special moduli K
+  uint64_t NumSpecialModuli() const { return m_num_special_moduli; }
+
+  /// @brief Returns the number of moduli of the key switching keys, L + K
+  uint64_t KeyModulusSize() const {
+    return m_num_ciphertext_moduli + m_num_special_moduli;
+  }
+
+  /// @brief Returns the number of ciphertext moduli in each digit
+  uint64_t DigitSize() const { return m_digit_size; }
+
+  /// @brief Returns the number of digits of a polynomial with \p num_moduli
+  /// ciphertext moduli
+  uint64_t NumDigits(uint64_t num_moduli) const {
+    return (num_moduli + m_digit_size - 1) / m_digit_size;
+  }
+
+  /// @brief Returns the scheme of the ciphertexts to key switch
+  KeySwitchScheme GetScheme() const { return m_scheme; }
+
+ private:
+  // Index in m_moduli of the m'th modulus of the extended basis {q_0, ...,
+  // q_{num_moduli-1}, p_0, ..., p_{K-1}}
+  uint64_t ExtendedIndex(uint64_t m, uint64_t num_moduli) const {
+    return (m < num_moduli) ? m : m_num_ciphertext_moduli + (m - num_moduli);
+  }
+
+  uint64_t m_n{0};
+  uint64_t m_num_ciphertext_moduli{0};
+  uint64_t m_num_special_moduli{0};
+  uint64_t m_digit_size{1};
+  KeySwitchScheme m_scheme{KeySwitchScheme::CKKS};
+  uint64_t m_plain_modulus{0};
+
+  std::vector<uint64_t> m_moduli;
+
+  std::vector<NTT> m_ntts;
+
+  // ModUp tables, indexed by num_moduli - 1. For ciphertext modulus q_i in
+  // digit j, with Q_j the product of the moduli of digit j at that level:
+  //   m_digit_inv[i] = (Q_j / q_i)^{-1} mod q_i
+  //   m_digit_conv[i * (num_moduli + K) + m] = (Q_j / q_i) mod (m'th modulus
+  //   of the extended basis)
+  std::vector<std::vector<uint64_t>> m_digit_inv;
+  std::vector<std::vector<uint64_t>> m_digit_conv;
+
+  // ModDown tables
+  //   m_special_inv[k] = (P / p_k)^{-1} mod p_k, times t^{-1} for BGV
+  //   m_special_conv[k * L + i] = (P / p_k) mod q_i
+  //   m_special_modulus_inv[i] = P^{-1} mod q_i
+  //   m_half_special_modulus[m] = floor(P / 2) mod m'th modulus
+  //   m_plain_modulus_mod[i] = t mod q_i, for BGV
+  std::vector<uint64_t> m_special_inv;
+  std::vector<uint64_t> m_special_conv;
+  std::vector<uint64_t> m_special_modulus_inv;
+  std::vector<uint64_t> m_half_special_modulus;
+  std::vector<uint64_t> m_plain_modulus_mod;
+};
+
+}  // namespace hexl
+}  // namespace intel
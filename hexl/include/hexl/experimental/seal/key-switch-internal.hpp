@@ -5,6 +5,13 @@
 
 #include <stdint.h>
 
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+#include "hexl/ntt/ntt.hpp"
+
 namespace intel {
 namespace hexl {
 namespace internal {
@@ -31,13 +38,339 @@ namespace internal {
 /// coeff_count * ((key_modulus_size - 1)+ (key_component_count - 1) *
 /// (key_modulus_size) + 1) entries
 /// @param[in] modswitch_factors Array of modulus switch factors
-/// @param[in] root_of_unity_powers_ptr Array of root of unity powers
+/// @param[in] root_of_unity_powers_ptr Array of root of unity powers. If not
+/// nullptr, has key_modulus_size entries of n powers each, in bit-reversed
+/// order, as returned by NTT::GetRootOfUnityPowers()
+/// @param[in] executor Executor on which to run independent RNS limbs and key
+/// components. If nullptr, runs on the calling thread
 void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
                uint64_t decomp_modulus_size, uint64_t key_modulus_size,
                uint64_t rns_modulus_size, uint64_t key_component_count,
                const uint64_t* moduli, const uint64_t** k_switch_keys,
                const uint64_t* modswitch_factors,
-               const uint64_t* root_of_unity_powers_ptr = nullptr);
+               const uint64_t* root_of_unity_powers_ptr = nullptr,
+               Executor* executor = nullptr);
+
+/// @brief Computes key switching in-place using pre-computed NTTs
+/// @details Parameters are as in KeySwitch above
+/// @param[in] ntts NTT objects for each of the key_modulus_size moduli, in
+/// the same order as \p moduli. Only used to compute transforms, so may be
+/// shared across concurrent calls
+/// @param[in] executor Executor on which to run independent RNS limbs and key
+/// components. If nullptr, runs on the calling thread
+/// @param[in] workspace Scratch memory with at least KeySwitchWorkspaceSize()
+/// elements for the same \p executor. If nullptr, scratch memory is allocated
+/// internally
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitch
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] decomp_modulus_size Number of moduli in the ciphertext at its
+/// current level, excluding one auxiliary prime
+/// @param[in] rns_modulus_size Number of moduli in the ciphertext at its
+/// current level, including one auxiliary prime
+/// @param[in] key_component_count Number of components in the resulting
+/// ciphertext
+/// @param[in] executor Executor on which KeySwitch runs. The workspace grows
+/// with the number of workers
+uint64_t KeySwitchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                uint64_t rns_modulus_size,
+                                uint64_t key_component_count,
+                                const Executor* executor = nullptr);
+
+/// @brief Computes key switching in-place for a batch of ciphertexts sharing
+/// the same key switching keys
+/// @details Each key tile is applied to a group of ciphertexts before moving
+/// on, so the keys are streamed from memory once per group rather than once
+/// per ciphertext. The result for each ciphertext is identical to KeySwitch.
+/// Other parameters are as in KeySwitch above
+/// @param[in,out] results Array of \p batch_size ciphertext data pointers,
+/// each as the result of KeySwitch
+/// @param[in] t_target_iter_ptrs Array of \p batch_size pointers to the last
+/// component of each input ciphertext
+/// @param[in] batch_size Number of ciphertexts
+/// @param[in] workspace Scratch memory with at least
+/// KeySwitchBatchWorkspaceSize() elements for the same \p batch_size and \p
+/// executor. If nullptr, scratch memory is allocated internally
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli, const uint64_t** k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Computes key switching in-place with keys stored in a
+/// CompactKeySwitchKey
+/// @details Each key limb is unpacked, or expanded from the seed, when the
+/// inner product reaches it. Other parameters are as in KeySwitch above
+/// @param[in] k_switch_keys Keys with the same degree, moduli and component
+/// count, and at least decomp_modulus_size digits
+/// @param[in] workspace Scratch memory with at least KeySwitchWorkspaceSize()
+/// elements for the same \p executor. If nullptr, scratch memory is allocated
+/// internally
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const CompactKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Computes batched key switching in-place with keys stored in a
+/// CompactKeySwitchKey
+/// @details Each key limb is unpacked once per group of ciphertexts. Other
+/// parameters are as in KeySwitchBatch above
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const CompactKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Computes key switching in-place with keys stored in a
+/// PreparedKeySwitchKey
+/// @details Other parameters are as in KeySwitch above
+/// @param[in] k_switch_keys Keys with the same degree, number of key moduli
+/// and component count, and at least decomp_modulus_size digits
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const PreparedKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Computes batched key switching in-place with keys stored in a
+/// PreparedKeySwitchKey
+/// @details Parameters are as in KeySwitchBatch above
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const PreparedKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of coefficients per tile of the KeySwitch inner
+/// product, chosen from the L1 data cache size
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] key_component_count Number of components in the key switching
+/// keys
+uint64_t KeySwitchBatchTileSize(uint64_t n, uint64_t key_component_count);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitchBatch
+/// @details Parameters are as in KeySwitchWorkspaceSize
+/// @param[in] batch_size Number of ciphertexts
+uint64_t KeySwitchBatchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                     uint64_t rns_modulus_size,
+                                     uint64_t key_component_count,
+                                     uint64_t batch_size,
+                                     const Executor* executor = nullptr);
+
+/// @brief Computes the permutation of NTT coefficients applied by
+/// GaloisPermuteNTT: result[i] = operand[permutation[i]]
+/// @param[out] permutation Stores the n indices
+/// @param[in] n Number of coefficients. Must be a power of two
+/// @param[in] galois_elt Odd Galois element in [1, 2n)
+void GaloisPermutationNTT(uint64_t* permutation, uint64_t n,
+                          uint64_t galois_elt);
+
+/// @brief Applies the automorphism X -> X^galois_elt to a polynomial in NTT
+/// form, as computed by the NTT class
+/// @details In NTT form, the automorphism permutes the coefficients, so the
+/// same permutation applies modulo any modulus
+/// @param[out] result Stores the permuted polynomial. Must not alias \p
+/// operand
+/// @param[in] operand Polynomial of n coefficients in NTT form
+/// @param[in] n Number of coefficients. Must be a power of two
+/// @param[in] galois_elt Odd Galois element in [1, 2n)
+void GaloisPermuteNTT(uint64_t* result, const uint64_t* operand, uint64_t n,
+                      uint64_t galois_elt);
+
+/// @brief Returns the number of 64-bit words in a key switching
+/// decomposition computed by KeySwitchDecompose
+/// @details Parameters are as in KeySwitchWorkspaceSize
+uint64_t KeySwitchDecompositionSize(uint64_t n, uint64_t decomp_modulus_size,
+                                    uint64_t rns_modulus_size);
+
+/// @brief Computes the decomposition of a ciphertext component for hoisted
+/// key switching
+/// @details Performs the inverse NTTs, RNS conversions and forward NTTs of
+/// KeySwitch once, so that KeySwitchHoisted can apply many Galois keys to the
+/// same ciphertext. Parameters are as in KeySwitch with pre-computed NTTs.
+/// @param[out] decomposition Stores KeySwitchDecompositionSize() words: for
+/// each of the rns_modulus_size output moduli, the decomp_modulus_size digits
+/// in NTT form modulo that output modulus, in [0, 4 * modulus)
+void KeySwitchDecompose(uint64_t* decomposition,
+                        const uint64_t* t_target_iter_ptr, uint64_t n,
+                        uint64_t decomp_modulus_size,
+                        uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                        const uint64_t* moduli, const std::vector<NTT>& ntts,
+                        Executor* executor = nullptr);
+
+/// @brief Computes key switching in-place of the automorphisms of one
+/// ciphertext component, for several Galois keys
+/// @details For each key r, adds to results[r] the key switching of the
+/// image of the decomposed component under X -> X^galois_elts[r], as
+/// KeySwitch does. For a rotation, results[r] would hold the image of the
+/// first ciphertext component and zero. The digits of the image are
+/// permutations of the shared decomposition, so they may differ from those
+/// KeySwitch computes from the rotated component by multiples of the digit
+/// moduli; both are valid key switchings with the same noise bound. Other
+/// parameters are as in KeySwitch with pre-computed NTTs.
+/// @param[in,out] results Array of \p num_keys ciphertext data pointers, each
+/// as the result of KeySwitch
+/// @param[in] decomposition Decomposition computed by KeySwitchDecompose
+/// @param[in] galois_elts Array of \p num_keys odd Galois elements in
+/// [1, 2n)
+/// @param[in] num_keys Number of Galois keys
+/// @param[in] k_switch_keys Array of \p num_keys evaluation keys, each as the
+/// k_switch_keys of KeySwitch
+/// @param[in] workspace Scratch memory with at least
+/// KeySwitchHoistedWorkspaceSize() elements for the same \p num_keys and \p
+/// executor. Need not be initialized. If nullptr, scratch memory is allocated
+/// internally
+void KeySwitchHoisted(uint64_t** results, const uint64_t* decomposition,
+                      const uint64_t* galois_elts, uint64_t num_keys,
+                      uint64_t n, uint64_t decomp_modulus_size,
+                      uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                      uint64_t key_component_count, const uint64_t* moduli,
+                      const uint64_t*** k_switch_keys,
+                      const uint64_t* modswitch_factors,
+                      const std::vector<NTT>& ntts,
+                      Executor* executor = nullptr,
+                      uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitchHoisted
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] rns_modulus_size Number of moduli in the ciphertext at its
+/// current level, including one auxiliary prime
+/// @param[in] key_component_count Number of components in the resulting
+/// ciphertext
+/// @param[in] num_keys Number of Galois keys
+/// @param[in] executor Executor on which KeySwitchHoisted runs
+uint64_t KeySwitchHoistedWorkspaceSize(uint64_t n, uint64_t rns_modulus_size,
+                                       uint64_t key_component_count,
+                                       uint64_t num_keys,
+                                       const Executor* executor = nullptr);
+
+/// @brief Multiplies two vectors element-wise and adds the products to a lazy
+/// 128-bit accumulator without modular reduction
+/// @param[in,out] acc_hi High words of the accumulator. Element i of the
+/// accumulator represents acc_hi[i] * 2^64 + acc_lo[i]
+/// @param[in,out] acc_lo Low words of the accumulator
+/// @param[in] operand Vector of elements to multiply
+/// @param[in] key Vector of elements to multiply
+/// @param[in] n Number of elements in each vector
+void KeySwitchMultiplyAccumulateNative(uint64_t* acc_hi, uint64_t* acc_lo,
+                                       const uint64_t* operand,
+                                       const uint64_t* key, uint64_t n);
+
+/// @brief Reduces a lazy 128-bit accumulator modulo \p modulus
+/// @param[out] result Stores the result, in [0, modulus)
+/// @param[in] acc_hi High words of the accumulator. Element i of the
+/// accumulator represents acc_hi[i] * 2^64 + acc_lo[i]
+/// @param[in] acc_lo Low words of the accumulator
+/// @param[in] n Number of elements in each vector
+/// @param[in] modulus Modulus with which to perform modular reduction
+void KeySwitchReduceNative(uint64_t* result, const uint64_t* acc_hi,
+                           const uint64_t* acc_lo, uint64_t n,
+                           uint64_t modulus);
+
+/// @brief Returns the radix, in bits, of the lazy accumulator used for
+/// products modulo \p modulus
+/// @param[in] n Number of elements in each vector
+/// @param[in] modulus Modulus of the products
+/// @param[in] num_products Number of products accumulated before reduction
+/// @details The 52-bit radix is used by AVX512IFMA, which requires operands
+/// in [0, 4 * modulus) to fit in 52 bits. Otherwise returns 64.
+int KeySwitchAccumulatorBitShift(uint64_t n, uint64_t modulus,
+                                 uint64_t num_products);
+
+/// @brief Multiplies two vectors element-wise and adds the products to a lazy
+/// accumulator, using the best available implementation
+/// @param[in,out] acc_hi High words of the accumulator. Element i of the
+/// accumulator represents acc_hi[i] * 2^bit_shift + acc_lo[i]
+/// @param[in,out] acc_lo Low words of the accumulator
+/// @param[in] operand Vector of elements to multiply
+/// @param[in] key Vector of elements to multiply
+/// @param[in] n Number of elements in each vector
+/// @param[in] bit_shift Accumulator radix, as returned by
+/// KeySwitchAccumulatorBitShift
+void KeySwitchMultiplyAccumulate(uint64_t* acc_hi, uint64_t* acc_lo,
+                                 const uint64_t* operand, const uint64_t* key,
+                                 uint64_t n, int bit_shift);
+
+/// @brief Reduces a lazy accumulator modulo \p modulus, using the best
+/// available implementation
+/// @param[out] result Stores the result, in [0, modulus)
+/// @param[in] acc_hi High words of the accumulator
+/// @param[in] acc_lo Low words of the accumulator
+/// @param[in] n Number of elements in each vector
+/// @param[in] modulus Modulus with which to perform modular reduction
+/// @param[in] bit_shift Accumulator radix, as returned by
+/// KeySwitchAccumulatorBitShift
+void KeySwitchReduce(uint64_t* result, const uint64_t* acc_hi,
+                     const uint64_t* acc_lo, uint64_t n, uint64_t modulus,
+                     int bit_shift);
+
+/// @brief First fused ModDown pass: computes the NTT input for one ciphertext
+/// modulus from the special limb in coefficient form
+/// @details Computes ((special[i] + floor(special_modulus / 2)) mod
+/// special_modulus) mod modulus, plus modulus - (floor(special_modulus / 2)
+/// mod modulus), i.e. the rounded special limb shifted to modulo \p modulus.
+/// @param[out] result Stores the result, in [0, 2 * modulus)
+/// @param[in] special Special limb, in [0, special_modulus)
+/// @param[in] n Number of elements in each vector
+/// @param[in] special_modulus Special (auxiliary) modulus
+/// @param[in] modulus Ciphertext modulus
+void KeySwitchModDownPrepareNative(uint64_t* result, const uint64_t* special,
+                                   uint64_t n, uint64_t special_modulus,
+                                   uint64_t modulus);
+
+/// @brief First fused ModDown pass, using the best available implementation
+/// @details Parameters are as in KeySwitchModDownPrepareNative
+void KeySwitchModDownPrepare(uint64_t* result, const uint64_t* special,
+                             uint64_t n, uint64_t special_modulus,
+                             uint64_t modulus);
+
+/// @brief Second fused ModDown pass: computes result[i] = (result[i] +
+/// (operand[i] - special[i]) * modswitch_factor) mod modulus
+/// @param[in,out] result Ciphertext limb to accumulate into, in [0, modulus)
+/// @param[in] operand Product limb, in [0, modulus)
+/// @param[in] special Special limb converted to \p modulus, in [0, 4 *
+/// modulus)
+/// @param[in] n Number of elements in each vector
+/// @param[in] modulus Ciphertext modulus. Must be less than 2^61
+/// @param[in] modswitch_factor Inverse of the special modulus, in [0, modulus)
+void KeySwitchModDownAccumulateNative(uint64_t* result, const uint64_t* operand,
+                                      const uint64_t* special, uint64_t n,
+                                      uint64_t modulus,
+                                      uint64_t modswitch_factor);
+
+/// @brief Second fused ModDown pass, using the best available implementation
+/// @details Parameters are as in KeySwitchModDownAccumulateNative
+void KeySwitchModDownAccumulate(uint64_t* result, const uint64_t* operand,
+                                const uint64_t* special, uint64_t n,
+                                uint64_t modulus, uint64_t modswitch_factor);
 
 }  // namespace internal
 }  // namespace hexl
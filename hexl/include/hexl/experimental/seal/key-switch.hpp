@@ -5,6 +5,13 @@
 
 #include <stdint.h>
 
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+#include "hexl/ntt/ntt.hpp"
+
 namespace intel {
 namespace hexl {
 
@@ -30,7 +37,14 @@ namespace hexl {
 /// coeff_count * ((key_modulus_size - 1)+ (key_component_count - 1) *
 /// (key_modulus_size) + 1) entries
 /// @param[in] modswitch_factors Array of modulus switch factors
-/// @param[in] root_of_unity_powers_ptr Array of root of unity powers
+/// @param[in] root_of_unity_powers_ptr Array of root of unity powers. If not
+/// nullptr, has key_modulus_size entries of n powers each, in bit-reversed
+/// order, as returned by NTT::GetRootOfUnityPowers()
+/// @details Builds the NTT tables on the first call with a parameter set and
+/// caches them on the calling thread, for the four most recently used
+/// parameter sets. Callers which alternate between more parameter sets, or
+/// need to bound the memory of the tables, should construct the NTTs once and
+/// use the overload taking them
 void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
                uint64_t decomp_modulus_size, uint64_t key_modulus_size,
                uint64_t rns_modulus_size, uint64_t key_component_count,
@@ -38,5 +52,233 @@ void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
                const uint64_t* modswitch_factors,
                const uint64_t* root_of_unity_powers_ptr = nullptr);
 
+/// @brief Computes key switching in-place, running independent RNS limbs and
+/// key components on \p executor
+/// @details The result is identical to the single-threaded KeySwitch, for any
+/// number of workers. Parameters are as in the single-threaded KeySwitch.
+/// @param[in] executor Executor on which to run tasks. If nullptr, runs on the
+/// calling thread. Each call runs several ParallelFor stages, so use an
+/// executor with persistent threads, such as ThreadExecutor, constructed once
+/// and reused across calls
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors,
+               const uint64_t* root_of_unity_powers_ptr, Executor* executor);
+
+/// @brief Computes key switching in-place using pre-computed NTTs, so no
+/// NTT tables are constructed
+/// @details Parameters are as in the single-threaded KeySwitch.
+/// @param[in] ntts NTT objects for each of the key_modulus_size moduli, in
+/// the same order as \p moduli
+/// @param[in] executor Executor on which to run tasks. If nullptr, runs on the
+/// calling thread
+/// @param[in] workspace Scratch memory with at least KeySwitchWorkspaceSize()
+/// elements for the same \p executor, preferably 64-byte aligned. Need not be
+/// initialized. If nullptr, scratch memory is allocated internally
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli, const uint64_t** k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitch
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] decomp_modulus_size Number of moduli in the ciphertext at its
+/// current level, excluding one auxiliary prime
+/// @param[in] rns_modulus_size Number of moduli in the ciphertext at its
+/// current level, including one auxiliary prime
+/// @param[in] key_component_count Number of components in the resulting
+/// ciphertext
+/// @param[in] executor Executor on which KeySwitch runs. The workspace grows
+/// with the number of workers
+uint64_t KeySwitchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                uint64_t rns_modulus_size,
+                                uint64_t key_component_count,
+                                const Executor* executor = nullptr);
+
+/// @brief Computes key switching in-place for a batch of ciphertexts sharing
+/// the same key switching keys
+/// @details Each key tile is applied to a group of ciphertexts before moving
+/// on, amortizing the memory bandwidth of the keys across the batch. The
+/// result for each ciphertext is identical to KeySwitch. Other parameters are
+/// as in KeySwitch with pre-computed NTTs.
+/// @param[in,out] results Array of \p batch_size ciphertext data pointers,
+/// each as the result of KeySwitch
+/// @param[in] t_target_iter_ptrs Array of \p batch_size pointers to the last
+/// component of each input ciphertext
+/// @param[in] batch_size Number of ciphertexts
+/// @param[in] workspace Scratch memory with at least
+/// KeySwitchBatchWorkspaceSize() elements for the same \p batch_size and \p
+/// executor. Need not be initialized. If nullptr, scratch memory is allocated
+/// internally
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli, const uint64_t** k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Computes key switching in-place with keys stored in a
+/// CompactKeySwitchKey
+/// @details Each key limb is unpacked, or expanded from the seed, when the
+/// inner product reaches it. Other parameters are as in KeySwitch with
+/// pre-computed NTTs
+/// @param[in] k_switch_keys Keys with the same degree, moduli and component
+/// count, and at least decomp_modulus_size digits
+/// @param[in] workspace Scratch memory with at least KeySwitchWorkspaceSize()
+/// elements for the same \p executor. Need not be initialized. If nullptr,
+/// scratch memory is allocated internally
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const CompactKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Computes batched key switching in-place with keys stored in a
+/// CompactKeySwitchKey
+/// @details Each key limb is unpacked once per group of ciphertexts. Other
+/// parameters are as in KeySwitchBatch
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const CompactKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Computes key switching in-place with keys stored in a
+/// PreparedKeySwitchKey
+/// @details The inner product for each output modulus reads the prepared keys
+/// as one sequential stream. Other parameters are as in KeySwitch with
+/// pre-computed NTTs
+/// @param[in] k_switch_keys Keys with the same degree, number of key moduli
+/// and component count, and at least decomp_modulus_size digits
+/// @param[in] workspace Scratch memory with at least KeySwitchWorkspaceSize()
+/// elements for the same \p executor. Need not be initialized. If nullptr,
+/// scratch memory is allocated internally
+void KeySwitch(uint64_t* result, const uint64_t* t_target_iter_ptr, uint64_t n,
+               uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+               uint64_t rns_modulus_size, uint64_t key_component_count,
+               const uint64_t* moduli,
+               const PreparedKeySwitchKey& k_switch_keys,
+               const uint64_t* modswitch_factors, const std::vector<NTT>& ntts,
+               Executor* executor = nullptr, uint64_t* workspace = nullptr);
+
+/// @brief Computes batched key switching in-place with keys stored in a
+/// PreparedKeySwitchKey
+/// @details Parameters are as in KeySwitchBatch
+void KeySwitchBatch(uint64_t** results, const uint64_t** t_target_iter_ptrs,
+                    uint64_t batch_size, uint64_t n,
+                    uint64_t decomp_modulus_size, uint64_t key_modulus_size,
+                    uint64_t rns_modulus_size, uint64_t key_component_count,
+                    const uint64_t* moduli,
+                    const PreparedKeySwitchKey& k_switch_keys,
+                    const uint64_t* modswitch_factors,
+                    const std::vector<NTT>& ntts,
+                    Executor* executor = nullptr,
+                    uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitchBatch
+/// @details Parameters are as in KeySwitchWorkspaceSize
+/// @param[in] batch_size Number of ciphertexts
+uint64_t KeySwitchBatchWorkspaceSize(uint64_t n, uint64_t decomp_modulus_size,
+                                     uint64_t rns_modulus_size,
+                                     uint64_t key_component_count,
+                                     uint64_t batch_size,
+                                     const Executor* executor = nullptr);
+
+/// @brief Applies the automorphism X -> X^galois_elt to a polynomial in NTT
+/// form, as computed by the NTT class
+/// @details In NTT form, the automorphism permutes the coefficients, so the
+/// same permutation applies modulo any modulus
+/// @param[out] result Stores the permuted polynomial. Must not alias \p
+/// operand
+/// @param[in] operand Polynomial of n coefficients in NTT form
+/// @param[in] n Number of coefficients. Must be a power of two
+/// @param[in] galois_elt Odd Galois element in [1, 2n)
+void GaloisPermuteNTT(uint64_t* result, const uint64_t* operand, uint64_t n,
+                      uint64_t galois_elt);
+
+/// @brief Returns the number of 64-bit words in a key switching
+/// decomposition computed by KeySwitchDecompose
+/// @details Parameters are as in KeySwitchWorkspaceSize
+uint64_t KeySwitchDecompositionSize(uint64_t n, uint64_t decomp_modulus_size,
+                                    uint64_t rns_modulus_size);
+
+/// @brief Computes the decomposition of a ciphertext component for hoisted
+/// key switching
+/// @details Performs the inverse NTTs, RNS conversions and forward NTTs of
+/// KeySwitch once, so that KeySwitchHoisted can apply many Galois keys to the
+/// same ciphertext. Parameters are as in KeySwitch with pre-computed NTTs.
+/// @param[out] decomposition Stores KeySwitchDecompositionSize() words: for
+/// each of the rns_modulus_size output moduli, the decomp_modulus_size digits
+/// in NTT form modulo that output modulus, in [0, 4 * modulus)
+void KeySwitchDecompose(uint64_t* decomposition,
+                        const uint64_t* t_target_iter_ptr, uint64_t n,
+                        uint64_t decomp_modulus_size,
+                        uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                        const uint64_t* moduli, const std::vector<NTT>& ntts,
+                        Executor* executor = nullptr);
+
+/// @brief Computes key switching in-place of the automorphisms of one
+/// ciphertext component, for several Galois keys
+/// @details For each key r, adds to results[r] the key switching of the
+/// image of the decomposed component under X -> X^galois_elts[r], as
+/// KeySwitch does. For a rotation, results[r] would hold the image of the
+/// first ciphertext component and zero. The digits of the image are
+/// permutations of the shared decomposition, so they may differ from those
+/// KeySwitch computes from the rotated component by multiples of the digit
+/// moduli; both are valid key switchings with the same noise bound. Other
+/// parameters are as in KeySwitch with pre-computed NTTs.
+/// @param[in,out] results Array of \p num_keys ciphertext data pointers, each
+/// as the result of KeySwitch
+/// @param[in] decomposition Decomposition computed by KeySwitchDecompose
+/// @param[in] galois_elts Array of \p num_keys odd Galois elements in
+/// [1, 2n)
+/// @param[in] num_keys Number of Galois keys
+/// @param[in] k_switch_keys Array of \p num_keys evaluation keys, each as the
+/// k_switch_keys of KeySwitch
+/// @param[in] workspace Scratch memory with at least
+/// KeySwitchHoistedWorkspaceSize() elements for the same \p num_keys and \p
+/// executor. Need not be initialized. If nullptr, scratch memory is allocated
+/// internally
+void KeySwitchHoisted(uint64_t** results, const uint64_t* decomposition,
+                      const uint64_t* galois_elts, uint64_t num_keys,
+                      uint64_t n, uint64_t decomp_modulus_size,
+                      uint64_t key_modulus_size, uint64_t rns_modulus_size,
+                      uint64_t key_component_count, const uint64_t* moduli,
+                      const uint64_t*** k_switch_keys,
+                      const uint64_t* modswitch_factors,
+                      const std::vector<NTT>& ntts,
+                      Executor* executor = nullptr,
+                      uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// KeySwitchHoisted
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] rns_modulus_size Number of moduli in the ciphertext at its
+/// current level, including one auxiliary prime
+/// @param[in] key_component_count Number of components in the resulting
+/// ciphertext
+/// @param[in] num_keys Number of Galois keys
+/// @param[in] executor Executor on which KeySwitchHoisted runs
+uint64_t KeySwitchHoistedWorkspaceSize(uint64_t n, uint64_t rns_modulus_size,
+                                       uint64_t key_component_count,
+                                       uint64_t num_keys,
+                                       const Executor* executor = nullptr);
+
 }  // namespace hexl
 }  // namespace intel
@@ -0,0 +1,103 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "hexl/util/aligned-allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Key switching keys re-laid in the order read by the KeySwitch inner
+/// product
+/// @details For each key modulus, then each digit, the limbs of all key
+/// components are split into tiles of TileSize() coefficients, and the tiles
+/// of the components are interleaved: tile 0 of component 0, tile 0 of
+/// component 1, ..., tile 1 of component 0, and so on. The inner product for
+/// one output modulus then reads its keys as a single sequential stream,
+/// rather than one stream per digit and component spread over the key
+/// switching keys.
+class PreparedKeySwitchKey {
+ public:
+  /// @brief Initializes an empty PreparedKeySwitchKey object
+  PreparedKeySwitchKey() = default;
+
+  /// @brief Prepares key switching keys for KeySwitch. This is a one-time
+  /// transform; the keys may be freed afterwards
+  /// @param[in] k_switch_keys Array of num_digits keys in the layout taken by
+  /// KeySwitch, each with (key_component_count * key_modulus_size * n)
+  /// elements
+  /// @param[in] n Number of coefficients in each polynomial. Must be a power
+  /// of two
+  /// @param[in] num_digits Number of keys, one per decomposition modulus
+  /// @param[in] key_modulus_size Number of key moduli, including the special
+  /// modulus
+  /// @param[in] key_component_count Number of components in each key
+  /// @param[in] use_huge_pages Whether to request huge pages for the prepared
+  /// keys. Falls back to regular pages where unavailable
+  PreparedKeySwitchKey(const uint64_t** k_switch_keys, uint64_t n,
+                       uint64_t num_digits, uint64_t key_modulus_size,
+                       uint64_t key_component_count,
+                       bool use_huge_pages = false);
+
+  /// @brief Returns the tiles of all components of one key limb
+  /// @param[in] digit Index of the key, in [0, NumDigits())
+  /// @param[in] modulus_index Index of the key modulus, in
+  /// [0, KeyModulusSize())
+  /// @return Pointer to (KeyComponentCount() * GetDegree()) elements
+  const uint64_t* GetLimbs(uint64_t digit, uint64_t modulus_index) const {
+    return Data() +
+           (modulus_index * m_num_digits + digit) * m_key_component_count * m_n;
+  }
+
+  /// @brief Returns the degree N
+  uint64_t GetDegree() const { return m_n; }
+
+  /// @brief Returns the number of keys
+  uint64_t NumDigits() const { return m_num_digits; }
+
+  /// @brief Returns the number of key moduli
+  uint64_t KeyModulusSize() const { return m_key_modulus_size; }
+
+  /// @brief Returns the number of components in each key
+  uint64_t KeyComponentCount() const { return m_key_component_count; }
+
+  /// @brief Returns the number of coefficients in each tile
+  uint64_t TileSize() const { return m_tile_size; }
+
+  /// @brief Returns whether the keys are stored on huge pages
+  bool UsesHugePages() const { return m_huge_pages != nullptr; }
+
+  /// @brief Returns the number of bytes used to store the keys
+  uint64_t StorageSize() const {
+    return m_key_modulus_size * m_num_digits * m_key_component_count * m_n *
+           sizeof(uint64_t);
+  }
+
+ private:
+  uint64_t* Data() {
+    return UsesHugePages() ? m_huge_pages.get() : m_storage.data();
+  }
+
+  const uint64_t* Data() const {
+    return UsesHugePages() ? m_huge_pages.get() : m_storage.data();
+  }
+
+  uint64_t m_n{0};
+  uint64_t m_num_digits{0};
+  uint64_t m_key_modulus_size{0};
+  uint64_t m_key_component_count{0};
+  uint64_t m_tile_size{0};
+
+  // Prepared keys, either in aligned memory or in an anonymous mapping backed
+  // by huge pages
+  AlignedVector64<uint64_t> m_storage;
+  std::shared_ptr<uint64_t> m_huge_pages;
+};
+
+}  // namespace hexl
+}  // namespace intel
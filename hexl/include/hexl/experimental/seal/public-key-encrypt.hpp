@@ -0,0 +1,64 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/ntt/ntt.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Computes a public-key RLWE encryption in NTT form
+/// @details For each RNS limb, computes
+/// (u * pk[0] + e0 + plain, u * pk[1] + e1), where u, e0 and e1 are the
+/// forward NTTs of the small polynomials expanded into the limb. Each limb is
+/// computed in turn: the three polynomials are expanded and transformed into
+/// scratch memory and the result, then the products are added in a single
+/// pass, so the intermediate limbs stay in cache.
+/// @param[out] result Stores the ciphertext. Has (2 * n * num_moduli)
+/// elements
+/// @param[in] public_key Public key in NTT form. Has (2 * n * num_moduli)
+/// elements
+/// @param[in] u Ephemeral secret of n signed coefficients
+/// @param[in] e0 Error of the first ciphertext polynomial, of n signed
+/// coefficients
+/// @param[in] e1 Error of the second ciphertext polynomial, of n signed
+/// coefficients
+/// @param[in] plain Scaled plaintext in NTT form, with (n * num_moduli)
+/// elements, each less than the modulus of its limb, or nullptr to encrypt
+/// zero
+/// @param[in] n Number of coefficients in each polynomial. Must be a power of
+/// two
+/// @param[in] moduli Pointer to contiguous array of num_moduli word-sized
+/// coefficient moduli. The absolute value of each coefficient of \p u, \p e0
+/// and \p e1 must be less than each modulus
+/// @param[in] num_moduli Number of word-sized coefficient moduli
+/// @param[in] ntts NTT objects for at least the num_moduli moduli, in the same
+/// order as \p moduli
+/// @param[in] executor Runs the limbs concurrently. If nullptr, runs on the
+/// calling thread
+/// @param[in] workspace Scratch memory with at least
+/// PublicKeyEncryptWorkspaceSize() elements for the same \p executor. Need
+/// not be initialized. If nullptr, scratch memory is allocated internally
+void PublicKeyEncrypt(uint64_t* result, const uint64_t* public_key,
+                      const int64_t* u, const int64_t* e0, const int64_t* e1,
+                      const uint64_t* plain, uint64_t n,
+                      const uint64_t* moduli, uint64_t num_moduli,
+                      const std::vector<NTT>& ntts,
+                      Executor* executor = nullptr,
+                      uint64_t* workspace = nullptr);
+
+/// @brief Returns the number of 64-bit words of scratch memory used by
+/// PublicKeyEncrypt
+/// @param[in] n Number of coefficients in each polynomial
+/// @param[in] executor Executor passed to PublicKeyEncrypt
+uint64_t PublicKeyEncryptWorkspaceSize(uint64_t n,
+                                       const Executor* executor = nullptr);
+
+}  // namespace hexl
+}  // namespace intel
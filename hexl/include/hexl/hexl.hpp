@@ -10,16 +10,29 @@
 #include "hexl/eltwise/eltwise-mult-mod.hpp"
 #include "hexl/eltwise/eltwise-reduce-mod.hpp"
 #include "hexl/eltwise/eltwise-sub-mod.hpp"
+#include "hexl/experimental/misc/diagonal-mat-vec-mult.hpp"
+#include "hexl/experimental/misc/executor.hpp"
 #include "hexl/experimental/misc/lr-mat-vec-mult.hpp"
+#include "hexl/experimental/seal/command-queue.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
 #include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
 #include "hexl/experimental/seal/dyadic-multiply.hpp"
+#include "hexl/experimental/seal/hybrid-key-switch.hpp"
 #include "hexl/experimental/seal/key-switch-internal.hpp"
 #include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+#include "hexl/experimental/seal/public-key-encrypt.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/ntt/ntt.hpp"
 #include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/arena-allocator.hpp"
+#include "hexl/util/cache-info.hpp"
 #include "hexl/util/check.hpp"
 #include "hexl/util/compiler.hpp"
 #include "hexl/util/defines.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/instrumentation.hpp"
+#include "hexl/util/pool-allocator.hpp"
+#include "hexl/util/tracing.hpp"
 #include "hexl/util/types.hpp"
 #include "hexl/util/util.hpp"
@@ -97,7 +97,8 @@ class NTT {
   /// @param[in] output_mod_factor Returns output \p result in [0,
   /// output_mod_factor * q). Must be 1 or 4.
   void ComputeForward(uint64_t* result, const uint64_t* operand,
-                      uint64_t input_mod_factor, uint64_t output_mod_factor);
+                      uint64_t input_mod_factor,
+                      uint64_t output_mod_factor) const;
 
   /// Compute inverse NTT. Results are bit-reversed.
   /// @param[out] result Stores the result
@@ -107,7 +108,8 @@ class NTT {
   /// @param[in] output_mod_factor Returns output \p result in [0,
   /// output_mod_factor * q). Must be 1 or 2.
   void ComputeInverse(uint64_t* result, const uint64_t* operand,
-                      uint64_t input_mod_factor, uint64_t output_mod_factor);
+                      uint64_t input_mod_factor,
+                      uint64_t output_mod_factor) const;
 
   /// @brief Returns the minimal 2N'th root of unity
   uint64_t GetMinimalRootOfUnity() const { return m_w; }
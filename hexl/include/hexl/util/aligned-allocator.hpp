@@ -54,9 +54,15 @@ class AlignedAllocator {
     using other = AlignedAllocator<U, Alignment>;
   };
 
-  bool operator==(const AlignedAllocator&) { return true; }
+  /// @brief Allocators are equal if they share a strategy, so containers only
+  /// hand memory to an allocator which can free it
+  bool operator==(const AlignedAllocator& other) const {
+    return m_alloc_impl == other.m_alloc_impl;
+  }
 
-  bool operator!=(const AlignedAllocator&) { return false; }
+  bool operator!=(const AlignedAllocator& other) const {
+    return !(*this == other);
+  }
 
   /// @brief Allocates \p n elements aligned to Alignment-byte boundaries
   /// @return Pointer to the aligned allocated memory
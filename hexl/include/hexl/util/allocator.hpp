@@ -5,6 +5,8 @@
 
 #include <cstddef>
 
+#include "hexl/util/defines.hpp"
+
 namespace intel {
 namespace hexl {
 
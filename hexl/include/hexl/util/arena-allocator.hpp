@@ -0,0 +1,92 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "hexl/util/allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Allocator which hands out consecutive 64-byte aligned pieces of
+/// large blocks, and frees them all at once
+/// @details deallocate does nothing; memory is reclaimed by Rewind() or
+/// Reset(), after which it is reused by subsequent allocations. Blocks are only
+/// returned to malloc when the arena is destroyed. Not thread-safe
+class ArenaAllocator final : public AllocatorBase {
+ public:
+  /// @brief Position in the arena, returned by GetMark()
+  struct Mark {
+    size_t block;
+    size_t offset;
+  };
+
+  /// @brief Initializes an empty arena
+  /// @param[in] block_size Minimum size in bytes of each block taken from
+  /// malloc
+  explicit ArenaAllocator(size_t block_size = size_t(1) << 20);
+
+  ~ArenaAllocator();
+
+  ArenaAllocator(const ArenaAllocator&) = delete;
+  ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+  void* allocate(size_t bytes_count) override;
+
+  void deallocate(void* p, size_t n) override;
+
+  /// @brief Returns the current position, to be passed to Rewind()
+  Mark GetMark() const { return Mark{m_current, m_offset}; }
+
+  /// @brief Reclaims all memory allocated since \p mark was taken
+  /// @details \p mark must not be ahead of the current position, nor have been
+  /// taken before a Reset()
+  void Rewind(const Mark& mark);
+
+  /// @brief Reclaims all allocated memory. If the arena grew beyond one block,
+  /// replaces its blocks with a single block of the same total size
+  void Reset();
+
+  /// @brief Returns the bytes below the current position, including space
+  /// left unused at the end of blocks
+  size_t BytesUsed() const;
+
+  /// @brief Returns the total size in bytes of the blocks
+  size_t Capacity() const;
+
+ private:
+  struct Block {
+    void* raw;   // As returned by malloc
+    char* data;  // raw, aligned up to 64 bytes
+    size_t size;
+  };
+
+  void AddBlock(size_t size);
+
+  size_t m_block_size;
+  std::vector<Block> m_blocks;
+  size_t m_current{0};
+  size_t m_offset{0};
+};
+
+/// @brief Rewinds an arena on destruction to its position on construction
+class ScopedArenaReset {
+ public:
+  explicit ScopedArenaReset(ArenaAllocator& arena)
+      : m_arena(arena), m_mark(arena.GetMark()) {}
+
+  ~ScopedArenaReset() { m_arena.Rewind(m_mark); }
+
+  ScopedArenaReset(const ScopedArenaReset&) = delete;
+  ScopedArenaReset& operator=(const ScopedArenaReset&) = delete;
+
+ private:
+  ArenaAllocator& m_arena;
+  ArenaAllocator::Mark m_mark;
+};
+
+}  // namespace hexl
+}  // namespace intel
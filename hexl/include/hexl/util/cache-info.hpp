@@ -0,0 +1,40 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+namespace intel {
+namespace hexl {
+
+/// @brief Returns the size in bytes of the level 1 data cache of one core,
+/// from which tiled kernels choose their tile sizes
+/// @details Detected at runtime, unless overridden by SetCacheSizes or the
+/// HEXL_L1D_CACHE_SIZE environment variable
+uint64_t GetL1DataCacheSize();
+
+/// @brief Returns the size in bytes of the level 2 cache of one core, from
+/// which tiled kernels choose their tile sizes
+/// @details Detected at runtime, unless overridden by SetCacheSizes or the
+/// HEXL_L2_CACHE_SIZE environment variable
+uint64_t GetL2CacheSize();
+
+/// @brief Overrides the cache sizes from which tiled kernels choose their tile
+/// sizes, e.g. to tune for a different processor
+/// @param[in] l1_data_cache_size Size in bytes of the level 1 data cache, or 0
+/// to restore the detected size
+/// @param[in] l2_cache_size Size in bytes of the level 2 cache, or 0 to restore
+/// the detected size
+/// @details Affects subsequent calls only. Objects which store data in tiles,
+/// such as PreparedKeySwitchKey, keep the tile size chosen at construction
+void SetCacheSizes(uint64_t l1_data_cache_size, uint64_t l2_cache_size);
+
+/// @brief Returns the largest power-of-two tile size, at most \p n, for which
+/// \p words_per_coeff 64-bit words per coefficient fit in \p cache_size bytes
+/// @details Returns at least min(n, 64), to keep the per-tile overhead small
+uint64_t CacheTileSize(uint64_t n, uint64_t cache_size,
+                       uint64_t words_per_coeff);
+
+}  // namespace hexl
+}  // namespace intel
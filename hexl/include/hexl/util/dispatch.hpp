@@ -0,0 +1,70 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+namespace intel {
+namespace hexl {
+
+/// @brief Instruction sets from which kernels are selected at runtime, from
+/// slowest to fastest
+enum class Backend {
+  kNative,     ///< Portable C++ only
+  kAVX512DQ,   ///< AVX512-DQ instructions
+  kAVX512IFMA  ///< AVX512-IFMA52 instructions, in addition to AVX512-DQ
+};
+
+/// @brief Kernels whose implementation is selected at runtime
+enum class Kernel {
+  kEltwiseAddMod,
+  kEltwiseCmpAdd,
+  kEltwiseCmpSubMod,
+  kEltwiseFMAMod,
+  kEltwiseMultMod,
+  kEltwiseReduceMod,
+  kEltwiseSubMod,
+  kForwardNTT,
+  kInverseNTT,
+  kDyadicMultiply,  ///< Experimental DyadicMultiply
+  kKeySwitch        ///< Experimental KeySwitch
+};
+
+/// @brief Returns the name of \p backend, e.g. "AVX512-DQ"
+const char* BackendName(Backend backend);
+
+/// @brief Returns the name of \p kernel, e.g. "EltwiseAddMod"
+const char* KernelName(Kernel kernel);
+
+/// @brief Returns the fastest backend supported by both the library build and
+/// the processor
+/// @details Detected once, on the first call. Lowered by the
+/// HEXL_DISABLE_AVX512DQ and HEXL_DISABLE_AVX512IFMA environment variables
+Backend GetSupportedBackend();
+
+/// @brief Returns the fastest backend from which kernels are selected
+/// @details GetSupportedBackend(), unless overridden by SetBackend
+Backend GetBackend();
+
+/// @brief Restricts kernels to backends no faster than \p backend, e.g. to
+/// compare backends in benchmarks or to roll out a backend gradually
+/// @param[in] backend Backend no faster than GetSupportedBackend(). Otherwise,
+/// throws std::invalid_argument
+/// @details Affects subsequent calls from all threads. Objects which
+/// precompute data for a backend, such as NTT, need not be recreated
+void SetBackend(Backend backend);
+
+/// @brief Restores the backend to GetSupportedBackend(), undoing SetBackend
+void ResetBackend();
+
+/// @brief Returns the backend which \p kernel uses for \p modulus, given the
+/// current GetBackend()
+/// @details Assumes the input lengths are multiples of 8, NTT degrees are at
+/// least 16, inputs are fully reduced, and KeySwitch accumulates fewer than
+/// 4096 products. Other inputs may use a slower backend. Experimental kernels
+/// use the native backend unless HEXL_EXPERIMENTAL is enabled
+Backend GetKernelBackend(Kernel kernel, uint64_t modulus);
+
+}  // namespace hexl
+}  // namespace intel
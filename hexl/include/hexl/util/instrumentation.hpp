@@ -0,0 +1,79 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <array>
+#include <string>
+
+#include "hexl/util/dispatch.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Number of values of Kernel
+constexpr size_t kNumKernels = static_cast<size_t>(Kernel::kKeySwitch) + 1;
+
+/// @brief Number of values of Backend
+constexpr size_t kNumBackends = static_cast<size_t>(Backend::kAVX512IFMA) + 1;
+
+/// @brief Number of power-of-two bins in KernelStats::cycle_histogram
+constexpr size_t kNumCycleBins = 40;
+
+/// @brief Counters of one kernel, accumulated over all threads
+struct KernelStats {
+  uint64_t calls = 0;     ///< Number of calls
+  uint64_t elements = 0;  ///< Number of input coefficients processed
+  uint64_t bytes = 0;     ///< Bytes of operands read and results written
+  uint64_t cycles = 0;    ///< Total duration, in units of CycleCounterName()
+
+  /// @brief Number of calls which ran on each backend, indexed by Backend.
+  /// Calls counted under Backend::kNative on an AVX512 processor fell back
+  /// to the native implementation, e.g. for a large modulus or odd length
+  std::array<uint64_t, kNumBackends> backend_calls{};
+
+  /// @brief Number of calls lasting [2^i, 2^(i+1)) cycles in bin i. Bin 0
+  /// also holds calls of 0 cycles and the last bin holds all longer calls
+  std::array<uint64_t, kNumCycleBins> cycle_histogram{};
+};
+
+/// @brief Counters of all kernels at one point in time
+struct InstrumentationSnapshot {
+  /// @brief Counters indexed by Kernel
+  std::array<KernelStats, kNumKernels> kernels{};
+
+  /// @brief Returns the counters of \p kernel
+  const KernelStats& operator[](Kernel kernel) const {
+    return kernels[static_cast<size_t>(kernel)];
+  }
+};
+
+/// @brief Starts or stops recording kernel calls
+/// @details Disabled by default, unless the HEXL_ENABLE_INSTRUMENTATION
+/// environment variable is set. While disabled, each kernel call costs one
+/// relaxed atomic load. Counters are kept while disabled
+void EnableInstrumentation(bool enable = true);
+
+/// @brief Returns whether kernel calls are being recorded
+bool IsInstrumentationEnabled();
+
+/// @brief Returns a copy of the counters of all kernels
+/// @details Counters of calls still in progress on other threads may be
+/// partially updated
+InstrumentationSnapshot GetInstrumentationSnapshot();
+
+/// @brief Sets all counters to zero
+void ResetInstrumentation();
+
+/// @brief Returns the unit of KernelStats::cycles: "rdtsc" for the x86
+/// time-stamp counter, or "steady_clock_ns" for nanoseconds elsewhere
+const char* CycleCounterName();
+
+/// @brief Returns \p snapshot as a JSON object, keyed by KernelName(). Kernels
+/// which were never called are omitted
+std::string InstrumentationToJSON(const InstrumentationSnapshot& snapshot);
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,55 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "hexl/util/aligned-allocator.hpp"
+#include "hexl/util/allocator.hpp"
+
+namespace intel {
+namespace hexl {
+
+/// @brief Allocator which recycles freed blocks through a cache on each thread
+/// @details Sizes are rounded up to one of four size classes per power of two,
+/// so at most 25% of each block is unused. Freed blocks are kept in the cache
+/// of the freeing thread and reused by its next allocation of the same class,
+/// without locking. Blocks over MaxPooledBytes(), and blocks which would grow
+/// a cache beyond MaxCachedBytes(), are returned to malloc. Memory may be
+/// freed on a different thread than it was allocated on. All PoolAllocator
+/// objects share the caches, so they are interchangeable
+class PoolAllocator final : public AllocatorBase {
+ public:
+  void* allocate(size_t bytes_count) override;
+
+  void deallocate(void* p, size_t n) override;
+
+  /// @brief Returns the largest allocation which is pooled
+  static size_t MaxPooledBytes();
+
+  /// @brief Returns the bound on the free bytes cached by each thread
+  static size_t MaxCachedBytes();
+
+  /// @brief Returns the free bytes cached by the calling thread
+  static size_t ThreadCachedBytes();
+
+  /// @brief Returns the free blocks cached by the calling thread to malloc
+  /// @details Caches are also released when their thread exits
+  static void ReleaseThreadCache();
+};
+
+/// @brief Returns the PoolAllocator used for temporaries by NTT and the
+/// experimental kernels
+const std::shared_ptr<AllocatorBase>& GetPoolAllocator();
+
+/// @brief Returns an empty 64-byte aligned vector which allocates from
+/// GetPoolAllocator()
+template <typename T>
+inline AlignedVector64<T> MakePooledVector() {
+  return AlignedVector64<T>(AlignedAllocator<T, 64>(GetPoolAllocator()));
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,60 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "hexl/util/defines.hpp"
+#include "hexl/util/dispatch.hpp"
+
+#ifdef HEXL_TRACING
+
+namespace intel {
+namespace hexl {
+
+/// @brief Describes one kernel call to the trace hooks
+struct TraceEvent {
+  Kernel kernel;  ///< Kernel being called; see KernelName()
+
+  /// @brief In TraceHooks::begin, GetBackend(), i.e. the fastest backend the
+  /// kernel may select. In TraceHooks::end, the backend the call ran on
+  Backend backend;
+
+  uint64_t n;             ///< Length of each operand, or NTT degree
+  uint64_t num_moduli;    ///< Number of RNS limbs
+  uint64_t modulus_bits;  ///< Bit length of the largest modulus, or 0
+  uint64_t elements;      ///< Input coefficients over all limbs and batches
+  uint64_t duration_ns;   ///< Duration of the call in TraceHooks::end, else 0
+};
+
+/// @brief Callbacks around each call of NTT::ComputeForward,
+/// NTT::ComputeInverse, the Eltwise* kernels, DyadicMultiply and KeySwitch
+/// @details Called on the calling thread. Kernels which call other kernels,
+/// such as KeySwitch, produce nested spans. Callbacks must not throw
+struct TraceHooks {
+  /// @brief Called before the kernel runs. Returns a span, e.g. a pointer to
+  /// the caller's trace span object, which is passed to end. May be nullptr
+  void* (*begin)(const TraceEvent& event, void* user_data) = nullptr;
+
+  /// @brief Called after the kernel runs, with the span returned by begin. May
+  /// be nullptr
+  void (*end)(const TraceEvent& event, void* span, void* user_data) = nullptr;
+
+  /// @brief Passed to begin and end
+  void* user_data = nullptr;
+};
+
+/// @brief Installs \p hooks for subsequent kernel calls on all threads
+/// @param[in] hooks Hooks to install, or nullptr to remove the installed
+/// hooks. Must outlive all kernel calls which start while installed
+/// @details With no hooks installed, each kernel call costs one branch
+void SetTraceHooks(const TraceHooks* hooks);
+
+/// @brief Returns the installed hooks, or nullptr
+const TraceHooks* GetTraceHooks();
+
+}  // namespace hexl
+}  // namespace intel
+
+#endif
@@ -12,9 +12,12 @@
 #include "hexl/util/aligned-allocator.hpp"
 #include "hexl/util/check.hpp"
 #include "hexl/util/defines.hpp"
+#include "hexl/util/pool-allocator.hpp"
 #include "ntt/fwd-ntt-avx512.hpp"
 #include "ntt/inv-ntt-avx512.hpp"
 #include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+#include "util/instrumentation-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -52,9 +55,14 @@ NTT::NTT(uint64_t degree, uint64_t q, std::shared_ptr<AllocatorBase> alloc_ptr)
     : NTT(degree, q, MinimalPrimitiveRoot(2 * degree, q), alloc_ptr) {}
 
 void NTT::ComputeRootOfUnityPowers() {
-  AlignedVector64<uint64_t> root_of_unity_powers(m_degree, 0, m_aligned_alloc);
+  // Scratch tables come from the pool, unless the caller supplied an allocator
+  AlignedAllocator<uint64_t, 64> scratch_alloc =
+      (m_alloc == nullptr)
+          ? AlignedAllocator<uint64_t, 64>(GetPoolAllocator())
+          : m_aligned_alloc;
+  AlignedVector64<uint64_t> root_of_unity_powers(m_degree, 0, scratch_alloc);
   AlignedVector64<uint64_t> inv_root_of_unity_powers(m_degree, 0,
-                                                     m_aligned_alloc);
+                                                     scratch_alloc);
 
   // 64-bit preconditioned inverse and root of unity powers
   root_of_unity_powers[0] = 1;
@@ -78,7 +86,7 @@ void NTT::ComputeRootOfUnityPowers() {
   // These are the roots of unity used in the FwdNTT FwdT2 function
   // By creating these duplicates, we avoid extra permutations while loading the
   // roots of unity
-  AlignedVector64<uint64_t> W2_roots;
+  AlignedVector64<uint64_t> W2_roots(scratch_alloc);
   W2_roots.reserve(m_degree / 2);
   for (size_t i = m_degree / 4; i < m_degree / 2; ++i) {
     W2_roots.push_back(m_root_of_unity_powers[i]);
@@ -95,7 +103,7 @@ void NTT::ComputeRootOfUnityPowers() {
   // These are the roots of unity used in the FwdNTT FwdT4 function
   // By creating these duplicates, we avoid extra permutations while loading the
   // roots of unity
-  AlignedVector64<uint64_t> W4_roots;
+  AlignedVector64<uint64_t> W4_roots(scratch_alloc);
   W4_roots.reserve(m_degree / 2);
   for (size_t i = m_degree / 8; i < m_degree / 4; ++i) {
     W4_roots.push_back(m_root_of_unity_powers[i]);
@@ -113,6 +121,7 @@ void NTT::ComputeRootOfUnityPowers() {
   auto compute_barrett_vector = [&](const AlignedVector64<uint64_t>& values,
                                     uint64_t bit_shift) {
     AlignedVector64<uint64_t> barrett_vector(m_aligned_alloc);
+    barrett_vector.reserve(values.size());
     for (uint64_t value : values) {
       MultiplyFactor mf(value, bit_shift, m_q);
       barrett_vector.push_back(mf.BarrettFactor());
@@ -125,13 +134,17 @@ void NTT::ComputeRootOfUnityPowers() {
   m_precon64_root_of_unity_powers =
       compute_barrett_vector(root_of_unity_powers, 64);
 
+  // The AVX512 tables are computed if the processor supports the kernels
+  // which use them, even if SetBackend selects a slower backend
+  const CpuFeatures& features = GetCpuFeatures();
+
   // 52-bit preconditioned root of unity powers
-  if (has_avx512ifma) {
+  if (features.avx512ifma) {
     m_avx512_precon52_root_of_unity_powers =
         compute_barrett_vector(m_avx512_root_of_unity_powers, 52);
   }
 
-  if (has_avx512dq) {
+  if (features.avx512dq) {
     m_avx512_precon32_root_of_unity_powers =
         compute_barrett_vector(m_avx512_root_of_unity_powers, 32);
     m_avx512_precon64_root_of_unity_powers =
@@ -158,7 +171,7 @@ void NTT::ComputeRootOfUnityPowers() {
       compute_barrett_vector(m_inv_root_of_unity_powers, 32);
 
   // 52-bit preconditioned inverse root of unity powers
-  if (has_avx512ifma) {
+  if (features.avx512ifma) {
     m_precon52_inv_root_of_unity_powers =
         compute_barrett_vector(m_inv_root_of_unity_powers, 52);
   }
@@ -187,7 +200,7 @@ bool NTT::CheckArguments(uint64_t degree, uint64_t modulus) {
 
 void NTT::ComputeForward(uint64_t* result, const uint64_t* operand,
                          uint64_t input_mod_factor,
-                         uint64_t output_mod_factor) {
+                         uint64_t output_mod_factor) const {
   HEXL_CHECK(result != nullptr, "result == nullptr");
   HEXL_CHECK(operand != nullptr, "operand == nullptr");
   HEXL_CHECK(
@@ -199,59 +212,21 @@ void NTT::ComputeForward(uint64_t* result, const uint64_t* operand,
       operand, m_degree, m_q * input_mod_factor,
       "value in operand exceeds bound " << m_q * input_mod_factor);
 
-#ifdef HEXL_HAS_AVX512IFMA
-  if (has_avx512ifma && (m_q < s_max_fwd_ifma_modulus && (m_degree >= 16))) {
-    const uint64_t* root_of_unity_powers = GetAVX512RootOfUnityPowers().data();
-    const uint64_t* precon_root_of_unity_powers =
-        GetAVX512Precon52RootOfUnityPowers().data();
-
-    HEXL_VLOG(3, "Calling 52-bit AVX512-IFMA FwdNTT");
-    ForwardTransformToBitReverseAVX512<s_ifma_shift_bits>(
-        result, operand, m_degree, m_q, root_of_unity_powers,
-        precon_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    return;
-  }
-#endif
-
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq && m_degree >= 16) {
-    if (m_q < s_max_fwd_32_modulus) {
-      HEXL_VLOG(3, "Calling 32-bit AVX512-DQ FwdNTT");
-      const uint64_t* root_of_unity_powers =
-          GetAVX512RootOfUnityPowers().data();
-      const uint64_t* precon_root_of_unity_powers =
-          GetAVX512Precon32RootOfUnityPowers().data();
-      ForwardTransformToBitReverseAVX512<32>(
-          result, operand, m_degree, m_q, root_of_unity_powers,
-          precon_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    } else {
-      HEXL_VLOG(3, "Calling 64-bit AVX512-DQ FwdNTT");
-      const uint64_t* root_of_unity_powers =
-          GetAVX512RootOfUnityPowers().data();
-      const uint64_t* precon_root_of_unity_powers =
-          GetAVX512Precon64RootOfUnityPowers().data();
-
-      ForwardTransformToBitReverseAVX512<s_default_shift_bits>(
-          result, operand, m_degree, m_q, root_of_unity_powers,
-          precon_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    }
-    return;
-  }
-#endif
+  KernelTimer timer(Kernel::kForwardNTT, m_degree, &m_q, 1, m_degree,
+                    2 * m_degree * sizeof(uint64_t));
 
-  HEXL_VLOG(3, "Calling ForwardTransformToBitReverseRadix2");
-  const uint64_t* root_of_unity_powers = GetRootOfUnityPowers().data();
-  const uint64_t* precon_root_of_unity_powers =
-      GetPrecon64RootOfUnityPowers().data();
-
-  ForwardTransformToBitReverseRadix2(
-      result, operand, m_degree, m_q, root_of_unity_powers,
-      precon_root_of_unity_powers, input_mod_factor, output_mod_factor);
+  // The AVX512 transforms process at least 16 coefficients at a time
+  const DispatchTable& table =
+      (m_degree >= 16) ? GetDispatchTable() : GetNativeDispatchTable();
+  const auto& variant = table.forward_ntt.Select(m_q);
+  timer.SetBackend(variant.backend);
+  variant.function(*this, result, operand, input_mod_factor,
+                   output_mod_factor);
 }
 
 void NTT::ComputeInverse(uint64_t* result, const uint64_t* operand,
                          uint64_t input_mod_factor,
-                         uint64_t output_mod_factor) {
+                         uint64_t output_mod_factor) const {
   HEXL_CHECK(result != nullptr, "result == nullptr");
   HEXL_CHECK(operand != nullptr, "operand == nullptr");
   HEXL_CHECK(input_mod_factor == 1 || input_mod_factor == 2,
@@ -261,53 +236,95 @@ void NTT::ComputeInverse(uint64_t* result, const uint64_t* operand,
   HEXL_CHECK_BOUNDS(operand, m_degree, m_q * input_mod_factor,
                     "operand exceeds bound " << m_q * input_mod_factor);
 
-#ifdef HEXL_HAS_AVX512IFMA
-  if (has_avx512ifma && (m_q < s_max_inv_ifma_modulus) && (m_degree >= 16)) {
-    HEXL_VLOG(3, "Calling 52-bit AVX512-IFMA InvNTT");
-    const uint64_t* inv_root_of_unity_powers = GetInvRootOfUnityPowers().data();
-    const uint64_t* precon_inv_root_of_unity_powers =
-        GetPrecon52InvRootOfUnityPowers().data();
-    InverseTransformFromBitReverseAVX512<s_ifma_shift_bits>(
-        result, operand, m_degree, m_q, inv_root_of_unity_powers,
-        precon_inv_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    return;
-  }
-#endif
+  KernelTimer timer(Kernel::kInverseNTT, m_degree, &m_q, 1, m_degree,
+                    2 * m_degree * sizeof(uint64_t));
 
-#ifdef HEXL_HAS_AVX512DQ
-  if (has_avx512dq && m_degree >= 16) {
-    if (m_q < s_max_inv_32_modulus) {
-      HEXL_VLOG(3, "Calling 32-bit AVX512-DQ InvNTT");
-      const uint64_t* inv_root_of_unity_powers =
-          GetInvRootOfUnityPowers().data();
-      const uint64_t* precon_inv_root_of_unity_powers =
-          GetPrecon32InvRootOfUnityPowers().data();
-      InverseTransformFromBitReverseAVX512<32>(
-          result, operand, m_degree, m_q, inv_root_of_unity_powers,
-          precon_inv_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    } else {
-      HEXL_VLOG(3, "Calling 64-bit AVX512 InvNTT");
-      const uint64_t* inv_root_of_unity_powers =
-          GetInvRootOfUnityPowers().data();
-      const uint64_t* precon_inv_root_of_unity_powers =
-          GetPrecon64InvRootOfUnityPowers().data();
-
-      InverseTransformFromBitReverseAVX512<s_default_shift_bits>(
-          result, operand, m_degree, m_q, inv_root_of_unity_powers,
-          precon_inv_root_of_unity_powers, input_mod_factor, output_mod_factor);
-    }
-    return;
-  }
-#endif
+  const DispatchTable& table =
+      (m_degree >= 16) ? GetDispatchTable() : GetNativeDispatchTable();
+  const auto& variant = table.inverse_ntt.Select(m_q);
+  timer.SetBackend(variant.backend);
+  variant.function(*this, result, operand, input_mod_factor,
+                   output_mod_factor);
+}
 
+void ComputeForwardRadix2(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor) {
+  HEXL_VLOG(3, "Calling ForwardTransformToBitReverseRadix2");
+  ForwardTransformToBitReverseRadix2(
+      result, operand, ntt.GetDegree(), ntt.GetModulus(),
+      ntt.GetRootOfUnityPowers().data(),
+      ntt.GetPrecon64RootOfUnityPowers().data(), input_mod_factor,
+      output_mod_factor);
+}
+
+void ComputeInverseRadix2(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor) {
   HEXL_VLOG(3, "Calling 64-bit default InvNTT");
-  const uint64_t* inv_root_of_unity_powers = GetInvRootOfUnityPowers().data();
-  const uint64_t* precon_inv_root_of_unity_powers =
-      GetPrecon64InvRootOfUnityPowers().data();
   InverseTransformFromBitReverseRadix2(
-      result, operand, m_degree, m_q, inv_root_of_unity_powers,
-      precon_inv_root_of_unity_powers, input_mod_factor, output_mod_factor);
+      result, operand, ntt.GetDegree(), ntt.GetModulus(),
+      ntt.GetInvRootOfUnityPowers().data(),
+      ntt.GetPrecon64InvRootOfUnityPowers().data(), input_mod_factor,
+      output_mod_factor);
 }
 
+#ifdef HEXL_HAS_AVX512DQ
+template <int BitShift>
+void ComputeForwardAVX512(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor) {
+  HEXL_VLOG(3, "Calling " << BitShift << "-bit AVX512 FwdNTT");
+  const AlignedVector64<uint64_t>& precon_root_of_unity_powers =
+      (BitShift == 32)   ? ntt.GetAVX512Precon32RootOfUnityPowers()
+      : (BitShift == 52) ? ntt.GetAVX512Precon52RootOfUnityPowers()
+                         : ntt.GetAVX512Precon64RootOfUnityPowers();
+  ForwardTransformToBitReverseAVX512<BitShift>(
+      result, operand, ntt.GetDegree(), ntt.GetModulus(),
+      ntt.GetAVX512RootOfUnityPowers().data(),
+      precon_root_of_unity_powers.data(), input_mod_factor, output_mod_factor);
+}
+
+template <int BitShift>
+void ComputeInverseAVX512(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor) {
+  HEXL_VLOG(3, "Calling " << BitShift << "-bit AVX512 InvNTT");
+  const AlignedVector64<uint64_t>& precon_inv_root_of_unity_powers =
+      (BitShift == 32)   ? ntt.GetPrecon32InvRootOfUnityPowers()
+      : (BitShift == 52) ? ntt.GetPrecon52InvRootOfUnityPowers()
+                         : ntt.GetPrecon64InvRootOfUnityPowers();
+  InverseTransformFromBitReverseAVX512<BitShift>(
+      result, operand, ntt.GetDegree(), ntt.GetModulus(),
+      ntt.GetInvRootOfUnityPowers().data(),
+      precon_inv_root_of_unity_powers.data(), input_mod_factor,
+      output_mod_factor);
+}
+
+template void ComputeForwardAVX512<32>(const NTT& ntt, uint64_t* result,
+                                       const uint64_t* operand,
+                                       uint64_t input_mod_factor,
+                                       uint64_t output_mod_factor);
+template void ComputeForwardAVX512<NTT::s_default_shift_bits>(
+    const NTT& ntt, uint64_t* result, const uint64_t* operand,
+    uint64_t input_mod_factor, uint64_t output_mod_factor);
+template void ComputeInverseAVX512<32>(const NTT& ntt, uint64_t* result,
+                                       const uint64_t* operand,
+                                       uint64_t input_mod_factor,
+                                       uint64_t output_mod_factor);
+template void ComputeInverseAVX512<NTT::s_default_shift_bits>(
+    const NTT& ntt, uint64_t* result, const uint64_t* operand,
+    uint64_t input_mod_factor, uint64_t output_mod_factor);
+#endif
+
+#ifdef HEXL_HAS_AVX512IFMA
+template void ComputeForwardAVX512<NTT::s_ifma_shift_bits>(
+    const NTT& ntt, uint64_t* result, const uint64_t* operand,
+    uint64_t input_mod_factor, uint64_t output_mod_factor);
+template void ComputeInverseAVX512<NTT::s_ifma_shift_bits>(
+    const NTT& ntt, uint64_t* result, const uint64_t* operand,
+    uint64_t input_mod_factor, uint64_t output_mod_factor);
+#endif
+
 }  // namespace hexl
 }  // namespace intel
@@ -121,5 +121,41 @@ void InverseTransformFromBitReverseRadix4(
     const uint64_t* precon_root_of_unity_powers, uint64_t input_mod_factor = 1,
     uint64_t output_mod_factor = 1);
 
+/// @brief Computes the forward NTT of \p ntt with
+/// ForwardTransformToBitReverseRadix2
+/// @details Parameters are as in NTT::ComputeForward
+void ComputeForwardRadix2(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor);
+
+/// @brief Computes the inverse NTT of \p ntt with
+/// InverseTransformFromBitReverseRadix2
+/// @details Parameters are as in NTT::ComputeInverse
+void ComputeInverseRadix2(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor);
+
+#ifdef HEXL_HAS_AVX512DQ
+/// @brief Computes the forward NTT of \p ntt with
+/// ForwardTransformToBitReverseAVX512 and the root of unity powers
+/// preconditioned for \p BitShift
+/// @details Parameters are as in NTT::ComputeForward. The degree of \p ntt
+/// must be at least 16
+template <int BitShift>
+void ComputeForwardAVX512(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor);
+
+/// @brief Computes the inverse NTT of \p ntt with
+/// InverseTransformFromBitReverseAVX512 and the inverse root of unity powers
+/// preconditioned for \p BitShift
+/// @details Parameters are as in NTT::ComputeInverse. The degree of \p ntt
+/// must be at least 16
+template <int BitShift>
+void ComputeInverseAVX512(const NTT& ntt, uint64_t* result,
+                          const uint64_t* operand, uint64_t input_mod_factor,
+                          uint64_t output_mod_factor);
+#endif
+
 }  // namespace hexl
 }  // namespace intel
@@ -9,7 +9,6 @@
 #include "hexl/util/aligned-allocator.hpp"
 #include "hexl/util/check.hpp"
 #include "ntt/ntt-default.hpp"
-#include "util/cpu-features.hpp"
 
 namespace intel {
 namespace hexl {
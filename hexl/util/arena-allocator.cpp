@@ -0,0 +1,115 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/arena-allocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "hexl/util/check.hpp"
+#include "hexl/util/defines.hpp"
+
+namespace intel {
+namespace hexl {
+
+namespace {
+
+constexpr size_t kArenaAlignment = 64;
+
+inline size_t RoundUpToAlignment(size_t bytes) {
+  return (bytes + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+}  // namespace
+
+ArenaAllocator::ArenaAllocator(size_t block_size)
+    : m_block_size(RoundUpToAlignment(std::max(block_size, kArenaAlignment))) {}
+
+ArenaAllocator::~ArenaAllocator() {
+  for (const Block& block : m_blocks) {
+    std::free(block.raw);
+  }
+}
+
+void ArenaAllocator::AddBlock(size_t size) {
+  void* raw = std::malloc(size + kArenaAlignment - 1);
+  if (raw == nullptr) {
+    return;
+  }
+  uintptr_t address = reinterpret_cast<uintptr_t>(raw);
+  address = (address + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+  m_blocks.push_back(Block{raw, reinterpret_cast<char*>(address), size});
+}
+
+void* ArenaAllocator::allocate(size_t bytes_count) {
+  size_t bytes = RoundUpToAlignment(std::max(bytes_count, size_t(1)));
+  if (m_current < m_blocks.size() &&
+      m_offset + bytes <= m_blocks[m_current].size) {
+    void* result = m_blocks[m_current].data + m_offset;
+    m_offset += bytes;
+    return result;
+  }
+
+  // Move to the first later block which fits, or else a new block
+  size_t next = m_blocks.empty() ? 0 : m_current + 1;
+  while (next < m_blocks.size() && m_blocks[next].size < bytes) {
+    ++next;
+  }
+  if (next == m_blocks.size()) {
+    AddBlock(std::max(m_block_size, bytes));
+    if (next == m_blocks.size()) {
+      return nullptr;
+    }
+  }
+  m_current = next;
+  m_offset = bytes;
+  return m_blocks[m_current].data;
+}
+
+void ArenaAllocator::deallocate(void* p, size_t n) {
+  HEXL_UNUSED(p);
+  HEXL_UNUSED(n);
+}
+
+void ArenaAllocator::Rewind(const Mark& mark) {
+  HEXL_CHECK(mark.block < m_current ||
+                 (mark.block == m_current && mark.offset <= m_offset),
+             "Mark (" << mark.block << ", " << mark.offset
+                      << ") is ahead of the arena position (" << m_current
+                      << ", " << m_offset << ")");
+  m_current = mark.block;
+  m_offset = mark.offset;
+}
+
+void ArenaAllocator::Reset() {
+  if (m_blocks.size() > 1) {
+    size_t capacity = Capacity();
+    for (const Block& block : m_blocks) {
+      std::free(block.raw);
+    }
+    m_blocks.clear();
+    AddBlock(capacity);
+  }
+  m_current = 0;
+  m_offset = 0;
+}
+
+size_t ArenaAllocator::BytesUsed() const {
+  size_t bytes = m_offset;
+  for (size_t i = 0; i < m_current && i < m_blocks.size(); ++i) {
+    bytes += m_blocks[i].size;
+  }
+  return bytes;
+}
+
+size_t ArenaAllocator::Capacity() const {
+  size_t capacity = 0;
+  for (const Block& block : m_blocks) {
+    capacity += block.size;
+  }
+  return capacity;
+}
+
+}  // namespace hexl
+}  // namespace intel
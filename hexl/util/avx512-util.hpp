@@ -508,14 +508,16 @@ inline __m512i _mm512_hexl_shrdi_epi64(__m512i x, __m512i y,
 
 // Concatenate packed 64-bit integers in x and y, producing an intermediate
 // 128-bit result. Shift the result right by BitShift bits, and return the lower
-// 64 bits.
-template <int BitShift>
+// 64 bits. UseVBMI2 selects the AVX512-VBMI2 instruction, which must then be
+// enabled for the calling translation unit
+template <int BitShift, bool UseVBMI2 = false>
 inline __m512i _mm512_hexl_shrdi_epi64(__m512i x, __m512i y) {
 #ifdef HEXL_HAS_AVX512VBMI2
-  return _mm512_shrdi_epi64(x, y, BitShift);
-#else
-  return _mm512_hexl_shrdi_epi64(x, y, BitShift);
+  if constexpr (UseVBMI2) {
+    return _mm512_shrdi_epi64(x, y, BitShift);
+  }
 #endif
+  return _mm512_hexl_shrdi_epi64(x, y, BitShift);
 }
 
 #endif  // HEXL_HAS_AVX512DQ
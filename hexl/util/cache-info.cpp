@@ -0,0 +1,100 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/cache-info.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#include "cpuinfo_x86.h"  // NOLINT(build/include_subdir)
+#include "hexl/util/check.hpp"
+
+namespace intel {
+namespace hexl {
+
+struct CacheSizes {
+  // Typical of recent Xeon processors; used where detection fails
+  uint64_t l1_data = 32 * 1024;
+  uint64_t l2 = 1024 * 1024;
+};
+
+// Returns the value of an environment variable holding a size in bytes, or 0
+// if unset or invalid
+inline uint64_t GetCacheSizeFromEnv(const char* name) {
+  const char* value = std::getenv(name);
+  if (value == nullptr) {
+    return 0;
+  }
+  return std::strtoull(value, nullptr, 10);
+}
+
+inline CacheSizes DetectCacheSizes() {
+  CacheSizes sizes;
+  cpu_features::CacheInfo info = cpu_features::GetX86CacheInfo();
+  for (int i = 0; i < info.size; ++i) {
+    const cpu_features::CacheLevelInfo& level = info.levels[i];
+    if (level.cache_size <= 0) {
+      continue;
+    }
+    bool data = level.cache_type == cpu_features::CPU_FEATURE_CACHE_DATA ||
+                level.cache_type == cpu_features::CPU_FEATURE_CACHE_UNIFIED;
+    if (data && level.level == 1) {
+      sizes.l1_data = static_cast<uint64_t>(level.cache_size);
+    } else if (data && level.level == 2) {
+      sizes.l2 = static_cast<uint64_t>(level.cache_size);
+    }
+  }
+
+  uint64_t l1_data_from_env = GetCacheSizeFromEnv("HEXL_L1D_CACHE_SIZE");
+  if (l1_data_from_env != 0) {
+    sizes.l1_data = l1_data_from_env;
+  }
+  uint64_t l2_from_env = GetCacheSizeFromEnv("HEXL_L2_CACHE_SIZE");
+  if (l2_from_env != 0) {
+    sizes.l2 = l2_from_env;
+  }
+  return sizes;
+}
+
+inline const CacheSizes& DetectedCacheSizes() {
+  static const CacheSizes sizes = DetectCacheSizes();
+  return sizes;
+}
+
+// Overrides set by SetCacheSizes; 0 if unset
+static std::atomic<uint64_t> l1_data_cache_size_override{0};
+static std::atomic<uint64_t> l2_cache_size_override{0};
+
+uint64_t GetL1DataCacheSize() {
+  uint64_t size = l1_data_cache_size_override.load(std::memory_order_relaxed);
+  return (size != 0) ? size : DetectedCacheSizes().l1_data;
+}
+
+uint64_t GetL2CacheSize() {
+  uint64_t size = l2_cache_size_override.load(std::memory_order_relaxed);
+  return (size != 0) ? size : DetectedCacheSizes().l2;
+}
+
+void SetCacheSizes(uint64_t l1_data_cache_size, uint64_t l2_cache_size) {
+  l1_data_cache_size_override.store(l1_data_cache_size,
+                                    std::memory_order_relaxed);
+  l2_cache_size_override.store(l2_cache_size, std::memory_order_relaxed);
+}
+
+uint64_t CacheTileSize(uint64_t n, uint64_t cache_size,
+                       uint64_t words_per_coeff) {
+  HEXL_CHECK(n != 0, "Require n != 0");
+  HEXL_CHECK(words_per_coeff != 0, "Require words_per_coeff != 0");
+
+  const uint64_t min_tile_size = 64;
+  uint64_t max_tile_size = cache_size / (words_per_coeff * sizeof(uint64_t));
+  uint64_t tile_size = min_tile_size;
+  while (2 * tile_size <= max_tile_size) {
+    tile_size *= 2;
+  }
+  return std::min(n, tile_size);
+}
+
+}  // namespace hexl
+}  // namespace intel
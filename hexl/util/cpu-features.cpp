@@ -0,0 +1,37 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "util/cpu-features.hpp"
+
+#include <cstdlib>
+
+#include "cpuinfo_x86.h"  // NOLINT(build/include_subdir)
+
+namespace intel {
+namespace hexl {
+
+inline CpuFeatures DetectCpuFeatures() {
+  // Use to disable avx512 dispatching at runtime
+  bool disable_avx512dq = std::getenv("HEXL_DISABLE_AVX512DQ") != nullptr;
+  bool disable_avx512ifma =
+      disable_avx512dq || (std::getenv("HEXL_DISABLE_AVX512IFMA") != nullptr);
+  bool disable_avx512vbmi2 =
+      disable_avx512dq || (std::getenv("HEXL_DISABLE_AVX512VBMI2") != nullptr);
+
+  cpu_features::X86Features features = cpu_features::GetX86Info().features;
+
+  CpuFeatures result;
+  result.avx512dq = features.avx512f && features.avx512dq &&
+                    features.avx512vl && !disable_avx512dq;
+  result.avx512ifma = features.avx512ifma && !disable_avx512ifma;
+  result.avx512vbmi2 = features.avx512vbmi2 && !disable_avx512vbmi2;
+  return result;
+}
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -5,31 +5,20 @@
 
 #include <stdbool.h>
 
-#include <cstdlib>
-
-#include "cpuinfo_x86.h"  // NOLINT(build/include_subdir)
-
 namespace intel {
 namespace hexl {
 
-// Use to disable avx512 dispatching at runtime
-static const bool disable_avx512dq =
-    (std::getenv("HEXL_DISABLE_AVX512DQ") != nullptr);
-static const bool disable_avx512ifma =
-    disable_avx512dq || (std::getenv("HEXL_DISABLE_AVX512IFMA") != nullptr);
-static const bool disable_avx512vbmi2 =
-    disable_avx512dq || (std::getenv("HEXL_DISABLE_AVX512VBMI2") != nullptr);
-
-static const cpu_features::X86Features features =
-    cpu_features::GetX86Info().features;
-
-static const bool has_avx512dq = features.avx512f && features.avx512dq &&
-                                 features.avx512vl && !disable_avx512dq;
-
-static const bool has_avx512ifma = features.avx512ifma && !disable_avx512ifma;
-
-static const bool has_avx512vbmi2 =
-    features.avx512vbmi2 && !disable_avx512vbmi2;
+/// @brief AVX512 extensions of the processor, less those disabled by the
+/// HEXL_DISABLE_AVX512DQ, HEXL_DISABLE_AVX512IFMA and HEXL_DISABLE_AVX512VBMI2
+/// environment variables
+struct CpuFeatures {
+  bool avx512dq;
+  bool avx512ifma;
+  bool avx512vbmi2;
+};
+
+/// @brief Returns the processor features, detected once on the first call
+const CpuFeatures& GetCpuFeatures();
 
 }  // namespace hexl
 }  // namespace intel
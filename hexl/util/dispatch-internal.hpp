@@ -0,0 +1,183 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hexl/util/defines.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/util.hpp"
+
+namespace intel {
+namespace hexl {
+
+class NTT;
+
+/// @brief Implementation of a kernel for one class of moduli
+template <typename Function>
+struct KernelVariant {
+  // Selected for moduli less than max_modulus
+  uint64_t max_modulus;
+  // Entry point. nullptr where the kernel's element-wise fallback is faster
+  Function function;
+  // Backend the entry point runs on
+  Backend backend;
+};
+
+/// @brief Implementations of a kernel for each class of moduli, in order of
+/// preference
+/// @details Select returns the first variant whose max_modulus exceeds the
+/// modulus, or the last variant, which takes all remaining moduli. Unused
+/// leading variants have max_modulus 0
+template <typename Function, size_t NumVariants>
+struct KernelVariants {
+  KernelVariant<Function> variants[NumVariants];
+
+  const KernelVariant<Function>& Select(uint64_t modulus) const {
+    for (size_t i = 0; i + 1 < NumVariants; ++i) {
+      if (modulus < variants[i].max_modulus) {
+        return variants[i];
+      }
+    }
+    return variants[NumVariants - 1];
+  }
+};
+
+using EltwiseBinaryModFunction = void (*)(uint64_t* result,
+                                          const uint64_t* operand1,
+                                          const uint64_t* operand2, uint64_t n,
+                                          uint64_t modulus);
+using EltwiseScalarModFunction = void (*)(uint64_t* result,
+                                          const uint64_t* operand1,
+                                          uint64_t operand2, uint64_t n,
+                                          uint64_t modulus);
+using EltwiseCmpAddFunction = void (*)(uint64_t* result,
+                                       const uint64_t* operand1, uint64_t n,
+                                       CMPINT cmp, uint64_t bound,
+                                       uint64_t diff);
+using EltwiseCmpSubModFunction = void (*)(uint64_t* result,
+                                          const uint64_t* operand1, uint64_t n,
+                                          uint64_t modulus, CMPINT cmp,
+                                          uint64_t bound, uint64_t diff);
+using EltwiseFMAModFunction = void (*)(uint64_t* result, const uint64_t* arg1,
+                                       uint64_t arg2, const uint64_t* arg3,
+                                       uint64_t n, uint64_t modulus,
+                                       uint64_t input_mod_factor);
+using EltwiseMultModFunction = void (*)(uint64_t* result,
+                                        const uint64_t* operand1,
+                                        const uint64_t* operand2, uint64_t n,
+                                        uint64_t modulus,
+                                        uint64_t input_mod_factor);
+using EltwiseReduceModFunction = void (*)(uint64_t* result,
+                                          const uint64_t* operand, uint64_t n,
+                                          uint64_t modulus,
+                                          uint64_t input_mod_factor,
+                                          uint64_t output_mod_factor);
+using NTTFunction = void (*)(const NTT& ntt, uint64_t* result,
+                             const uint64_t* operand,
+                             uint64_t input_mod_factor,
+                             uint64_t output_mod_factor);
+
+#ifdef HEXL_EXPERIMENTAL
+using DyadicMultiplyBatchFunction =
+    void (*)(uint64_t* const* results, const uint64_t* const* operand1s,
+             const uint64_t* const* operand2s, uint64_t batch_size,
+             uint64_t offset, uint64_t n, uint64_t poly_size,
+             uint64_t modulus);
+using DyadicMultiplyAccumulateFunction =
+    void (*)(uint64_t* result, const uint64_t* operand1,
+             const uint64_t* operand2, uint64_t num_pairs,
+             uint64_t pair_stride, uint64_t n, uint64_t poly_size,
+             uint64_t modulus);
+using PlainMultiplyAccumulateFunction =
+    void (*)(uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+             uint64_t n, uint64_t poly_size, uint64_t modulus);
+using PlainMultiplyAccumulateShoupFunction =
+    void (*)(uint64_t* result, const uint64_t* plain,
+             const uint64_t* plain_shoup, const uint64_t* cipher, uint64_t n,
+             uint64_t poly_size, uint64_t modulus);
+using DiagonalMultiplyAccumulateFunction =
+    void (*)(uint64_t* result, const uint64_t* plain, const uint64_t* cipher,
+             uint64_t num_terms, uint64_t plain_stride, uint64_t cipher_stride,
+             uint64_t n, uint64_t poly_size, uint64_t modulus);
+using DyadicTensorProductFunction =
+    void (*)(uint64_t* result, const uint64_t* operand1,
+             uint64_t operand1_size, const uint64_t* operand2,
+             uint64_t operand2_size, uint64_t n, uint64_t poly_size,
+             uint64_t modulus);
+using DyadicTensorSquareFunction =
+    void (*)(uint64_t* result, const uint64_t* operand, uint64_t operand_size,
+             uint64_t n, uint64_t poly_size, uint64_t modulus);
+using KeySwitchModDownPrepareFunction =
+    void (*)(uint64_t* result, const uint64_t* special, uint64_t n,
+             uint64_t special_modulus, uint64_t modulus);
+using KeySwitchModDownAccumulateFunction =
+    void (*)(uint64_t* result, const uint64_t* operand,
+             const uint64_t* special, uint64_t n, uint64_t modulus,
+             uint64_t modswitch_factor);
+
+/// @brief Inner product kernels of KeySwitch for one accumulator radix
+struct KeySwitchAccumulator {
+  int bit_shift;
+  void (*multiply_accumulate)(uint64_t* acc_hi, uint64_t* acc_lo,
+                              const uint64_t* operand, const uint64_t* key,
+                              uint64_t n);
+  void (*reduce)(uint64_t* result, const uint64_t* acc_hi,
+                 const uint64_t* acc_lo, uint64_t n, uint64_t modulus);
+};
+#endif
+
+/// @brief Kernels resolved for one backend
+/// @details Each kernel selects its entry point and the backend it reports
+/// from its variants, so the modulus classes of the kernels are defined here
+/// only. Kernels whose vectorized entry points require a minimum or a
+/// multiple of the input size use GetNativeDispatchTable() for other sizes
+struct DispatchTable {
+  Backend backend;
+
+  KernelVariants<EltwiseBinaryModFunction, 1> eltwise_add_mod;
+  KernelVariants<EltwiseScalarModFunction, 1> eltwise_add_mod_scalar;
+  KernelVariants<EltwiseBinaryModFunction, 1> eltwise_sub_mod;
+  KernelVariants<EltwiseScalarModFunction, 1> eltwise_sub_mod_scalar;
+  KernelVariants<EltwiseCmpAddFunction, 1> eltwise_cmp_add;
+  // Selected by input_mod_factor * modulus
+  KernelVariants<EltwiseFMAModFunction, 2> eltwise_fma_mod;
+  KernelVariants<EltwiseMultModFunction, 2> eltwise_mult_mod;
+  KernelVariants<EltwiseReduceModFunction, 2> eltwise_reduce_mod;
+  KernelVariants<EltwiseCmpSubModFunction, 2> eltwise_cmp_sub_mod;
+  // Require a degree of at least 16
+  KernelVariants<NTTFunction, 3> forward_ntt;
+  KernelVariants<NTTFunction, 3> inverse_ntt;
+
+#ifdef HEXL_EXPERIMENTAL
+  // Require n to be a multiple of 8
+  KernelVariants<DyadicMultiplyBatchFunction, 3> dyadic_multiply;
+  KernelVariants<DyadicMultiplyBatchFunction, 2> dyadic_multiply_karatsuba;
+  KernelVariants<DyadicMultiplyAccumulateFunction, 2>
+      dyadic_multiply_accumulate;
+  KernelVariants<PlainMultiplyAccumulateFunction, 3> plain_multiply_accumulate;
+  KernelVariants<PlainMultiplyAccumulateShoupFunction, 2>
+      plain_multiply_accumulate_shoup;
+  KernelVariants<DiagonalMultiplyAccumulateFunction, 2>
+      diagonal_multiply_accumulate;
+  KernelVariants<DyadicTensorProductFunction, 3> dyadic_tensor_product;
+  KernelVariants<DyadicTensorSquareFunction, 3> dyadic_tensor_square;
+  KernelVariants<KeySwitchAccumulator, 2> key_switch_accumulate;
+  KernelVariants<KeySwitchModDownPrepareFunction, 1>
+      key_switch_mod_down_prepare;
+  KernelVariants<KeySwitchModDownAccumulateFunction, 2>
+      key_switch_mod_down_accumulate;
+#endif
+};
+
+/// @brief Returns the table for GetBackend(), resolved on the first call and
+/// on each SetBackend or ResetBackend
+const DispatchTable& GetDispatchTable();
+
+/// @brief Returns the table of the native backend
+const DispatchTable& GetNativeDispatchTable();
+
+}  // namespace hexl
+}  // namespace intel
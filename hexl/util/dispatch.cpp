@@ -0,0 +1,435 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/dispatch.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include "eltwise/eltwise-add-mod-avx512.hpp"
+#include "eltwise/eltwise-add-mod-internal.hpp"
+#include "eltwise/eltwise-cmp-add-avx512.hpp"
+#include "eltwise/eltwise-cmp-add-internal.hpp"
+#include "eltwise/eltwise-cmp-sub-mod-avx512.hpp"
+#include "eltwise/eltwise-cmp-sub-mod-internal.hpp"
+#include "eltwise/eltwise-fma-mod-avx512.hpp"
+#include "eltwise/eltwise-fma-mod-internal.hpp"
+#include "eltwise/eltwise-mult-mod-avx512.hpp"
+#include "eltwise/eltwise-mult-mod-internal.hpp"
+#include "eltwise/eltwise-reduce-mod-avx512.hpp"
+#include "eltwise/eltwise-reduce-mod-internal.hpp"
+#include "eltwise/eltwise-sub-mod-avx512.hpp"
+#include "eltwise/eltwise-sub-mod-internal.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/util/defines.hpp"
+#include "ntt/ntt-internal.hpp"
+#include "util/cpu-features.hpp"
+#include "util/dispatch-internal.hpp"
+
+#ifdef HEXL_EXPERIMENTAL
+#include "experimental/seal/dyadic-multiply-avx512.hpp"
+#include "experimental/seal/key-switch-avx512.hpp"
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+#endif
+
+namespace intel {
+namespace hexl {
+
+// Max modulus of the last variant of each kernel, which is selected for all
+// remaining moduli
+static constexpr uint64_t kAllModuli = ~uint64_t(0);
+
+// The tables hold only constants, so are initialized before any code runs.
+// Variants with max_modulus 0 are never selected, and pad the leading
+// variants of kernels with fewer classes of moduli on a backend
+static const DispatchTable native_table = {
+    Backend::kNative,
+    {{{kAllModuli, EltwiseAddModNative, Backend::kNative}}},
+    {{{kAllModuli, EltwiseAddModNative, Backend::kNative}}},
+    {{{kAllModuli, EltwiseSubModNative, Backend::kNative}}},
+    {{{kAllModuli, EltwiseSubModNative, Backend::kNative}}},
+    {{{kAllModuli, EltwiseCmpAddNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseFMAModNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseMultModNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseReduceModNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseCmpSubModNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, ComputeForwardRadix2, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, ComputeInverseRadix2, Backend::kNative}}},
+#ifdef HEXL_EXPERIMENTAL
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicMultiplyFusedNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicMultiplyKaratsubaNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicMultiplyAccumulateNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, internal::PlainMultiplyAccumulateNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::PlainMultiplyAccumulateNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DiagonalMultiplyAccumulateNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicTensorProductNative, Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicTensorSquareNative, Backend::kNative}}},
+    {{{0, {}, Backend::kNative},
+      {kAllModuli,
+       {64, internal::KeySwitchMultiplyAccumulateNative,
+        internal::KeySwitchReduceNative},
+       Backend::kNative}}},
+    {{{kAllModuli, internal::KeySwitchModDownPrepareNative,
+       Backend::kNative}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::KeySwitchModDownAccumulateNative,
+       Backend::kNative}}},
+#endif
+};
+
+#ifdef HEXL_HAS_AVX512DQ
+static const DispatchTable avx512dq_table = {
+    Backend::kAVX512DQ,
+    {{{kAllModuli, EltwiseAddModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseAddModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseSubModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseSubModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseCmpAddAVX512, Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseFMAModAVX512<64>, Backend::kAVX512DQ}}},
+    // The floating-point multiplication is faster for small moduli
+    {{{1ULL << 50, EltwiseMultModAVX512Float, Backend::kAVX512DQ},
+      {kAllModuli, EltwiseMultModAVX512DQInt, Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseReduceModAVX512<64>, Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, EltwiseCmpSubModAVX512<64>, Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {NTT::s_max_fwd_32_modulus, ComputeForwardAVX512<32>,
+       Backend::kAVX512DQ},
+      {kAllModuli, ComputeForwardAVX512<NTT::s_default_shift_bits>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {NTT::s_max_inv_32_modulus, ComputeInverseAVX512<32>,
+       Backend::kAVX512DQ},
+      {kAllModuli, ComputeInverseAVX512<NTT::s_default_shift_bits>,
+       Backend::kAVX512DQ}}},
+#ifdef HEXL_EXPERIMENTAL
+    // EltwiseMultMod uses faster floating-point multiplication for moduli
+    // less than 2^50. Each 64-bit product takes several multiplications, so
+    // Karatsuba multiplication is used for larger moduli even if not requested
+    {{{0, nullptr, Backend::kNative},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicMultiplyKaratsubaAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicMultiplyKaratsubaAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DyadicMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::PlainMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::PlainMultiplyAccumulateShoupAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::DiagonalMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicTensorProductAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicTensorSquareAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{0, {}, Backend::kNative},
+      {kAllModuli,
+       {64, internal::KeySwitchMultiplyAccumulateAVX512<64>,
+        internal::KeySwitchReduceAVX512<64>},
+       Backend::kAVX512DQ}}},
+    {{{kAllModuli, internal::KeySwitchModDownPrepareAVX512,
+       Backend::kAVX512DQ}}},
+    {{{0, nullptr, Backend::kNative},
+      {kAllModuli, internal::KeySwitchModDownAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+#endif
+};
+#endif
+
+#ifdef HEXL_HAS_AVX512IFMA
+// As avx512dq_table, with the 52-bit variants for the moduli for which the
+// AVX512-IFMA52 instructions are faster. EltwiseMultMod prefers the
+// floating-point AVX512-DQ multiplication to AVX512-IFMA52
+static const DispatchTable avx512ifma_table = {
+    Backend::kAVX512IFMA,
+    {{{kAllModuli, EltwiseAddModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseAddModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseSubModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseSubModAVX512, Backend::kAVX512DQ}}},
+    {{{kAllModuli, EltwiseCmpAddAVX512, Backend::kAVX512DQ}}},
+    {{{1ULL << 52, EltwiseFMAModAVX512<52>, Backend::kAVX512IFMA},
+      {kAllModuli, EltwiseFMAModAVX512<64>, Backend::kAVX512DQ}}},
+    {{{1ULL << 50, EltwiseMultModAVX512Float, Backend::kAVX512DQ},
+      {kAllModuli, EltwiseMultModAVX512DQInt, Backend::kAVX512DQ}}},
+    {{{1ULL << 52, EltwiseReduceModAVX512<52>, Backend::kAVX512IFMA},
+      {kAllModuli, EltwiseReduceModAVX512<64>, Backend::kAVX512DQ}}},
+    {{{1ULL << 52, EltwiseCmpSubModAVX512<52>, Backend::kAVX512IFMA},
+      {kAllModuli, EltwiseCmpSubModAVX512<64>, Backend::kAVX512DQ}}},
+    {{{NTT::s_max_fwd_ifma_modulus,
+       ComputeForwardAVX512<NTT::s_ifma_shift_bits>, Backend::kAVX512IFMA},
+      {NTT::s_max_fwd_32_modulus, ComputeForwardAVX512<32>,
+       Backend::kAVX512DQ},
+      {kAllModuli, ComputeForwardAVX512<NTT::s_default_shift_bits>,
+       Backend::kAVX512DQ}}},
+    {{{NTT::s_max_inv_ifma_modulus,
+       ComputeInverseAVX512<NTT::s_ifma_shift_bits>, Backend::kAVX512IFMA},
+      {NTT::s_max_inv_32_modulus, ComputeInverseAVX512<32>,
+       Backend::kAVX512DQ},
+      {kAllModuli, ComputeInverseAVX512<NTT::s_default_shift_bits>,
+       Backend::kAVX512DQ}}},
+#ifdef HEXL_EXPERIMENTAL
+    {{{1ULL << 49, internal::DyadicMultiplyFusedAVX512<52>,
+       Backend::kAVX512IFMA},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicMultiplyKaratsubaAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::DyadicMultiplyKaratsubaAVX512<52>,
+       Backend::kAVX512IFMA},
+      {kAllModuli, internal::DyadicMultiplyKaratsubaAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::DyadicMultiplyAccumulateAVX512<52>,
+       Backend::kAVX512IFMA},
+      {kAllModuli, internal::DyadicMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::PlainMultiplyAccumulateAVX512<52>,
+       Backend::kAVX512IFMA},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::PlainMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 50, internal::PlainMultiplyAccumulateShoupAVX512<52>,
+       Backend::kAVX512IFMA},
+      {kAllModuli, internal::PlainMultiplyAccumulateShoupAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::DiagonalMultiplyAccumulateAVX512<52>,
+       Backend::kAVX512IFMA},
+      {kAllModuli, internal::DiagonalMultiplyAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::DyadicTensorProductAVX512<52>,
+       Backend::kAVX512IFMA},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicTensorProductAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 49, internal::DyadicTensorSquareAVX512<52>,
+       Backend::kAVX512IFMA},
+      {1ULL << 50, nullptr, Backend::kAVX512DQ},
+      {kAllModuli, internal::DyadicTensorSquareAVX512<64>,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 50,
+       {52, internal::KeySwitchMultiplyAccumulateAVX512<52>,
+        internal::KeySwitchReduceAVX512<52>},
+       Backend::kAVX512IFMA},
+      {kAllModuli,
+       {64, internal::KeySwitchMultiplyAccumulateAVX512<64>,
+        internal::KeySwitchReduceAVX512<64>},
+       Backend::kAVX512DQ}}},
+    {{{kAllModuli, internal::KeySwitchModDownPrepareAVX512,
+       Backend::kAVX512DQ}}},
+    {{{1ULL << 50, internal::KeySwitchModDownAccumulateAVX512<52>,
+       Backend::kAVX512IFMA},
+      {kAllModuli, internal::KeySwitchModDownAccumulateAVX512<64>,
+       Backend::kAVX512DQ}}},
+#endif
+};
+#endif
+
+#ifdef HEXL_HAS_AVX512VBMI2
+// Returns table with the AVX512-VBMI2 variants of its kernels
+inline DispatchTable WithAVX512VBMI2(DispatchTable table) {
+  const EltwiseMultModFunction dq_int = EltwiseMultModAVX512DQInt;
+  for (auto& variant : table.eltwise_mult_mod.variants) {
+    if (variant.function == dq_int) {
+      variant.function = EltwiseMultModAVX512VBMI2Int;
+    }
+  }
+  return table;
+}
+#endif
+
+// Table of the current backend; nullptr until the first call to
+// GetDispatchTable or SetBackend
+static std::atomic<const DispatchTable*> dispatch_table{nullptr};
+
+inline const DispatchTable* TableForBackend(Backend backend) {
+  switch (backend) {
+#ifdef HEXL_HAS_AVX512IFMA
+    case Backend::kAVX512IFMA:
+#ifdef HEXL_HAS_AVX512VBMI2
+      if (GetCpuFeatures().avx512vbmi2) {
+        static const DispatchTable table = WithAVX512VBMI2(avx512ifma_table);
+        return &table;
+      }
+#endif
+      return &avx512ifma_table;
+#endif
+#ifdef HEXL_HAS_AVX512DQ
+    case Backend::kAVX512DQ:
+#ifdef HEXL_HAS_AVX512VBMI2
+      if (GetCpuFeatures().avx512vbmi2) {
+        static const DispatchTable table = WithAVX512VBMI2(avx512dq_table);
+        return &table;
+      }
+#endif
+      return &avx512dq_table;
+#endif
+    default:
+      return &native_table;
+  }
+}
+
+inline Backend DetectSupportedBackend() {
+  const CpuFeatures& features = GetCpuFeatures();
+#ifdef HEXL_HAS_AVX512IFMA
+  if (features.avx512dq && features.avx512ifma) {
+    return Backend::kAVX512IFMA;
+  }
+#endif
+#ifdef HEXL_HAS_AVX512DQ
+  if (features.avx512dq) {
+    return Backend::kAVX512DQ;
+  }
+#endif
+  HEXL_UNUSED(features);
+  return Backend::kNative;
+}
+
+const char* BackendName(Backend backend) {
+  switch (backend) {
+    case Backend::kNative:
+      return "Native";
+    case Backend::kAVX512DQ:
+      return "AVX512-DQ";
+    case Backend::kAVX512IFMA:
+      return "AVX512-IFMA";
+  }
+  return "Unknown";
+}
+
+const char* KernelName(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kEltwiseAddMod:
+      return "EltwiseAddMod";
+    case Kernel::kEltwiseCmpAdd:
+      return "EltwiseCmpAdd";
+    case Kernel::kEltwiseCmpSubMod:
+      return "EltwiseCmpSubMod";
+    case Kernel::kEltwiseFMAMod:
+      return "EltwiseFMAMod";
+    case Kernel::kEltwiseMultMod:
+      return "EltwiseMultMod";
+    case Kernel::kEltwiseReduceMod:
+      return "EltwiseReduceMod";
+    case Kernel::kEltwiseSubMod:
+      return "EltwiseSubMod";
+    case Kernel::kForwardNTT:
+      return "ForwardNTT";
+    case Kernel::kInverseNTT:
+      return "InverseNTT";
+    case Kernel::kDyadicMultiply:
+      return "DyadicMultiply";
+    case Kernel::kKeySwitch:
+      return "KeySwitch";
+  }
+  return "Unknown";
+}
+
+Backend GetSupportedBackend() {
+  static const Backend backend = DetectSupportedBackend();
+  return backend;
+}
+
+const DispatchTable& GetDispatchTable() {
+  const DispatchTable* table = dispatch_table.load(std::memory_order_acquire);
+  if (table == nullptr) {
+    // Keeps the table of a concurrent SetBackend, if any
+    const DispatchTable* expected = nullptr;
+    table = TableForBackend(GetSupportedBackend());
+    if (!dispatch_table.compare_exchange_strong(expected, table,
+                                                std::memory_order_acq_rel)) {
+      table = expected;
+    }
+  }
+  return *table;
+}
+
+Backend GetBackend() { return GetDispatchTable().backend; }
+
+void SetBackend(Backend backend) {
+  if (backend > GetSupportedBackend()) {
+    throw std::invalid_argument(
+        std::string("Backend ") + BackendName(backend) +
+        " is not supported; the fastest supported backend is " +
+        BackendName(GetSupportedBackend()));
+  }
+  dispatch_table.store(TableForBackend(backend), std::memory_order_release);
+}
+
+void ResetBackend() { SetBackend(GetSupportedBackend()); }
+
+const DispatchTable& GetNativeDispatchTable() { return native_table; }
+
+Backend GetKernelBackend(Kernel kernel, uint64_t modulus) {
+  const DispatchTable& table = GetDispatchTable();
+  switch (kernel) {
+    case Kernel::kEltwiseAddMod:
+      return table.eltwise_add_mod.Select(modulus).backend;
+    case Kernel::kEltwiseCmpAdd:
+      return table.eltwise_cmp_add.Select(modulus).backend;
+    case Kernel::kEltwiseCmpSubMod:
+      return table.eltwise_cmp_sub_mod.Select(modulus).backend;
+    case Kernel::kEltwiseFMAMod:
+      return table.eltwise_fma_mod.Select(modulus).backend;
+    case Kernel::kEltwiseMultMod:
+      return table.eltwise_mult_mod.Select(modulus).backend;
+    case Kernel::kEltwiseReduceMod:
+      return table.eltwise_reduce_mod.Select(modulus).backend;
+    case Kernel::kEltwiseSubMod:
+      return table.eltwise_sub_mod.Select(modulus).backend;
+    case Kernel::kForwardNTT:
+      return table.forward_ntt.Select(modulus).backend;
+    case Kernel::kInverseNTT:
+      return table.inverse_ntt.Select(modulus).backend;
+#ifdef HEXL_EXPERIMENTAL
+    case Kernel::kDyadicMultiply:
+      return table.dyadic_multiply.Select(modulus).backend;
+    case Kernel::kKeySwitch:
+      return table.key_switch_accumulate.Select(modulus).backend;
+#endif
+    default:
+      break;
+  }
+  return Backend::kNative;
+}
+
+}  // namespace hexl
+}  // namespace intel
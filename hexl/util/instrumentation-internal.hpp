@@ -0,0 +1,137 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+
+#include "hexl/util/defines.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/instrumentation.hpp"
+#include "hexl/util/tracing.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HEXL_HAS_RDTSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define HEXL_HAS_RDTSC
+#endif
+
+namespace intel {
+namespace hexl {
+
+/// @brief Whether kernel calls are recorded; set by EnableInstrumentation
+extern std::atomic<bool> instrumentation_enabled;
+
+#ifdef HEXL_TRACING
+/// @brief Installed hooks, or nullptr; set by SetTraceHooks
+extern std::atomic<const TraceHooks*> trace_hooks;
+#endif
+
+/// @brief Returns a timestamp in units of CycleCounterName()
+inline uint64_t ReadCycleCounter() {
+#ifdef HEXL_HAS_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+/// @brief Adds one call of \p kernel to the counters
+void RecordKernelCall(Kernel kernel, Backend backend, uint64_t elements,
+                      uint64_t bytes, uint64_t cycles);
+
+/// @brief Records the kernel call in whose scope it lives, if instrumentation
+/// is enabled on construction, and calls the trace hooks, if installed
+/// @details The backend defaults to Backend::kNative; kernels call
+/// SetBackend with the backend of the variant they select from the dispatch
+/// table
+class KernelTimer {
+ public:
+  /// @param[in] kernel Kernel being called
+  /// @param[in] n Length of each operand, or NTT degree
+  /// @param[in] moduli Moduli of the limbs, or nullptr for kernels without a
+  /// modulus. Must outlive the KernelTimer
+  /// @param[in] num_moduli Number of RNS limbs
+  /// @param[in] elements Number of input coefficients
+  /// @param[in] bytes Bytes of operands read and results written
+  KernelTimer(Kernel kernel, uint64_t n, const uint64_t* moduli,
+              uint64_t num_moduli, uint64_t elements, uint64_t bytes)
+      : m_enabled(instrumentation_enabled.load(std::memory_order_relaxed)),
+        m_kernel(kernel),
+        m_n(n),
+        m_moduli(moduli),
+        m_num_moduli(num_moduli),
+        m_elements(elements),
+        m_bytes(bytes) {
+#ifdef HEXL_TRACING
+    m_hooks = trace_hooks.load(std::memory_order_acquire);
+    if (m_hooks != nullptr) {
+      BeginTrace();
+    }
+#endif
+    if (m_enabled) {
+      m_start = ReadCycleCounter();
+    }
+  }
+
+  KernelTimer(const KernelTimer&) = delete;
+  KernelTimer& operator=(const KernelTimer&) = delete;
+
+  ~KernelTimer() {
+    if (m_enabled) {
+      RecordKernelCall(m_kernel, m_backend, m_elements, m_bytes,
+                       ReadCycleCounter() - m_start);
+    }
+#ifdef HEXL_TRACING
+    if (m_hooks != nullptr) {
+      EndTrace();
+    }
+#endif
+  }
+
+  /// @brief Returns whether the call is recorded or traced, so kernels can
+  /// skip computing a backend which SetBackend would ignore
+  bool IsEnabled() const {
+#ifdef HEXL_TRACING
+    return m_enabled || m_hooks != nullptr;
+#else
+    return m_enabled;
+#endif
+  }
+
+  /// @brief Sets the backend on which the call runs
+  void SetBackend(Backend backend) { m_backend = backend; }
+
+ private:
+#ifdef HEXL_TRACING
+  // Defined in tracing.cpp
+  TraceEvent MakeTraceEvent() const;
+  void BeginTrace();
+  void EndTrace();
+
+  const TraceHooks* m_hooks;
+  void* m_span{nullptr};
+  uint64_t m_trace_start{0};
+#endif
+
+  bool m_enabled;
+  Kernel m_kernel;
+  Backend m_backend{Backend::kNative};
+  uint64_t m_n;
+  const uint64_t* m_moduli;
+  uint64_t m_num_moduli;
+  uint64_t m_elements;
+  uint64_t m_bytes;
+  uint64_t m_start{0};
+};
+
+}  // namespace hexl
+}  // namespace intel
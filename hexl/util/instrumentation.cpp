@@ -0,0 +1,140 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/instrumentation.hpp"
+
+#include <cstdlib>
+#include <sstream>
+
+#include "util/instrumentation-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+std::atomic<bool> instrumentation_enabled{
+    std::getenv("HEXL_ENABLE_INSTRUMENTATION") != nullptr};
+
+// Counters of one kernel, on their own cache lines to limit false sharing
+// between threads calling different kernels
+struct alignas(64) AtomicKernelStats {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> elements{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> cycles{0};
+  std::atomic<uint64_t> backend_calls[kNumBackends] = {};
+  std::atomic<uint64_t> cycle_histogram[kNumCycleBins] = {};
+};
+
+static AtomicKernelStats kernel_stats[kNumKernels];
+
+// Returns floor(log2(cycles)), clamped to the histogram bins
+inline size_t CycleBin(uint64_t cycles) {
+  size_t bin = 0;
+  while (cycles > 1 && bin + 1 < kNumCycleBins) {
+    cycles >>= 1;
+    ++bin;
+  }
+  return bin;
+}
+
+void RecordKernelCall(Kernel kernel, Backend backend, uint64_t elements,
+                      uint64_t bytes, uint64_t cycles) {
+  AtomicKernelStats& stats = kernel_stats[static_cast<size_t>(kernel)];
+  stats.calls.fetch_add(1, std::memory_order_relaxed);
+  stats.elements.fetch_add(elements, std::memory_order_relaxed);
+  stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  stats.cycles.fetch_add(cycles, std::memory_order_relaxed);
+  stats.backend_calls[static_cast<size_t>(backend)].fetch_add(
+      1, std::memory_order_relaxed);
+  stats.cycle_histogram[CycleBin(cycles)].fetch_add(1,
+                                                    std::memory_order_relaxed);
+}
+
+void EnableInstrumentation(bool enable) {
+  instrumentation_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool IsInstrumentationEnabled() {
+  return instrumentation_enabled.load(std::memory_order_relaxed);
+}
+
+InstrumentationSnapshot GetInstrumentationSnapshot() {
+  InstrumentationSnapshot snapshot;
+  for (size_t k = 0; k < kNumKernels; ++k) {
+    const AtomicKernelStats& stats = kernel_stats[k];
+    KernelStats& result = snapshot.kernels[k];
+    result.calls = stats.calls.load(std::memory_order_relaxed);
+    result.elements = stats.elements.load(std::memory_order_relaxed);
+    result.bytes = stats.bytes.load(std::memory_order_relaxed);
+    result.cycles = stats.cycles.load(std::memory_order_relaxed);
+    for (size_t b = 0; b < kNumBackends; ++b) {
+      result.backend_calls[b] =
+          stats.backend_calls[b].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kNumCycleBins; ++i) {
+      result.cycle_histogram[i] =
+          stats.cycle_histogram[i].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+void ResetInstrumentation() {
+  for (AtomicKernelStats& stats : kernel_stats) {
+    stats.calls.store(0, std::memory_order_relaxed);
+    stats.elements.store(0, std::memory_order_relaxed);
+    stats.bytes.store(0, std::memory_order_relaxed);
+    stats.cycles.store(0, std::memory_order_relaxed);
+    for (auto& count : stats.backend_calls) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    for (auto& count : stats.cycle_histogram) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+const char* CycleCounterName() {
+#ifdef HEXL_HAS_RDTSC
+  return "rdtsc";
+#else
+  return "steady_clock_ns";
+#endif
+}
+
+std::string InstrumentationToJSON(const InstrumentationSnapshot& snapshot) {
+  std::ostringstream json;
+  json << "{\"cycle_counter\": \"" << CycleCounterName()
+       << "\", \"kernels\": {";
+  bool first_kernel = true;
+  for (size_t k = 0; k < kNumKernels; ++k) {
+    const KernelStats& stats = snapshot.kernels[k];
+    if (stats.calls == 0) {
+      continue;
+    }
+    if (!first_kernel) {
+      json << ", ";
+    }
+    first_kernel = false;
+
+    json << "\"" << KernelName(static_cast<Kernel>(k)) << "\": {"
+         << "\"calls\": " << stats.calls << ", \"elements\": " << stats.elements
+         << ", \"bytes\": " << stats.bytes << ", \"cycles\": " << stats.cycles
+         << ", \"backends\": {";
+    for (size_t b = 0; b < kNumBackends; ++b) {
+      json << (b == 0 ? "" : ", ") << "\""
+           << BackendName(static_cast<Backend>(b))
+           << "\": " << stats.backend_calls[b];
+    }
+    json << "}, \"cycle_histogram\": [";
+    for (size_t i = 0; i < kNumCycleBins; ++i) {
+      json << (i == 0 ? "" : ", ") << stats.cycle_histogram[i];
+    }
+    json << "]}";
+  }
+  json << "}}";
+  return json.str();
+}
+
+}  // namespace hexl
+}  // namespace intel
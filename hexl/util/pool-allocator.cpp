@@ -0,0 +1,171 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/pool-allocator.hpp"
+
+#include <cstdlib>
+
+namespace intel {
+namespace hexl {
+
+namespace {
+
+// Precedes each block. Keeps the returned memory 16-byte aligned, like malloc
+struct alignas(16) PoolBlockHeader {
+  size_t size_class;
+  PoolBlockHeader* next;  // Next free block of the class, while cached
+};
+
+// Classes are 64 bytes, then four per power of two up to 2^kMaxClassLog
+constexpr size_t kMinClassLog = 6;
+constexpr size_t kMaxClassLog = 26;
+constexpr size_t kNumClasses = (kMaxClassLog - kMinClassLog) * 4 + 1;
+
+// Marks blocks larger than the largest class, which are never cached
+constexpr size_t kUnpooledClass = kNumClasses;
+
+constexpr size_t kMaxCachedBytes = size_t(1) << 27;
+
+// Returns the smallest class holding total_bytes, including the header
+inline size_t SizeClass(size_t total_bytes) {
+  if (total_bytes <= (size_t(1) << kMinClassLog)) {
+    return 0;
+  }
+  // 2^k < total_bytes <= 2^(k + 1)
+  size_t k = kMinClassLog;
+  while ((size_t(2) << k) < total_bytes) {
+    ++k;
+  }
+  size_t step_log = k - 2;
+  size_t sub = ((total_bytes - (size_t(1) << k)) + (size_t(1) << step_log) - 1)
+               >> step_log;
+  return (k - kMinClassLog) * 4 + sub;
+}
+
+// Returns the block size of the class, including the header
+constexpr size_t ClassSize(size_t size_class) {
+  return (size_class == 0)
+             ? (size_t(1) << kMinClassLog)
+             : (size_t(1) << ((size_class - 1) / 4 + kMinClassLog)) +
+                   (((size_class - 1) % 4 + 1)
+                    << ((size_class - 1) / 4 + kMinClassLog - 2));
+}
+
+constexpr size_t kMaxPooledBytes =
+    ClassSize(kNumClasses - 1) - sizeof(PoolBlockHeader);
+
+struct PoolCache;
+
+// Both are trivially destructible, so they stay valid while other thread_local
+// objects are destroyed. pool_cache points to the cache of the thread once it
+// is constructed, and is reset when the cache is destroyed, after which freed
+// blocks go straight to free
+thread_local PoolCache* pool_cache = nullptr;
+thread_local bool pool_cache_destroyed = false;
+
+struct PoolCache {
+  PoolBlockHeader* free_lists[kNumClasses] = {};
+  size_t cached_bytes = 0;
+
+  ~PoolCache() {
+    Release();
+    pool_cache = nullptr;
+    pool_cache_destroyed = true;
+  }
+
+  void Release() {
+    for (size_t i = 0; i < kNumClasses; ++i) {
+      while (free_lists[i] != nullptr) {
+        PoolBlockHeader* block = free_lists[i];
+        free_lists[i] = block->next;
+        std::free(block);
+      }
+    }
+    cached_bytes = 0;
+  }
+};
+
+// Returns the cache of the calling thread, or nullptr during thread exit
+inline PoolCache* GetPoolCache() {
+  PoolCache* cache = pool_cache;
+  if (cache == nullptr && !pool_cache_destroyed) {
+    thread_local PoolCache thread_cache;
+    pool_cache = &thread_cache;
+    cache = &thread_cache;
+  }
+  return cache;
+}
+
+}  // namespace
+
+void* PoolAllocator::allocate(size_t bytes_count) {
+  size_t total_bytes = bytes_count + sizeof(PoolBlockHeader);
+  if (bytes_count > kMaxPooledBytes) {
+    void* raw = std::malloc(total_bytes);
+    if (raw == nullptr) {
+      return nullptr;
+    }
+    PoolBlockHeader* block = static_cast<PoolBlockHeader*>(raw);
+    block->size_class = kUnpooledClass;
+    return block + 1;
+  }
+
+  size_t size_class = SizeClass(total_bytes);
+  PoolBlockHeader* block = nullptr;
+  PoolCache* cache = GetPoolCache();
+  if (cache != nullptr && cache->free_lists[size_class] != nullptr) {
+    block = cache->free_lists[size_class];
+    cache->free_lists[size_class] = block->next;
+    cache->cached_bytes -= ClassSize(size_class);
+  } else {
+    block = static_cast<PoolBlockHeader*>(std::malloc(ClassSize(size_class)));
+    if (block == nullptr) {
+      return nullptr;
+    }
+    block->size_class = size_class;
+  }
+  return block + 1;
+}
+
+void PoolAllocator::deallocate(void* p, size_t n) {
+  HEXL_UNUSED(n);
+  if (p == nullptr) {
+    return;
+  }
+  PoolBlockHeader* block = static_cast<PoolBlockHeader*>(p) - 1;
+  size_t size_class = block->size_class;
+  PoolCache* cache = (size_class == kUnpooledClass) ? nullptr : GetPoolCache();
+  if (cache == nullptr ||
+      cache->cached_bytes + ClassSize(size_class) > kMaxCachedBytes) {
+    std::free(block);
+    return;
+  }
+  block->next = cache->free_lists[size_class];
+  cache->free_lists[size_class] = block;
+  cache->cached_bytes += ClassSize(size_class);
+}
+
+size_t PoolAllocator::MaxPooledBytes() { return kMaxPooledBytes; }
+
+size_t PoolAllocator::MaxCachedBytes() { return kMaxCachedBytes; }
+
+size_t PoolAllocator::ThreadCachedBytes() {
+  PoolCache* cache = GetPoolCache();
+  return (cache == nullptr) ? 0 : cache->cached_bytes;
+}
+
+void PoolAllocator::ReleaseThreadCache() {
+  PoolCache* cache = GetPoolCache();
+  if (cache != nullptr) {
+    cache->Release();
+  }
+}
+
+const std::shared_ptr<AllocatorBase>& GetPoolAllocator() {
+  static const std::shared_ptr<AllocatorBase> pool_allocator =
+      std::make_shared<PoolAllocator>();
+  return pool_allocator;
+}
+
+}  // namespace hexl
+}  // namespace intel
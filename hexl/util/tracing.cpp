@@ -0,0 +1,68 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "hexl/util/tracing.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "hexl/number-theory/number-theory.hpp"
+#include "util/instrumentation-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+std::atomic<const TraceHooks*> trace_hooks{nullptr};
+
+// Nanoseconds since an arbitrary epoch
+inline uint64_t TraceClock() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void SetTraceHooks(const TraceHooks* hooks) {
+  trace_hooks.store(hooks, std::memory_order_release);
+}
+
+const TraceHooks* GetTraceHooks() {
+  return trace_hooks.load(std::memory_order_acquire);
+}
+
+TraceEvent KernelTimer::MakeTraceEvent() const {
+  TraceEvent event;
+  event.kernel = m_kernel;
+  event.backend = m_backend;
+  event.n = m_n;
+  event.num_moduli = m_num_moduli;
+  event.modulus_bits = 0;
+  if (m_moduli != nullptr && m_num_moduli > 0) {
+    uint64_t max_modulus = *std::max_element(m_moduli, m_moduli + m_num_moduli);
+    event.modulus_bits = (max_modulus == 0) ? 0 : MSB(max_modulus) + 1;
+  }
+  event.elements = m_elements;
+  event.duration_ns = 0;
+  return event;
+}
+
+void KernelTimer::BeginTrace() {
+  if (m_hooks->begin != nullptr) {
+    TraceEvent event = MakeTraceEvent();
+    event.backend = GetBackend();
+    m_span = m_hooks->begin(event, m_hooks->user_data);
+  }
+  m_trace_start = TraceClock();
+}
+
+void KernelTimer::EndTrace() {
+  uint64_t duration_ns = TraceClock() - m_trace_start;
+  if (m_hooks->end != nullptr) {
+    TraceEvent event = MakeTraceEvent();
+    event.duration_ns = duration_ns;
+    m_hooks->end(event, m_span, m_hooks->user_data);
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,91 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hexl/experimental/misc/diagonal-mat-vec-mult.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Checks the inner sums against separate products of each diagonal and
+// ciphertext, including moduli where the sums are reduced more than once and
+// moduli handled with element-wise multiplications
+TEST(DiagonalMatrixVectorMultiply, inner_sums) {
+  size_t coeff_count = 1024;
+  size_t num_moduli = 2;
+  size_t poly_size = coeff_count * num_moduli;
+
+  for (uint64_t bits : {40, 50, 60, 62}) {
+    std::vector<uint64_t> moduli =
+        GeneratePrimes(num_moduli, bits, true, coeff_count);
+    for (size_t baby_steps : {1, 3, 8}) {
+      for (size_t giant_steps : {1, 4}) {
+        std::vector<uint64_t> diagonals;
+        for (size_t d = 0; d < giant_steps * baby_steps; ++d) {
+          for (uint64_t modulus : moduli) {
+            auto values =
+                GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+            values[0] = modulus - 1;
+            diagonals.insert(diagonals.end(), values.begin(), values.end());
+          }
+        }
+        std::vector<uint64_t> ciphers;
+        for (size_t i = 0; i < baby_steps; ++i) {
+          for (size_t poly = 0; poly < 2; ++poly) {
+            for (uint64_t modulus : moduli) {
+              auto values =
+                  GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+              values[0] = modulus - 1;
+              ciphers.insert(ciphers.end(), values.begin(), values.end());
+            }
+          }
+        }
+
+        std::vector<uint64_t> expected(giant_steps * 2 * poly_size, 0);
+        for (size_t j = 0; j < giant_steps; ++j) {
+          for (size_t i = 0; i < baby_steps; ++i) {
+            const uint64_t* d = &diagonals[(j * baby_steps + i) * poly_size];
+            const uint64_t* c = &ciphers[i * 2 * poly_size];
+            uint64_t* out = &expected[j * 2 * poly_size];
+            for (size_t k = 0; k < 2; ++k) {
+              for (size_t l = 0; l < poly_size; ++l) {
+                uint64_t modulus = moduli[l / coeff_count];
+                out[k * poly_size + l] = AddUIntMod(
+                    out[k * poly_size + l],
+                    MultiplyMod(d[l], c[k * poly_size + l], modulus), modulus);
+              }
+            }
+          }
+        }
+
+        std::vector<uint64_t> result(expected.size(), 0);
+        DiagonalMatrixVectorMultiply(result.data(), diagonals.data(),
+                                     ciphers.data(), coeff_count,
+                                     moduli.data(), num_moduli, baby_steps,
+                                     giant_steps);
+        CheckEqual(result, expected);
+
+        ThreadExecutor executor(3);
+        std::vector<uint64_t> workspace(
+            DiagonalMatrixVectorMultiplyWorkspaceSize(coeff_count, &executor));
+        std::fill(result.begin(), result.end(), 0);
+        DiagonalMatrixVectorMultiply(result.data(), diagonals.data(),
+                                     ciphers.data(), coeff_count,
+                                     moduli.data(), num_moduli, baby_steps,
+                                     giant_steps, &executor, workspace.data());
+        CheckEqual(result, expected);
+      }
+    }
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
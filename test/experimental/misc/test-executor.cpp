@@ -0,0 +1,167 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+
+namespace intel {
+namespace hexl {
+
+TEST(ParallelFor, nullptr) {
+  std::vector<size_t> order;
+  ParallelFor(nullptr, 5, [&](size_t task, size_t worker) {
+    EXPECT_EQ(worker, 0ULL);
+    order.push_back(task);
+  });
+  EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4}));
+  EXPECT_EQ(NumWorkers(nullptr), 1ULL);
+}
+
+TEST(ThreadExecutor, tasks) {
+  for (size_t num_threads : {1, 2, 3, 8}) {
+    ThreadExecutor executor(num_threads);
+    EXPECT_EQ(executor.NumWorkers(), num_threads);
+
+    for (size_t num_tasks : {0, 1, 7, 64}) {
+      std::vector<std::atomic<size_t>> counts(num_tasks);
+      std::vector<size_t> workers(num_tasks);
+      ParallelFor(&executor, num_tasks, [&](size_t task, size_t worker) {
+        EXPECT_LT(worker, num_threads);
+        counts[task]++;
+        workers[task] = worker;
+      });
+      for (size_t i = 0; i < num_tasks; ++i) {
+        EXPECT_EQ(counts[i].load(), 1ULL);
+        // Each worker runs a contiguous chunk of tasks
+        if (i > 0) {
+          EXPECT_LE(workers[i - 1], workers[i]);
+        }
+      }
+    }
+  }
+}
+
+// Successive calls run on the same worker threads
+TEST(ThreadExecutor, persistent_threads) {
+  ThreadExecutor executor(3);
+  std::vector<std::thread::id> first(3);
+  ParallelFor(&executor, 3, [&](size_t task, size_t) {
+    first[task] = std::this_thread::get_id();
+  });
+  for (size_t repeat = 0; repeat < 3; ++repeat) {
+    std::vector<std::thread::id> ids(3);
+    ParallelFor(&executor, 3, [&](size_t task, size_t) {
+      ids[task] = std::this_thread::get_id();
+    });
+    EXPECT_EQ(ids, first);
+  }
+  EXPECT_EQ(first[0], std::this_thread::get_id());
+}
+
+TEST(ThreadExecutor, nested) {
+  ThreadExecutor executor(3);
+  std::atomic<size_t> count{0};
+  ParallelFor(&executor, 4, [&](size_t, size_t) {
+    ParallelFor(&executor, 4, [&](size_t, size_t) { count++; });
+  });
+  EXPECT_EQ(count.load(), 16ULL);
+}
+
+TEST(ThreadExecutor, default_num_threads) {
+  ThreadExecutor executor;
+  EXPECT_GE(executor.NumWorkers(), 1ULL);
+}
+
+TEST(ThreadExecutor, exception) {
+  ThreadExecutor executor(4);
+  EXPECT_THROW(ParallelFor(&executor, 8,
+                           [](size_t task, size_t) {
+                             if (task == 5) {
+                               throw std::runtime_error("task failed");
+                             }
+                           }),
+               std::runtime_error);
+}
+
+TEST(ThreadPoolExecutor, tasks) {
+  for (size_t num_threads : {1, 2, 3, 8}) {
+    ThreadPoolExecutor executor(num_threads);
+    EXPECT_EQ(executor.NumWorkers(), num_threads);
+
+    // The same threads run successive calls
+    for (size_t repeat = 0; repeat < 3; ++repeat) {
+      for (size_t num_tasks : {0, 1, 7, 64}) {
+        std::vector<std::atomic<size_t>> counts(num_tasks);
+        std::vector<size_t> workers(num_tasks);
+        ParallelFor(&executor, num_tasks, [&](size_t task, size_t worker) {
+          EXPECT_LT(worker, num_threads);
+          counts[task]++;
+          workers[task] = worker;
+        });
+        for (size_t i = 0; i < num_tasks; ++i) {
+          EXPECT_EQ(counts[i].load(), 1ULL);
+          if (i > 0) {
+            EXPECT_LE(workers[i - 1], workers[i]);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(ThreadPoolExecutor, concurrent_callers) {
+  ThreadPoolExecutor executor(3);
+  std::atomic<size_t> total{0};
+  std::vector<std::thread> callers;
+  for (size_t c = 0; c < 4; ++c) {
+    callers.emplace_back([&] {
+      for (size_t repeat = 0; repeat < 20; ++repeat) {
+        ParallelFor(&executor, 16, [&](size_t, size_t) { total++; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(total.load(), 4ULL * 20 * 16);
+}
+
+// ParallelFor from within a task runs inline rather than deadlocking
+TEST(ThreadPoolExecutor, nested) {
+  ThreadPoolExecutor executor(3);
+  std::vector<std::atomic<size_t>> counts(6 * 5);
+  ParallelFor(&executor, 6, [&](size_t outer, size_t) {
+    ParallelFor(&executor, 5, [&](size_t inner, size_t worker) {
+      EXPECT_EQ(worker, 0ULL);
+      counts[outer * 5 + inner]++;
+    });
+  });
+  for (const auto& count : counts) {
+    EXPECT_EQ(count.load(), 1ULL);
+  }
+}
+
+TEST(ThreadPoolExecutor, exception) {
+  ThreadPoolExecutor executor(4);
+  EXPECT_THROW(ParallelFor(&executor, 8,
+                           [](size_t task, size_t) {
+                             if (task == 5) {
+                               throw std::runtime_error("task failed");
+                             }
+                           }),
+               std::runtime_error);
+
+  // The pool remains usable
+  std::atomic<size_t> count{0};
+  ParallelFor(&executor, 8, [&](size_t, size_t) { count++; });
+  EXPECT_EQ(count.load(), 8ULL);
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -3,12 +3,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
+#include "hexl/experimental/misc/executor.hpp"
 #include "hexl/experimental/misc/lr-mat-vec-mult.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/cache-info.hpp"
 #include "test-util.hpp"
+#include "util/util-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -57,5 +61,203 @@ TEST(LinRegMatrixVectorMultiply, small_one_mod) {
   CheckEqual(out, exp_out);
 }
 
+TEST(LinRegMatrixVectorMultiply, workspace) {
+  size_t coeff_count = 1024;
+  size_t num_weights = 4;
+  std::vector<uint64_t> moduli = GeneratePrimes(2, 50, true, coeff_count);
+
+  std::vector<uint64_t> op1;
+  std::vector<uint64_t> op2;
+  for (size_t r = 0; r < num_weights; ++r) {
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+        op1.insert(op1.end(), values1.begin(), values1.end());
+        op2.insert(op2.end(), values2.begin(), values2.end());
+      }
+    }
+  }
+
+  std::vector<uint64_t> exp_out(num_weights * 3 * coeff_count * moduli.size(),
+                                0);
+  LinRegMatrixVectorMultiply(exp_out.data(), op1.data(), op2.data(),
+                             coeff_count, moduli.data(), moduli.size(),
+                             num_weights);
+
+  // The workspace need not be initialized
+  std::vector<uint64_t> workspace(
+      LinRegMatrixVectorMultiplyWorkspaceSize(coeff_count), 0xFFFFFFFFFFFFFFFF);
+  std::vector<uint64_t> out(exp_out.size(), 0);
+  LinRegMatrixVectorMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                             moduli.data(), moduli.size(), num_weights,
+                             workspace.data());
+  CheckEqual(out, exp_out);
+}
+
+// Checks the multithreaded adder tree matches the single-threaded one, and
+// that the first output is the sum of all rows when num_weights is not a
+// power of two
+TEST(LinRegMatrixVectorMultiply, executor) {
+  size_t coeff_count = 1024;
+  std::vector<uint64_t> moduli = GeneratePrimes(2, 50, true, coeff_count);
+  size_t poly_size = coeff_count * moduli.size();
+
+  for (size_t num_weights : {1, 3, 5, 8, 13}) {
+    std::vector<uint64_t> op1;
+    std::vector<uint64_t> op2;
+    for (size_t r = 0; r < num_weights; ++r) {
+      for (size_t poly = 0; poly < 2; ++poly) {
+        for (uint64_t modulus : moduli) {
+          auto values1 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          auto values2 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          op1.insert(op1.end(), values1.begin(), values1.end());
+          op2.insert(op2.end(), values2.begin(), values2.end());
+        }
+      }
+    }
+
+    std::vector<uint64_t> exp_out(num_weights * 3 * poly_size, 0);
+    LinRegMatrixVectorMultiply(exp_out.data(), op1.data(), op2.data(),
+                               coeff_count, moduli.data(), moduli.size(),
+                               num_weights);
+
+    std::vector<uint64_t> sum(3 * poly_size, 0);
+    LinRegMatrixVectorMultiplyAccumulate(sum.data(), op1.data(), op2.data(),
+                                         coeff_count, moduli.data(),
+                                         moduli.size(), num_weights);
+    CheckEqual(std::vector<uint64_t>(exp_out.begin(),
+                                     exp_out.begin() + 3 * poly_size),
+               sum);
+
+    ThreadExecutor executor(3);
+    std::vector<uint64_t> workspace(
+        LinRegMatrixVectorMultiplyWorkspaceSize(coeff_count, &executor));
+    std::vector<uint64_t> out(exp_out.size(), 0);
+    LinRegMatrixVectorMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                               moduli.data(), moduli.size(), num_weights,
+                               workspace.data(), &executor);
+    CheckEqual(out, exp_out);
+
+    std::fill(out.begin(), out.end(), 0);
+    LinRegMatrixVectorMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                               moduli.data(), moduli.size(), num_weights,
+                               nullptr, &executor);
+    CheckEqual(out, exp_out);
+  }
+}
+
+// Checks the accumulation mode against a direct sum of the row products,
+// including moduli where the products are reduced more than once
+TEST(LinRegMatrixVectorMultiply, accumulate) {
+  size_t coeff_count = 1024;
+  size_t num_moduli = 2;
+
+  for (uint64_t bits : {40, 50, 60, 62}) {
+    std::vector<uint64_t> moduli =
+        GeneratePrimes(num_moduli, bits, true, coeff_count);
+    for (size_t num_weights : {1, 3, 4, 16}) {
+      std::vector<uint64_t> op1;
+      std::vector<uint64_t> op2;
+      for (size_t r = 0; r < num_weights; ++r) {
+        for (size_t poly = 0; poly < 2; ++poly) {
+          for (uint64_t modulus : moduli) {
+            auto values1 =
+                GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+            auto values2 =
+                GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+            values1[0] = modulus - 1;
+            values2[0] = modulus - 1;
+            op1.insert(op1.end(), values1.begin(), values1.end());
+            op2.insert(op2.end(), values2.begin(), values2.end());
+          }
+        }
+      }
+
+      size_t poly_size = coeff_count * num_moduli;
+      std::vector<uint64_t> exp_out(3 * poly_size, 0);
+      for (size_t r = 0; r < num_weights; ++r) {
+        const uint64_t* x = op1.data() + r * 2 * poly_size;
+        const uint64_t* y = op2.data() + r * 2 * poly_size;
+        for (size_t i = 0; i < num_moduli; ++i) {
+          uint64_t modulus = moduli[i];
+          for (size_t l = i * coeff_count; l < (i + 1) * coeff_count; ++l) {
+            uint64_t x0 = x[l];
+            uint64_t x1 = x[l + poly_size];
+            uint64_t y0 = y[l];
+            uint64_t y1 = y[l + poly_size];
+            uint64_t cross = AddUIntMod(MultiplyMod(x0, y1, modulus),
+                                        MultiplyMod(x1, y0, modulus), modulus);
+            exp_out[l] =
+                AddUIntMod(exp_out[l], MultiplyMod(x0, y0, modulus), modulus);
+            exp_out[l + poly_size] =
+                AddUIntMod(exp_out[l + poly_size], cross, modulus);
+            exp_out[l + 2 * poly_size] =
+                AddUIntMod(exp_out[l + 2 * poly_size],
+                           MultiplyMod(x1, y1, modulus), modulus);
+          }
+        }
+      }
+
+      std::vector<uint64_t> out(exp_out.size(), 0);
+      LinRegMatrixVectorMultiplyAccumulate(out.data(), op1.data(), op2.data(),
+                                           coeff_count, moduli.data(),
+                                           num_moduli, num_weights);
+      CheckEqual(out, exp_out);
+
+      // The workspace need not be initialized
+      std::vector<uint64_t> workspace(
+          LinRegMatrixVectorMultiplyAccumulateWorkspaceSize(coeff_count),
+          0xFFFFFFFFFFFFFFFF);
+      std::fill(out.begin(), out.end(), 0);
+      LinRegMatrixVectorMultiplyAccumulate(
+          out.data(), op1.data(), op2.data(), coeff_count, moduli.data(),
+          num_moduli, num_weights, workspace.data());
+      CheckEqual(out, exp_out);
+    }
+  }
+}
+
+// Checks the accumulation mode where the tile size does not divide n, with a
+// modulus taking the element-wise fallback
+TEST(LinRegMatrixVectorMultiply, accumulate_partial_tile) {
+  // A 16 KiB L1 data cache gives tiles of 256 coefficients
+  size_t coeff_count = 320;
+  size_t num_weights = 3;
+  uint64_t modulus = GeneratePrimes(1, 62, true, 1024)[0];
+
+  auto op1 = GenerateInsecureUniformRandomValues(2 * num_weights * coeff_count,
+                                                 0, modulus);
+  auto op2 = GenerateInsecureUniformRandomValues(2 * num_weights * coeff_count,
+                                                 0, modulus);
+  std::vector<uint64_t> exp_out(3 * coeff_count, 0);
+  for (size_t r = 0; r < num_weights; ++r) {
+    const uint64_t* x = op1.data() + r * 2 * coeff_count;
+    const uint64_t* y = op2.data() + r * 2 * coeff_count;
+    for (size_t l = 0; l < coeff_count; ++l) {
+      for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+          uint64_t& out = exp_out[l + (i + j) * coeff_count];
+          out = AddUIntMod(out,
+                           MultiplyMod(x[l + i * coeff_count],
+                                       y[l + j * coeff_count], modulus),
+                           modulus);
+        }
+      }
+    }
+  }
+
+  SetCacheSizes(16 * 1024, 1 << 20);
+  std::vector<uint64_t> out(exp_out.size(), 0);
+  LinRegMatrixVectorMultiplyAccumulate(out.data(), op1.data(), op2.data(),
+                                       coeff_count, &modulus, 1, num_weights);
+  SetCacheSizes(0, 0);
+  CheckEqual(out, exp_out);
+}
+
 }  // namespace hexl
 }  // namespace intel
@@ -0,0 +1,273 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include "hexl/experimental/seal/command-queue.hpp"
+#include "hexl/experimental/seal/dyadic-multiply.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Random ciphertext of num_polys polynomials modulo each of moduli
+inline std::vector<uint64_t> RandomCiphertext(
+    uint64_t n, uint64_t num_polys, const std::vector<uint64_t>& moduli) {
+  std::vector<uint64_t> cipher;
+  for (size_t poly = 0; poly < num_polys; ++poly) {
+    for (uint64_t modulus : moduli) {
+      auto values = GenerateInsecureUniformRandomValues(n, 0, modulus);
+      cipher.insert(cipher.end(), values.begin(), values.end());
+    }
+  }
+  return cipher;
+}
+
+TEST(CommandQueue, dyadic_multiply) {
+  uint64_t n = 1024;
+  size_t num_commands = 6;
+  for (size_t bits : {40, 60}) {
+    std::vector<uint64_t> moduli = GeneratePrimes(3, bits, true, n);
+    uint64_t num_moduli = moduli.size();
+
+    std::vector<std::vector<uint64_t>> op1s;
+    std::vector<std::vector<uint64_t>> op2s;
+    std::vector<std::vector<uint64_t>> expected(num_commands);
+    for (size_t c = 0; c < num_commands; ++c) {
+      op1s.push_back(RandomCiphertext(n, 2, moduli));
+      op2s.push_back(RandomCiphertext(n, 2, moduli));
+      expected[c].resize(3 * n * num_moduli);
+      DyadicMultiply(expected[c].data(), op1s[c].data(), op2s[c].data(), n,
+                     moduli.data(), num_moduli);
+    }
+
+    for (size_t num_threads : {1, 3}) {
+      CommandQueue queue(std::make_shared<CpuCommandQueueBackend>(num_threads));
+      std::vector<std::vector<uint64_t>> results(
+          num_commands, std::vector<uint64_t>(3 * n * num_moduli));
+
+      // One submission per command, completing in order
+      std::vector<std::future<void>> futures;
+      std::vector<size_t> completed;
+      for (size_t c = 0; c < num_commands; ++c) {
+        DyadicMultiplyCommand command;
+        command.result = results[c].data();
+        command.operand1 = op1s[c].data();
+        command.operand2 = op2s[c].data();
+        command.n = n;
+        command.moduli = moduli.data();
+        command.num_moduli = num_moduli;
+        futures.push_back(
+            queue.Submit(command, [&completed, c](std::exception_ptr error) {
+              EXPECT_EQ(error, nullptr);
+              completed.push_back(c);
+            }));
+      }
+      for (auto& future : futures) {
+        future.get();
+      }
+      std::vector<size_t> expected_order(num_commands);
+      for (size_t c = 0; c < num_commands; ++c) {
+        expected_order[c] = c;
+        AssertEqual(results[c], expected[c]);
+      }
+      EXPECT_EQ(completed, expected_order);
+
+      // One batch of all commands, the first computed in place
+      results.assign(num_commands, std::vector<uint64_t>(3 * n * num_moduli));
+      results[0] = op1s[0];
+      results[0].resize(3 * n * num_moduli);
+      std::vector<Command> commands;
+      for (size_t c = 0; c < num_commands; ++c) {
+        DyadicMultiplyCommand command;
+        command.result = results[c].data();
+        command.operand1 = (c == 0) ? results[c].data() : op1s[c].data();
+        command.operand2 = op2s[c].data();
+        command.n = n;
+        command.moduli = moduli.data();
+        command.num_moduli = num_moduli;
+        commands.push_back(command);
+      }
+      queue.SubmitBatch(commands).get();
+      for (size_t c = 0; c < num_commands; ++c) {
+        AssertEqual(results[c], expected[c]);
+      }
+    }
+  }
+}
+
+TEST(CommandQueue, key_switch) {
+  uint64_t n = 1024;
+  uint64_t decomp_modulus_size = 3;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+  size_t num_commands = 4;
+
+  std::vector<uint64_t> moduli =
+      GeneratePrimes(key_modulus_size, 50, true, n);
+  std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+  std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    keys[j] = RandomCiphertext(n, key_component_count, moduli);
+    key_ptrs[j] = keys[j].data();
+  }
+  std::vector<uint64_t> modswitch_factors;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors.push_back(
+        GenerateInsecureUniformRandomValue(1, moduli[i]));
+  }
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(n, moduli[m]);
+  }
+
+  std::vector<uint64_t> decomp_moduli(moduli.begin(),
+                                      moduli.begin() + decomp_modulus_size);
+  std::vector<std::vector<uint64_t>> inputs;
+  std::vector<std::vector<uint64_t>> initial;
+  std::vector<std::vector<uint64_t>> expected;
+  for (size_t c = 0; c < num_commands; ++c) {
+    inputs.push_back(RandomCiphertext(n, 1, decomp_moduli));
+    initial.push_back(RandomCiphertext(n, key_component_count, decomp_moduli));
+    expected.push_back(initial[c]);
+    KeySwitch(expected[c].data(), inputs[c].data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts);
+  }
+
+  CommandQueue queue(std::make_shared<CpuCommandQueueBackend>(2));
+  for (bool use_ntts : {false, true}) {
+    std::vector<std::vector<uint64_t>> results = initial;
+    std::vector<Command> commands;
+    for (size_t c = 0; c < num_commands; ++c) {
+      KeySwitchCommand command;
+      command.result = results[c].data();
+      command.t_target_iter_ptr = inputs[c].data();
+      command.n = n;
+      command.decomp_modulus_size = decomp_modulus_size;
+      command.key_modulus_size = key_modulus_size;
+      command.rns_modulus_size = rns_modulus_size;
+      command.key_component_count = key_component_count;
+      command.moduli = moduli.data();
+      command.k_switch_keys = key_ptrs.data();
+      command.modswitch_factors = modswitch_factors.data();
+      command.ntts = use_ntts ? &ntts : nullptr;
+      commands.push_back(command);
+    }
+    // The first command alone, then the rest as a batch
+    std::future<void> first = queue.Submit(commands[0].key_switch);
+    commands.erase(commands.begin());
+    std::future<void> rest = queue.SubmitBatch(commands);
+    first.get();
+    rest.get();
+    for (size_t c = 0; c < num_commands; ++c) {
+      AssertEqual(results[c], expected[c]);
+    }
+  }
+}
+
+// Submissions run in order, so a command may read the result of an earlier
+// submission
+TEST(CommandQueue, dependent_submissions) {
+  uint64_t n = 256;
+  std::vector<uint64_t> moduli = GeneratePrimes(2, 50, true, n);
+  uint64_t num_moduli = moduli.size();
+  auto op1 = RandomCiphertext(n, 2, moduli);
+  auto op2 = RandomCiphertext(n, 2, moduli);
+  auto op3 = RandomCiphertext(n, 2, moduli);
+
+  std::vector<uint64_t> product(3 * n * num_moduli);
+  std::vector<uint64_t> expected(3 * n * num_moduli);
+  DyadicMultiply(product.data(), op1.data(), op2.data(), n, moduli.data(),
+                 num_moduli);
+  DyadicMultiply(expected.data(), product.data(), op3.data(), n,
+                 moduli.data(), num_moduli);
+
+  CommandQueue queue;
+  std::vector<uint64_t> temp(3 * n * num_moduli);
+  std::vector<uint64_t> result(3 * n * num_moduli);
+  DyadicMultiplyCommand command;
+  command.n = n;
+  command.moduli = moduli.data();
+  command.num_moduli = num_moduli;
+  command.result = temp.data();
+  command.operand1 = op1.data();
+  command.operand2 = op2.data();
+  queue.Submit(command);
+  command.result = result.data();
+  command.operand1 = temp.data();
+  command.operand2 = op3.data();
+  queue.Submit(command);
+  queue.Wait();
+  AssertEqual(result, expected);
+}
+
+// Backend which completes each submission on the calling thread, failing any
+// submission with a KeySwitch command
+struct TestCommandQueueBackend : public CommandQueueBackend {
+  void Submit(std::vector<Command> commands,
+              CommandCallback on_complete) override {
+    num_commands += commands.size();
+    std::exception_ptr error;
+    for (const auto& command : commands) {
+      if (command.type == CommandType::kKeySwitch) {
+        error = std::make_exception_ptr(std::runtime_error("unsupported"));
+      }
+    }
+    on_complete(error);
+  }
+
+  size_t num_commands = 0;
+};
+
+TEST(CommandQueue, custom_backend) {
+  auto backend = std::make_shared<TestCommandQueueBackend>();
+  CommandQueue queue(backend);
+
+  std::atomic<size_t> num_errors{0};
+  auto callback = [&](std::exception_ptr error) {
+    if (error) {
+      num_errors++;
+    }
+  };
+  std::future<void> success =
+      queue.SubmitBatch({DyadicMultiplyCommand(), DyadicMultiplyCommand()},
+                        callback);
+  std::future<void> failure = queue.Submit(KeySwitchCommand(), callback);
+  queue.Wait();
+
+  EXPECT_NO_THROW(success.get());
+  EXPECT_THROW(failure.get(), std::runtime_error);
+  EXPECT_EQ(num_errors.load(), 1ULL);
+  EXPECT_EQ(backend->num_commands, 3ULL);
+}
+
+// Backend whose Submit throws, as on a failed allocation
+struct ThrowingCommandQueueBackend : public CommandQueueBackend {
+  void Submit(std::vector<Command> /*commands*/,
+              CommandCallback /*on_complete*/) override {
+    throw std::bad_alloc();
+  }
+};
+
+// A submission rejected by the backend is not waited for
+TEST(CommandQueue, backend_submit_throws) {
+  CommandQueue queue(std::make_shared<ThrowingCommandQueueBackend>());
+  EXPECT_THROW(queue.Submit(DyadicMultiplyCommand()), std::bad_alloc);
+  queue.Wait();
+}
+
+}  // namespace hexl
+}  // namespace intel
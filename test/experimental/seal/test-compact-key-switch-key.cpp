@@ -0,0 +1,233 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "experimental/seal/compact-key-switch-key-internal.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/compact-key-switch-key.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Test vector from RFC 8439, section 2.3.2
+TEST(CompactKeySwitchKey, chacha20) {
+  uint64_t key[4] = {0x0706050403020100, 0x0f0e0d0c0b0a0908,
+                     0x1716151413121110, 0x1f1e1d1c1b1a1918};
+  uint64_t counter = 0x0900000000000001;
+  uint64_t nonce = 0x000000004a000000;
+
+  std::vector<uint32_t> block(16);
+  internal::ChaCha20Block(block.data(), key, counter, nonce);
+
+  std::vector<uint32_t> expected{
+      0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3, 0xc7f4d1c7, 0x0368c033,
+      0x9aaa2204, 0x4e6cd4c3, 0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+      0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2};
+  EXPECT_EQ(block, expected);
+}
+
+TEST(CompactKeySwitchKey, pack_bits) {
+  uint64_t n = 37;
+  for (uint64_t bit_width = 1; bit_width <= 64; ++bit_width) {
+    uint64_t max_value = (bit_width == 64) ? ~uint64_t(0)
+                                           : (uint64_t(1) << bit_width) - 1;
+    auto values = GenerateInsecureUniformRandomValues(n, 0, max_value);
+    values[0] = max_value;
+
+    std::vector<uint64_t> packed((n * bit_width + 63) / 64);
+    internal::PackBits(packed.data(), values.data(), n, bit_width);
+    std::vector<uint64_t> unpacked(n);
+    internal::UnpackBits(unpacked.data(), packed.data(), n, bit_width);
+    AssertEqual(unpacked, values);
+  }
+}
+
+TEST(CompactKeySwitchKey, expand_uniform) {
+  uint64_t n = 1024;
+  uint64_t modulus = GeneratePrimes(1, 40, true, n)[0];
+  uint64_t seed[4] = {1, 2, 3, 4};
+
+  std::vector<uint64_t> a(n);
+  std::vector<uint64_t> b(n);
+  internal::ExpandUniform(a.data(), seed, 0, n, modulus);
+  internal::ExpandUniform(b.data(), seed, 0, n, modulus);
+  AssertEqual(a, b);
+  for (uint64_t value : a) {
+    ASSERT_LT(value, modulus);
+  }
+
+  // Different streams differ
+  internal::ExpandUniform(b.data(), seed, 1, n, modulus);
+  EXPECT_NE(a, b);
+  seed[3] = 5;
+  internal::ExpandUniform(b.data(), seed, 0, n, modulus);
+  EXPECT_NE(a, b);
+}
+
+// Checks KeySwitch with compact keys, seeded or not and in memory or
+// memory-mapped, matches KeySwitch with the same keys in the usual layout
+TEST(CompactKeySwitchKey, key_switch) {
+  uint64_t n = 1024;
+  uint64_t decomp_modulus_size = 3;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+  uint64_t seed[CompactKeySwitchKey::kSeedSize] = {0x0123456789abcdef, 42, 7,
+                                                   0xfedcba9876543210};
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 45, true, n);
+  std::vector<NTT> ntts;
+  for (uint64_t modulus : moduli) {
+    ntts.emplace_back(n, modulus);
+  }
+
+  std::vector<uint64_t> input;
+  std::vector<uint64_t> modswitch_factors;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+    input.insert(input.end(), poly.begin(), poly.end());
+    modswitch_factors.push_back(
+        InverseMod(moduli.back() % moduli[i], moduli[i]));
+  }
+
+  for (const uint64_t* key_seed : {static_cast<const uint64_t*>(nullptr),
+                                   static_cast<const uint64_t*>(seed)}) {
+    CompactKeySwitchKey compact(n, moduli, decomp_modulus_size,
+                                key_component_count, key_seed);
+
+    // For a seeded key, the last component is the expanded seed
+    std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+    std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+    for (size_t j = 0; j < decomp_modulus_size; ++j) {
+      keys[j].resize(key_component_count * key_modulus_size * n);
+      for (size_t k = 0; k < key_component_count; ++k) {
+        for (size_t m = 0; m < key_modulus_size; ++m) {
+          uint64_t* limb = &keys[j][(k * key_modulus_size + m) * n];
+          if (key_seed != nullptr && k == key_component_count - 1) {
+            compact.GetLimb(limb, j, k, m);
+          } else {
+            auto values = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+            std::copy(values.begin(), values.end(), limb);
+          }
+        }
+      }
+      key_ptrs[j] = keys[j].data();
+    }
+    compact.SetKeys(key_ptrs.data());
+    EXPECT_LT(compact.StorageSize(),
+              decomp_modulus_size * keys[0].size() * sizeof(uint64_t));
+
+    std::vector<uint64_t> limb(n);
+    for (size_t j = 0; j < decomp_modulus_size; ++j) {
+      for (size_t k = 0; k < key_component_count; ++k) {
+        for (size_t m = 0; m < key_modulus_size; ++m) {
+          compact.GetLimb(limb.data(), j, k, m);
+          std::vector<uint64_t> expected(
+              &keys[j][(k * key_modulus_size + m) * n],
+              &keys[j][(k * key_modulus_size + m + 1) * n]);
+          AssertEqual(limb, expected);
+        }
+      }
+    }
+
+    std::vector<uint64_t> expected(
+        key_component_count * decomp_modulus_size * n, 0);
+    KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts);
+
+    std::vector<uint64_t> result(expected.size(), 0);
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), compact, modswitch_factors.data(), ntts);
+    AssertEqual(result, expected);
+
+    std::string path = ::testing::TempDir() + "hexl-compact-key-switch-key";
+    compact.Save(path);
+    {
+      CompactKeySwitchKey mapped = CompactKeySwitchKey::Map(path);
+      EXPECT_TRUE(mapped.IsMapped());
+      EXPECT_EQ(mapped.IsSeeded(), key_seed != nullptr);
+      EXPECT_EQ(mapped.GetModuli(), moduli);
+      EXPECT_EQ(mapped.StorageSize(), compact.StorageSize());
+
+      ThreadExecutor executor(3);
+      std::fill(result.begin(), result.end(), 0);
+      KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), mapped, modswitch_factors.data(), ntts,
+                &executor);
+      AssertEqual(result, expected);
+    }
+    std::remove(path.c_str());
+  }
+}
+
+// Map rejects files whose header fields are inconsistent with the file
+TEST(CompactKeySwitchKey, map_invalid) {
+  uint64_t n = 64;
+  std::vector<uint64_t> moduli = GeneratePrimes(3, 40, true, n);
+  uint64_t seed[CompactKeySwitchKey::kSeedSize] = {1, 2, 3, 4};
+  CompactKeySwitchKey compact(n, moduli, 2, 2, seed);
+
+  std::string path = ::testing::TempDir() + "hexl-compact-key-switch-key";
+  compact.Save(path);
+  std::vector<uint64_t> words;
+  {
+    std::ifstream file(path, std::ios::binary);
+    uint64_t word;
+    while (file.read(reinterpret_cast<char*>(&word), sizeof(word))) {
+      words.push_back(word);
+    }
+  }
+  EXPECT_NO_THROW(CompactKeySwitchKey::Map(path));
+
+  // Writes the file with header word index set to value, then maps it
+  auto map_with = [&](size_t index, uint64_t value, size_t num_words) {
+    std::vector<uint64_t> corrupt(words.begin(), words.begin() + num_words);
+    if (index < num_words) {
+      corrupt[index] = value;
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(corrupt.data()),
+               static_cast<std::streamsize>(num_words * sizeof(uint64_t)));
+    file.close();
+    CompactKeySwitchKey::Map(path);
+  };
+  uint64_t max_value = ~uint64_t(0);
+  size_t num_words = words.size();
+  size_t moduli_index = 6 + CompactKeySwitchKey::kSeedSize;
+
+  EXPECT_THROW(map_with(0, 0, num_words), std::runtime_error);  // Magic
+  EXPECT_THROW(map_with(1, 0, num_words), std::runtime_error);  // n
+  EXPECT_THROW(map_with(1, max_value, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(1, uint64_t(1) << 58, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(2, 0, num_words), std::runtime_error);  // Moduli
+  EXPECT_THROW(map_with(2, max_value, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(2, max_value - 3, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(3, max_value, num_words), std::runtime_error);  // Keys
+  EXPECT_THROW(map_with(3, max_value / 2, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(4, 0, num_words), std::runtime_error);  // Components
+  EXPECT_THROW(map_with(4, max_value, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(5, 2, num_words), std::runtime_error);  // Seeded
+  EXPECT_THROW(map_with(moduli_index, 0, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(moduli_index + 2, 1, num_words), std::runtime_error);
+  EXPECT_THROW(map_with(0, 0, 4), std::runtime_error);  // Truncated header
+  EXPECT_THROW(map_with(num_words, 0, num_words - 1), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,217 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "experimental/seal/dyadic-multiply-avx512.hpp"
+#include "hexl/experimental/seal/dyadic-multiply-internal.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/cpu-features.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+#ifdef HEXL_HAS_AVX512DQ
+
+// Returns the two limbs of one modulus, each of length elements, with the
+// largest possible products first
+inline std::vector<uint64_t> GenerateDyadicOperand(uint64_t length,
+                                                   uint64_t modulus) {
+  auto values = GenerateInsecureUniformRandomValues(2 * length, 0, modulus);
+  values[0] = modulus - 1;
+  values[length] = modulus - 1;
+  return std::vector<uint64_t>(values.begin(), values.end());
+}
+
+// Checks the AVX512 fused and Karatsuba kernels match the native kernels, in
+// and out of place
+template <int BitShift>
+void CheckDyadicMultiplyAVX512(const std::vector<uint64_t>& bit_sizes) {
+  uint64_t length = 1024;
+  for (uint64_t bits : bit_sizes) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, length)[0];
+    auto op1 = GenerateDyadicOperand(length, modulus);
+    auto op2 = GenerateDyadicOperand(length, modulus);
+
+    std::vector<uint64_t> expected(3 * length, 0);
+    DyadicMultiplyFusedNative(expected.data(), op1.data(), op2.data(), length,
+                              length, modulus);
+    std::vector<uint64_t> karatsuba_native(3 * length, 0);
+    DyadicMultiplyKaratsubaNative(karatsuba_native.data(), op1.data(),
+                                  op2.data(), length, length, modulus);
+    AssertEqual(karatsuba_native, expected);
+
+    std::vector<uint64_t> fused(3 * length, 0);
+    DyadicMultiplyFusedAVX512<BitShift>(fused.data(), op1.data(), op2.data(),
+                                        length, length, modulus);
+    AssertEqual(fused, expected);
+
+    std::vector<uint64_t> karatsuba(op1);
+    karatsuba.resize(3 * length);
+    DyadicMultiplyKaratsubaAVX512<BitShift>(karatsuba.data(), karatsuba.data(),
+                                            op2.data(), length, length,
+                                            modulus);
+    AssertEqual(karatsuba, expected);
+  }
+}
+
+// Checks the AVX512 accumulation kernel matches the native kernel, with a
+// length not a multiple of the tile size
+template <int BitShift>
+void CheckDyadicMultiplyAccumulateAVX512(
+    const std::vector<uint64_t>& bit_sizes) {
+  uint64_t length = 1000;
+  uint64_t num_pairs = 5;
+  for (uint64_t bits : bit_sizes) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, 1024)[0];
+    auto op1 = GenerateDyadicOperand(num_pairs * length, modulus);
+    auto op2 = GenerateDyadicOperand(num_pairs * length, modulus);
+
+    for (uint64_t pairs = 1; pairs <= num_pairs; ++pairs) {
+      std::vector<uint64_t> expected(3 * length, 0);
+      DyadicMultiplyAccumulateNative(expected.data(), op1.data(), op2.data(),
+                                     pairs, 2 * length, length, length,
+                                     modulus);
+      std::vector<uint64_t> result(3 * length, 0);
+      DyadicMultiplyAccumulateAVX512<BitShift>(result.data(), op1.data(),
+                                               op2.data(), pairs, 2 * length,
+                                               length, length, modulus);
+      AssertEqual(result, expected);
+    }
+  }
+}
+
+// Checks the AVX512 plaintext multiply-accumulate kernels match the native
+// kernels, with and without Shoup factors
+template <int BitShift>
+void CheckPlainMultiplyAccumulateAVX512(
+    const std::vector<uint64_t>& bit_sizes) {
+  uint64_t length = 1024;
+  for (uint64_t bits : bit_sizes) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, length)[0];
+    auto plain = GenerateDyadicOperand(length / 2, modulus);
+    auto cipher = GenerateDyadicOperand(length, modulus);
+    auto acc = GenerateDyadicOperand(length, modulus);
+    std::vector<uint64_t> plain_shoup(length);
+    for (size_t l = 0; l < length; ++l) {
+      plain_shoup[l] = MultiplyFactor(plain[l], 64, modulus).BarrettFactor();
+    }
+
+    std::vector<uint64_t> expected(acc);
+    PlainMultiplyAccumulateNative(expected.data(), plain.data(), nullptr,
+                                  cipher.data(), length, length, modulus);
+    std::vector<uint64_t> shoup_native(acc);
+    PlainMultiplyAccumulateNative(shoup_native.data(), plain.data(),
+                                  plain_shoup.data(), cipher.data(), length,
+                                  length, modulus);
+    AssertEqual(shoup_native, expected);
+
+    std::vector<uint64_t> result(acc);
+    PlainMultiplyAccumulateAVX512<BitShift>(result.data(), plain.data(),
+                                            cipher.data(), length, length,
+                                            modulus);
+    AssertEqual(result, expected);
+
+    std::vector<uint64_t> shoup(acc);
+    PlainMultiplyAccumulateShoupAVX512<BitShift>(shoup.data(), plain.data(),
+                                       plain_shoup.data(), cipher.data(),
+                                       length, length, modulus);
+    AssertEqual(shoup, expected);
+  }
+}
+
+// Checks the AVX512 diagonal accumulation kernel matches the native kernel,
+// with a length not a multiple of the tile size
+template <int BitShift>
+void CheckDiagonalMultiplyAccumulateAVX512(
+    const std::vector<uint64_t>& bit_sizes) {
+  uint64_t length = 1000;
+  uint64_t num_terms = 5;
+  for (uint64_t bits : bit_sizes) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, 1024)[0];
+    auto plain = GenerateDyadicOperand(num_terms * length / 2, modulus);
+    auto cipher = GenerateDyadicOperand(num_terms * length, modulus);
+
+    for (uint64_t terms = 1; terms <= num_terms; ++terms) {
+      std::vector<uint64_t> expected(2 * length, 0);
+      DiagonalMultiplyAccumulateNative(expected.data(), plain.data(),
+                                       cipher.data(), terms, length,
+                                       2 * length, length, length, modulus);
+      std::vector<uint64_t> result(2 * length, 0);
+      DiagonalMultiplyAccumulateAVX512<BitShift>(
+          result.data(), plain.data(), cipher.data(), terms, length,
+          2 * length, length, length, modulus);
+      AssertEqual(result, expected);
+    }
+  }
+}
+
+// Checks the AVX512 tensor product and square kernels match the native
+// kernels, in place
+template <int BitShift>
+void CheckDyadicTensorAVX512(const std::vector<uint64_t>& bit_sizes) {
+  uint64_t length = 1024;
+  uint64_t size = 4;
+  for (uint64_t bits : bit_sizes) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, length)[0];
+    auto op1 = GenerateDyadicOperand(size * length / 2, modulus);
+    auto op2 = GenerateDyadicOperand(size * length / 2, modulus);
+
+    for (uint64_t size1 = 1; size1 <= size; ++size1) {
+      uint64_t result_size = size1 + size - 1;
+      std::vector<uint64_t> expected(result_size * length, 0);
+      DyadicTensorProductNative(expected.data(), op1.data(), size1, op2.data(),
+                                size, length, length, modulus);
+      std::vector<uint64_t> product(op1.begin(), op1.begin() + size1 * length);
+      product.resize(result_size * length);
+      DyadicTensorProductAVX512<BitShift>(product.data(), product.data(),
+                                          size1, op2.data(), size, length,
+                                          length, modulus);
+      AssertEqual(product, expected);
+
+      expected.assign((2 * size1 - 1) * length, 0);
+      DyadicTensorSquareNative(expected.data(), op1.data(), size1, length,
+                               length, modulus);
+      std::vector<uint64_t> square(op1.begin(), op1.begin() + size1 * length);
+      square.resize((2 * size1 - 1) * length);
+      DyadicTensorSquareAVX512<BitShift>(square.data(), square.data(), size1,
+                                         length, length, modulus);
+      AssertEqual(square, expected);
+    }
+  }
+}
+
+TEST(DyadicMultiply, AVX512DQ) {
+  if (!GetCpuFeatures().avx512dq) {
+    GTEST_SKIP();
+  }
+  CheckDyadicMultiplyAVX512<64>({20, 30, 40, 50, 60, 61});
+  CheckDyadicMultiplyAccumulateAVX512<64>({20, 30, 40, 50, 60, 61});
+  CheckDiagonalMultiplyAccumulateAVX512<64>({20, 30, 40, 50, 60, 61});
+  CheckPlainMultiplyAccumulateAVX512<64>({20, 30, 40, 50, 60, 61});
+  CheckDyadicTensorAVX512<64>({20, 30, 40, 50, 60, 61});
+}
+
+#ifdef HEXL_HAS_AVX512IFMA
+TEST(DyadicMultiply, AVX512IFMA) {
+  if (!GetCpuFeatures().avx512ifma) {
+    GTEST_SKIP();
+  }
+  CheckDyadicMultiplyAVX512<52>({20, 30, 40, 48, 49});
+  CheckDyadicMultiplyAccumulateAVX512<52>({20, 30, 40, 48, 49});
+  CheckDiagonalMultiplyAccumulateAVX512<52>({20, 30, 40, 48, 49});
+  CheckPlainMultiplyAccumulateAVX512<52>({20, 30, 40, 48, 49});
+  CheckDyadicTensorAVX512<52>({20, 30, 40, 48, 49});
+}
+#endif
+
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
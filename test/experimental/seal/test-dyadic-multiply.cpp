@@ -3,12 +3,18 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
+#include "hexl/experimental/misc/executor.hpp"
 #include "hexl/experimental/seal/dyadic-multiply.hpp"
 #include "hexl/logging/logging.hpp"
 #include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/cache-info.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/instrumentation.hpp"
 #include "test-util.hpp"
+#include "util/util-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -154,5 +160,404 @@ TEST(DyadicMultiply, small_two_mod) {
   CheckEqual(out, exp_out);
 }
 
+TEST(DyadicMultiply, workspace) {
+  for (size_t coeff_count : {8, 1024, 4096}) {
+    std::vector<uint64_t> moduli = GeneratePrimes(3, 50, true, coeff_count);
+
+    std::vector<uint64_t> op1;
+    std::vector<uint64_t> op2;
+    for (size_t poly = 0; poly < 2; ++poly) {
+      for (uint64_t modulus : moduli) {
+        auto values1 =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+        auto values2 =
+            GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+        op1.insert(op1.end(), values1.begin(), values1.end());
+        op2.insert(op2.end(), values2.begin(), values2.end());
+      }
+    }
+
+    std::vector<uint64_t> exp_out(3 * coeff_count * moduli.size(), 0);
+    DyadicMultiply(exp_out.data(), op1.data(), op2.data(), coeff_count,
+                   moduli.data(), moduli.size());
+
+    // The workspace need not be initialized
+    std::vector<uint64_t> workspace(DyadicMultiplyWorkspaceSize(coeff_count),
+                                    0xFFFFFFFFFFFFFFFF);
+    std::vector<uint64_t> out(exp_out.size(), 0);
+    DyadicMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                   moduli.data(), moduli.size(), workspace.data());
+    CheckEqual(out, exp_out);
+
+    // The workspace suffices for any tile size chosen from the cache sizes
+    for (uint64_t l1_data_cache_size : {4 * 1024, 1024 * 1024}) {
+      SetCacheSizes(l1_data_cache_size, 0);
+      std::fill(out.begin(), out.end(), 0);
+      DyadicMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                     moduli.data(), moduli.size(), workspace.data());
+      CheckEqual(out, exp_out);
+    }
+    SetCacheSizes(0, 0);
+  }
+}
+
+// Checks the element-wise fallback where the tile size does not divide n
+TEST(DyadicMultiply, partial_tile) {
+  // A 16 KiB L1 data cache gives tiles of 256 coefficients
+  uint64_t n = 320;
+  std::vector<uint64_t> moduli{(1ULL << 49) + 1,
+                               GeneratePrimes(1, 62, true, 1024)[0]};
+  size_t poly_size = n * moduli.size();
+
+  auto op1 = GenerateInsecureUniformRandomValues(2 * poly_size, 0, 1ULL << 49);
+  auto op2 = GenerateInsecureUniformRandomValues(2 * poly_size, 0, 1ULL << 49);
+  std::vector<uint64_t> exp_out(3 * poly_size);
+  for (size_t i = 0; i < moduli.size(); ++i) {
+    uint64_t q = moduli[i];
+    for (size_t j = i * n; j < (i + 1) * n; ++j) {
+      uint64_t x0 = op1[j];
+      uint64_t x1 = op1[j + poly_size];
+      uint64_t y0 = op2[j];
+      uint64_t y1 = op2[j + poly_size];
+      exp_out[j] = MultiplyMod(x0, y0, q);
+      exp_out[j + poly_size] =
+          AddUIntMod(MultiplyMod(x0, y1, q), MultiplyMod(x1, y0, q), q);
+      exp_out[j + 2 * poly_size] = MultiplyMod(x1, y1, q);
+    }
+  }
+
+  // Three-polynomial operands take the tensor kernels rather than those of
+  // DyadicMultiply
+  size_t size = 3;
+  auto op3 =
+      GenerateInsecureUniformRandomValues(size * poly_size, 0, 1ULL << 49);
+  std::vector<uint64_t> exp_tensor((2 * size - 1) * poly_size, 0);
+  for (size_t i = 0; i < moduli.size(); ++i) {
+    for (size_t j = i * n; j < (i + 1) * n; ++j) {
+      for (size_t k1 = 0; k1 < size; ++k1) {
+        for (size_t k2 = 0; k2 < size; ++k2) {
+          uint64_t& out = exp_tensor[j + (k1 + k2) * poly_size];
+          out = AddUIntMod(out,
+                           MultiplyMod(op3[j + k1 * poly_size],
+                                       op3[j + k2 * poly_size], moduli[i]),
+                           moduli[i]);
+        }
+      }
+    }
+  }
+
+  SetCacheSizes(16 * 1024, 1 << 20);
+  std::vector<uint64_t> out(exp_out.size(), 0);
+  DyadicMultiply(out.data(), op1.data(), op2.data(), n, moduli.data(),
+                 moduli.size());
+  std::vector<uint64_t> tensor(exp_tensor.size(), 0);
+  DyadicTensorProduct(tensor.data(), op3.data(), size, op3.data(), size, n,
+                      moduli.data(), moduli.size());
+  std::vector<uint64_t> square(exp_tensor.size(), 0);
+  DyadicTensorSquare(square.data(), op3.data(), size, n, moduli.data(),
+                     moduli.size());
+  SetCacheSizes(0, 0);
+  CheckEqual(out, exp_out);
+  CheckEqual(tensor, exp_tensor);
+  CheckEqual(square, exp_tensor);
+}
+
+// Checks DyadicMultiply and DyadicMultiplyKaratsuba against a reference for
+// moduli handled by each kernel, in and out of place
+TEST(DyadicMultiply, karatsuba) {
+  for (size_t coeff_count : {3, 1024}) {
+    for (size_t bits : {20, 48, 49, 50, 60, 61, 62}) {
+      std::vector<uint64_t> moduli =
+          GeneratePrimes(2, bits, true, coeff_count == 3 ? 2 : coeff_count);
+      uint64_t num_moduli = moduli.size();
+      uint64_t poly_size = coeff_count * num_moduli;
+
+      std::vector<uint64_t> op1;
+      std::vector<uint64_t> op2;
+      for (size_t poly = 0; poly < 2; ++poly) {
+        for (uint64_t modulus : moduli) {
+          auto values1 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          auto values2 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          // Largest possible products
+          values1[0] = modulus - 1;
+          values2[0] = modulus - 1;
+          op1.insert(op1.end(), values1.begin(), values1.end());
+          op2.insert(op2.end(), values2.begin(), values2.end());
+        }
+      }
+
+      std::vector<uint64_t> exp_out(3 * poly_size, 0);
+      for (size_t i = 0; i < num_moduli; ++i) {
+        uint64_t modulus = moduli[i];
+        for (size_t l = i * coeff_count; l < (i + 1) * coeff_count; ++l) {
+          uint64_t x0 = op1[l];
+          uint64_t x1 = op1[l + poly_size];
+          uint64_t y0 = op2[l];
+          uint64_t y1 = op2[l + poly_size];
+          exp_out[l] = MultiplyMod(x0, y0, modulus);
+          exp_out[l + poly_size] =
+              AddUIntMod(MultiplyMod(x0, y1, modulus),
+                         MultiplyMod(x1, y0, modulus), modulus);
+          exp_out[l + 2 * poly_size] = MultiplyMod(x1, y1, modulus);
+        }
+      }
+
+      std::vector<uint64_t> out(exp_out.size(), 0);
+      DyadicMultiply(out.data(), op1.data(), op2.data(), coeff_count,
+                     moduli.data(), num_moduli);
+      AssertEqual(out, exp_out);
+
+      std::fill(out.begin(), out.end(), 0);
+      DyadicMultiplyKaratsuba(out.data(), op1.data(), op2.data(), coeff_count,
+                              moduli.data(), num_moduli);
+      AssertEqual(out, exp_out);
+
+      std::vector<uint64_t> inplace(op1);
+      inplace.resize(exp_out.size());
+      DyadicMultiplyKaratsuba(inplace.data(), inplace.data(), op2.data(),
+                              coeff_count, moduli.data(), num_moduli);
+      AssertEqual(inplace, exp_out);
+    }
+  }
+}
+
+// Checks DyadicTensorProduct and DyadicTensorSquare against a reference for
+// ciphertexts of up to five polynomials, in and out of place
+TEST(DyadicMultiply, tensor_product) {
+  for (size_t coeff_count : {3, 1024}) {
+    for (size_t bits : {20, 48, 49, 50, 60, 61, 62}) {
+      std::vector<uint64_t> moduli =
+          GeneratePrimes(2, bits, true, coeff_count == 3 ? 2 : coeff_count);
+      uint64_t num_moduli = moduli.size();
+      uint64_t poly_size = coeff_count * num_moduli;
+
+      // Returns size polynomials, with the largest possible products first
+      auto generate_operand = [&](size_t size) {
+        std::vector<uint64_t> op;
+        for (size_t poly = 0; poly < size; ++poly) {
+          for (uint64_t modulus : moduli) {
+            auto values =
+                GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+            values[0] = modulus - 1;
+            op.insert(op.end(), values.begin(), values.end());
+          }
+        }
+        return op;
+      };
+
+      for (size_t size1 = 1; size1 <= 5; ++size1) {
+        for (size_t size2 = 1; size2 <= 5; ++size2) {
+          size_t result_size = size1 + size2 - 1;
+          std::vector<uint64_t> op1 = generate_operand(size1);
+          std::vector<uint64_t> op2 =
+              (size1 == size2) ? op1 : generate_operand(size2);
+
+          std::vector<uint64_t> exp_out(result_size * poly_size, 0);
+          for (size_t i = 0; i < num_moduli; ++i) {
+            uint64_t modulus = moduli[i];
+            for (size_t l = i * coeff_count; l < (i + 1) * coeff_count; ++l) {
+              for (size_t j1 = 0; j1 < size1; ++j1) {
+                for (size_t j2 = 0; j2 < size2; ++j2) {
+                  uint64_t& out = exp_out[l + (j1 + j2) * poly_size];
+                  out = AddUIntMod(out,
+                                   MultiplyMod(op1[l + j1 * poly_size],
+                                               op2[l + j2 * poly_size],
+                                               modulus),
+                                   modulus);
+                }
+              }
+            }
+          }
+
+          std::vector<uint64_t> out(exp_out.size(), 0);
+          DyadicTensorProduct(out.data(), op1.data(), size1, op2.data(), size2,
+                              coeff_count, moduli.data(), num_moduli);
+          AssertEqual(out, exp_out);
+
+          std::vector<uint64_t> inplace(op1);
+          inplace.resize(exp_out.size());
+          DyadicTensorProduct(inplace.data(), inplace.data(), size1,
+                              op2.data(), size2, coeff_count, moduli.data(),
+                              num_moduli);
+          AssertEqual(inplace, exp_out);
+
+          inplace = op2;
+          inplace.resize(exp_out.size());
+          DyadicTensorProduct(inplace.data(), op1.data(), size1,
+                              inplace.data(), size2, coeff_count,
+                              moduli.data(), num_moduli);
+          AssertEqual(inplace, exp_out);
+
+          if (size1 != size2) {
+            continue;
+          }
+          std::fill(out.begin(), out.end(), 0);
+          DyadicTensorSquare(out.data(), op1.data(), size1, coeff_count,
+                             moduli.data(), num_moduli);
+          AssertEqual(out, exp_out);
+
+          inplace = op1;
+          inplace.resize(exp_out.size());
+          DyadicTensorSquare(inplace.data(), inplace.data(), size1,
+                             coeff_count, moduli.data(), num_moduli);
+          AssertEqual(inplace, exp_out);
+        }
+      }
+    }
+  }
+}
+
+// Checks DyadicMultiplyBatch matches DyadicMultiply on each pair, with and
+// without an executor and workspace, and with results in place
+// Checks PlainMultiplyAccumulate with and without Shoup factors, out of place
+// and in place, against separate multiplications and additions
+TEST(DyadicMultiply, plain_multiply_accumulate) {
+  for (size_t coeff_count : {3, 1024}) {
+    for (size_t bits : {20, 48, 49, 50, 60, 61, 62}) {
+      std::vector<uint64_t> moduli =
+          GeneratePrimes(2, bits, true, coeff_count == 3 ? 2 : coeff_count);
+      uint64_t num_moduli = moduli.size();
+      uint64_t poly_size = coeff_count * num_moduli;
+
+      // Returns size polynomials, with the largest possible values first
+      auto generate_operand = [&](size_t size) {
+        std::vector<uint64_t> op;
+        for (size_t poly = 0; poly < size; ++poly) {
+          for (uint64_t modulus : moduli) {
+            auto values =
+                GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+            values[0] = modulus - 1;
+            op.insert(op.end(), values.begin(), values.end());
+          }
+        }
+        return op;
+      };
+      std::vector<uint64_t> plain = generate_operand(1);
+      std::vector<uint64_t> cipher = generate_operand(2);
+      std::vector<uint64_t> acc = generate_operand(2);
+
+      std::vector<uint64_t> exp_out(acc);
+      std::vector<uint64_t> exp_in_place(cipher);
+      for (size_t i = 0; i < num_moduli; ++i) {
+        uint64_t modulus = moduli[i];
+        for (size_t l = i * coeff_count; l < (i + 1) * coeff_count; ++l) {
+          for (size_t k = 0; k < 2; ++k) {
+            size_t index = l + k * poly_size;
+            uint64_t product = MultiplyMod(plain[l], cipher[index], modulus);
+            exp_out[index] = AddUIntMod(exp_out[index], product, modulus);
+            exp_in_place[index] =
+                AddUIntMod(exp_in_place[index], product, modulus);
+          }
+        }
+      }
+
+      std::vector<uint64_t> plain_shoup(plain.size());
+      PlainMultiplyShoupFactors(plain_shoup.data(), plain.data(), coeff_count,
+                                moduli.data(), num_moduli);
+      for (const uint64_t* shoup :
+           {static_cast<const uint64_t*>(nullptr),
+            static_cast<const uint64_t*>(plain_shoup.data())}) {
+        std::vector<uint64_t> out(acc);
+        PlainMultiplyAccumulate(out.data(), plain.data(), cipher.data(),
+                                coeff_count, moduli.data(), num_moduli, shoup);
+        AssertEqual(out, exp_out);
+
+        std::vector<uint64_t> in_place(cipher);
+        PlainMultiplyAccumulate(in_place.data(), plain.data(), in_place.data(),
+                                coeff_count, moduli.data(), num_moduli, shoup);
+        AssertEqual(in_place, exp_in_place);
+      }
+    }
+  }
+}
+
+TEST(DyadicMultiply, batch) {
+  size_t coeff_count = 1024;
+  size_t batch_size = 7;
+  for (size_t bits : {40, 50, 60, 62}) {
+    std::vector<uint64_t> moduli = GeneratePrimes(3, bits, true, coeff_count);
+    uint64_t num_moduli = moduli.size();
+
+    std::vector<std::vector<uint64_t>> op1s(batch_size);
+    std::vector<std::vector<uint64_t>> op2s(batch_size);
+    std::vector<std::vector<uint64_t>> expected(batch_size);
+    for (size_t b = 0; b < batch_size; ++b) {
+      for (size_t poly = 0; poly < 2; ++poly) {
+        for (uint64_t modulus : moduli) {
+          auto values1 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          auto values2 =
+              GenerateInsecureUniformRandomValues(coeff_count, 0, modulus);
+          op1s[b].insert(op1s[b].end(), values1.begin(), values1.end());
+          op2s[b].insert(op2s[b].end(), values2.begin(), values2.end());
+        }
+      }
+      expected[b].resize(3 * coeff_count * num_moduli);
+      DyadicMultiply(expected[b].data(), op1s[b].data(), op2s[b].data(),
+                     coeff_count, moduli.data(), num_moduli);
+    }
+
+    ThreadExecutor executor(3);
+    for (Executor* batch_executor :
+         {static_cast<Executor*>(nullptr), static_cast<Executor*>(&executor)}) {
+      std::vector<uint64_t> workspace(
+          DyadicMultiplyBatchWorkspaceSize(coeff_count, batch_executor));
+      for (uint64_t* batch_workspace : {static_cast<uint64_t*>(nullptr),
+                                        workspace.data()}) {
+        // The first pair is computed in place
+        std::vector<std::vector<uint64_t>> results(batch_size);
+        std::vector<uint64_t*> result_ptrs(batch_size);
+        std::vector<const uint64_t*> op1_ptrs(batch_size);
+        std::vector<const uint64_t*> op2_ptrs(batch_size);
+        for (size_t b = 0; b < batch_size; ++b) {
+          results[b] = (b == 0) ? op1s[b] : std::vector<uint64_t>();
+          results[b].resize(expected[b].size());
+          result_ptrs[b] = results[b].data();
+          op1_ptrs[b] = (b == 0) ? results[b].data() : op1s[b].data();
+          op2_ptrs[b] = op2s[b].data();
+        }
+
+        DyadicMultiplyBatch(result_ptrs.data(), op1_ptrs.data(),
+                            op2_ptrs.data(), batch_size, coeff_count,
+                            moduli.data(), num_moduli, batch_executor,
+                            batch_workspace);
+        for (size_t b = 0; b < batch_size; ++b) {
+          AssertEqual(results[b], expected[b]);
+        }
+      }
+    }
+  }
+}
+
+// Each DyadicMultiply call is recorded once, in addition to the element-wise
+// kernels it calls
+TEST(DyadicMultiply, instrumentation) {
+  bool enabled = IsInstrumentationEnabled();
+  EnableInstrumentation();
+  ResetInstrumentation();
+
+  uint64_t n = 64;
+  std::vector<uint64_t> moduli = GeneratePrimes(2, 45, true, n);
+  std::vector<uint64_t> op1(2 * n * moduli.size(), 1);
+  std::vector<uint64_t> op2(2 * n * moduli.size(), 2);
+  std::vector<uint64_t> out(3 * n * moduli.size());
+  DyadicMultiply(out.data(), op1.data(), op2.data(), n, moduli.data(),
+                 moduli.size());
+
+  const KernelStats stats =
+      GetInstrumentationSnapshot()[Kernel::kDyadicMultiply];
+  EXPECT_EQ(stats.calls, 1ULL);
+  EXPECT_EQ(stats.elements, 4 * n * moduli.size());
+  uint64_t max_modulus = *std::max_element(moduli.begin(), moduli.end());
+  size_t backend = static_cast<size_t>(
+      GetKernelBackend(Kernel::kDyadicMultiply, max_modulus));
+  EXPECT_EQ(stats.backend_calls[backend], 1ULL);
+
+  ResetInstrumentation();
+  EnableInstrumentation(enabled);
+}
+
 }  // namespace hexl
 }  // namespace intel
@@ -0,0 +1,235 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/hybrid-key-switch.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/logging/logging.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Returns a random ternary polynomial in NTT form modulo each of moduli
+inline std::vector<uint64_t> GenerateTernaryNTT(
+    uint64_t n, const std::vector<uint64_t>& moduli, std::vector<NTT>& ntts) {
+  auto ternary = GenerateInsecureUniformRandomValues(n, 0, 3);
+  std::vector<uint64_t> result(moduli.size() * n);
+  for (size_t m = 0; m < moduli.size(); ++m) {
+    for (size_t l = 0; l < n; ++l) {
+      result[m * n + l] = (ternary[l] + moduli[m] - 1) % moduli[m];
+    }
+    ntts[m].ComputeForward(&result[m * n], &result[m * n], 1, 1);
+  }
+  return result;
+}
+
+// Generates noise-free key switching keys from s_from to s_to, with the
+// layout expected by HybridKeySwitch::KeySwitch
+inline std::vector<std::vector<uint64_t>> GenerateHybridKeys(
+    const HybridKeySwitch& ks, const std::vector<uint64_t>& s_from,
+    const std::vector<uint64_t>& s_to) {
+  uint64_t n = ks.GetDegree();
+  uint64_t L = ks.NumCiphertextModuli();
+  uint64_t K = ks.NumSpecialModuli();
+  uint64_t key_modulus_size = ks.KeyModulusSize();
+  const auto& moduli = ks.GetModuli();
+
+  std::vector<std::vector<uint64_t>> keys(ks.NumDigits(L));
+  for (size_t j = 0; j < keys.size(); ++j) {
+    keys[j].resize(2 * key_modulus_size * n);
+    uint64_t begin = j * ks.DigitSize();
+    uint64_t end = std::min(begin + ks.DigitSize(), L);
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      uint64_t modulus = moduli[m];
+      // P * (Q / Q_j) * [(Q / Q_j)^{-1}]_{Q_j} is P modulo the moduli of
+      // digit j, and 0 otherwise
+      uint64_t gadget = 0;
+      if (m >= begin && m < end) {
+        gadget = 1;
+        for (size_t s = 0; s < K; ++s) {
+          gadget = MultiplyMod(gadget, moduli[L + s] % modulus, modulus);
+        }
+      }
+      auto a = GenerateInsecureUniformRandomValues(n, 0, modulus);
+      for (size_t l = 0; l < n; ++l) {
+        uint64_t as = MultiplyMod(a[l], s_to[m * n + l], modulus);
+        uint64_t gs = MultiplyMod(gadget, s_from[m * n + l], modulus);
+        keys[j][m * n + l] = SubUIntMod(gs, as, modulus);
+        keys[j][(key_modulus_size + m) * n + l] = a[l];
+      }
+    }
+  }
+  return keys;
+}
+
+// Checks c0 + c1 * s_to - d * s_from is the same small integer modulo each
+// ciphertext modulus, and a multiple of plain_modulus for BGV
+inline void CheckKeySwitchError(const HybridKeySwitch& ks,
+                                std::vector<NTT>& ntts,
+                                const std::vector<uint64_t>& result,
+                                const std::vector<uint64_t>& input,
+                                uint64_t num_moduli,
+                                const std::vector<uint64_t>& s_from,
+                                const std::vector<uint64_t>& s_to,
+                                uint64_t plain_modulus) {
+  uint64_t n = ks.GetDegree();
+  bool ntt_form = (ks.GetScheme() != KeySwitchScheme::BFV);
+  int64_t bound = static_cast<int64_t>((ks.NumSpecialModuli() + 2) * (n + 1) *
+                                       std::max(plain_modulus, uint64_t(1)));
+
+  std::vector<int64_t> expected_error;
+  for (size_t i = 0; i < num_moduli; ++i) {
+    uint64_t modulus = ks.GetModuli()[i];
+    std::vector<uint64_t> c0(&result[i * n], &result[(i + 1) * n]);
+    std::vector<uint64_t> c1(&result[(num_moduli + i) * n],
+                             &result[(num_moduli + i + 1) * n]);
+    std::vector<uint64_t> d(&input[i * n], &input[(i + 1) * n]);
+    if (!ntt_form) {
+      ntts[i].ComputeForward(c0.data(), c0.data(), 1, 1);
+      ntts[i].ComputeForward(c1.data(), c1.data(), 1, 1);
+      ntts[i].ComputeForward(d.data(), d.data(), 1, 1);
+    }
+    std::vector<uint64_t> error(n);
+    for (size_t l = 0; l < n; ++l) {
+      uint64_t c1s = MultiplyMod(c1[l], s_to[i * n + l], modulus);
+      uint64_t ds = MultiplyMod(d[l], s_from[i * n + l], modulus);
+      error[l] = SubUIntMod(AddUIntMod(c0[l], c1s, modulus), ds, modulus);
+    }
+    ntts[i].ComputeInverse(error.data(), error.data(), 1, 1);
+
+    std::vector<int64_t> centered(n);
+    for (size_t l = 0; l < n; ++l) {
+      centered[l] = (error[l] > modulus / 2)
+                        ? -static_cast<int64_t>(modulus - error[l])
+                        : static_cast<int64_t>(error[l]);
+      ASSERT_LE(std::abs(centered[l]), bound);
+      if (plain_modulus > 1) {
+        ASSERT_EQ(centered[l] % static_cast<int64_t>(plain_modulus), 0);
+      }
+    }
+    if (i == 0) {
+      expected_error = centered;
+    } else {
+      ASSERT_EQ(centered, expected_error);
+    }
+  }
+}
+
+// Checks hybrid key switching is correct for each scheme, level and number of
+// digits
+TEST(HybridKeySwitch, correctness) {
+  uint64_t n = 256;
+  uint64_t L = 5;
+  uint64_t plain_modulus = 65537;
+
+  for (uint64_t K : {1, 2, 3}) {
+    std::vector<uint64_t> primes = GeneratePrimes(L + K, 45, true, n);
+    std::vector<uint64_t> q(primes.begin(), primes.begin() + L);
+    std::vector<uint64_t> p(primes.begin() + L, primes.end());
+
+    std::vector<NTT> ntts;
+    for (uint64_t modulus : primes) {
+      ntts.emplace_back(n, modulus);
+    }
+    auto s_from = GenerateTernaryNTT(n, primes, ntts);
+    auto s_to = GenerateTernaryNTT(n, primes, ntts);
+
+    for (auto scheme :
+         {KeySwitchScheme::CKKS, KeySwitchScheme::BFV, KeySwitchScheme::BGV}) {
+      uint64_t t = (scheme == KeySwitchScheme::BGV) ? plain_modulus : 0;
+      for (uint64_t dnum : {1, 2, 5}) {
+        HybridKeySwitch ks(n, q, p, dnum, scheme, t);
+        auto keys = GenerateHybridKeys(ks, s_from, s_to);
+        std::vector<const uint64_t*> key_ptrs;
+        for (const auto& key : keys) {
+          key_ptrs.push_back(key.data());
+        }
+
+        for (uint64_t num_moduli : {L, L - 1, uint64_t(1)}) {
+          std::vector<uint64_t> input;
+          for (size_t i = 0; i < num_moduli; ++i) {
+            auto poly = GenerateInsecureUniformRandomValues(n, 0, q[i]);
+            input.insert(input.end(), poly.begin(), poly.end());
+          }
+
+          std::vector<uint64_t> result(2 * num_moduli * n, 0);
+          ks.KeySwitch(result.data(), input.data(), num_moduli, 2,
+                       key_ptrs.data());
+          CheckKeySwitchError(ks, ntts, result, input, num_moduli, s_from,
+                              s_to, t);
+
+          ThreadExecutor executor(3);
+          std::vector<uint64_t> result_mt(2 * num_moduli * n, 0);
+          ks.KeySwitch(result_mt.data(), input.data(), num_moduli, 2,
+                       key_ptrs.data(), &executor);
+          AssertEqual(result_mt, result);
+        }
+      }
+    }
+  }
+}
+
+// With one digit per modulus and one special prime, hybrid key switching is
+// the key switching performed by KeySwitch
+TEST(HybridKeySwitch, matches_key_switch) {
+  uint64_t n = 1024;
+  uint64_t L = 4;
+  uint64_t key_component_count = 2;
+
+  std::vector<uint64_t> primes = GeneratePrimes(L + 1, 50, true, n);
+  std::vector<uint64_t> q(primes.begin(), primes.begin() + L);
+  std::vector<uint64_t> p{primes.back()};
+  HybridKeySwitch ks(n, q, p, L, KeySwitchScheme::CKKS);
+
+  std::vector<std::vector<uint64_t>> keys(L);
+  std::vector<const uint64_t*> key_ptrs(L);
+  for (size_t j = 0; j < L; ++j) {
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < L + 1; ++m) {
+        auto key = GenerateInsecureUniformRandomValues(n, 0, primes[m]);
+        keys[j].insert(keys[j].end(), key.begin(), key.end());
+      }
+    }
+    key_ptrs[j] = keys[j].data();
+  }
+
+  for (uint64_t num_moduli : {L, L - 2}) {
+    std::vector<uint64_t> input;
+    std::vector<uint64_t> modswitch_factors;
+    std::vector<uint64_t> result_init;
+    for (size_t i = 0; i < num_moduli; ++i) {
+      auto poly = GenerateInsecureUniformRandomValues(n, 0, q[i]);
+      input.insert(input.end(), poly.begin(), poly.end());
+      modswitch_factors.push_back(InverseMod(p[0] % q[i], q[i]));
+    }
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t i = 0; i < num_moduli; ++i) {
+        auto poly = GenerateInsecureUniformRandomValues(n, 0, q[i]);
+        result_init.insert(result_init.end(), poly.begin(), poly.end());
+      }
+    }
+
+    std::vector<uint64_t> expected = result_init;
+    KeySwitch(expected.data(), input.data(), n, num_moduli, L + 1,
+              num_moduli + 1, key_component_count, primes.data(),
+              key_ptrs.data(), modswitch_factors.data());
+
+    std::vector<uint64_t> result = result_init;
+    ks.KeySwitch(result.data(), input.data(), num_moduli, key_component_count,
+                 key_ptrs.data());
+    AssertEqual(result, expected);
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
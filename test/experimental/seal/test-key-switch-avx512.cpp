@@ -0,0 +1,157 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "experimental/seal/key-switch-avx512.hpp"
+#include "hexl/experimental/seal/key-switch-internal.hpp"
+#include "hexl/logging/logging.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/cpu-features.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+namespace internal {
+
+// Checks the AVX512DQ lazy accumulation matches the native implementation
+#ifdef HEXL_HAS_AVX512DQ
+TEST(KeySwitch, AVX512DQ) {
+  if (!GetCpuFeatures().avx512dq) {
+    GTEST_SKIP();
+  }
+
+  uint64_t length = 1024;
+  size_t num_products = 33;
+
+  for (size_t bits = 20; bits <= 60; bits += 10) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, length)[0];
+
+    std::vector<uint64_t> hi_native(length, 0);
+    std::vector<uint64_t> lo_native(length, 0);
+    std::vector<uint64_t> hi_avx(length, 0);
+    std::vector<uint64_t> lo_avx(length, 0);
+
+    for (size_t j = 0; j < num_products; ++j) {
+      auto operand =
+          GenerateInsecureUniformRandomValues(length, 0, 4 * modulus);
+      auto key = GenerateInsecureUniformRandomValues(length, 0, modulus);
+
+      KeySwitchMultiplyAccumulateNative(hi_native.data(), lo_native.data(),
+                                        operand.data(), key.data(), length);
+      KeySwitchMultiplyAccumulateAVX512<64>(hi_avx.data(), lo_avx.data(),
+                                            operand.data(), key.data(), length);
+    }
+    AssertEqual(hi_native, hi_avx);
+    AssertEqual(lo_native, lo_avx);
+
+    std::vector<uint64_t> out_native(length, 0);
+    std::vector<uint64_t> out_avx(length, 0);
+    KeySwitchReduceNative(out_native.data(), hi_native.data(), lo_native.data(),
+                          length, modulus);
+    KeySwitchReduceAVX512<64>(out_avx.data(), hi_avx.data(), lo_avx.data(),
+                              length, modulus);
+    AssertEqual(out_native, out_avx);
+  }
+}
+#endif
+
+// Checks the AVX512IFMA lazy accumulation matches the native implementation
+#ifdef HEXL_HAS_AVX512IFMA
+TEST(KeySwitch, AVX512IFMA) {
+  if (!GetCpuFeatures().avx512ifma) {
+    GTEST_SKIP();
+  }
+
+  uint64_t length = 1024;
+  size_t num_products = 33;
+
+  for (size_t bits = 20; bits < 50; bits += 10) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, length)[0];
+
+    std::vector<uint64_t> hi_native(length, 0);
+    std::vector<uint64_t> lo_native(length, 0);
+    std::vector<uint64_t> hi_avx(length, 0);
+    std::vector<uint64_t> lo_avx(length, 0);
+
+    for (size_t j = 0; j < num_products; ++j) {
+      auto operand =
+          GenerateInsecureUniformRandomValues(length, 0, 4 * modulus);
+      auto key = GenerateInsecureUniformRandomValues(length, 0, modulus);
+
+      KeySwitchMultiplyAccumulateNative(hi_native.data(), lo_native.data(),
+                                        operand.data(), key.data(), length);
+      KeySwitchMultiplyAccumulateAVX512<52>(hi_avx.data(), lo_avx.data(),
+                                            operand.data(), key.data(), length);
+    }
+
+    std::vector<uint64_t> out_native(length, 0);
+    std::vector<uint64_t> out_avx(length, 0);
+    KeySwitchReduceNative(out_native.data(), hi_native.data(), lo_native.data(),
+                          length, modulus);
+    KeySwitchReduceAVX512<52>(out_avx.data(), hi_avx.data(), lo_avx.data(),
+                              length, modulus);
+    AssertEqual(out_native, out_avx);
+  }
+}
+#endif
+
+// Checks the AVX512 fused ModDown passes match the native implementations
+#ifdef HEXL_HAS_AVX512DQ
+TEST(KeySwitch, ModDownAVX512) {
+  if (!GetCpuFeatures().avx512dq) {
+    GTEST_SKIP();
+  }
+
+  uint64_t length = 1024;
+  for (size_t special_bits : {30, 45, 60}) {
+    uint64_t special_modulus = GeneratePrimes(1, special_bits, true, length)[0];
+    for (size_t bits = 20; bits <= 60; bits += 10) {
+      uint64_t modulus = GeneratePrimes(1, bits, false, length)[0];
+
+      auto special =
+          GenerateInsecureUniformRandomValues(length, 0, special_modulus);
+      std::vector<uint64_t> prepared_native(length, 0);
+      std::vector<uint64_t> prepared_avx(length, 0);
+      KeySwitchModDownPrepareNative(prepared_native.data(), special.data(),
+                                    length, special_modulus, modulus);
+      KeySwitchModDownPrepareAVX512(prepared_avx.data(), special.data(),
+                                    length, special_modulus, modulus);
+      AssertEqual(prepared_native, prepared_avx);
+
+      auto operand = GenerateInsecureUniformRandomValues(length, 0, modulus);
+      auto special_ntt =
+          GenerateInsecureUniformRandomValues(length, 0, 4 * modulus);
+      auto result = GenerateInsecureUniformRandomValues(length, 0, modulus);
+      uint64_t factor = GenerateInsecureUniformRandomValue(0, modulus);
+
+      auto result_native = result;
+      KeySwitchModDownAccumulateNative(result_native.data(), operand.data(),
+                                       special_ntt.data(), length, modulus,
+                                       factor);
+      auto result_avx = result;
+      KeySwitchModDownAccumulateAVX512<64>(result_avx.data(), operand.data(),
+                                           special_ntt.data(), length, modulus,
+                                           factor);
+      AssertEqual(result_native, result_avx);
+
+#ifdef HEXL_HAS_AVX512IFMA
+      if (GetCpuFeatures().avx512ifma && modulus < (1ULL << 50)) {
+        result_avx = result;
+        KeySwitchModDownAccumulateAVX512<52>(
+            result_avx.data(), operand.data(), special_ntt.data(), length,
+            modulus, factor);
+        AssertEqual(result_native, result_avx);
+      }
+#endif
+    }
+  }
+}
+#endif
+
+}  // namespace internal
+}  // namespace hexl
+}  // namespace intel
@@ -3,12 +3,18 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/key-switch-internal.hpp"
 #include "hexl/experimental/seal/key-switch.hpp"
 #include "hexl/logging/logging.hpp"
+#include "hexl/ntt/ntt.hpp"
 #include "hexl/number-theory/number-theory.hpp"
 #include "test-util.hpp"
+#include "util/util-internal.hpp"
 
 namespace intel {
 namespace hexl {
@@ -185,5 +191,603 @@ TEST(KeySwitch, small) {
   AssertEqual(input, expected_output);
 }
 
+// Checks the multi-threaded result matches the single-threaded result
+TEST(KeySwitch, executor) {
+  uint64_t n = 1024;
+  uint64_t decomp_modulus_size = 5;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 50, true, n);
+
+  std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+  std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto key = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+        keys[j].insert(keys[j].end(), key.begin(), key.end());
+      }
+    }
+    key_ptrs[j] = keys[j].data();
+  }
+
+  std::vector<uint64_t> input;
+  std::vector<uint64_t> modswitch_factors;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+    input.insert(input.end(), poly.begin(), poly.end());
+    modswitch_factors.push_back(
+        GenerateInsecureUniformRandomValue(1, moduli[i]));
+  }
+
+  std::vector<uint64_t> result_init;
+  for (size_t k = 0; k < key_component_count; ++k) {
+    for (size_t i = 0; i < decomp_modulus_size; ++i) {
+      auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+      result_init.insert(result_init.end(), poly.begin(), poly.end());
+    }
+  }
+
+  std::vector<uint64_t> expected = result_init;
+  KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+            key_modulus_size, rns_modulus_size, key_component_count,
+            moduli.data(), key_ptrs.data(), modswitch_factors.data());
+
+  for (size_t num_threads : {1, 3, 4, 16}) {
+    ThreadExecutor executor(num_threads);
+    std::vector<uint64_t> result = result_init;
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+              nullptr, &executor);
+    AssertEqual(result, expected);
+  }
+}
+
+// Checks the result with caller-provided roots of unity and pre-computed NTTs
+TEST(KeySwitch, precomputed_ntt) {
+  uint64_t n = 512;
+  uint64_t decomp_modulus_size = 3;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 55, true, n);
+
+  std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+  std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto key = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+        keys[j].insert(keys[j].end(), key.begin(), key.end());
+      }
+    }
+    key_ptrs[j] = keys[j].data();
+  }
+
+  std::vector<uint64_t> input;
+  std::vector<uint64_t> modswitch_factors;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+    input.insert(input.end(), poly.begin(), poly.end());
+    modswitch_factors.push_back(
+        GenerateInsecureUniformRandomValue(1, moduli[i]));
+  }
+
+  // Default roots of unity
+  {
+    std::vector<uint64_t> expected(
+        key_component_count * decomp_modulus_size * n, 0);
+    KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data());
+
+    std::vector<NTT> ntts;
+    std::vector<uint64_t> root_of_unity_powers;
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      ntts.emplace_back(n, moduli[m]);
+      const auto& powers = ntts.back().GetRootOfUnityPowers();
+      root_of_unity_powers.insert(root_of_unity_powers.end(), powers.begin(),
+                                  powers.end());
+    }
+
+    std::vector<uint64_t> result(expected.size(), 0);
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+              root_of_unity_powers.data());
+    AssertEqual(result, expected);
+
+    std::fill(result.begin(), result.end(), 0);
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts);
+    AssertEqual(result, expected);
+  }
+
+  // Non-minimal roots of unity
+  {
+    std::vector<NTT> ntts;
+    std::vector<uint64_t> root_of_unity_powers;
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      uint64_t root = PowMod(MinimalPrimitiveRoot(2 * n, moduli[m]), 3,
+                             moduli[m]);
+      ntts.emplace_back(n, moduli[m], root);
+      const auto& powers = ntts.back().GetRootOfUnityPowers();
+      root_of_unity_powers.insert(root_of_unity_powers.end(), powers.begin(),
+                                  powers.end());
+    }
+
+    std::vector<uint64_t> expected(
+        key_component_count * decomp_modulus_size * n, 0);
+    KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+              root_of_unity_powers.data());
+
+    std::vector<uint64_t> result(expected.size(), 0);
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts);
+    AssertEqual(result, expected);
+  }
+
+  // More roots of unity than the cached NTTs of the overload taking powers,
+  // used twice so both cache hits and evicted entries are checked
+  for (size_t trial = 0; trial < 2 * 6; ++trial) {
+    uint64_t exponent = 2 * (trial % 6) + 1;
+    std::vector<NTT> ntts;
+    std::vector<uint64_t> root_of_unity_powers;
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      uint64_t root = PowMod(MinimalPrimitiveRoot(2 * n, moduli[m]), exponent,
+                             moduli[m]);
+      ntts.emplace_back(n, moduli[m], root);
+      const auto& powers = ntts.back().GetRootOfUnityPowers();
+      root_of_unity_powers.insert(root_of_unity_powers.end(), powers.begin(),
+                                  powers.end());
+    }
+
+    std::vector<uint64_t> expected(
+        key_component_count * decomp_modulus_size * n, 0);
+    KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts);
+
+    std::vector<uint64_t> result(expected.size(), 0);
+    KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+              root_of_unity_powers.data());
+    AssertEqual(result, expected);
+  }
+}
+
+// Checks the result with a caller-provided, reused workspace
+TEST(KeySwitch, workspace) {
+  uint64_t n = 256;
+  uint64_t decomp_modulus_size = 4;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 45, true, n);
+
+  std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+  std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+  for (size_t j = 0; j < decomp_modulus_size; ++j) {
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto key = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+        keys[j].insert(keys[j].end(), key.begin(), key.end());
+      }
+    }
+    key_ptrs[j] = keys[j].data();
+  }
+
+  std::vector<uint64_t> input;
+  std::vector<uint64_t> modswitch_factors;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+    input.insert(input.end(), poly.begin(), poly.end());
+    modswitch_factors.push_back(
+        GenerateInsecureUniformRandomValue(1, moduli[i]));
+  }
+
+  std::vector<uint64_t> expected(key_component_count * decomp_modulus_size * n,
+                                 0);
+  KeySwitch(expected.data(), input.data(), n, decomp_modulus_size,
+            key_modulus_size, rns_modulus_size, key_component_count,
+            moduli.data(), key_ptrs.data(), modswitch_factors.data());
+
+  std::vector<NTT> ntts;
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    ntts.emplace_back(n, moduli[m]);
+  }
+
+  ThreadExecutor executor(3);
+  for (Executor* executor_ptr : {static_cast<Executor*>(nullptr),
+                                 static_cast<Executor*>(&executor)}) {
+    // The workspace need not be initialized
+    std::vector<uint64_t> workspace(
+        KeySwitchWorkspaceSize(n, decomp_modulus_size, rns_modulus_size,
+                               key_component_count, executor_ptr),
+        0xFFFFFFFFFFFFFFFF);
+    for (size_t trial = 0; trial < 2; ++trial) {
+      std::vector<uint64_t> result(expected.size(), 0);
+      KeySwitch(result.data(), input.data(), n, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), key_ptrs.data(), modswitch_factors.data(), ntts,
+                executor_ptr, workspace.data());
+      AssertEqual(result, expected);
+    }
+  }
+}
+
+// Checks batched key switching matches key switching each ciphertext
+TEST(KeySwitch, batch) {
+  uint64_t n = 1024;
+  uint64_t decomp_modulus_size = 3;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+  uint64_t ciphertext_size = key_component_count * decomp_modulus_size * n;
+
+  for (uint64_t modulus_bits : {40, 55}) {
+    std::vector<uint64_t> moduli =
+        GeneratePrimes(key_modulus_size, modulus_bits, true, n);
+
+    std::vector<std::vector<uint64_t>> keys(decomp_modulus_size);
+    std::vector<const uint64_t*> key_ptrs(decomp_modulus_size);
+    for (size_t j = 0; j < decomp_modulus_size; ++j) {
+      for (size_t k = 0; k < key_component_count; ++k) {
+        for (size_t m = 0; m < key_modulus_size; ++m) {
+          auto key = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+          keys[j].insert(keys[j].end(), key.begin(), key.end());
+        }
+      }
+      key_ptrs[j] = keys[j].data();
+    }
+
+    std::vector<uint64_t> modswitch_factors;
+    for (size_t i = 0; i < decomp_modulus_size; ++i) {
+      modswitch_factors.push_back(
+          GenerateInsecureUniformRandomValue(1, moduli[i]));
+    }
+
+    std::vector<NTT> ntts;
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      ntts.emplace_back(n, moduli[m]);
+    }
+
+    ThreadExecutor executor(3);
+    for (uint64_t batch_size : {1, 5, 11}) {
+      std::vector<std::vector<uint64_t>> inputs(batch_size);
+      std::vector<std::vector<uint64_t>> expected(batch_size);
+      for (size_t b = 0; b < batch_size; ++b) {
+        for (size_t i = 0; i < decomp_modulus_size; ++i) {
+          auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+          inputs[b].insert(inputs[b].end(), poly.begin(), poly.end());
+        }
+        for (size_t k = 0; k < key_component_count; ++k) {
+          for (size_t i = 0; i < decomp_modulus_size; ++i) {
+            auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+            expected[b].insert(expected[b].end(), poly.begin(), poly.end());
+          }
+        }
+      }
+      std::vector<std::vector<uint64_t>> initial = expected;
+
+      std::vector<const uint64_t*> input_ptrs;
+      for (size_t b = 0; b < batch_size; ++b) {
+        input_ptrs.push_back(inputs[b].data());
+        KeySwitch(expected[b].data(), inputs[b].data(), n, decomp_modulus_size,
+                  key_modulus_size, rns_modulus_size, key_component_count,
+                  moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+                  ntts);
+      }
+
+      for (Executor* executor_ptr : {static_cast<Executor*>(nullptr),
+                                     static_cast<Executor*>(&executor)}) {
+        std::vector<std::vector<uint64_t>> results = initial;
+        std::vector<uint64_t*> result_ptrs;
+        for (auto& result : results) {
+          ASSERT_EQ(result.size(), ciphertext_size);
+          result_ptrs.push_back(result.data());
+        }
+        std::vector<uint64_t> workspace(KeySwitchBatchWorkspaceSize(
+            n, decomp_modulus_size, rns_modulus_size, key_component_count,
+            batch_size, executor_ptr));
+        KeySwitchBatch(result_ptrs.data(), input_ptrs.data(), batch_size, n,
+                       decomp_modulus_size, key_modulus_size,
+                       rns_modulus_size, key_component_count, moduli.data(),
+                       key_ptrs.data(), modswitch_factors.data(), ntts,
+                       executor_ptr, workspace.data());
+        for (size_t b = 0; b < batch_size; ++b) {
+          AssertEqual(results[b], expected[b]);
+        }
+      }
+    }
+  }
+}
+
+// Checks the fused ModDown passes against their definitions
+TEST(KeySwitch, mod_down) {
+  uint64_t n = 64;
+  for (size_t special_bits : {30, 60}) {
+    uint64_t special_modulus = GeneratePrimes(1, special_bits, true, n)[0];
+    uint64_t half = special_modulus >> 1;
+    for (size_t bits : {20, 45, 59}) {
+      uint64_t modulus = GeneratePrimes(1, bits, false, n)[0];
+
+      auto special = GenerateInsecureUniformRandomValues(n, 0, special_modulus);
+      std::vector<uint64_t> prepared(n);
+      internal::KeySwitchModDownPrepare(prepared.data(), special.data(), n,
+                                        special_modulus, modulus);
+      for (size_t l = 0; l < n; ++l) {
+        uint64_t x = AddUIntMod(special[l], half, special_modulus) % modulus;
+        ASSERT_LT(prepared[l], 2 * modulus);
+        ASSERT_EQ(prepared[l] % modulus,
+                  SubUIntMod(x, half % modulus, modulus));
+      }
+
+      auto operand = GenerateInsecureUniformRandomValues(n, 0, modulus);
+      auto special_ntt = GenerateInsecureUniformRandomValues(n, 0, 4 * modulus);
+      auto result = GenerateInsecureUniformRandomValues(n, 0, modulus);
+      uint64_t factor = GenerateInsecureUniformRandomValue(0, modulus);
+      std::vector<uint64_t> expected(n);
+      for (size_t l = 0; l < n; ++l) {
+        uint64_t diff =
+            SubUIntMod(operand[l], special_ntt[l] % modulus, modulus);
+        expected[l] =
+            AddUIntMod(result[l], MultiplyMod(diff, factor, modulus), modulus);
+      }
+      internal::KeySwitchModDownAccumulate(result.data(), operand.data(),
+                                           special_ntt.data(), n, modulus,
+                                           factor);
+      AssertEqual(result, expected);
+    }
+  }
+}
+
+// Checks the automorphism in NTT form matches X -> X^galois_elt on
+// coefficients
+TEST(KeySwitch, galois_permute_ntt) {
+  uint64_t n = 64;
+  uint64_t modulus = GeneratePrimes(1, 40, true, n)[0];
+  NTT ntt(n, modulus);
+
+  for (uint64_t galois_elt : {uint64_t(1), uint64_t(3), uint64_t(5),
+                              uint64_t(2 * n - 1)}) {
+    auto input = GenerateInsecureUniformRandomValues(n, 0, modulus);
+    std::vector<uint64_t> expected(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t index = (i * galois_elt) % (2 * n);
+      if (index < n) {
+        expected[index] = input[i];
+      } else {
+        expected[index - n] = (modulus - input[i]) % modulus;
+      }
+    }
+    ntt.ComputeForward(expected.data(), expected.data(), 1, 1);
+
+    std::vector<uint64_t> input_ntt(n);
+    ntt.ComputeForward(input_ntt.data(), input.data(), 1, 1);
+    std::vector<uint64_t> result(n);
+    GaloisPermuteNTT(result.data(), input_ntt.data(), n, galois_elt);
+    AssertEqual(result, expected);
+  }
+}
+
+// With the identity automorphism, hoisted key switching is the key switching
+// performed by KeySwitch
+TEST(KeySwitch, hoisted_identity) {
+  uint64_t n = 1024;
+  uint64_t decomp_modulus_size = 3;
+  uint64_t key_modulus_size = decomp_modulus_size + 1;
+  uint64_t rns_modulus_size = decomp_modulus_size + 1;
+  uint64_t key_component_count = 2;
+  uint64_t num_keys = 3;
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 45, true, n);
+  std::vector<NTT> ntts;
+  for (uint64_t modulus : moduli) {
+    ntts.emplace_back(n, modulus);
+  }
+  std::vector<uint64_t> modswitch_factors;
+  std::vector<uint64_t> input;
+  for (size_t i = 0; i < decomp_modulus_size; ++i) {
+    modswitch_factors.push_back(
+        InverseMod(moduli.back() % moduli[i], moduli[i]));
+    auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+    input.insert(input.end(), poly.begin(), poly.end());
+  }
+
+  std::vector<std::vector<std::vector<uint64_t>>> keys(num_keys);
+  std::vector<std::vector<const uint64_t*>> key_ptrs(num_keys);
+  std::vector<const uint64_t**> key_set_ptrs(num_keys);
+  std::vector<std::vector<uint64_t>> expected(num_keys);
+  for (size_t r = 0; r < num_keys; ++r) {
+    keys[r].resize(decomp_modulus_size);
+    for (size_t j = 0; j < decomp_modulus_size; ++j) {
+      for (size_t k = 0; k < key_component_count; ++k) {
+        for (size_t m = 0; m < key_modulus_size; ++m) {
+          auto key = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+          keys[r][j].insert(keys[r][j].end(), key.begin(), key.end());
+        }
+      }
+      key_ptrs[r].push_back(keys[r][j].data());
+    }
+    key_set_ptrs[r] = key_ptrs[r].data();
+
+    expected[r].resize(key_component_count * decomp_modulus_size * n, 0);
+    KeySwitch(expected[r].data(), input.data(), n, decomp_modulus_size,
+              key_modulus_size, rns_modulus_size, key_component_count,
+              moduli.data(), key_ptrs[r].data(), modswitch_factors.data(),
+              ntts);
+  }
+
+  ThreadExecutor executor(3);
+  for (Executor* executor_ptr : {static_cast<Executor*>(nullptr),
+                                 static_cast<Executor*>(&executor)}) {
+    std::vector<uint64_t> decomposition(KeySwitchDecompositionSize(
+        n, decomp_modulus_size, rns_modulus_size));
+    KeySwitchDecompose(decomposition.data(), input.data(), n,
+                       decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                       moduli.data(), ntts, executor_ptr);
+
+    std::vector<uint64_t> galois_elts(num_keys, 1);
+    std::vector<std::vector<uint64_t>> results(num_keys);
+    std::vector<uint64_t*> result_ptrs;
+    for (auto& result : results) {
+      result.resize(key_component_count * decomp_modulus_size * n, 0);
+      result_ptrs.push_back(result.data());
+    }
+    KeySwitchHoisted(result_ptrs.data(), decomposition.data(),
+                     galois_elts.data(), num_keys, n, decomp_modulus_size,
+                     key_modulus_size, rns_modulus_size, key_component_count,
+                     moduli.data(), key_set_ptrs.data(),
+                     modswitch_factors.data(), ntts, executor_ptr);
+    for (size_t r = 0; r < num_keys; ++r) {
+      AssertEqual(results[r], expected[r]);
+    }
+  }
+}
+
+// Checks hoisted rotations with noise-free Galois keys decrypt to the
+// rotated plaintext, up to the ModDown rounding error
+TEST(KeySwitch, hoisted_rotations) {
+  uint64_t n = 256;
+  uint64_t num_digits = 4;
+  uint64_t key_modulus_size = num_digits + 1;
+  uint64_t key_component_count = 2;
+  std::vector<uint64_t> galois_elts{3, 5, 25, 2 * n - 1};
+  uint64_t num_keys = galois_elts.size();
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 45, true, n);
+  uint64_t special_modulus = moduli.back();
+  std::vector<NTT> ntts;
+  for (uint64_t modulus : moduli) {
+    ntts.emplace_back(n, modulus);
+  }
+
+  // Ternary secret in NTT form modulo each key modulus
+  auto ternary = GenerateInsecureUniformRandomValues(n, 0, 3);
+  std::vector<uint64_t> s(key_modulus_size * n);
+  for (size_t m = 0; m < key_modulus_size; ++m) {
+    for (size_t l = 0; l < n; ++l) {
+      s[m * n + l] = (ternary[l] + moduli[m] - 1) % moduli[m];
+    }
+    ntts[m].ComputeForward(&s[m * n], &s[m * n], 1, 1);
+  }
+
+  // Keys from the rotated secret to s: component 0 of key j is
+  // P * galois(s) - a * s modulo moduli[j], and -a * s modulo other moduli
+  std::vector<std::vector<uint64_t>> rotated_s(num_keys);
+  std::vector<std::vector<std::vector<uint64_t>>> keys(num_keys);
+  std::vector<std::vector<const uint64_t*>> key_ptrs(num_keys);
+  std::vector<const uint64_t**> key_set_ptrs(num_keys);
+  for (size_t r = 0; r < num_keys; ++r) {
+    rotated_s[r].resize(key_modulus_size * n);
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      GaloisPermuteNTT(&rotated_s[r][m * n], &s[m * n], n, galois_elts[r]);
+    }
+    keys[r].resize(num_digits);
+    for (size_t j = 0; j < num_digits; ++j) {
+      keys[r][j].resize(key_component_count * key_modulus_size * n);
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        uint64_t gadget = (m == j) ? special_modulus % moduli[m] : 0;
+        auto a = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+        for (size_t l = 0; l < n; ++l) {
+          uint64_t as = MultiplyMod(a[l], s[m * n + l], moduli[m]);
+          uint64_t gs =
+              MultiplyMod(gadget, rotated_s[r][m * n + l], moduli[m]);
+          keys[r][j][m * n + l] = SubUIntMod(gs, as, moduli[m]);
+          keys[r][j][(key_modulus_size + m) * n + l] = a[l];
+        }
+      }
+      key_ptrs[r].push_back(keys[r][j].data());
+    }
+    key_set_ptrs[r] = key_ptrs[r].data();
+  }
+
+  for (uint64_t decomp_modulus_size : {num_digits, num_digits - 2}) {
+    uint64_t rns_modulus_size = decomp_modulus_size + 1;
+    std::vector<uint64_t> modswitch_factors;
+    std::vector<uint64_t> c0;
+    std::vector<uint64_t> c1;
+    for (size_t i = 0; i < decomp_modulus_size; ++i) {
+      modswitch_factors.push_back(
+          InverseMod(special_modulus % moduli[i], moduli[i]));
+      auto poly0 = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+      auto poly1 = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+      c0.insert(c0.end(), poly0.begin(), poly0.end());
+      c1.insert(c1.end(), poly1.begin(), poly1.end());
+    }
+
+    std::vector<uint64_t> decomposition(KeySwitchDecompositionSize(
+        n, decomp_modulus_size, rns_modulus_size));
+    KeySwitchDecompose(decomposition.data(), c1.data(), n,
+                       decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                       moduli.data(), ntts);
+
+    // Each result starts as (galois(c0), 0)
+    std::vector<std::vector<uint64_t>> results(num_keys);
+    std::vector<uint64_t*> result_ptrs;
+    for (size_t r = 0; r < num_keys; ++r) {
+      results[r].resize(key_component_count * decomp_modulus_size * n, 0);
+      for (size_t i = 0; i < decomp_modulus_size; ++i) {
+        GaloisPermuteNTT(&results[r][i * n], &c0[i * n], n, galois_elts[r]);
+      }
+      result_ptrs.push_back(results[r].data());
+    }
+    KeySwitchHoisted(result_ptrs.data(), decomposition.data(),
+                     galois_elts.data(), num_keys, n, decomp_modulus_size,
+                     key_modulus_size, rns_modulus_size, key_component_count,
+                     moduli.data(), key_set_ptrs.data(),
+                     modswitch_factors.data(), ntts);
+
+    // result0 + result1 * s - galois(c0 + c1 * s) is the same small error
+    // modulo each modulus
+    int64_t bound = static_cast<int64_t>(3 * (n + 1));
+    for (size_t r = 0; r < num_keys; ++r) {
+      std::vector<int64_t> expected_error;
+      for (size_t i = 0; i < decomp_modulus_size; ++i) {
+        uint64_t modulus = moduli[i];
+        std::vector<uint64_t> rotated_c0(n);
+        std::vector<uint64_t> rotated_c1(n);
+        GaloisPermuteNTT(rotated_c0.data(), &c0[i * n], n, galois_elts[r]);
+        GaloisPermuteNTT(rotated_c1.data(), &c1[i * n], n, galois_elts[r]);
+        std::vector<uint64_t> error(n);
+        for (size_t l = 0; l < n; ++l) {
+          uint64_t r0 = results[r][i * n + l];
+          uint64_t r1 = results[r][(decomp_modulus_size + i) * n + l];
+          uint64_t decrypted =
+              AddUIntMod(r0, MultiplyMod(r1, s[i * n + l], modulus), modulus);
+          uint64_t rotated = MultiplyMod(rotated_c1[l],
+                                         rotated_s[r][i * n + l], modulus);
+          rotated = AddUIntMod(rotated, rotated_c0[l], modulus);
+          error[l] = SubUIntMod(decrypted, rotated, modulus);
+        }
+        ntts[i].ComputeInverse(error.data(), error.data(), 1, 1);
+        std::vector<int64_t> centered(n);
+        for (size_t l = 0; l < n; ++l) {
+          centered[l] = (error[l] > modulus / 2)
+                            ? -static_cast<int64_t>(modulus - error[l])
+                            : static_cast<int64_t>(error[l]);
+          ASSERT_LE(std::abs(centered[l]), bound);
+        }
+        if (i == 0) {
+          expected_error = centered;
+        } else {
+          ASSERT_EQ(centered, expected_error);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace hexl
 }  // namespace intel
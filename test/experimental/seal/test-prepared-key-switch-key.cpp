@@ -0,0 +1,149 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/key-switch.hpp"
+#include "hexl/experimental/seal/prepared-key-switch-key.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/cache-info.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+TEST(PreparedKeySwitchKey, layout) {
+  uint64_t n = 1024;
+  uint64_t num_digits = 3;
+  uint64_t key_modulus_size = 4;
+  uint64_t key_component_count = 2;
+
+  std::vector<std::vector<uint64_t>> keys(num_digits);
+  std::vector<const uint64_t*> key_ptrs(num_digits);
+  for (size_t j = 0; j < num_digits; ++j) {
+    auto values = GenerateInsecureUniformRandomValues(
+        key_component_count * key_modulus_size * n, 0, 1ULL << 50);
+    keys[j].assign(values.begin(), values.end());
+    key_ptrs[j] = keys[j].data();
+  }
+
+  for (bool use_huge_pages : {false, true}) {
+    PreparedKeySwitchKey prepared(key_ptrs.data(), n, num_digits,
+                                  key_modulus_size, key_component_count,
+                                  use_huge_pages);
+    uint64_t tile_size = prepared.TileSize();
+    ASSERT_EQ(n % tile_size, 0ULL);
+
+    for (size_t m = 0; m < key_modulus_size; ++m) {
+      for (size_t j = 0; j < num_digits; ++j) {
+        const uint64_t* limbs = prepared.GetLimbs(j, m);
+        for (size_t k = 0; k < key_component_count; ++k) {
+          for (size_t l = 0; l < n; ++l) {
+            uint64_t tile = l / tile_size;
+            uint64_t index = (tile * key_component_count + k) * tile_size +
+                             l % tile_size;
+            ASSERT_EQ(limbs[index],
+                      keys[j][(k * key_modulus_size + m) * n + l]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Checks KeySwitch and KeySwitchBatch with prepared keys match KeySwitch with
+// the same keys in the usual layout, at the top level and one level below
+TEST(PreparedKeySwitchKey, key_switch) {
+  uint64_t n = 1024;
+  uint64_t num_digits = 4;
+  uint64_t key_modulus_size = num_digits + 1;
+  uint64_t key_component_count = 2;
+  uint64_t batch_size = 3;
+
+  std::vector<uint64_t> moduli = GeneratePrimes(key_modulus_size, 45, true, n);
+  std::vector<NTT> ntts;
+  for (uint64_t modulus : moduli) {
+    ntts.emplace_back(n, modulus);
+  }
+
+  std::vector<std::vector<uint64_t>> keys(num_digits);
+  std::vector<const uint64_t*> key_ptrs(num_digits);
+  for (size_t j = 0; j < num_digits; ++j) {
+    for (size_t k = 0; k < key_component_count; ++k) {
+      for (size_t m = 0; m < key_modulus_size; ++m) {
+        auto values = GenerateInsecureUniformRandomValues(n, 0, moduli[m]);
+        keys[j].insert(keys[j].end(), values.begin(), values.end());
+      }
+    }
+    key_ptrs[j] = keys[j].data();
+  }
+  PreparedKeySwitchKey prepared(key_ptrs.data(), n, num_digits,
+                                key_modulus_size, key_component_count);
+
+  // Tiles chosen for a smaller cache
+  SetCacheSizes(4 * 1024, 0);
+  PreparedKeySwitchKey small_tiles(key_ptrs.data(), n, num_digits,
+                                   key_modulus_size, key_component_count);
+  SetCacheSizes(0, 0);
+  EXPECT_EQ(small_tiles.TileSize(), 64ULL);
+
+  for (uint64_t decomp_modulus_size : {num_digits, num_digits - 1}) {
+    uint64_t rns_modulus_size = decomp_modulus_size + 1;
+    std::vector<uint64_t> modswitch_factors;
+    for (size_t i = 0; i < decomp_modulus_size; ++i) {
+      modswitch_factors.push_back(
+          InverseMod(moduli.back() % moduli[i], moduli[i]));
+    }
+
+    std::vector<std::vector<uint64_t>> inputs(batch_size);
+    std::vector<std::vector<uint64_t>> expected(batch_size);
+    std::vector<std::vector<uint64_t>> results(batch_size);
+    std::vector<const uint64_t*> input_ptrs(batch_size);
+    std::vector<uint64_t*> result_ptrs(batch_size);
+    for (size_t b = 0; b < batch_size; ++b) {
+      for (size_t i = 0; i < decomp_modulus_size; ++i) {
+        auto poly = GenerateInsecureUniformRandomValues(n, 0, moduli[i]);
+        inputs[b].insert(inputs[b].end(), poly.begin(), poly.end());
+      }
+      expected[b].resize(key_component_count * decomp_modulus_size * n, 0);
+      KeySwitch(expected[b].data(), inputs[b].data(), n, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), key_ptrs.data(), modswitch_factors.data(),
+                ntts);
+
+      std::vector<uint64_t> result(expected[b].size(), 0);
+      KeySwitch(result.data(), inputs[b].data(), n, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), prepared, modswitch_factors.data(), ntts);
+      AssertEqual(result, expected[b]);
+
+      std::fill(result.begin(), result.end(), 0);
+      KeySwitch(result.data(), inputs[b].data(), n, decomp_modulus_size,
+                key_modulus_size, rns_modulus_size, key_component_count,
+                moduli.data(), small_tiles, modswitch_factors.data(), ntts);
+      AssertEqual(result, expected[b]);
+
+      results[b].resize(expected[b].size(), 0);
+      input_ptrs[b] = inputs[b].data();
+      result_ptrs[b] = results[b].data();
+    }
+
+    ThreadExecutor executor(3);
+    KeySwitchBatch(result_ptrs.data(), input_ptrs.data(), batch_size, n,
+                   decomp_modulus_size, key_modulus_size, rns_modulus_size,
+                   key_component_count, moduli.data(), prepared,
+                   modswitch_factors.data(), ntts, &executor);
+    for (size_t b = 0; b < batch_size; ++b) {
+      AssertEqual(results[b], expected[b]);
+    }
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -0,0 +1,149 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/experimental/misc/executor.hpp"
+#include "hexl/experimental/seal/public-key-encrypt.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Computes the encryption with separate expansions, NTTs, multiplications and
+// additions
+inline std::vector<uint64_t> ReferencePublicKeyEncrypt(
+    const std::vector<uint64_t>& public_key, const std::vector<int64_t>& u,
+    const std::vector<int64_t>& e0, const std::vector<int64_t>& e1,
+    const uint64_t* plain, uint64_t n, const std::vector<uint64_t>& moduli,
+    std::vector<NTT>& ntts) {
+  uint64_t num_moduli = moduli.size();
+  size_t poly_size = n * num_moduli;
+  std::vector<uint64_t> result(2 * poly_size);
+  std::vector<uint64_t> u_ntt(n);
+  std::vector<uint64_t> e_ntt(n);
+  for (size_t i = 0; i < num_moduli; ++i) {
+    uint64_t modulus = moduli[i];
+    for (size_t j = 0; j < n; ++j) {
+      u_ntt[j] = (u[j] < 0) ? modulus - static_cast<uint64_t>(-u[j])
+                            : static_cast<uint64_t>(u[j]);
+    }
+    ntts[i].ComputeForward(u_ntt.data(), u_ntt.data(), 1, 1);
+    for (size_t k = 0; k < 2; ++k) {
+      const std::vector<int64_t>& e = (k == 0) ? e0 : e1;
+      for (size_t j = 0; j < n; ++j) {
+        e_ntt[j] = (e[j] < 0) ? modulus - static_cast<uint64_t>(-e[j])
+                              : static_cast<uint64_t>(e[j]);
+      }
+      ntts[i].ComputeForward(e_ntt.data(), e_ntt.data(), 1, 1);
+      uint64_t* result_k = result.data() + k * poly_size + i * n;
+      EltwiseMultMod(result_k, u_ntt.data(),
+                     public_key.data() + k * poly_size + i * n, n, modulus, 1);
+      EltwiseAddMod(result_k, result_k, e_ntt.data(), n, modulus);
+      if (k == 0 && plain != nullptr) {
+        EltwiseAddMod(result_k, result_k, plain + i * n, n, modulus);
+      }
+    }
+  }
+  return result;
+}
+
+inline std::vector<int64_t> RandomSmallPolynomial(uint64_t n, int64_t bound) {
+  std::vector<int64_t> poly(n);
+  uint64_t range = 2 * static_cast<uint64_t>(bound) + 1;
+  auto values = GenerateInsecureUniformRandomValues(n, 0, range);
+  for (size_t j = 0; j < n; ++j) {
+    poly[j] = static_cast<int64_t>(values[j]) - bound;
+  }
+  return poly;
+}
+
+TEST(PublicKeyEncrypt, small) {
+  uint64_t n = 8;
+  uint64_t modulus = 17;
+  std::vector<uint64_t> moduli{modulus};
+  std::vector<NTT> ntts;
+  ntts.emplace_back(n, modulus);
+
+  // Encrypting zero with u = 1 and no error gives the public key
+  std::vector<uint64_t> public_key{1, 2, 3, 4, 5, 6, 7, 8,
+                                   9, 10, 11, 12, 13, 14, 15, 16};
+  std::vector<int64_t> u{1, 0, 0, 0, 0, 0, 0, 0};
+  std::vector<int64_t> zero(n, 0);
+  std::vector<uint64_t> result(2 * n);
+  PublicKeyEncrypt(result.data(), public_key.data(), u.data(), zero.data(),
+                   zero.data(), nullptr, n, moduli.data(), 1, ntts);
+  CheckEqual(result, public_key);
+
+  // With u = -1, the result is the negated public key plus the plaintext
+  u[0] = -1;
+  std::vector<uint64_t> plain(n, 1);
+  PublicKeyEncrypt(result.data(), public_key.data(), u.data(), zero.data(),
+                   zero.data(), plain.data(), n, moduli.data(), 1, ntts);
+  std::vector<uint64_t> expected(2 * n);
+  for (size_t j = 0; j < 2 * n; ++j) {
+    expected[j] = (modulus - public_key[j] + ((j < n) ? 1 : 0)) % modulus;
+  }
+  CheckEqual(result, expected);
+}
+
+TEST(PublicKeyEncrypt, random) {
+  uint64_t num_moduli = 3;
+  ThreadExecutor executor(2);
+  for (uint64_t n : {16, 1024}) {
+    for (size_t bits : {30, 48, 50, 60, 62}) {
+      std::vector<uint64_t> moduli = GeneratePrimes(num_moduli, bits, true, n);
+      std::vector<NTT> ntts;
+      for (uint64_t modulus : moduli) {
+        ntts.emplace_back(n, modulus);
+      }
+
+      std::vector<uint64_t> public_key;
+      std::vector<uint64_t> plain;
+      for (size_t k = 0; k < 2; ++k) {
+        for (uint64_t modulus : moduli) {
+          auto values = GenerateInsecureUniformRandomValues(n, 0, modulus);
+          public_key.insert(public_key.end(), values.begin(), values.end());
+          if (k == 0) {
+            values = GenerateInsecureUniformRandomValues(n, 0, modulus);
+            plain.insert(plain.end(), values.begin(), values.end());
+          }
+        }
+      }
+      auto u = RandomSmallPolynomial(n, 1);
+      auto e0 = RandomSmallPolynomial(n, 19);
+      auto e1 = RandomSmallPolynomial(n, 19);
+
+      for (const uint64_t* plain_ptr :
+           {static_cast<const uint64_t*>(nullptr),
+            static_cast<const uint64_t*>(plain.data())}) {
+        auto expected = ReferencePublicKeyEncrypt(public_key, u, e0, e1,
+                                                  plain_ptr, n, moduli, ntts);
+        for (Executor* executor_ptr : {static_cast<Executor*>(nullptr),
+                                       static_cast<Executor*>(&executor)}) {
+          std::vector<uint64_t> workspace(
+              PublicKeyEncryptWorkspaceSize(n, executor_ptr));
+          for (uint64_t* workspace_ptr :
+               {static_cast<uint64_t*>(nullptr), workspace.data()}) {
+            std::vector<uint64_t> result(2 * n * num_moduli);
+            PublicKeyEncrypt(result.data(), public_key.data(), u.data(),
+                             e0.data(), e1.data(), plain_ptr, n,
+                             moduli.data(), num_moduli, ntts, executor_ptr,
+                             workspace_ptr);
+            AssertEqual(result, expected);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace hexl
+}  // namespace intel
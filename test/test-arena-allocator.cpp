@@ -0,0 +1,108 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/arena-allocator.hpp"
+#include "test-util.hpp"
+
+namespace intel {
+namespace hexl {
+
+TEST(ArenaAllocator, bump) {
+  ArenaAllocator arena(1024);
+  EXPECT_EQ(arena.Capacity(), 0ULL);
+  EXPECT_EQ(arena.BytesUsed(), 0ULL);
+
+  char* p = static_cast<char*>(arena.allocate(10));
+  char* q = static_cast<char*>(arena.allocate(64));
+  char* r = static_cast<char*>(arena.allocate(1));
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0ULL);
+  EXPECT_EQ(q, p + 64);
+  EXPECT_EQ(r, q + 64);
+  EXPECT_EQ(arena.BytesUsed(), 192ULL);
+  EXPECT_EQ(arena.Capacity(), 1024ULL);
+
+  // deallocate does not reclaim memory
+  arena.deallocate(r, 1);
+  EXPECT_EQ(arena.BytesUsed(), 192ULL);
+}
+
+TEST(ArenaAllocator, rewind) {
+  ArenaAllocator arena(1024);
+  void* p = arena.allocate(100);
+  ArenaAllocator::Mark mark = arena.GetMark();
+  void* q = arena.allocate(100);
+  void* r = arena.allocate(2000);
+  EXPECT_EQ(arena.Capacity(), 1024ULL + 2048ULL);
+
+  arena.Rewind(mark);
+  EXPECT_EQ(arena.BytesUsed(), 128ULL);
+  EXPECT_EQ(arena.allocate(100), q);
+  EXPECT_EQ(arena.allocate(2000), r);
+  EXPECT_EQ(arena.Capacity(), 1024ULL + 2048ULL);
+
+  {
+    ScopedArenaReset reset(arena);
+    arena.allocate(5000);
+    EXPECT_GT(arena.BytesUsed(), 5000ULL);
+  }
+  EXPECT_EQ(arena.BytesUsed(), 1024ULL + 2048ULL);
+
+  arena.Rewind(ArenaAllocator::Mark{0, 0});
+  EXPECT_EQ(arena.allocate(100), p);
+}
+
+TEST(ArenaAllocator, reset) {
+  ArenaAllocator arena(1024);
+  arena.allocate(1000);
+  arena.allocate(1000);
+  arena.allocate(3000);
+  size_t capacity = arena.Capacity();
+  EXPECT_EQ(capacity, 1024ULL + 1024ULL + 3008ULL);
+
+  // The blocks are merged, so the same allocations then fit in one block
+  arena.Reset();
+  EXPECT_EQ(arena.BytesUsed(), 0ULL);
+  EXPECT_EQ(arena.Capacity(), capacity);
+  char* p = static_cast<char*>(arena.allocate(1000));
+  EXPECT_EQ(static_cast<char*>(arena.allocate(1000)), p + 1024);
+  EXPECT_EQ(static_cast<char*>(arena.allocate(3000)), p + 2048);
+  EXPECT_EQ(arena.Capacity(), capacity);
+}
+
+TEST(ArenaAllocator, ntt) {
+  uint64_t n = 1024;
+  uint64_t modulus = GeneratePrimes(1, 50, true, n)[0];
+  NTT ntt(n, modulus);
+
+  ArenaAllocator arena(4096);
+  std::vector<uint64_t> input(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    input[i] = (i * i) % modulus;
+  }
+  std::vector<uint64_t> expected(n);
+  ntt.ComputeForward(expected.data(), input.data(), 1, 1);
+
+  // The arena is reused by the second NTT
+  for (size_t trial = 0; trial < 2; ++trial) {
+    ScopedArenaReset reset(arena);
+    std::shared_ptr<AllocatorBase> arena_ptr(&arena, [](AllocatorBase*) {});
+    NTT arena_ntt(n, modulus, arena_ptr);
+    std::vector<uint64_t> result(n);
+    arena_ntt.ComputeForward(result.data(), input.data(), 1, 1);
+    AssertEqual(result, expected);
+    arena_ntt.ComputeInverse(result.data(), result.data(), 1, 1);
+    AssertEqual(result, input);
+  }
+  EXPECT_EQ(arena.BytesUsed(), 0ULL);
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -18,7 +18,7 @@ namespace hexl {
 #ifdef HEXL_HAS_AVX512DQ
 
 TEST(AVX512, ExtractValues) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   __m512i x = _mm512_set_epi64(1, 2, 3, 4, 5, 6, 7, 8);
@@ -27,7 +27,7 @@ TEST(AVX512, ExtractValues) {
 }
 
 TEST(AVX512, ExtractIntValues) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   __m512i x = _mm512_set_epi64(1, 2, 3, 4, 5, 6, 7, 8);
@@ -36,7 +36,7 @@ TEST(AVX512, ExtractIntValues) {
 }
 
 TEST(AVX512, ExtractDoubleValues) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   __m512d x = _mm512_set_pd(-4.4, -3.3, -2.2, -1.1, 0, 1.1, 2.2, 3.3);
@@ -47,7 +47,7 @@ TEST(AVX512, ExtractDoubleValues) {
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(AVX512, _mm512_hexl_mulhi_epi52) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
   __m512i x = _mm512_set_epi64(90774764920991, 90774764920991, 90774764920991,
@@ -65,7 +65,7 @@ TEST(AVX512, _mm512_hexl_mulhi_epi52) {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(AVX512, _mm512_hexl_mulhi_epi64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   __m512i w = _mm512_set_epi64(90774764920991,    //
@@ -108,7 +108,7 @@ TEST(AVX512, _mm512_hexl_mulhi_epi64) {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(AVX512, _mm512_hexl_cmplt_epu64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -153,7 +153,7 @@ TEST(AVX512, _mm512_hexl_cmplt_epu64) {
 }
 
 TEST(AVX512, _mm512_hexl_cmple_epu64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   // Small
@@ -200,7 +200,7 @@ TEST(AVX512, _mm512_hexl_cmple_epu64) {
 }
 
 TEST(AVX512, _mm512_hexl_cmpge_epu64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -247,7 +247,7 @@ TEST(AVX512, _mm512_hexl_cmpge_epu64) {
 }
 
 TEST(AVX512, _mm512_hexl_small_mod_epu64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -290,7 +290,7 @@ TEST(AVX512, _mm512_hexl_small_mod_epu64) {
 }
 
 TEST(AVX512, _mm512_hexl_barrett_reduce64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -351,7 +351,7 @@ TEST(AVX512, _mm512_hexl_barrett_reduce64) {
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(AVX512, _mm512_hexl_montgomery_reduce52) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
 
@@ -449,7 +449,7 @@ TEST(AVX512, _mm512_hexl_montgomery_reduce52) {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(AVX512, _mm512_hexl_montgomery_reduce64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -0,0 +1,39 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include "hexl/util/cache-info.hpp"
+
+namespace intel {
+namespace hexl {
+
+TEST(CacheInfo, override) {
+  uint64_t l1_data_cache_size = GetL1DataCacheSize();
+  uint64_t l2_cache_size = GetL2CacheSize();
+  EXPECT_GT(l1_data_cache_size, 0ULL);
+  EXPECT_GT(l2_cache_size, 0ULL);
+
+  SetCacheSizes(16 * 1024, 256 * 1024);
+  EXPECT_EQ(GetL1DataCacheSize(), 16ULL * 1024);
+  EXPECT_EQ(GetL2CacheSize(), 256ULL * 1024);
+
+  SetCacheSizes(0, 0);
+  EXPECT_EQ(GetL1DataCacheSize(), l1_data_cache_size);
+  EXPECT_EQ(GetL2CacheSize(), l2_cache_size);
+}
+
+TEST(CacheInfo, tile_size) {
+  // 8 words per coefficient of a 512-coefficient tile fill 32 KiB
+  EXPECT_EQ(CacheTileSize(16384, 32 * 1024, 8), 512ULL);
+  EXPECT_EQ(CacheTileSize(16384, 48 * 1024, 8), 512ULL);
+  EXPECT_EQ(CacheTileSize(16384, 64 * 1024, 8), 1024ULL);
+
+  // Bounded below by 64 and above by n
+  EXPECT_EQ(CacheTileSize(16384, 1024, 8), 64ULL);
+  EXPECT_EQ(CacheTileSize(256, 1024 * 1024, 8), 256ULL);
+  EXPECT_EQ(CacheTileSize(8, 1024, 8), 8ULL);
+}
+
+}  // namespace hexl
+}  // namespace intel
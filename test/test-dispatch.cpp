@@ -0,0 +1,128 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-cmp-sub-mod.hpp"
+#include "hexl/eltwise/eltwise-fma-mod.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/defines.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "test-util.hpp"
+#include "util/util-internal.hpp"
+
+namespace intel {
+namespace hexl {
+
+const std::vector<Backend> all_backends{Backend::kNative, Backend::kAVX512DQ,
+                                        Backend::kAVX512IFMA};
+
+TEST(Dispatch, backend_name) {
+  EXPECT_EQ(std::string(BackendName(Backend::kNative)), "Native");
+  EXPECT_EQ(std::string(BackendName(Backend::kAVX512DQ)), "AVX512-DQ");
+  EXPECT_EQ(std::string(BackendName(Backend::kAVX512IFMA)), "AVX512-IFMA");
+}
+
+TEST(Dispatch, set_backend) {
+  Backend supported = GetSupportedBackend();
+  EXPECT_EQ(GetBackend(), supported);
+
+  for (Backend backend : all_backends) {
+    if (backend > supported) {
+      EXPECT_THROW(SetBackend(backend), std::invalid_argument);
+      EXPECT_EQ(GetBackend(), supported);
+    } else {
+      SetBackend(backend);
+      EXPECT_EQ(GetBackend(), backend);
+    }
+  }
+  ResetBackend();
+  EXPECT_EQ(GetBackend(), supported);
+}
+
+TEST(Dispatch, kernel_backend) {
+  Backend supported = GetSupportedBackend();
+
+  SetBackend(Backend::kNative);
+  EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseAddMod, 769), Backend::kNative);
+  EXPECT_EQ(GetKernelBackend(Kernel::kForwardNTT, 769), Backend::kNative);
+
+  if (supported >= Backend::kAVX512DQ) {
+    SetBackend(Backend::kAVX512DQ);
+    EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseAddMod, 769),
+              Backend::kAVX512DQ);
+    EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseReduceMod, 769),
+              Backend::kAVX512DQ);
+  }
+
+  if (supported >= Backend::kAVX512IFMA) {
+    SetBackend(Backend::kAVX512IFMA);
+    EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseReduceMod, 769),
+              Backend::kAVX512IFMA);
+    EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseReduceMod, 1ULL << 60),
+              Backend::kAVX512DQ);
+    EXPECT_EQ(GetKernelBackend(Kernel::kForwardNTT, (1ULL << 50) - 1),
+              Backend::kAVX512IFMA);
+    EXPECT_EQ(GetKernelBackend(Kernel::kForwardNTT, (1ULL << 50) + 1),
+              Backend::kAVX512DQ);
+#ifdef HEXL_EXPERIMENTAL
+    EXPECT_EQ(GetKernelBackend(Kernel::kDyadicMultiply, (1ULL << 49) - 1),
+              Backend::kAVX512IFMA);
+    EXPECT_EQ(GetKernelBackend(Kernel::kDyadicMultiply, (1ULL << 49) + 1),
+              Backend::kAVX512DQ);
+#else
+    // The experimental kernels are not built
+    EXPECT_EQ(GetKernelBackend(Kernel::kDyadicMultiply, (1ULL << 49) + 1),
+              Backend::kNative);
+#endif
+    // Prefers floating-point AVX512-DQ instructions
+    EXPECT_EQ(GetKernelBackend(Kernel::kEltwiseMultMod, 769),
+              Backend::kAVX512DQ);
+  }
+  ResetBackend();
+}
+
+// Each backend computes the same results
+TEST(Dispatch, kernels) {
+  uint64_t n = 1024;
+  Backend supported = GetSupportedBackend();
+  for (size_t bits : {30, 50, 60}) {
+    uint64_t modulus = GeneratePrimes(1, bits, true, n)[0];
+    NTT ntt(n, modulus);
+    auto op1 = GenerateInsecureUniformRandomValues(n, 0, modulus);
+    auto op2 = GenerateInsecureUniformRandomValues(n, 0, modulus);
+    auto op3 = GenerateInsecureUniformRandomValues(n, 0, modulus);
+
+    std::vector<std::vector<uint64_t>> expected;
+    for (Backend backend : all_backends) {
+      if (backend > supported) {
+        continue;
+      }
+      SetBackend(backend);
+      std::vector<std::vector<uint64_t>> results(4, std::vector<uint64_t>(n));
+      EltwiseAddMod(results[0].data(), op1.data(), op2.data(), n, modulus);
+      EltwiseFMAMod(results[1].data(), op1.data(), 12345 % modulus, op2.data(),
+                    n, modulus, 1);
+      EltwiseCmpSubMod(results[2].data(), op1.data(), n, modulus, CMPINT::LT,
+                       modulus / 2, 3);
+      ntt.ComputeForward(results[3].data(), op3.data(), 1, 1);
+      if (backend == Backend::kNative) {
+        expected = results;
+      } else {
+        for (size_t i = 0; i < results.size(); ++i) {
+          AssertEqual(results[i], expected[i]);
+        }
+      }
+    }
+  }
+  ResetBackend();
+}
+
+}  // namespace hexl
+}  // namespace intel
@@ -19,7 +19,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseAddMod, vector_vector_avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -33,7 +33,7 @@ TEST(EltwiseAddMod, vector_vector_avx512_small) {
 }
 
 TEST(EltwiseAddMod, vector_scalar_avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -47,7 +47,7 @@ TEST(EltwiseAddMod, vector_scalar_avx512_small) {
 }
 
 TEST(EltwiseAddMod, vector_vector_avx512_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -67,7 +67,7 @@ TEST(EltwiseAddMod, vector_vector_avx512_big) {
 }
 
 TEST(EltwiseAddMod, vector_scalar_avx512_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -89,7 +89,7 @@ TEST(EltwiseAddMod, vector_scalar_avx512_big) {
 // Checks AVX512 and native eltwise add implementations match
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseAddMod, vector_vector_avx512_native_match) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -125,7 +125,7 @@ TEST(EltwiseAddMod, vector_vector_avx512_native_match) {
 }
 
 TEST(EltwiseAddMod, vector_scalar_avx512_native_match) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   size_t length = 173;
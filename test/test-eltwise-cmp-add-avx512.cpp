@@ -20,7 +20,7 @@ namespace hexl {
 // Checks AVX512 and native implementations match
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseCmpAdd, AVX512) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -20,7 +20,7 @@ namespace hexl {
 // Checks AVX512 and native implementations match
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(EltwiseCmpSubMod, AVX512_52) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   uint64_t length = 9;
@@ -52,7 +52,7 @@ TEST(EltwiseCmpSubMod, AVX512_52) {
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(EltwiseCmpSubMod, AVX512) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -91,7 +91,7 @@ TEST(EltwiseCmpSubMod, AVX512) {
 }
 
 TEST(EltwiseCmpSubMod, AVX512_64) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   uint64_t length = 9;
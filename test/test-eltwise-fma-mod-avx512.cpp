@@ -19,7 +19,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseFMAMod, avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -36,7 +36,7 @@ TEST(EltwiseFMAMod, avx512_small) {
 }
 
 TEST(EltwiseFMAMod, avx512_small2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -54,7 +54,7 @@ TEST(EltwiseFMAMod, avx512_small2) {
 }
 
 TEST(EltwiseFMAMod, avx512_mult1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -75,7 +75,7 @@ TEST(EltwiseFMAMod, avx512_mult1) {
 }
 
 TEST(EltwiseFMAMod, avx512_mult2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -96,7 +96,7 @@ TEST(EltwiseFMAMod, avx512_mult2) {
 }
 
 TEST(EltwiseFMAMod, avx512_mult4) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -117,7 +117,7 @@ TEST(EltwiseFMAMod, avx512_mult4) {
 }
 
 TEST(EltwiseFMAMod, avx512_mult8) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -141,7 +141,7 @@ TEST(EltwiseFMAMod, avx512_mult8) {
 // Check AVX512DQ and native eltwise FMA implementations match
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseFMAMod, AVX512DQ) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -213,7 +213,7 @@ TEST(EltwiseFMAMod, AVX512DQ) {
 // Checks AVX512IFMA and native eltwise FMA implementations match
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(EltwiseFMAMod, AVX512IFMA) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
 
@@ -238,7 +238,7 @@ TEST(EltwiseFMAMod, AVX512IFMA) {
       EltwiseFMAMod(arg1.data(), arg1.data(), arg2, arg3_data, arg1.size(),
                     modulus, input_mod_factor);
 
-      if (has_avx512ifma) {
+      if (GetCpuFeatures().avx512ifma) {
         EltwiseFMAModAVX512<52, input_mod_factor>(
             arg1a.data(), arg1a.data(), arg2, arg3_data, arg1.size(), modulus);
         ASSERT_EQ(arg1, arg1a);
@@ -20,7 +20,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseMultMod, avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   std::vector<uint64_t> op1{1, 2, 3, 1, 1, 1, 0, 1, 0};
@@ -36,7 +36,7 @@ TEST(EltwiseMultMod, avx512_small) {
 }
 
 TEST(EltwiseMultMod, avx512_int2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   uint64_t modulus = GeneratePrimes(1, 60, true, 1024)[0];
@@ -55,7 +55,7 @@ TEST(EltwiseMultMod, avx512_int2) {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseMultMod, Big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
   uint64_t modulus = 1125891450734593;
@@ -79,6 +79,9 @@ TEST(EltwiseMultMod, Big) {
 }
 
 TEST(EltwiseMultMod, AVX512FloatInPlaceNoInputReduceMod) {
+  if (!GetCpuFeatures().avx512dq) {
+    GTEST_SKIP();
+  }
   uint64_t modulus = 281474976546817;
 
   std::vector<uint64_t> data_native(8, 998771110802331);
@@ -96,7 +99,7 @@ TEST(EltwiseMultMod, AVX512FloatInPlaceNoInputReduceMod) {
 }
 
 TEST(EltwiseMultMod, avx512dqint_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -124,7 +127,7 @@ TEST(EltwiseMultMod, avx512dqint_small) {
 
 // Checks AVX512 and native eltwise mult out-of-place implementations match
 TEST(EltwiseMultMod, avx512dqint_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -207,9 +210,43 @@ TEST(EltwiseMultMod, avx512dqint_big) {
   }
 }
 
+#ifdef HEXL_HAS_AVX512VBMI2
+// Checks the AVX512-VBMI2 variant matches the native implementation for each
+// shift of the product
+TEST(EltwiseMultMod, avx512vbmi2int) {
+  if (!GetCpuFeatures().avx512dq || !GetCpuFeatures().avx512vbmi2) {
+    GTEST_SKIP();
+  }
+
+  for (size_t length : {1000, 1024, 32768}) {
+    std::vector<uint64_t> rs_native(length, 0);
+    std::vector<uint64_t> rs_avx(length, 0);
+    for (size_t input_mod_factor = 1; input_mod_factor <= 4;
+         input_mod_factor *= 2) {
+      for (size_t bits = 51; bits <= 61; ++bits) {
+        uint64_t modulus = (1ULL << bits) + 7;
+        uint64_t data_upper_bound = input_mod_factor * modulus;
+        auto op1 =
+            GenerateInsecureUniformRandomValues(length, 0, data_upper_bound);
+        auto op2 =
+            GenerateInsecureUniformRandomValues(length, 0, data_upper_bound);
+        op1[0] = data_upper_bound - 1;
+        op2[0] = data_upper_bound - 1;
+
+        EltwiseMultModNative(rs_native.data(), op1.data(), op2.data(),
+                             op1.size(), modulus, input_mod_factor);
+        EltwiseMultModAVX512VBMI2Int(rs_avx.data(), op1.data(), op2.data(),
+                                     op1.size(), modulus, input_mod_factor);
+        ASSERT_EQ(rs_avx, rs_native);
+      }
+    }
+  }
+}
+#endif
+
 // Checks Montgomery and AVX512DQInt eltwise mult implementations match
 TEST(EltwiseMultModMont_EConv, avx512dqint_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -238,7 +275,7 @@ TEST(EltwiseMultModMont_EConv, avx512dqint_big) {
 
 // Checks Montgomery and AVX512DQInt eltwise mult implementations match
 TEST(EltwiseMultModMont_NoConv, avx512dqint_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -263,7 +300,7 @@ TEST(EltwiseMultModMont_NoConv, avx512dqint_big) {
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(EltwiseMultMod, avx512ifma_big) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
 
@@ -332,7 +369,7 @@ TEST(EltwiseMultMod, avx512ifma_big) {
 
 // Checks Montgomery and AVX512ifmaInt eltwise mult implementations match
 TEST(EltwiseMultModMont, avx512ifmaint_big) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
   size_t length = 1024;
@@ -19,7 +19,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseReduceMod, avx512_64_mod_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -36,7 +36,7 @@ TEST(EltwiseReduceMod, avx512_64_mod_1) {
 }
 
 TEST(EltwiseReduceModMontInOut, avx512_64_mod_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -66,7 +66,7 @@ TEST(EltwiseReduceModMontInOut, avx512_64_mod_1) {
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST(EltwiseReduceMod, avx512_52_mod_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -83,7 +83,7 @@ TEST(EltwiseReduceMod, avx512_52_mod_1) {
 }
 
 TEST(EltwiseReduceMod, avx512Big_mod_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -105,7 +105,7 @@ TEST(EltwiseReduceMod, avx512Big_mod_1) {
 }
 
 TEST(EltwiseReduceModMontInOut, avx512_52_mod_1) {
-  if (!has_avx512ifma) {
+  if (!GetCpuFeatures().avx512ifma) {
     GTEST_SKIP();
   }
 
@@ -136,7 +136,7 @@ TEST(EltwiseReduceModMontInOut, avx512_52_mod_1) {
 #endif
 
 TEST(EltwiseReduceMod, avx512_2_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -153,7 +153,7 @@ TEST(EltwiseReduceMod, avx512_2_1) {
 }
 
 TEST(EltwiseReduceMod, avx512_4_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -170,7 +170,7 @@ TEST(EltwiseReduceMod, avx512_4_1) {
 }
 
 TEST(EltwiseReduceMod, avx512_4_2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -189,7 +189,7 @@ TEST(EltwiseReduceMod, avx512_4_2) {
 // Checks AVX512 and native EltwiseReduceMod implementations match with randomly
 // generated inputs
 TEST(EltwiseReduceMod, AVX512Big_0_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -222,7 +222,7 @@ TEST(EltwiseReduceMod, AVX512Big_0_1) {
 }
 
 TEST(EltwiseReduceMod, AVX512Big_4_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -254,7 +254,7 @@ TEST(EltwiseReduceMod, AVX512Big_4_1) {
 }
 
 TEST(EltwiseReduceMod, AVX512Big_4_2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -286,7 +286,7 @@ TEST(EltwiseReduceMod, AVX512Big_4_2) {
 }
 
 TEST(EltwiseReduceMod, AVX512Big_2_1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -19,7 +19,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseSubMod, vector_vector_avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -33,7 +33,7 @@ TEST(EltwiseSubMod, vector_vector_avx512_small) {
 }
 
 TEST(EltwiseSubMod, vector_scalar_avx512_small) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -47,7 +47,7 @@ TEST(EltwiseSubMod, vector_scalar_avx512_small) {
 }
 
 TEST(EltwiseSubMod, vector_vector_avx512_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -66,7 +66,7 @@ TEST(EltwiseSubMod, vector_vector_avx512_big) {
 }
 
 TEST(EltwiseSubMod, vector_scalar_avx512_big) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -87,7 +87,7 @@ TEST(EltwiseSubMod, vector_scalar_avx512_big) {
 // Checks AVX512 and native eltwise implementations match
 #ifdef HEXL_HAS_AVX512DQ
 TEST(EltwiseSubMod, vector_vector_avx512_native_match) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -124,7 +124,7 @@ TEST(EltwiseSubMod, vector_vector_avx512_native_match) {
 }
 
 TEST(EltwiseSubMod, vector_scalar_avx512_native_match) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
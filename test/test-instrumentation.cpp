@@ -0,0 +1,141 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-mult-mod.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/instrumentation.hpp"
+
+namespace intel {
+namespace hexl {
+
+inline uint64_t Sum(const std::array<uint64_t, kNumCycleBins>& counts) {
+  return std::accumulate(counts.begin(), counts.end(), uint64_t(0));
+}
+
+TEST(Instrumentation, disabled) {
+  bool enabled = IsInstrumentationEnabled();
+  EnableInstrumentation(false);
+  ResetInstrumentation();
+
+  uint64_t n = 64;
+  uint64_t modulus = 769;
+  std::vector<uint64_t> op(n, 1);
+  EltwiseAddMod(op.data(), op.data(), op.data(), n, modulus);
+  EXPECT_EQ(GetInstrumentationSnapshot()[Kernel::kEltwiseAddMod].calls, 0ULL);
+
+  EnableInstrumentation(enabled);
+}
+
+TEST(Instrumentation, counters) {
+  bool enabled = IsInstrumentationEnabled();
+  EnableInstrumentation();
+  ResetInstrumentation();
+
+  uint64_t n = 1024;
+  uint64_t modulus = GeneratePrimes(1, 45, true, n)[0];
+  NTT ntt(n, modulus);
+  std::vector<uint64_t> op1(n, 1);
+  std::vector<uint64_t> op2(n, 2);
+  EltwiseAddMod(op1.data(), op1.data(), op2.data(), n, modulus);
+  EltwiseAddMod(op1.data(), op1.data(), 3, n, modulus);
+  ntt.ComputeForward(op2.data(), op1.data(), 1, 1);
+
+  InstrumentationSnapshot snapshot = GetInstrumentationSnapshot();
+  const KernelStats& add = snapshot[Kernel::kEltwiseAddMod];
+  EXPECT_EQ(add.calls, 2ULL);
+  EXPECT_EQ(add.elements, 2 * n);
+  EXPECT_EQ(add.bytes, 5 * n * sizeof(uint64_t));
+  EXPECT_EQ(Sum(add.cycle_histogram), 2ULL);
+  size_t add_backend = static_cast<size_t>(
+      GetKernelBackend(Kernel::kEltwiseAddMod, modulus));
+  EXPECT_EQ(add.backend_calls[add_backend], 2ULL);
+
+  const KernelStats& fwd_ntt = snapshot[Kernel::kForwardNTT];
+  EXPECT_EQ(fwd_ntt.calls, 1ULL);
+  EXPECT_EQ(fwd_ntt.elements, n);
+  EXPECT_GT(fwd_ntt.cycles, 0ULL);
+  EXPECT_EQ(Sum(fwd_ntt.cycle_histogram), 1ULL);
+  size_t ntt_backend =
+      static_cast<size_t>(GetKernelBackend(Kernel::kForwardNTT, modulus));
+  EXPECT_EQ(fwd_ntt.backend_calls[ntt_backend], 1ULL);
+
+  EXPECT_EQ(snapshot[Kernel::kInverseNTT].calls, 0ULL);
+
+  ResetInstrumentation();
+  snapshot = GetInstrumentationSnapshot();
+  EXPECT_EQ(snapshot[Kernel::kEltwiseAddMod].calls, 0ULL);
+  EXPECT_EQ(snapshot[Kernel::kForwardNTT].cycles, 0ULL);
+  EXPECT_EQ(Sum(snapshot[Kernel::kForwardNTT].cycle_histogram), 0ULL);
+
+  EnableInstrumentation(enabled);
+}
+
+// Calls restricted by SetBackend are counted as fallbacks
+TEST(Instrumentation, backend) {
+  bool enabled = IsInstrumentationEnabled();
+  EnableInstrumentation();
+  ResetInstrumentation();
+
+  uint64_t n = 64;
+  uint64_t modulus = (1ULL << 60) + 1;
+  std::vector<uint64_t> op(n, 1);
+  SetBackend(Backend::kNative);
+  EltwiseMultMod(op.data(), op.data(), op.data(), n, modulus, 1);
+  ResetBackend();
+  EltwiseMultMod(op.data(), op.data(), op.data(), n, modulus, 1);
+
+  const KernelStats mult =
+      GetInstrumentationSnapshot()[Kernel::kEltwiseMultMod];
+  EXPECT_EQ(mult.calls, 2ULL);
+  if (GetSupportedBackend() == Backend::kNative) {
+    EXPECT_EQ(mult.backend_calls[0], 2ULL);
+  } else {
+    EXPECT_EQ(mult.backend_calls[0], 1ULL);
+    EXPECT_EQ(mult.backend_calls[1], 1ULL);
+  }
+
+  ResetInstrumentation();
+  EnableInstrumentation(enabled);
+}
+
+TEST(Instrumentation, json) {
+  InstrumentationSnapshot snapshot;
+  EXPECT_EQ(InstrumentationToJSON(snapshot),
+            std::string("{\"cycle_counter\": \"") + CycleCounterName() +
+                "\", \"kernels\": {}}");
+
+  KernelStats& stats =
+      snapshot.kernels[static_cast<size_t>(Kernel::kEltwiseSubMod)];
+  stats.calls = 3;
+  stats.elements = 24;
+  stats.bytes = 576;
+  stats.cycles = 100;
+  stats.backend_calls[1] = 3;
+  stats.cycle_histogram[5] = 3;
+
+  std::string expected_histogram = "[0, 0, 0, 0, 0, 3";
+  for (size_t i = 6; i < kNumCycleBins; ++i) {
+    expected_histogram += ", 0";
+  }
+  expected_histogram += "]";
+  EXPECT_EQ(InstrumentationToJSON(snapshot),
+            std::string("{\"cycle_counter\": \"") + CycleCounterName() +
+                "\", \"kernels\": {\"EltwiseSubMod\": {\"calls\": 3, "
+                "\"elements\": 24, \"bytes\": 576, \"cycles\": 100, "
+                "\"backends\": {\"Native\": 0, \"AVX512-DQ\": 3, "
+                "\"AVX512-IFMA\": 0}, \"cycle_histogram\": " +
+                expected_histogram + "}}}");
+}
+
+}  // namespace hexl
+}  // namespace intel
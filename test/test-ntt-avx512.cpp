@@ -21,7 +21,7 @@ namespace hexl {
 
 #ifdef HEXL_HAS_AVX512DQ
 TEST(NTT, LoadFwdInterleavedT1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -39,7 +39,7 @@ TEST(NTT, LoadFwdInterleavedT1) {
 }
 
 TEST(NTT, LoadInvInterleavedT1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -57,7 +57,7 @@ TEST(NTT, LoadInvInterleavedT1) {
 }
 
 TEST(NTT, LoadFwdInterleavedT2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -75,7 +75,7 @@ TEST(NTT, LoadFwdInterleavedT2) {
 }
 
 TEST(NTT, LoadInvInterleavedT2) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -93,7 +93,7 @@ TEST(NTT, LoadInvInterleavedT2) {
 }
 
 TEST(NTT, LoadFwdInterleavedT4) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -111,7 +111,7 @@ TEST(NTT, LoadFwdInterleavedT4) {
 }
 
 TEST(NTT, LoadInvInterleavedT4) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -129,7 +129,7 @@ TEST(NTT, LoadInvInterleavedT4) {
 }
 
 TEST(NTT, WriteFwdInterleavedT1) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -148,7 +148,7 @@ TEST(NTT, WriteFwdInterleavedT1) {
 }
 
 TEST(NTT, WriteInvInterleavedT4) {
-  if (!has_avx512dq) {
+  if (!GetCpuFeatures().avx512dq) {
     GTEST_SKIP();
   }
 
@@ -170,7 +170,8 @@ class NttAVX512Test : public DegreeModulusBoolTest {};
 
 #ifdef HEXL_HAS_AVX512IFMA
 TEST_P(NttAVX512Test, FwdNTT_AVX512IFMA) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(52))) {
+  if (!GetCpuFeatures().avx512ifma ||
+      (m_modulus >= NTT::s_max_fwd_modulus(52))) {
     GTEST_SKIP();
   }
 
@@ -206,7 +207,8 @@ TEST_P(NttAVX512Test, FwdNTT_AVX512IFMA) {
 }
 
 TEST_P(NttAVX512Test, InvNTT_AVX512IFMA) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(52))) {
+  if (!GetCpuFeatures().avx512ifma ||
+      (m_modulus >= NTT::s_max_fwd_modulus(52))) {
     GTEST_SKIP();
   }
 
@@ -245,7 +247,7 @@ TEST_P(NttAVX512Test, InvNTT_AVX512IFMA) {
 
 // Checks AVX512 and native forward NTT implementations match
 TEST_P(NttAVX512Test, FwdNTT_AVX512_32) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(32))) {
+  if (!GetCpuFeatures().avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(32))) {
     GTEST_SKIP();
   }
 
@@ -281,7 +283,7 @@ TEST_P(NttAVX512Test, FwdNTT_AVX512_32) {
 
 // Checks AVX512 and native forward NTT implementations match
 TEST_P(NttAVX512Test, FwdNTT_AVX512_64) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(64))) {
+  if (!GetCpuFeatures().avx512dq || (m_modulus >= NTT::s_max_fwd_modulus(64))) {
     GTEST_SKIP();
   }
 
@@ -317,7 +319,7 @@ TEST_P(NttAVX512Test, FwdNTT_AVX512_64) {
 
 // Checks 32-bit AVX512 and native InvNTT implementations match
 TEST_P(NttAVX512Test, InvNTT_AVX512_32) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_inv_modulus(32))) {
+  if (!GetCpuFeatures().avx512dq || (m_modulus >= NTT::s_max_inv_modulus(32))) {
     GTEST_SKIP();
   }
 
@@ -354,7 +356,7 @@ TEST_P(NttAVX512Test, InvNTT_AVX512_32) {
 
 // Checks 64-bit AVX512 and native InvNTT implementations match
 TEST_P(NttAVX512Test, InvNTT_AVX512_64) {
-  if (!has_avx512dq || (m_modulus >= NTT::s_max_inv_modulus(64))) {
+  if (!GetCpuFeatures().avx512dq || (m_modulus >= NTT::s_max_inv_modulus(64))) {
     GTEST_SKIP();
   }
 
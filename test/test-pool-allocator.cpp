@@ -0,0 +1,145 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/pool-allocator.hpp"
+#include "test-util.hpp"
+
+namespace intel {
+namespace hexl {
+
+TEST(PoolAllocator, reuse) {
+  PoolAllocator pool;
+  PoolAllocator::ReleaseThreadCache();
+  EXPECT_EQ(PoolAllocator::ThreadCachedBytes(), 0ULL);
+
+  void* p = pool.allocate(1000);
+  ASSERT_NE(p, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0ULL);
+  pool.deallocate(p, 1000);
+  EXPECT_GE(PoolAllocator::ThreadCachedBytes(), 1000ULL);
+
+  // Sizes in the same class share blocks
+  void* q = pool.allocate(900);
+  EXPECT_EQ(q, p);
+  EXPECT_EQ(PoolAllocator::ThreadCachedBytes(), 0ULL);
+
+  // Sizes in a different class do not
+  void* r = pool.allocate(100);
+  EXPECT_NE(r, q);
+  pool.deallocate(q, 900);
+  pool.deallocate(r, 100);
+
+  // All PoolAllocator objects share the cache
+  PoolAllocator other;
+  void* s = other.allocate(1000);
+  EXPECT_EQ(s, p);
+  other.deallocate(s, 1000);
+
+  PoolAllocator::ReleaseThreadCache();
+  EXPECT_EQ(PoolAllocator::ThreadCachedBytes(), 0ULL);
+}
+
+TEST(PoolAllocator, unpooled) {
+  PoolAllocator pool;
+  PoolAllocator::ReleaseThreadCache();
+
+  size_t bytes = PoolAllocator::MaxPooledBytes() + 1;
+  void* p = pool.allocate(bytes);
+  ASSERT_NE(p, nullptr);
+  pool.deallocate(p, bytes);
+  EXPECT_EQ(PoolAllocator::ThreadCachedBytes(), 0ULL);
+
+  pool.deallocate(nullptr, 0);
+  EXPECT_EQ(PoolAllocator::ThreadCachedBytes(), 0ULL);
+}
+
+TEST(PoolAllocator, cache_bound) {
+  PoolAllocator pool;
+  PoolAllocator::ReleaseThreadCache();
+
+  size_t bytes = PoolAllocator::MaxPooledBytes();
+  size_t count = PoolAllocator::MaxCachedBytes() / bytes + 2;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < count; ++i) {
+    blocks.push_back(pool.allocate(bytes));
+    ASSERT_NE(blocks.back(), nullptr);
+  }
+  for (void* p : blocks) {
+    pool.deallocate(p, bytes);
+  }
+  EXPECT_LE(PoolAllocator::ThreadCachedBytes(),
+            PoolAllocator::MaxCachedBytes());
+  EXPECT_GT(PoolAllocator::ThreadCachedBytes(), 0ULL);
+  PoolAllocator::ReleaseThreadCache();
+}
+
+// Blocks may be freed on another thread than they were allocated on
+TEST(PoolAllocator, cross_thread) {
+  PoolAllocator pool;
+  PoolAllocator::ReleaseThreadCache();
+
+  void* p = nullptr;
+  std::thread allocating_thread([&]() { p = pool.allocate(4096); });
+  allocating_thread.join();
+  ASSERT_NE(p, nullptr);
+  pool.deallocate(p, 4096);
+  EXPECT_EQ(pool.allocate(4096), p);
+  pool.deallocate(p, 4096);
+
+  std::thread freeing_thread([&]() {
+    void* q = pool.allocate(4096);
+    EXPECT_NE(q, p);
+    pool.deallocate(q, 4096);
+  });
+  freeing_thread.join();
+  PoolAllocator::ReleaseThreadCache();
+}
+
+TEST(PoolAllocator, vector) {
+  AlignedVector64<uint64_t> x = MakePooledVector<uint64_t>();
+  for (uint64_t i = 0; i < 1000; ++i) {
+    x.push_back(i);
+  }
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(x.data()) % 64, 0);
+  for (uint64_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(x[i], i);
+  }
+
+  // Vectors with a different allocator do not take over the pooled buffer
+  AlignedVector64<uint64_t> y;
+  y = std::move(x);
+  ASSERT_EQ(y.size(), 1000ULL);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(y.data()) % 64, 0);
+  AlignedAllocator<uint64_t, 64> malloc_alloc;
+  EXPECT_TRUE(y.get_allocator() == malloc_alloc);
+}
+
+TEST(PoolAllocator, ntt) {
+  uint64_t n = 1024;
+  uint64_t modulus = GeneratePrimes(1, 50, true, n)[0];
+  NTT ntt(n, modulus);
+  NTT pooled_ntt(n, modulus, GetPoolAllocator());
+
+  std::vector<uint64_t> input(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    input[i] = i % modulus;
+  }
+  std::vector<uint64_t> expected(n);
+  std::vector<uint64_t> result(n);
+  ntt.ComputeForward(expected.data(), input.data(), 1, 1);
+  pooled_ntt.ComputeForward(result.data(), input.data(), 1, 1);
+  AssertEqual(result, expected);
+
+  pooled_ntt.ComputeInverse(result.data(), result.data(), 1, 1);
+  AssertEqual(result, input);
+}
+
+}  // namespace hexl
+}  // namespace intel
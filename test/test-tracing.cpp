@@ -0,0 +1,108 @@
+// Copyright (C) 2020-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hexl/eltwise/eltwise-add-mod.hpp"
+#include "hexl/eltwise/eltwise-cmp-add.hpp"
+#include "hexl/ntt/ntt.hpp"
+#include "hexl/number-theory/number-theory.hpp"
+#include "hexl/util/dispatch.hpp"
+#include "hexl/util/tracing.hpp"
+
+namespace intel {
+namespace hexl {
+
+// Records the events of each span, in the order the hooks were called
+struct TraceLog {
+  std::vector<TraceEvent> begins;
+  std::vector<TraceEvent> ends;
+  std::vector<size_t> end_spans;
+};
+
+inline void* TraceLogBegin(const TraceEvent& event, void* user_data) {
+  TraceLog* log = static_cast<TraceLog*>(user_data);
+  log->begins.push_back(event);
+  // Identifies the span by its index, offset so it is not nullptr
+  return reinterpret_cast<void*>(log->begins.size());
+}
+
+inline void TraceLogEnd(const TraceEvent& event, void* span, void* user_data) {
+  TraceLog* log = static_cast<TraceLog*>(user_data);
+  log->ends.push_back(event);
+  log->end_spans.push_back(reinterpret_cast<size_t>(span) - 1);
+}
+
+TEST(Tracing, hooks) {
+  TraceLog log;
+  TraceHooks hooks;
+  hooks.begin = TraceLogBegin;
+  hooks.end = TraceLogEnd;
+  hooks.user_data = &log;
+
+  uint64_t n = 1024;
+  uint64_t modulus = GeneratePrimes(1, 45, true, n)[0];
+  NTT ntt(n, modulus);
+  std::vector<uint64_t> op1(n, 1);
+  std::vector<uint64_t> op2(n, 2);
+
+  EXPECT_EQ(GetTraceHooks(), nullptr);
+  SetTraceHooks(&hooks);
+  EXPECT_EQ(GetTraceHooks(), &hooks);
+  EltwiseAddMod(op1.data(), op1.data(), op2.data(), n, modulus);
+  ntt.ComputeInverse(op2.data(), op1.data(), 1, 1);
+  EltwiseCmpAdd(op1.data(), op1.data(), n, CMPINT::LT, 3, 1);
+  SetTraceHooks(nullptr);
+  EltwiseAddMod(op1.data(), op1.data(), op2.data(), n, modulus);
+
+  ASSERT_EQ(log.begins.size(), 3ULL);
+  ASSERT_EQ(log.ends.size(), 3ULL);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(log.end_spans[i], i);
+    EXPECT_EQ(log.begins[i].kernel, log.ends[i].kernel);
+    EXPECT_EQ(log.begins[i].backend, GetBackend());
+    EXPECT_EQ(log.begins[i].duration_ns, 0ULL);
+    EXPECT_EQ(log.ends[i].n, n);
+    EXPECT_EQ(log.ends[i].num_moduli, 1ULL);
+  }
+
+  EXPECT_EQ(log.ends[0].kernel, Kernel::kEltwiseAddMod);
+  EXPECT_EQ(log.ends[0].modulus_bits, Log2(modulus) + 1);
+  EXPECT_EQ(log.ends[0].backend,
+            GetKernelBackend(Kernel::kEltwiseAddMod, modulus));
+
+  EXPECT_EQ(log.ends[1].kernel, Kernel::kInverseNTT);
+  EXPECT_EQ(log.ends[1].modulus_bits, Log2(modulus) + 1);
+  EXPECT_EQ(log.ends[1].elements, n);
+  EXPECT_EQ(log.ends[1].backend,
+            GetKernelBackend(Kernel::kInverseNTT, modulus));
+  EXPECT_GT(log.ends[1].duration_ns, 0ULL);
+
+  // EltwiseCmpAdd has no modulus
+  EXPECT_EQ(log.ends[2].kernel, Kernel::kEltwiseCmpAdd);
+  EXPECT_EQ(log.ends[2].modulus_bits, 0ULL);
+}
+
+// Either hook may be omitted
+TEST(Tracing, end_only) {
+  TraceLog log;
+  TraceHooks hooks;
+  hooks.end = TraceLogEnd;
+  hooks.user_data = &log;
+
+  uint64_t n = 64;
+  uint64_t modulus = 769;
+  std::vector<uint64_t> op(n, 1);
+  SetTraceHooks(&hooks);
+  EltwiseAddMod(op.data(), op.data(), op.data(), n, modulus);
+  SetTraceHooks(nullptr);
+
+  ASSERT_EQ(log.ends.size(), 1ULL);
+  EXPECT_EQ(log.end_spans[0], static_cast<size_t>(-1));
+  EXPECT_EQ(log.ends[0].modulus_bits, 10ULL);
+}
+
+}  // namespace hexl
+}  // namespace intel